@@ -42,4 +42,6 @@ class CAccessToken {
         const char * getTokenAsBase64(bool bRandomIV = true);
         /// @brief Validate token structure, IP address, key and lifetime.
         bool isAuthValid(const char * pszIPAddress, const char * pszTokenKey);
+        /// @brief Time stamp (millis()) of the token, it is valid for TOKEN_TIME_ALIVE.
+        unsigned long getTimeStamp() { return(m_ulTimeStamp); }
 };
@@ -4,7 +4,9 @@
 #include <JsonNode.h>
 #include <ModuleInterface.h>
 #include <Logging.h>
+#include <ApplLogging.h>
 #include <Vars.h>
+#include <ConfigJournal.h>
 #include <DevelopmentHelper.h>
 
 
@@ -17,43 +19,10 @@
  */
 
 
- /**
-  * Macros for Application Logging
-  * Use this macros, to log messages, so it is possible to undef them all at once,
-  * if needed (for example in production code)
-  */
-#ifdef NO_LOGGING
-    #define ApplLogInfo(oData)          NULL_FUNCTION
-    #define ApplLogWarn(oData)          NULL_FUNCTION
-    #define ApplLogVerbose(oData)       NULL_FUNCTION
-    #define ApplLogError(oData)         NULL_FUNCTION
-
-    #define ApplLogInfoWithParms(str,...)     NULL_FUNCTION
-    #define ApplLogVerboseWithParms(str,...)  NULL_FUNCTION
-    #define ApplLogWarnWithParms(str,...)     NULL_FUNCTION
-    #define ApplLogErrorWithParms(str,...)    NULL_FUNCTION
-
-    #define ApplLogTrace(oData)                 NULL_FUNCTION
-    #define ApplLogTraceWithParms(str,...)      NULL_FUNCTION
-#else
-    #define ApplLogInfo(oData)          Appl.Log.log("I",oData)
-    #define ApplLogWarn(oData)          Appl.Log.log("W",oData)
-    #define ApplLogVerbose(oData)       Appl.Log.log("V",oData)
-    #define ApplLogError(oData)         Appl.Log.log("E",oData)
-
-    #define ApplLogInfoWithParms(str,...)     Appl.Log.log("I",str,__VA_ARGS__)
-    #define ApplLogVerboseWithParms(str,...)  Appl.Log.log("V",str,__VA_ARGS__)
-    #define ApplLogWarnWithParms(str,...)     Appl.Log.log("W",str,__VA_ARGS__)
-    #define ApplLogErrorWithParms(str,...)    Appl.Log.log("E",str,__VA_ARGS__)
-#endif
-
-// Enable Trace Logging, if TRACE is defined - Default is NO trace...
-#ifdef TRACE
-    #define ApplLogTrace(oData)                 Appl.Log.log("T",oData)
-    #define ApplLogTraceWithParms(str,...)      Appl.Log.log("T",str,__VA_ARGS__)
-#else
-    #define ApplLogTraceWithParms(str,...)      NULL_FUNCTION
-    #define ApplLogTrace(oData)                 NULL_FUNCTION
+// Queue log entries in CAppl::LogRing, written by the application loop (0 = write synchronously).
+// Opt-in: the ring reserves LOG_RING_SIZE * LOG_RING_TEXT_SIZE bytes and truncates longer entries.
+#ifndef LSC_APPL_LOG_RING
+    #define LSC_APPL_LOG_RING       0
 #endif
 
 // Default sizes for Json Status Documents (needed for JSON < 7)
@@ -80,6 +49,10 @@
     #define JSON_APPL_CONFIG_FILE           "/config.json"
 #endif
 
+#ifndef JSON_APPL_CONFIG_JOURNAL_FILE
+    #define JSON_APPL_CONFIG_JOURNAL_FILE   "/config.jnl"
+#endif
+
 #ifndef DEFAULT_DEVICE_NAME
     #define DEFAULT_DEVICE_NAME             "LSC-Device"
 #endif
@@ -154,8 +127,14 @@ class CAppl : public CConfigHandler, public CStatusHandler, IMsgEventReceiver {
         CVarTable      Config;
         /// @brief Application message bus used by modules and log writers.
         CEventHandler  MsgBus;
+        /// @brief Queue of log entries, drained by the application loop into the log writers.
+        #if LSC_APPL_LOG_RING
+        CLogRing       LogRing { &MsgBus };
+        #endif
         /// @brief Event-based application logger.
         CEventLogger   Log;
+        /// @brief Change journal of JSON_APPL_CONFIG_FILE, clear it when the file is replaced.
+        CConfigJournal ConfigJournal { JSON_APPL_CONFIG_FILE, JSON_APPL_CONFIG_JOURNAL_FILE };
 
         /**
          * @brief Register a module with configuration, status and event handling.
@@ -0,0 +1,73 @@
+#pragma once
+/**
+ * Logging macros of the application (Appl.Log)
+ *
+ * The macros expand to calls of Appl.Log - the including file provides Appl
+ * (Appl.h declares it). Kept apart from Appl.h, so the compile-time floor can
+ * be checked without the application class.
+ */
+#include <Logging.h>
+#include <DevelopmentHelper.h>
+
+ /**
+  * Macros for Application Logging
+  * Use this macros, to log messages, so it is possible to undef them all at once,
+  * if needed (for example in production code)
+  *
+  * Compile-time log floor:
+  * Calls of a log class above the floor (class number, see LOG_CLASS_LEVEL_MASK) are
+  * removed by the preprocessor - no format string in flash, no argument evaluation.
+  * Calls within the floor are still filtered by the log level of the writers.
+  * Warnings and errors are never removed (only by NO_LOGGING).
+  *  -D LSC_LOG_LEVEL_FLOOR=n           floor of all modules (default: keep all)
+  *  #define LOG_MODULE_LEVEL_FLOOR n   floor of one module - define it in the .cpp file
+  *                                     before the first #include (like DEBUG_LSC_*)
+  */
+#ifndef LSC_LOG_LEVEL_FLOOR
+    #define LSC_LOG_LEVEL_FLOOR     LOG_CLASS_NO_EXCEPTION
+#endif
+#ifndef LOG_MODULE_LEVEL_FLOOR
+    #define LOG_MODULE_LEVEL_FLOOR  LSC_LOG_LEVEL_FLOOR
+#endif
+
+#ifdef NO_LOGGING
+    #define ApplLogInfo(oData)          NULL_FUNCTION
+    #define ApplLogWarn(oData)          NULL_FUNCTION
+    #define ApplLogVerbose(oData)       NULL_FUNCTION
+    #define ApplLogError(oData)         NULL_FUNCTION
+
+    #define ApplLogInfoWithParms(str,...)     NULL_FUNCTION
+    #define ApplLogVerboseWithParms(str,...)  NULL_FUNCTION
+    #define ApplLogWarnWithParms(str,...)     NULL_FUNCTION
+    #define ApplLogErrorWithParms(str,...)    NULL_FUNCTION
+#else
+    #define ApplLogWarn(oData)          Appl.Log.log("W",oData)
+    #define ApplLogError(oData)         Appl.Log.log("E",oData)
+
+    #define ApplLogWarnWithParms(str,...)     Appl.Log.log("W",str,__VA_ARGS__)
+    #define ApplLogErrorWithParms(str,...)    Appl.Log.log("E",str,__VA_ARGS__)
+
+    #if LOG_MODULE_LEVEL_FLOOR >= LOG_CLASS_NO_INFO
+        #define ApplLogInfo(oData)                Appl.Log.log("I",oData)
+        #define ApplLogInfoWithParms(str,...)     Appl.Log.log("I",str,__VA_ARGS__)
+    #else
+        #define ApplLogInfo(oData)                NULL_FUNCTION
+        #define ApplLogInfoWithParms(str,...)     NULL_FUNCTION
+    #endif
+    #if LOG_MODULE_LEVEL_FLOOR >= LOG_CLASS_NO_VERBOSE
+        #define ApplLogVerbose(oData)             Appl.Log.log("V",oData)
+        #define ApplLogVerboseWithParms(str,...)  Appl.Log.log("V",str,__VA_ARGS__)
+    #else
+        #define ApplLogVerbose(oData)             NULL_FUNCTION
+        #define ApplLogVerboseWithParms(str,...)  NULL_FUNCTION
+    #endif
+#endif
+
+// Enable Trace Logging, if TRACE is defined - Default is NO trace...
+#if defined(TRACE) && !defined(NO_LOGGING) && LOG_MODULE_LEVEL_FLOOR >= LOG_CLASS_NO_TRACE
+    #define ApplLogTrace(oData)                 Appl.Log.log("T",oData)
+    #define ApplLogTraceWithParms(str,...)      Appl.Log.log("T",str,__VA_ARGS__)
+#else
+    #define ApplLogTraceWithParms(str,...)      NULL_FUNCTION
+    #define ApplLogTrace(oData)                 NULL_FUNCTION
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+/**
+ * Base class for log writers that send the entries over the network
+ *
+ * Sending one message per log line saturates the TCP stack (specially on ESP8266).
+ * This writer collects the entries in a fixed buffer and sends them as one batch,
+ * when the flush interval elapsed or the buffer is full. A rate limit (entries per
+ * second) protects the destination from log floods - the number of dropped entries
+ * is sent with the next batch. The level filter is the log level of the writer.
+ *
+ * Batch (payload) format:
+ *      { "dropped": <n>, "entries": [ "<millis> [<type>] <message>", ... ] }
+ */
+#include <Runtime.h>
+#include <Logging.h>
+
+// Size of the batch buffer (bytes)
+#ifndef LOG_BATCH_BUFFER_SIZE
+    #define LOG_BATCH_BUFFER_SIZE       1024
+#endif
+// Default max. time (ms) an entry waits for the batch to be sent
+#ifndef LOG_BATCH_FLUSH_INTERVAL
+    #define LOG_BATCH_FLUSH_INTERVAL    1000
+#endif
+// Default max. number of entries per second (0 = no limit)
+#ifndef LOG_BATCH_RATE_LIMIT
+    #define LOG_BATCH_RATE_LIMIT        20
+#endif
+
+/**
+ * @brief Log writer, that sends the entries in batches.
+ *        Derived classes implement isReady() and sendBatch().
+ */
+class CBatchLogWriter : public CLogWriter {
+    private:
+        char            m_tBatch[LOG_BATCH_BUFFER_SIZE];
+        size_t          m_nBatched        = 0;      // Bytes in the batch buffer (entries are zero terminated)
+        size_t          m_nEntries        = 0;
+        unsigned long   m_ulFlushInterval = LOG_BATCH_FLUSH_INTERVAL;
+        unsigned long   m_ulFirstEntry    = 0;      // millis() of the first entry in the batch
+        unsigned int    m_nRateLimit      = LOG_BATCH_RATE_LIMIT;
+        unsigned long   m_ulRateTime      = 0;      // millis() of the last token refill
+        unsigned long   m_ulTokens        = LOG_BATCH_RATE_LIMIT * 1000UL;  // Rate tokens (entries * 1000)
+        bool            m_bSending        = false;
+
+        unsigned long   m_ulSent          = 0;      // Sent entries
+        unsigned long   m_ulBatches       = 0;      // Sent batches
+        unsigned long   m_ulDropped       = 0;      // Dropped entries (rate limit, not ready, too long)
+        unsigned long   m_ulDroppedUnsent = 0;      // Dropped since the last batch
+
+        bool takeRateToken();
+
+    protected:
+        /// @brief Return true if the destination can receive batches (i.E. is connected).
+        virtual bool isReady() = 0;
+        /// @brief Send one batch (payload) to the destination.
+        virtual void sendBatch(JsonNode &oBatch) = 0;
+
+    public:
+        /// @brief Set the max. time (ms) an entry waits for the batch to be sent.
+        void setFlushInterval(unsigned long ulInterval) { m_ulFlushInterval = ulInterval; }
+        /// @brief Set the max. number of entries per second (0 = no limit).
+        void setRateLimit(unsigned int nEntriesPerSecond);
+        /// @brief Send the collected entries now.
+        void flush();
+
+        /// @brief Number of collected entries.
+        size_t getPending()             { return(m_nEntries); }
+        unsigned long getSent()         { return(m_ulSent); }
+        unsigned long getBatches()      { return(m_ulBatches); }
+        unsigned long getDropped()      { return(m_ulDropped); }
+
+        /// @brief Sends the batch on MSG_APPL_LOOP, when the flush interval elapsed.
+        int  receiveEvent(const void * pSender, int nMsgType, const void * pMessage, int nClass) override;
+        /// @brief Add a text log entry to the batch.
+        void writeLogEntry(const char *pszType, const char *pszMessage) override;
+        /// @brief Add a JSON log entry (as text) to the batch.
+        void writeLogEntry(const char *pszType, JsonNode *pDoc) override;
+};
@@ -0,0 +1,94 @@
+#pragma once
+/**
+ * Size classed buffer pool
+ *
+ * Network messages are received into buffers of very different sizes, that live
+ * only until the application loop processed them. Allocating them with malloc()
+ * fragments the heap over time (specially on ESP8266).
+ * The pool reserves one block for all buffers at construction. A request is served
+ * by the smallest free buffer of the size classes; if the matching class is used
+ * up, a larger class is used. Only oversized requests (or an exhausted pool) fall
+ * back to the heap - release() detects, where the buffer came from.
+ *
+ * Buffers are allocated in network callbacks and released by the application loop,
+ * so the free lists are guarded by a short critical section.
+ */
+#include <Runtime.h>
+#include <StatusHandler.h>
+#ifdef NATIVE_RUNTIME
+    #include <mutex>
+#endif
+
+// Max. number of size classes of a pool
+#ifndef BUFFER_POOL_MAX_CLASSES
+    #define BUFFER_POOL_MAX_CLASSES     4
+#endif
+
+/// @brief Size and number of buffers of one size class.
+struct BufferPoolClass {
+    size_t Size;
+    size_t Count;
+};
+
+/**
+ * @brief Pool of preallocated buffers in size classes, with heap fallback.
+ */
+class CBufferPool : public IStatusHandler {
+    private:
+        struct PoolClass {
+            size_t        Size      = 0;
+            size_t        Count     = 0;
+            char *        pBuffers  = nullptr;  // First buffer of the class in the block
+            void **       pFree     = nullptr;  // Stack of free buffers
+            size_t        nFree     = 0;
+            size_t        HighWater = 0;        // Max. number of used buffers
+            unsigned long Exhausted = 0;        // Requests, that found no free buffer in this class
+        };
+        PoolClass       m_tClasses[BUFFER_POOL_MAX_CLASSES];
+        size_t          m_nClasses  = 0;
+        char *          m_pBlock    = nullptr;
+        size_t          m_nBlockSize = 0;
+
+        unsigned long   m_ulHits      = 0;      // Requests served by the pool
+        unsigned long   m_ulHeap      = 0;      // Requests served by the heap (exhausted)
+        unsigned long   m_ulOversized = 0;      // Requests larger than the largest class
+
+        #ifdef NATIVE_RUNTIME
+            std::mutex  m_oLock;
+        #elif defined(ESP32)
+            portMUX_TYPE m_tLock = portMUX_INITIALIZER_UNLOCKED;
+        #else
+            uint32_t    m_ulSavedPS = 0;
+        #endif
+        void lock();
+        void unlock();
+
+    public:
+        /**
+         * @brief Create a pool and reserve the buffers.
+         * @param pClasses Size classes, ascending by size (max. BUFFER_POOL_MAX_CLASSES).
+         * @param nClasses Number of size classes.
+         */
+        CBufferPool(const BufferPoolClass *pClasses, size_t nClasses);
+        virtual ~CBufferPool();
+
+        /// @brief Get a buffer of at least nSize bytes (pool or heap), nullptr if out of memory.
+        void * allocate(size_t nSize);
+        /// @brief Give a buffer back (pool or heap).
+        void   release(void *pBuffer);
+        /// @brief Return true if the buffer belongs to the pool.
+        bool   isPoolBuffer(const void *pBuffer) {
+            return(pBuffer >= m_pBlock && pBuffer < m_pBlock + m_nBlockSize);
+        }
+
+        unsigned long getHits()         { return(m_ulHits); }
+        unsigned long getHeap()         { return(m_ulHeap); }
+        unsigned long getOversized()    { return(m_ulOversized); }
+        /// @brief Number of requests, that found their size class used up.
+        unsigned long getExhausted();
+        /// @brief Number of free buffers in all classes.
+        size_t getFree();
+
+        /// @brief Write the counters and the use of each size class.
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel = STATUS_LEVEL_INFO) override;
+};
@@ -0,0 +1,70 @@
+#pragma once
+/**
+ * Append-only change journal for the configuration file
+ *
+ * Saving the configuration normally rewrites the whole config file. With the journal,
+ * only the settings that differ from the persisted state are appended as one small
+ * record to the journal file. On boot the records are replayed on top of the base
+ * config file. When the journal grows too large, the merged configuration is written
+ * into a new base file (temp file + rename) and the journal is removed.
+ *
+ * Record format (one per save):
+ *      <length> TAB <json object with the changed settings> LF
+ * A record that has not been written completely (power loss) fails the length check
+ * and is ignored, together with everything after it.
+ */
+#include <Runtime.h>
+#include <JsonNode.h>
+#include <NamedValueTable.h>
+#include <memory>
+
+// Compact the journal into the base file, when it exceeds this size (bytes)
+#ifndef CONFIG_JOURNAL_MAX_SIZE
+    #define CONFIG_JOURNAL_MAX_SIZE     4096
+#endif
+
+/**
+ * @brief Journal of configuration changes for one base config file.
+ */
+class CConfigJournal {
+    private:
+        const char * m_pszBaseFile;
+        const char * m_pszJournalFile;
+        /// @brief Hash of every persisted setting, key is the path of the setting.
+        std::unique_ptr<CNamedValueTable<uint32_t>> m_pPersisted;
+        size_t  m_nJournalSize      = 0;
+        size_t  m_nRecords          = 0;
+        bool    m_bNeedsCompaction  = false;
+
+        bool collectChanges(JsonNode &oNode, String &strPath, JsonNode &oRecord, bool bRecord);
+
+    public:
+        /**
+         * @brief Creates a journal for a config file.
+         * @param pszBaseFile Config file (static string).
+         * @param pszJournalFile Journal file (static string).
+         */
+        CConfigJournal(const char *pszBaseFile, const char *pszJournalFile);
+
+        /// @brief Replay the records of a journal text into the config document.
+        size_t replay(const char *pszJournal, JsonNode &oDoc);
+        /// @brief Replay the journal file into the config document.
+        size_t replayFile(JsonNode &oDoc);
+        /// @brief Remember the document as persisted state, the next save writes only the differences.
+        void   remember(JsonNode &oDoc);
+        /// @brief Create a record with the settings that differ from the persisted state.
+        bool   createRecord(JsonNode &oCurrent, String &strRecord);
+        /// @brief Persist the current configuration (append or compact).
+        bool   save(JsonNode &oCurrent);
+        /// @brief Write base file + journal + current settings into a new base file.
+        bool   compact(JsonNode &oCurrent);
+        /// @brief Remove the journal (i.E. after the base file has been replaced).
+        void   clear();
+
+        /// @brief Size of the journal in bytes.
+        size_t getJournalSize()     { return(m_nJournalSize); }
+        /// @brief Number of records in the journal.
+        size_t getRecordCount()     { return(m_nRecords); }
+        /// @brief Name of the base config file.
+        const char * getBaseFile()  { return(m_pszBaseFile); }
+};
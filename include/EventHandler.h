@@ -4,8 +4,13 @@
 #include <vector>
 #include <queue>
 #include <NamedValueTable.h>
+#include <MsgQueue.h>
 #include <DevelopmentHelper.h>
 
+#ifndef MSG_POST_QUEUE_SIZE
+    #define MSG_POST_QUEUE_SIZE 16
+#endif
+
 #define EVENT_MSG_CALL_AGAIN_WHEN_ALL_OK -9
 #define EVENT_MSG_RESULT_OK               0
 #define EVENT_MSG_RESULT_WARN             1
@@ -22,6 +27,53 @@ class IMsgEventReceiver
         virtual int receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nMsgInfo) = 0;
 };  
 
+/**
+ * @brief Accumulated dispatch costs of one registered receiver.
+ *        Only collected while profiling is enabled (see CEventHandler::enableProfiling()).
+ */
+struct MsgReceiverProfile {
+    /// @brief Number of receiveEvent() calls.
+    unsigned long Calls       = 0;
+    /// @brief Total time spent inside receiveEvent() in microseconds.
+    unsigned long TotalMicros = 0;
+    /// @brief Longest single receiveEvent() call in microseconds.
+    unsigned long MaxMicros   = 0;
+};
+
+/**
+ * @brief Event, posted from another task, waiting to be sent on the application task.
+ */
+struct PostedEvent {
+    void        * pSender   = nullptr;
+    int           nMsg      = 0;
+    const void  * pMessage  = nullptr;
+    int           nClass    = 0;
+    /// @brief Optional function to release pMessage, after all receivers are called.
+    void       (* pfnRelease)(const void *pMessage) = nullptr;
+};
+
+/**
+ * @brief Queue of one producer (task or callback context) for posted events.
+ *        Register it with CEventHandler::registerPostQueue() on the application task,
+ *        then only this producer calls post().
+ */
+class CMsgPostQueue : public CSPSCQueue<PostedEvent,MSG_POST_QUEUE_SIZE> {
+    public:
+        /**
+         * @brief Post an event, it will be sent by CEventHandler::dispatchPostedEvents().
+         * @return false if the queue is full - the message is not released in this case.
+         */
+        bool post(void *pSender, int nMsg, const void *pMessage, int nClass, void (*pfnRelease)(const void *) = nullptr) {
+            PostedEvent oEvent;
+            oEvent.pSender    = pSender;
+            oEvent.nMsg       = nMsg;
+            oEvent.pMessage   = pMessage;
+            oEvent.nClass     = nClass;
+            oEvent.pfnRelease = pfnRelease;
+            return(push(oEvent));
+        }
+};
+
 /**
  * Event Handler Manager
  */
@@ -49,6 +101,13 @@ class CEventHandler
 */
 
         CMultiNameUniqueValueTable<IMsgEventReceiver *> m_tReceiverTable;
+        IMsgEventReceiver *             m_pEventRecorder = nullptr;     // Receives a copy of all top level events
+        int                             m_nSendDepth     = 0;           // Nesting level of sendEvent()
+        bool                            m_bProfiling     = false;       // Collect receiver timings
+        std::vector<MsgReceiverProfile> m_tProfiles;                    // Same index as m_tReceiverTable.Entries
+        std::vector<CMsgPostQueue *>    m_tPostQueues;                  // Queues of foreign producers
+
+        int  callReceiver(size_t nIdx, IMsgEventReceiver *pEventReceiver, void *pSender, int nMsg, const void *pMessage, int nClass);
         
     public: 
         ~CEventHandler() {
@@ -71,6 +130,52 @@ class CEventHandler
          */
         int sendEvent(void *pSender, int nMsgID, const void *pMessage, int nMsgType);
 
+        /**
+         * @brief Register the event queue of a producer, running on another task.
+         *        Call this on the application task, before the producer posts events.
+         */
+        void registerPostQueue(CMsgPostQueue *pQueue);
+
+        /**
+         * @brief Send all events, posted into the registered queues, to the receivers.
+         *        Has to be called on the application task (CAppl::dispatch() does this).
+         * @return Number of events sent.
+         */
+        int dispatchPostedEvents();
+
+        /**
+         * @brief Set a recorder that gets a copy of every top level event, before the
+         *        receivers are called. Events sent while another event is processed
+         *        (nested events, like log entries) are not passed to the recorder,
+         *        as they will be generated again, when the top level event is replayed.
+         * @param pRecorder Recorder or nullptr to stop recording.
+         */
+        void setEventRecorder(IMsgEventReceiver *pRecorder) { m_pEventRecorder = pRecorder; }
+
+        /**
+         * @brief Get the registered name of a receiver (or sender).
+         * @return Name of the receiver, or nullptr if the address is not registered.
+         */
+        const char * getReceiverName(const void *pReceiver);
+
+        /**
+         * @brief Get a registered receiver by its name (first match).
+         * @return Receiver, or nullptr if no receiver with this name is registered.
+         */
+        IMsgEventReceiver * getReceiver(const char *pszReceiverName);
+
+        /**
+         * @brief Enable or disable the timing of each receiver in sendEvent().
+         *        Enabling resets the collected data.
+         */
+        void enableProfiling(bool bEnable = true);
+
+        /**
+         * @brief Get the collected timings of a receiver.
+         * @return Profile of the first receiver with this name, or nullptr if not found.
+         */
+        const MsgReceiverProfile * getProfile(const char *pszReceiverName);
+
         void dumpReceiver() {
             /*
             for(HandlerEntry * pEntry : m_tEventReceivers) {
@@ -85,5 +190,17 @@ class CEventHandler
                               pEntry->getKey());
             }
         }
+
+        void dumpProfile() {
+            for(size_t nIdx = 0; nIdx < m_tProfiles.size() && nIdx < m_tReceiverTable.Entries.size(); nIdx++) {
+                MsgReceiverProfile &oProfile = m_tProfiles[nIdx];
+                Serial.printf("EVH: - %-24s calls: %8lu  total: %10lu us  avg: %6lu us  max: %8lu us\n",
+                              m_tReceiverTable.Entries[nIdx]->getKey(),
+                              oProfile.Calls,
+                              oProfile.TotalMicros,
+                              oProfile.Calls > 0 ? oProfile.TotalMicros / oProfile.Calls : 0,
+                              oProfile.MaxMicros);
+            }
+        }
     };
 
@@ -0,0 +1,111 @@
+#pragma once
+/**
+ * Index of the files delivered by the web server
+ *
+ * The index keeps one entry per file: its path, the hash of the path, its size,
+ * its modification time and the hash of its content. The entries are sorted by
+ * the path hash and found by a binary search. The path is only compared with
+ * the entries of the same hash, so two paths with the same hash keep their own
+ * entries. The content hash is the ETag of the file, so a browser can revalidate a file
+ * (If-None-Match) without transferring it again. It is set when a file is
+ * uploaded, all other files are hashed by the application loop (hashNext()) -
+ * a request never reads a file to get its ETag, a file without a known hash is
+ * delivered without an ETag. A file changed by others (size or modification
+ * time differ) is found by checkNext() or by its delivery (verify()) and hashed
+ * again.
+ *
+ * The static helpers cover the HTTP side of the delivery: content type by
+ * extension, ETag matching and byte ranges.
+ */
+#include <Runtime.h>
+#include <StatusHandler.h>
+#include <vector>
+
+// Size of the read buffer to hash a file
+#ifndef FILE_INDEX_READ_SIZE
+    #define FILE_INDEX_READ_SIZE    512
+#endif
+// Max. length of an ETag (with quotes and terminator)
+#define FILE_INDEX_ETAG_SIZE        24
+// Interval (ms) to check the next file for changes by others (see CFileIndex::checkNext())
+#ifndef FILE_INDEX_CHECK_INTERVAL
+    #define FILE_INDEX_CHECK_INTERVAL   1000
+#endif
+
+// Results of parseRange()
+#define FILE_RANGE_NONE             0   // No (or an ignored) range, deliver the whole file
+#define FILE_RANGE_OK               1   // Deliver the range (206)
+#define FILE_RANGE_INVALID          2   // Range not satisfiable (416)
+
+/// @brief Entry of the file index.
+struct FileIndexEntry {
+    String      Path;
+    uint32_t    PathHash    = 0;        // LSC::getHash() of the path
+    uint32_t    Size        = 0;
+    uint32_t    Time        = 0;        // Modification time of the hashed content
+    uint32_t    ContentHash = 0;        // LSC::updateHash() of the content, 0 = not known yet
+    uint32_t    Version     = 0;        // Changed with the content (set(), new hash), see CFileIndex::getVersion()
+};
+
+/**
+ * @brief Sorted index of the files, with the content hash (ETag) per file.
+ */
+class CFileIndex : public IStatusHandler {
+    private:
+        std::vector<FileIndexEntry> m_tEntries;     // Sorted by PathHash, paths with the same hash are neighbours
+        unsigned long   m_ulHashed  = 0;            // Files hashed by hashNext()
+        unsigned long   m_ulLookups = 0;
+        uint32_t        m_ulVersion = 0;            // Last version given to an entry
+        bool            m_bPending  = false;        // An entry may wait for its content hash
+        size_t          m_nCheckPos = 0;            // Next entry checked by checkNext()
+
+        std::vector<FileIndexEntry>::iterator getPosition(uint32_t ulPathHash, const char *pszPath);
+        bool isEntry(std::vector<FileIndexEntry>::iterator itEntry, uint32_t ulPathHash, const char *pszPath);
+        static uint32_t hashFile(const char *pszPath, size_t &nSize);
+        static bool     statFile(const char *pszPath, size_t &nSize, uint32_t &ulTime);
+        void setChanged(FileIndexEntry &oEntry);
+
+    public:
+        /// @brief Find the entry of a file, nullptr if it is not in the index.
+        FileIndexEntry * find(const char *pszPath);
+        /// @brief Add or update the entry of a file, ulContentHash = 0 if it is not known (a known hash is bound to the current modification time).
+        FileIndexEntry * set(const char *pszPath, size_t nSize, uint32_t ulContentHash = 0);
+        /// @brief Remove the entry of a file.
+        void remove(const char *pszPath);
+        /// @brief Remove all entries.
+        void clear() { m_tEntries.clear(); m_bPending = false; }
+        /// @brief Add the files of a directory (not recursive), the content is hashed by hashNext().
+        void scan(const char *pszDir = "/");
+        /// @brief Hash the content of the next file without a known hash (application loop), false if no file is pending.
+        bool hashNext();
+        /// @brief Check the size and modification time of the next file (application loop), a changed file is hashed again.
+        void checkNext();
+        /// @brief Check a delivered file against its entry, a changed file is hashed again - false if the ETag is not valid for it.
+        bool verify(const char *pszPath, size_t nSize, uint32_t ulTime);
+        /// @brief Version of a file, changed when the file is set or hashed again - 0 if it is not in the index.
+        uint32_t getVersion(const char *pszPath);
+        /// @brief Number of files in the index.
+        size_t getCount() { return(m_tEntries.size()); }
+
+        /**
+         * @brief Get the ETag of a file in the index.
+         * Only a known content hash is used, the file is not read.
+         * @return false if the file is not in the index or its content is not hashed yet.
+         */
+        bool getETag(const char *pszPath, char *pszETag, size_t nETagSize = FILE_INDEX_ETAG_SIZE);
+
+        /// @brief Content type of a file by its extension (a ".gz" extension is skipped).
+        static const char * getContentType(const char *pszPath);
+        /// @brief Check if an ETag matches the value of an If-None-Match header (list, "*", weak tags).
+        static bool matchesETag(const char *pszIfNoneMatch, const char *pszETag);
+        /**
+         * @brief Parse a Range header (single range "bytes=first-last", "bytes=first-" or "bytes=-suffix").
+         * @param nStart First byte of the range.
+         * @param nEnd Last byte of the range (inclusive).
+         * @return FILE_RANGE_NONE, FILE_RANGE_OK or FILE_RANGE_INVALID.
+         */
+        static int parseRange(const char *pszRange, size_t nSize, size_t &nStart, size_t &nEnd);
+
+        /// @brief Write the number of files and the counters.
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel = STATUS_LEVEL_INFO) override;
+};
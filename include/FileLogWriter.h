@@ -0,0 +1,119 @@
+#pragma once
+/**
+ * Rotating, write-behind file log writer
+ *
+ * Log entries are collected in a RAM buffer and written in flash page sized chunks,
+ * so the file system writes whole pages instead of rewriting the last page for
+ * every log line. The rest of the buffer is written after FILE_LOG_FLUSH_INTERVAL
+ * or on shutdown.
+ *
+ * The log is spread over FILE_LOG_FILE_COUNT files ("<base>.0" ... "<base>.n").
+ * When a file exceeds FILE_LOG_FILE_SIZE, the next file is truncated and used.
+ * The index file ("<base>.idx") holds the number (generation) of the current file,
+ * so the files can be read from the oldest to the newest entry without scanning.
+ */
+#include <Runtime.h>
+#include <Logging.h>
+
+// Base name of the log files
+#ifndef FILE_LOG_BASE_NAME
+    #define FILE_LOG_BASE_NAME          "/log"
+#endif
+// Number of log files
+#ifndef FILE_LOG_FILE_COUNT
+    #define FILE_LOG_FILE_COUNT         4
+#endif
+// Max. size of one log file (bytes)
+#ifndef FILE_LOG_FILE_SIZE
+    #define FILE_LOG_FILE_SIZE          16384
+#endif
+// Flash page size, data is written in multiples of this size
+#ifndef FILE_LOG_PAGE_SIZE
+    #define FILE_LOG_PAGE_SIZE          256
+#endif
+// Size of the RAM buffer (should be a multiple of FILE_LOG_PAGE_SIZE)
+#ifndef FILE_LOG_BUFFER_SIZE
+    #define FILE_LOG_BUFFER_SIZE        1024
+#endif
+// Max. time (ms) an entry stays in the RAM buffer
+#ifndef FILE_LOG_FLUSH_INTERVAL
+    #define FILE_LOG_FLUSH_INTERVAL     10000
+#endif
+
+class CFileLogWriter;
+
+/**
+ * @brief Reads the log files from the oldest to the newest entry in small parts.
+ *        Used to stream the log without loading whole files.
+ */
+class CFileLogReader {
+    private:
+        CFileLogWriter *m_pWriter;
+        unsigned long   m_ulGeneration;         // Generation of the file to read
+        size_t          m_nOffset;              // Offset in this file
+    public:
+        /**
+         * @brief Create a reader for the last bytes of the log.
+         * @param pWriter Writer of the log files (flushed first).
+         * @param nMaxBytes Max. number of bytes to read, 0 = the whole log.
+         */
+        CFileLogReader(CFileLogWriter *pWriter, size_t nMaxBytes = 0);
+        /// @brief Read the next part of the log, returns 0 at the end of the log.
+        size_t read(uint8_t *pBuffer, size_t nMaxLen);
+};
+
+/**
+ * @brief Log writer, that writes the entries into rotating log files.
+ */
+class CFileLogWriter : public CLogWriter {
+    friend class CFileLogReader;
+    private:
+        String          m_strBaseName;
+        char            m_tBuffer[FILE_LOG_BUFFER_SIZE];
+        size_t          m_nBuffered      = 0;
+        unsigned long   m_ulFirstBuffered = 0;  // millis() of the oldest buffered entry
+        unsigned long   m_ulGeneration   = 0;   // Number of the current file (file = generation % count)
+        size_t          m_nFileSize      = 0;   // Size of the current file
+        bool            m_bOpened        = false;
+
+        unsigned long   m_ulWrites       = 0;   // Write calls to the file system
+        unsigned long   m_ulBytes        = 0;   // Bytes written to the file system
+        unsigned long   m_ulRotations    = 0;
+        unsigned long   m_ulErrors       = 0;
+
+        void   open();
+        void   write(size_t nLen);
+        void   append(const char *pszData, size_t nLen);
+        void   rotate();
+        String getFileName(unsigned long ulGeneration);
+
+    public:
+        /// @brief Create a writer for the log files "<pszBaseName>.0" ...
+        CFileLogWriter(const char *pszBaseName = FILE_LOG_BASE_NAME);
+        virtual ~CFileLogWriter();
+
+        /// @brief Write the page aligned part of the buffer, or all if bAll is true.
+        void flush(bool bAll = true);
+        /// @brief Remove all log files.
+        void clear();
+
+        /// @brief Generation of the current log file.
+        unsigned long getGeneration()   { open(); return(m_ulGeneration); }
+        /// @brief Generation of the oldest log file.
+        unsigned long getOldestGeneration();
+        /// @brief Size of a log file, 0 if it does not exist.
+        size_t getFileSize(unsigned long ulGeneration);
+        /// @brief Number of bytes in the RAM buffer.
+        size_t getBuffered()            { return(m_nBuffered); }
+        unsigned long getWrites()       { return(m_ulWrites); }
+        unsigned long getBytes()        { return(m_ulBytes); }
+        unsigned long getRotations()    { return(m_ulRotations); }
+        unsigned long getErrors()       { return(m_ulErrors); }
+
+        /// @brief Flushes the buffer on MSG_APPL_LOOP (when due) and MSG_APPL_SHUTDOWN.
+        int  receiveEvent(const void * pSender, int nMsgType, const void * pMessage, int nClass) override;
+        /// @brief Add a text log entry to the buffer.
+        void writeLogEntry(const char *pszType, const char *pszMessage) override;
+        /// @brief Add a JSON log entry to the buffer.
+        void writeLogEntry(const char *pszType, JsonNode *pDoc) override;
+};
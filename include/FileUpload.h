@@ -0,0 +1,141 @@
+#pragma once
+/**
+ * Uploads of files to LittleFS
+ *
+ * The data of an upload arrives in TCP sized chunks. A CFileUpload collects
+ * them in a RAM buffer and writes it in multiples of the flash page size, so
+ * the file system gets a few large writes instead of many small ones. The
+ * content hash (the ETag of the file index) is computed while the data passes.
+ *
+ * The data is written to "<path>.<n>.tmp", n is counted per upload - so
+ * concurrent uploads of the same path do not share a temporary file. Only a
+ * complete upload replaces the file (rename), an aborted upload leaves the old
+ * file untouched.
+ *
+ * CFileUploads holds the uploads of the running requests by request and path,
+ * so a request can upload several files (multipart) and concurrent uploads
+ * do not share a file.
+ */
+#include <Runtime.h>
+#include <StatusHandler.h>
+#include <vector>
+#ifndef NATIVE_RUNTIME
+    #include <LittleFS.h>
+#endif
+
+// Flash page size, data is written in multiples of this size
+#ifndef FILE_UPLOAD_PAGE_SIZE
+    #define FILE_UPLOAD_PAGE_SIZE       256
+#endif
+// Size of the write buffer (a multiple of FILE_UPLOAD_PAGE_SIZE)
+#ifndef FILE_UPLOAD_BUFFER_SIZE
+    #define FILE_UPLOAD_BUFFER_SIZE     2048
+#endif
+// Max. number of concurrent uploads
+#ifndef FILE_UPLOAD_MAX
+    #define FILE_UPLOAD_MAX             2
+#endif
+// Extension of the file, the data is written to ("<path>.<n>.tmp")
+#define FILE_UPLOAD_TEMP_EXT            ".tmp"
+
+/**
+ * @brief Upload of one file, buffered and hashed while it is written.
+ */
+class CFileUpload {
+    private:
+        String      m_strPath;
+        String      m_strTempPath;
+        #ifdef NATIVE_RUNTIME
+            FILE *  m_pFile = nullptr;
+        #else
+            File    m_oFile;
+        #endif
+        uint8_t *   m_pBuffer   = nullptr;
+        size_t      m_nBuffered = 0;
+        size_t      m_nSize     = 0;
+        uint32_t    m_ulHash    = 0;
+        unsigned long m_ulWrites = 0;
+        bool        m_bOpen     = false;
+        bool        m_bFailed   = false;
+
+        bool writeBuffer(size_t nLen);
+        void closeFile();
+
+    public:
+        CFileUpload() {}
+        ~CFileUpload();
+        CFileUpload(const CFileUpload &) = delete;
+        CFileUpload & operator=(const CFileUpload &) = delete;
+
+        /// @brief Start the upload of a file, the data is written to "<path>.<n>.tmp".
+        bool begin(const char *pszPath);
+        /// @brief Add data of the upload.
+        bool write(const uint8_t *pData, size_t nLen);
+        /// @brief Write the rest of the data and replace the file. Returns false if the upload failed.
+        bool finish();
+        /// @brief Remove the temporary file, the file is not changed.
+        void abort();
+
+        const char *  getPath()     { return(m_strPath.c_str()); }
+        /// @brief Temporary file of the upload.
+        const char *  getTempPath() { return(m_strTempPath.c_str()); }
+        /// @brief Number of bytes received.
+        size_t        getSize()     { return(m_nSize); }
+        /// @brief Content hash (LSC::updateHash()), as used by the file index.
+        uint32_t      getHash()     { return(m_ulHash == 0 ? 1 : m_ulHash); }
+        /// @brief Number of writes to the file system.
+        unsigned long getWrites()   { return(m_ulWrites); }
+        bool          isOpen()      { return(m_bOpen); }
+        bool          hasFailed()   { return(m_bFailed); }
+};
+
+/**
+ * @brief The uploads of the running requests, found by their owner (request) and path.
+ *
+ * A slot is used while a file is received. The result of the files of an
+ * owner is kept until the owner is released, so a request with several files
+ * can report, if all of them have been written.
+ */
+class CFileUploads : public IStatusHandler {
+    private:
+        struct Slot {
+            const void *    Owner  = nullptr;
+            CFileUpload *   Upload = nullptr;
+        };
+        /// @brief Finished files of an owner.
+        struct Result {
+            const void *    Owner     = nullptr;
+            size_t          Completed = 0;
+            bool            Failed    = false;
+        };
+        Slot                m_tSlots[FILE_UPLOAD_MAX];
+        std::vector<Result> m_tResults;
+        unsigned long   m_ulCompleted = 0;
+        unsigned long   m_ulFailed    = 0;
+        unsigned long   m_ulRejected  = 0;
+
+        Result & getResult(const void *pOwner);
+        void     freeSlot(Slot &oSlot);
+
+    public:
+        ~CFileUploads();
+        /**
+         * @brief Start the upload of a file for the owner.
+         * A running upload of the owner for the same path is aborted, its other uploads continue.
+         * @return nullptr if all slots are in use or the file cannot be created (the owner has failed then).
+         */
+        CFileUpload * begin(const void *pOwner, const char *pszPath);
+        /// @brief The upload of a file of the owner, nullptr if there is none.
+        CFileUpload * get(const void *pOwner, const char *pszPath);
+        /// @brief Count a finished upload (CFileUpload::finish()) of the owner and free its slot.
+        void done(const void *pOwner, CFileUpload *pUpload);
+        /**
+         * @brief Delete the uploads of the owner - unfinished uploads are aborted.
+         * @return true if at least one file has been uploaded and no upload of the owner failed.
+         */
+        bool release(const void *pOwner);
+        /// @brief Number of running uploads.
+        size_t getActive();
+
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel = STATUS_LEVEL_INFO) override;
+};
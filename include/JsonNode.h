@@ -23,7 +23,17 @@
 #define SIMPLE_JSON_TYPE_OBJECT 1
 #define SIMPLE_JSON_TYPE_ARRAY  2
 
+// Max. nesting of decoded CBOR data
+#ifndef JSON_CBOR_MAX_DEPTH
+    #define JSON_CBOR_MAX_DEPTH 16
+#endif
+
+class CJsonTextWriter;
+class CJsonCborWriter;
+class CJsonSerializer;
+
 class CJsonNode {
+    friend class CJsonSerializer;
 public:
     /// @brief JSON node kind used by the lightweight tree implementation.
     enum ELEMENT_TYPE {
@@ -58,6 +68,12 @@ protected:
     const char * serializeNode(String & strResultString, int nIdentDeep = 0);
     /// @brief Append indentation spaces used by pretty JSON serialization.
     void         writeIdentPrefixString(String & strResultString, int nIdentDeep = 0);
+    /// @brief Recursively write this node as compact JSON into a text writer.
+    void         writeNode(CJsonTextWriter & oWriter);
+    /// @brief Recursively write this node as CBOR into a writer.
+    void         writeCbor(CJsonCborWriter & oWriter);
+    /// @brief Recursively read one CBOR item into this node.
+    const uint8_t * readCbor(const uint8_t *pData, const uint8_t *pEnd, int nDepth);
     /// @brief Convert this node into a scalar value and remember quote handling.
     void         setNodeValueType(bool bWriteWithQuotes = true);
     /// @brief Split a dotted JSON path and return the final element name.
@@ -215,6 +231,15 @@ public:
     /// @brief Remove and delete the direct child with the given name.
     void       remove(const char* pszName);
 
+    /// @brief Replace the content of this node by a deep copy of the source (the name is kept).
+    void       copyFrom(CJsonNode & oSource);
+    /// @brief Merge the source into this node - objects are merged, all other nodes replaced.
+    void       merge(CJsonNode & oSource);
+    /// @brief Return true if both node trees have the same content (object elements in the same order).
+    bool       isEqual(CJsonNode & oOther);
+    /// @brief Make this node the merge patch (RFC 7386), that turns oOld into oNew - returns false if nothing changed.
+    bool       createMergePatch(CJsonNode & oOld, CJsonNode & oNew);
+
     /// @brief Store a quoted string value in this node.
     CJsonNode* setValue(const char  *   pszValue);
     /// @brief Store a quoted String value in this node.
@@ -276,5 +301,51 @@ public:
     const char* getAsJsonText();
     /// @brief Serialize this node tree as pretty-printed JSON.
     const char* getAsJsonTextPretty();
+    /// @brief Length of the compact JSON text (without terminator), nothing is allocated.
+    size_t measureJson();
+    /// @brief Serialize this node tree as compact JSON into a buffer, returns the full length.
+    size_t serializeTo(char *pBuffer, size_t nBufferSize);
+    /// @brief Length of the CBOR encoding (RFC 8949) of this node tree, nothing is allocated.
+    size_t measureCbor();
+    /// @brief Encode this node tree as CBOR into a buffer, returns the full length.
+    size_t serializeCborTo(uint8_t *pBuffer, size_t nBufferSize);
+    /// @brief Decode one CBOR item into this node tree, returns the number of bytes read (0 = invalid).
+    size_t parseCbor(const uint8_t *pData, size_t nLen);
 };
 
+/**
+ * @brief Serializes a node tree as compact JSON in parts.
+ *
+ * The position in the tree is kept between the parts, so each part continues
+ * where the last one stopped - the tree is walked once, however many parts are
+ * read, and the text of the whole tree is never built. The text is the same
+ * as getAsJsonText(). The tree must not be changed while it is serialized.
+ */
+class CJsonSerializer {
+    private:
+        /// @brief Node being written and the index of its next child.
+        struct Frame {
+            CJsonNode * Node;
+            size_t      Child;
+            bool        Opened;
+        };
+        /// @brief Text to write, values are escaped.
+        struct Piece {
+            const char *Text;
+            size_t      Len;
+            bool        Escaped;
+        };
+        std::vector<Frame> m_tStack;
+        Piece   m_tPieces[4];
+        size_t  m_nPieces  = 0;
+        size_t  m_nPiece   = 0;                 // Piece to write next
+        char    m_cPending = 0;                 // Escaped char, the backslash of it ended the last part
+
+        void addPiece(const char *pszText, size_t nLen, bool bEscaped = false);
+        bool next();
+
+    public:
+        CJsonSerializer(CJsonNode *pRoot);
+        /// @brief Write the next part of the text (no terminator), returns 0 at the end of the text.
+        size_t read(char *pBuffer, size_t nMaxLen);
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include "Runtime.h"
 
+// Start value of updateHash() (FNV-1a offset basis)
+#define LSC_HASH_START 2166136261UL
+
 namespace LSC {
 
     char * getCurrentISODateTime(char *pszBuffer, int nBufferLen);
@@ -10,6 +13,9 @@ namespace LSC {
     float getCelsiusFromFarenheit(float fTemp);
 
     int stricmp(const char *psz1, const char *psz2);
+    uint32_t getHash(const char *psz);
+    uint32_t getHashNoCase(const char *psz);
+    uint32_t updateHash(uint32_t ulHash, const void *pData, size_t nLen);
     int indexOf(const char *psz, const char cToken);
     int lastIndexOf(const char *psz, const char cToken);
 
@@ -18,6 +24,8 @@ namespace LSC {
     bool ICACHE_FLASH_ATTR isWhite(const char c);
     bool ICACHE_FLASH_ATTR isNumber(const char *psz);
     const char * ICACHE_FLASH_ATTR skipWhite(const char * psz);
+    bool isInList(const char *pszList, const char *pszName);
+    const char * getListItem(const char *pszList, char *pszItem, size_t nItemSize);
 
     int ICACHE_FLASH_ATTR parseBytesToArray(uint8_t *pBytes, const char * pszData, char cSep, int nMaxBytes, int nBase);
 
@@ -0,0 +1,114 @@
+#pragma once
+/**
+ * Asynchronous log ring
+ *
+ * Without the ring, CEventLogger sends every log record through the message bus and
+ * the writers write it synchronously (i.E. to Serial) - so a slow output stalls the
+ * caller, even inside an interrupt or network callback.
+ * With the ring, the logger formats the entry on the stack, copies it into a fixed
+ * size slot (no allocation) and returns. The application loop (MSG_APPL_LOOP)
+ * drains the ring under a time budget and sends the entries to the log writers.
+ *
+ * Producers may be the application task, other tasks or interrupt handlers, so
+ * the slots are guarded by a short critical section (copy only, no formatting).
+ */
+#include <Runtime.h>
+#include <EventHandler.h>
+#include <StatusHandler.h>
+#include <stdarg.h>
+#ifdef NATIVE_RUNTIME
+    #include <mutex>
+#endif
+
+// Number of slots in the ring
+#ifndef LOG_RING_SIZE
+    #define LOG_RING_SIZE           16
+#endif
+// Max. text length of one entry, longer texts are truncated
+#ifndef LOG_RING_TEXT_SIZE
+    #define LOG_RING_TEXT_SIZE      160
+#endif
+// Time budget (micro seconds) for draining the ring in one loop iteration
+#ifndef LOG_RING_DRAIN_BUDGET_US
+    #define LOG_RING_DRAIN_BUDGET_US 2000
+#endif
+
+/// @brief What to do with a new entry, if the ring is full.
+enum LogRingPolicy {
+    LOG_RING_DROP_OLDEST = 0,   // Overwrite the oldest entry (default)
+    LOG_RING_DROP_NEW    = 1,   // Drop the new entry
+    LOG_RING_BLOCK       = 2    // Write the oldest entry synchronously, then add (drop new in an ISR)
+};
+
+/**
+ * @brief Fixed size ring of formatted log entries.
+ */
+class CLogRing : public IMsgEventReceiver, public IStatusHandler {
+    private:
+        struct LogRingEntry {
+            char Type;
+            char Text[LOG_RING_TEXT_SIZE];
+        };
+        LogRingEntry    m_tSlots[LOG_RING_SIZE];
+        size_t          m_nHead  = 0;           // Oldest entry
+        size_t          m_nCount = 0;           // Number of entries in the ring
+        CEventHandler * m_pEventHandler;
+        LogRingPolicy   m_ePolicy = LOG_RING_DROP_OLDEST;
+        bool            m_bDraining = false;
+
+        unsigned long   m_ulWritten   = 0;      // Entries added to the ring
+        unsigned long   m_ulDropped   = 0;      // Entries lost (overwritten or rejected)
+        unsigned long   m_ulTruncated = 0;      // Entries longer than LOG_RING_TEXT_SIZE
+        unsigned long   m_ulBlocked   = 0;      // Entries written synchronously (LOG_RING_BLOCK)
+        size_t          m_nHighWater  = 0;      // Max. number of entries in the ring
+
+        #ifdef NATIVE_RUNTIME
+            std::mutex  m_oLock;
+        #elif defined(ESP32)
+            portMUX_TYPE m_tLock = portMUX_INITIALIZER_UNLOCKED;
+        #else
+            uint32_t    m_ulSavedPS = 0;
+        #endif
+        bool pop(char &cType, char *pszText);
+        void send(char cType, const char *pszText);
+
+    public:
+        /// @brief Create a ring, the entries are sent to the event handler.
+        CLogRing(CEventHandler *pEventHandler) : m_pEventHandler(pEventHandler) {}
+
+        /// @brief Enter the critical section of the ring (short, no formatting inside).
+        ///        The logger checks its suppression table in it, as the producers do not share another lock.
+        void lock();
+        /// @brief Leave the critical section of the ring.
+        void unlock();
+
+        /// @brief Set the overflow policy.
+        void setPolicy(LogRingPolicy ePolicy)   { m_ePolicy = ePolicy; }
+        /// @brief Get the overflow policy.
+        LogRingPolicy getPolicy()               { return(m_ePolicy); }
+
+        /// @brief Add a log entry, the text is copied into a slot.
+        bool push(char cType, const char *pszText);
+        /// @brief Format a log entry (on the stack) and add it.
+        bool pushFormatted(char cType, const char *pszFormat, va_list *pArgs);
+        /// @brief Send the queued entries to the writers, until the time budget is used.
+        size_t drain(unsigned long ulBudgetMicros = LOG_RING_DRAIN_BUDGET_US);
+        /// @brief Send all queued entries to the writers (i.E. before reboot).
+        size_t flush();
+
+        /// @brief Number of queued entries.
+        size_t size()                           { return(m_nCount); }
+        /// @brief Max. number of entries.
+        size_t capacity()                       { return(LOG_RING_SIZE); }
+        unsigned long getWritten()              { return(m_ulWritten); }
+        unsigned long getDropped()              { return(m_ulDropped); }
+        unsigned long getTruncated()            { return(m_ulTruncated); }
+        unsigned long getBlocked()              { return(m_ulBlocked); }
+        size_t        getHighWater()            { return(m_nHighWater); }
+
+        /// @brief Drains the ring on MSG_APPL_LOOP.
+        int  receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nClass) override;
+        /// @brief Writes the ring counters.
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel = STATUS_LEVEL_INFO) override;
+        bool hasStatusValues(int nLevel = STATUS_LEVEL_INFO) override { return(nLevel >= STATUS_LEVEL_INFO); }
+};
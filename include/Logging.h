@@ -2,7 +2,9 @@
 
 #include <stdarg.h>
 #include <EventHandler.h>
+#include <JsonNode.h>
 #include <Msgs.h>
+#include <LogRing.h>
 
 #define logInfo(s,...)      log("I",s, ##__VA_ARGS__)
 #define logVerbose(s,...)   log("V",s, ##__VA_ARGS__)
@@ -17,33 +19,249 @@
 #define LOG_CLASS_LEVEL_MASK  ".IV..TWEDX"
 #define LOG_CLASS_TYPE_ALWAYS "WEX"  
 
+// Log class numbers (index in LOG_CLASS_LEVEL_MASK), to be used in #if
+#define LOG_CLASS_NO_INFO       1
+#define LOG_CLASS_NO_VERBOSE    2
+#define LOG_CLASS_NO_TRACE      5
+#define LOG_CLASS_NO_WARNING    6
+#define LOG_CLASS_NO_ERROR      7
+#define LOG_CLASS_NO_DEBUG      8
+#define LOG_CLASS_NO_EXCEPTION  9
 
-/// @brief Logger facade that sends formatted log events through CEventHandler.
+
+#ifndef LOG_ENTRY_BUFFER_SIZE
+    #define LOG_ENTRY_BUFFER_SIZE  512
+#endif
+// Max. number of fields of a structured log entry (logKV)
+#ifndef LOG_KV_MAX_FIELDS
+    #define LOG_KV_MAX_FIELDS      8
+#endif
+
+/**
+ * @brief Fields of a structured log entry (see CEventLogger::logKV()).
+ *
+ * A flat record on the stack - names and string values are not copied, so the
+ * record is valid during the log call only. Writers render it as text or JSON.
+ */
+class CLogFields {
+    public:
+        /// @brief One name/value pair.
+        struct LogField {
+            const char * Name;
+            char         Type;          // 'i' signed, 'u' unsigned (64 bit), 'f' double, 'b' bool, 's' string
+            union {
+                long long           lValue;
+                unsigned long long  ulValue;
+                double          dValue;
+                bool            bValue;
+                const char *    pszValue;
+            };
+        };
+    private:
+        const char * m_pszEvent;
+        LogField     m_tFields[LOG_KV_MAX_FIELDS];
+        size_t       m_nFields  = 0;
+        size_t       m_nDropped = 0;    // Fields beyond LOG_KV_MAX_FIELDS
+        LogField *   addField(const char *pszName, char cType);
+    public:
+        /// @brief Create a record for an event name.
+        CLogFields(const char *pszEvent) : m_pszEvent(pszEvent) {}
+
+        void set(const char *pszName, int nValue)               { LogField *p = addField(pszName,'i'); if(p) p->lValue   = nValue; }
+        void set(const char *pszName, long lValue)              { LogField *p = addField(pszName,'i'); if(p) p->lValue   = lValue; }
+        void set(const char *pszName, unsigned int unValue)     { LogField *p = addField(pszName,'u'); if(p) p->ulValue  = unValue; }
+        void set(const char *pszName, unsigned long ulValue)    { LogField *p = addField(pszName,'u'); if(p) p->ulValue  = ulValue; }
+        void set(const char *pszName, long long llValue)        { LogField *p = addField(pszName,'i'); if(p) p->lValue   = llValue; }
+        void set(const char *pszName, unsigned long long ullValue) { LogField *p = addField(pszName,'u'); if(p) p->ulValue = ullValue; }
+        void set(const char *pszName, double dValue)            { LogField *p = addField(pszName,'f'); if(p) p->dValue   = dValue; }
+        void set(const char *pszName, bool bValue)              { LogField *p = addField(pszName,'b'); if(p) p->bValue   = bValue; }
+        void set(const char *pszName, const char *pszValue)     { LogField *p = addField(pszName,'s'); if(p) p->pszValue = pszValue; }
+        void set(const char *pszName, const String &strValue)   { set(pszName,strValue.c_str()); }
+
+        /// @brief Add name/value pairs.
+        void add() {}
+        template <typename TValue, typename... TRest>
+        void add(const char *pszName, const TValue &tValue, const TRest &... tRest) {
+            static_assert(sizeof...(TRest) % 2 == 0, "logKV() needs name/value pairs");
+            set(pszName,tValue);
+            add(tRest...);
+        }
+
+        /// @brief Name of the event.
+        const char * getEvent()             { return(m_pszEvent); }
+        /// @brief Number of fields.
+        size_t       getCount()             { return(m_nFields); }
+        /// @brief Field by index.
+        LogField &   getField(size_t nIdx)  { return(m_tFields[nIdx]); }
+
+        /// @brief Render as text: event name=value name="text" ...
+        size_t renderText(char *pszBuffer, size_t nBufferSize);
+        /// @brief Render as JSON object: {"event":"...","name":value,...}
+        size_t renderJson(char *pszBuffer, size_t nBufferSize);
+};
+
+/**
+ * @brief Log entry as sent by CEventLogger (payload of MSG_LOG_RECORD).
+ *
+ * The record holds the format string and the arguments of the log call. The text
+ * is formatted on the first call of getText() - so only if a writer really writes
+ * the entry - and only once, even if more writers write it.
+ * The record is valid during the sendEvent() call only.
+ */
+class CLogRecord {
+    private:
+        char         m_cType;
+        const char * m_pszFormat;
+        va_list    * m_pArgs;
+        char       * m_pszBuffer;
+        size_t       m_nBufferSize;
+        bool         m_bFormatted = false;
+        CLogFields * m_pFields    = nullptr;
+    public:
+        /// @brief Create a record, the text is formatted into pszBuffer when needed.
+        CLogRecord(char cType, const char *pszFormat, va_list *pArgs, char *pszBuffer, size_t nBufferSize)
+            : m_cType(cType), m_pszFormat(pszFormat), m_pArgs(pArgs), m_pszBuffer(pszBuffer), m_nBufferSize(nBufferSize) {}
+        /// @brief Create a record of a structured entry, the text is rendered into pszBuffer when needed.
+        CLogRecord(char cType, CLogFields *pFields, char *pszBuffer, size_t nBufferSize)
+            : m_cType(cType), m_pszFormat(pFields->getEvent()), m_pArgs(nullptr), m_pszBuffer(pszBuffer), m_nBufferSize(nBufferSize), m_pFields(pFields) {}
+        /// @brief Create a record of an already formatted text (i.E. from CLogRing).
+        CLogRecord(char cType, const char *pszText)
+            : m_cType(cType), m_pszFormat(pszText), m_pArgs(nullptr), m_pszBuffer((char *) pszText), m_nBufferSize(0), m_bFormatted(true) {}
+        /// @brief Log class character ('I','W',...).
+        char         getType()      { return(m_cType); }
+        /// @brief Format string of the log call (may be a flash string).
+        const char * getFormat()    { return(m_pszFormat); }
+        /// @brief Return true if the text has already been formatted.
+        bool         isFormatted()  { return(m_bFormatted); }
+        /// @brief Fields of a structured entry (logKV), nullptr for text entries.
+        CLogFields * getFields()    { return(m_pFields); }
+        /// @brief Return the formatted text.
+        const char * getText();
+};
+
+// Number of entries in the repeat suppression table (power of 2, min. 2)
+#ifndef LOG_SUPPRESS_TABLE_SIZE
+    #define LOG_SUPPRESS_TABLE_SIZE  16
+#endif
+// Repeats of a log call within this time (ms) are collapsed, 0 = no suppression (default).
+// Opt-in: a call site is keyed by its format string, so calls with other arguments are collapsed too.
+#ifndef LOG_SUPPRESS_WINDOW
+    #define LOG_SUPPRESS_WINDOW      0
+#endif
+
+/// @brief Number of suppressed repeats of a log call, reported as "last message repeated N times".
+struct LogRepeatReport {
+    char          Type    = 0;
+    unsigned long Repeats = 0;
+};
+
+/**
+ * @brief Suppression of repeated log calls and sampling per log class.
+ *
+ * A log call is identified by the address of its format string and the log class
+ * (the text is not formatted yet), so a flooding call site costs one lookup in a
+ * small two-way associative table. The first call passes, repeats within the window are
+ * counted and reported, when the window is over or the table entry is reused.
+ * Off by default - enable it with LOG_SUPPRESS_WINDOW or setWindow().
+ * Sampling passes only every n-th entry of a log class.
+ */
+class CLogSuppressor {
+    private:
+        struct SuppressEntry {
+            const void *  Key     = nullptr;
+            char          Type    = 0;
+            unsigned long Start   = 0;      // millis() of the first call in the window
+            unsigned long Repeats = 0;
+        };
+        SuppressEntry   m_tEntries[LOG_SUPPRESS_TABLE_SIZE];
+        unsigned long   m_ulWindow     = LOG_SUPPRESS_WINDOW;
+        uint16_t        m_tSampleEvery[10];
+        uint16_t        m_tSampleCount[10];
+        size_t          m_nPending     = 0; // Entries with unreported repeats
+        unsigned long   m_ulSuppressed = 0;
+        unsigned long   m_ulSampledOut = 0;
+        void takeReport(SuppressEntry &oEntry, LogRepeatReport &oReport);
+    public:
+        CLogSuppressor();
+        /// @brief Set the suppression window (ms), 0 = no suppression.
+        void setWindow(unsigned long ulWindow)  { m_ulWindow = ulWindow; }
+        /// @brief Pass only every n-th entry of a log class (1 = all).
+        void setSampling(char cType, uint16_t nEvery);
+        /// @brief Check a log call - oReport receives the repeats of a replaced entry.
+        bool accept(char cType, const void *pKey, LogRepeatReport &oReport);
+        /// @brief Take the repeats of an entry, whose window is over.
+        bool takeExpired(LogRepeatReport &oReport);
+        /// @brief Number of suppressed repeats.
+        unsigned long getSuppressed()           { return(m_ulSuppressed); }
+        /// @brief Number of entries dropped by sampling.
+        unsigned long getSampledOut()           { return(m_ulSampledOut); }
+};
+
+/**
+ * @brief Logger facade that sends log records through CEventHandler.
+ *
+ * The entries are sent as MSG_LOG_RECORD, only for log classes written by a
+ * CLogWriter. Receivers of the formatted text (MSG_LOG_ENTRY) are not fed by
+ * the logger - see doc/Logging.md.
+ */
 class CEventLogger {
     private:
         CEventHandler * pEventHandler;
+        CLogRing      * m_pRing = nullptr;
+        void sendRecord(char cType, const char *pszFormat, va_list *pArgs);
+        void sendFields(char cType, CLogFields &oFields);
+        void sendText(char cType, const char *pszFormat, ...);
+        bool isSuppressed(char cType, const void *pKey);
     public:
+        /// @brief Suppression of repeated log calls and sampling (configuration and counters).
+        CLogSuppressor Suppressor;
+
         /// @brief Create a logger without an attached event handler.
         CEventLogger();
         /// @brief Create a logger that publishes to the given event handler.
         CEventLogger(CEventHandler * pEventHandler);
+        /// @brief Create a logger that queues the entries in a log ring, drained into the event handler.
+        CEventLogger(CEventHandler * pEventHandler, CLogRing * pRing);
+        /// @brief Return the log ring, or nullptr if entries are sent synchronously.
+        CLogRing * getRing() { return(m_pRing); }
 
         /// @brief Convert a log class character into its numeric message class.
         static int  getLogClassNumberFrom(const char cClass);
         /// @brief Convert a numeric message class back to its log class character.
         static char getClassCharFromLogClass(int nClassNo);
+        /// @brief Return true if any log writer writes entries of this class.
+        static bool isClassEnabled(const char cClass);
+        /// @brief Report suppressed repeats, whose window is over (call it in the loop).
+        void flushRepeats();
 
-        /// @brief Format and publish a flash-string log message.
+        /// @brief Publish a flash-string log message, formatted by the writers.
         void log(const char* pszType, const __FlashStringHelper* pszMessage, ...);
-        /// @brief Format and publish a C-string log message.
+        /// @brief Publish a C-string log message, formatted by the writers.
         void log(const char* pszType, const char *pszMessage, ...);
         /// @brief Publish a JSON document as log payload.
         void log(const char* strType, JsonNode *pDoc);
+
+        /**
+         * @brief Publish a structured log entry, i.E. logKV("W","mqtt_disconnect","reason",n,"uptime",t)
+         * @param pszType Log class string. The first character is used.
+         * @param pszEvent Name of the event.
+         * @param tFields Name/value pairs (names are strings, values numbers, bools or strings).
+         */
+        template <typename... TFields>
+        void logKV(const char *pszType, const char *pszEvent, const TFields &... tFields) {
+            char cType = pszType == nullptr ? 'I' : pszType[0];
+            if(!pEventHandler || !isClassEnabled(cType) || isSuppressed(cType,pszEvent)) return;
+            CLogFields oFields(pszEvent);
+            oFields.add(tFields...);
+            sendFields(cType,oFields);
+        }
 };
 
 
 /// @brief Class to handle the logging for a module
 ///      This class is used to write log entries for a specific module
+///      All writers are known by the logger, so log calls for classes that no
+///      writer writes, are dropped before they are formatted.
 class CLogWriter : public IMsgEventReceiver {
     
     private:
@@ -53,21 +271,30 @@ class CLogWriter : public IMsgEventReceiver {
         char m_nLogLevel = 3; 
         bool isTypeToWriteAlways(const char cType);
         bool isLogLevelToWrite(const char cType);
+        static void updateAcceptedClasses();
     public:
-        CLogWriter(){};
+        CLogWriter();
+        virtual ~CLogWriter();
         /// @brief Set the maximum log level written by this writer.
         int setLogLevel(int nLogLevel);
         /// @brief Return the currently configured maximum log level.
         int getLogLevel();
+        /// @brief Return true if this writer writes entries of the log class.
+        bool isClassToWrite(const char cType);
+        /// @brief Bit mask of the log class numbers written by any writer.
+        static uint16_t getAcceptedClasses();
         /// @brief Receive log events from the message bus and write matching entries.
         virtual int  receiveEvent(const void * pSender, int nMsgType, const void * pMessage, int nClass) override;   
 
+        /// @brief Write a log record, the default formats the text and calls writeLogEntry().
+        virtual void writeLogRecord(const char *strType, CLogRecord *pRecord);
         /// @brief Write a text log entry to the concrete output.
         virtual void writeLogEntry(const char *strType, const char *strMessage);
         /// @brief Write a JSON log entry to the concrete output.
         virtual void writeLogEntry(const char *strType, JsonNode *oDoc);
 };
 
+#ifndef NATIVE_RUNTIME
 /// @brief Log writer that prints log entries to an Arduino Stream.
 class CStreamLogWriter : public CLogWriter {
     private:
@@ -87,3 +314,4 @@ class CSerialLogWriter : public CStreamLogWriter {
     public:
         CSerialLogWriter() : CStreamLogWriter(&Serial){}
 };
+#endif
@@ -27,13 +27,27 @@
 #include <NamedValueTable.h>
 #include <SimpleDelay.h>
 
-#include <queue>
+#include <MsgQueue.h>
+#include <EventHandler.h>
+#include <BatchLogWriter.h>
+
+#ifndef MQTT_MSG_QUEUE_SIZE
+    #define MQTT_MSG_QUEUE_SIZE 16
+#endif
+// Max. number of queued connect/disconnect events of the MQTT callbacks
+#ifndef MQTT_CONNECTION_QUEUE_SIZE
+    #define MQTT_CONNECTION_QUEUE_SIZE 4
+#endif
 
 
 #define MQTT_STATE_AVAILABLE       "online"
 #define MQTT_STATE_UNAVAILABLE     "offline"
 #define MQTT_STATE_BOOTING         "booting"
 
+#ifndef MQTT_MSG_TOPIC_LOG
+    #define MQTT_MSG_TOPIC_LOG     "log"
+#endif
+
 class MQTTMessage;
 class CMQTTController;
 
@@ -83,6 +97,14 @@ struct MQTTStatus {
     String                           DisConReasonString;
 };
 
+/// @brief Connect or disconnect of the MQTT callbacks, handled by the application loop.
+struct MQTTConnectionEvent {
+    bool            Connected      = false;
+    bool            SessionPresent = false;
+    AsyncMqttClientDisconnectReason Reason = AsyncMqttClientDisconnectReason::TCP_DISCONNECTED;
+    unsigned long   Time           = 0;         // millis() of the callback
+};
+
 /**
  * Implement if needed
  * 
@@ -117,7 +139,8 @@ class CMQTTController : public AsyncMqttClient, public ApplModule {
         char * m_pszPublishAvailabilityTopic = nullptr;
 
         unsigned long m_ulLastHeartBeat = 0;
-        std::queue<MQTTMessage * > m_tMessageQeue; // FiFo queue with Message pointer...
+        CSPSCQueue<MQTTMessage *,MQTT_MSG_QUEUE_SIZE> m_tMessageQeue; // Producer: MQTT callback, consumer: application loop
+        CSPSCQueue<MQTTConnectionEvent,MQTT_CONNECTION_QUEUE_SIZE> m_tConnectionEvents; // Producer: MQTT callbacks, consumer: application loop
         CNamedValueTable<IHomeAssistantComponent *> m_tComponentHandlerByName;
         CSimpleDelay m_oTryConnectDelay;
 
@@ -174,6 +197,8 @@ class CMQTTController : public AsyncMqttClient, public ApplModule {
         void onMqttConnect(bool sessionPresent);
         /// @brief AsyncMqttClient disconnect callback.
         void onMqttDisconnect(AsyncMqttClientDisconnectReason reason);
+        /// @brief Update the status, log and send the queued connect/disconnect events (application loop).
+        void dispatchConnectionEvents();
         /// @brief AsyncMqttClient message callback.
         void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total);
 
@@ -207,10 +232,9 @@ class MQTTMessage {
         Topic = strdup(pszTopic);
         Message = strdup(pszMessage);
         if(isDeviceCommandTopic()) {
-            String strDeviceCmdTopic = pszTopic;
             size_t nPublishTopicLength = pController ? strlen(pController->getDeviceCommandBaseTopicPath()) : 0;
-            strDeviceCmdTopic.remove(0,nPublishTopicLength + 1); // Remove the command topic prefix and the following slash 
-            DeviceCmdTopic = strdup(strDeviceCmdTopic.c_str());
+            // Skip the command topic prefix and the following slash
+            DeviceCmdTopic = strdup(strlen(pszTopic) > nPublishTopicLength ? pszTopic + nPublishTopicLength + 1 : "");
         } else {
             DeviceCmdTopic = nullptr;
         }
@@ -224,6 +248,9 @@ class MQTTMessage {
         if(Topic) {
             free(Topic);
         }
+        if(DeviceCmdTopic) {
+            free(DeviceCmdTopic);
+        }
     }
 
     /// @brief Return true if this message topic belongs to the device prefix.
@@ -259,3 +286,31 @@ inline bool CMQTTController::isDeviceCommandTopic(const char *pszTopic) {
     return(bIsCommandTopic);
 }
 #endif
+
+/**
+ * @brief Gets the cached base topic for device commands.
+ * @return PublishTopicPrefix + "/cmd".
+ */
+inline const char * CMQTTController::getDeviceCommandBaseTopicPath() {
+    if(m_pszDeviceCommandTopics == nullptr) {
+        m_pszDeviceCommandTopics = strdup((Config.PublishTopicPrefix + "/cmd").c_str());
+    }
+    return(m_pszDeviceCommandTopics);
+}
+
+/**
+ * @brief Log writer, that publishes the log entries in batches to a device topic
+ *        (diagnostics topic, default "<prefix>/log").
+ */
+class CMQTTLogWriter : public CBatchLogWriter {
+    private:
+        CMQTTController *m_pController;
+        const char      *m_pszTopic;
+    protected:
+        bool isReady() override;
+        void sendBatch(JsonNode &oBatch) override;
+    public:
+        /// @brief Create a log writer for a device topic (static string) of the controller.
+        CMQTTLogWriter(CMQTTController *pController, const char *pszTopic = MQTT_MSG_TOPIC_LOG)
+            : m_pController(pController), m_pszTopic(pszTopic) {}
+};
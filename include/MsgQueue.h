@@ -0,0 +1,73 @@
+#pragma once
+/**
+ * Lock free message queue
+ *
+ * On ESP32 the network callbacks (AsyncTCP, AsyncMqttClient, WiFi) run on another
+ * FreeRTOS task than loop(). Each producer (callback context) gets its own queue,
+ * the application task is the only consumer. With exactly one producer and one
+ * consumer per queue, no lock is needed - only the read and write index are shared.
+ *
+ * The capacity is fixed (no allocation after construction), push() returns false
+ * when the queue is full, so the producer can drop (and count) the message.
+ */
+#include <Runtime.h>
+#include <atomic>
+
+/**
+ * @brief Single producer / single consumer ring buffer.
+ * @tparam TValue Element type (usually a pointer to the message object).
+ * @tparam nCapacity Max. number of elements in the queue.
+ */
+template <typename TValue, size_t nCapacity>
+class CSPSCQueue {
+    private:
+        static const size_t SLOTS = nCapacity + 1;    // One slot stays free to detect "full"
+        TValue              m_tSlots[SLOTS];
+        std::atomic<size_t> m_nHead { 0 };              // Next slot to read, written by the consumer only
+        std::atomic<size_t> m_nTail { 0 };              // Next slot to write, written by the producer only
+        std::atomic<unsigned long> m_ulDropped { 0 };   // Rejected pushes, written by the producer only
+
+    public:
+        /**
+         * @brief Adds an element (producer side).
+         * @return true if added, false if the queue is full.
+         */
+        bool push(const TValue &tValue) {
+            size_t nTail = m_nTail.load(std::memory_order_relaxed);
+            size_t nNext = (nTail + 1) % SLOTS;
+            if(nNext == m_nHead.load(std::memory_order_acquire)) {
+                m_ulDropped.store(m_ulDropped.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+                return(false);
+            }
+            m_tSlots[nTail] = tValue;
+            m_nTail.store(nNext,std::memory_order_release);
+            return(true);
+        }
+
+        /**
+         * @brief Removes the oldest element (consumer side).
+         * @return true if an element was read into tValue.
+         */
+        bool pop(TValue &tValue) {
+            size_t nHead = m_nHead.load(std::memory_order_relaxed);
+            if(nHead == m_nTail.load(std::memory_order_acquire)) return(false);
+            tValue = m_tSlots[nHead];
+            m_nHead.store((nHead + 1) % SLOTS,std::memory_order_release);
+            return(true);
+        }
+
+        /// @brief Return true if no element is queued (snapshot).
+        bool empty() {
+            return(m_nHead.load(std::memory_order_acquire) == m_nTail.load(std::memory_order_acquire));
+        }
+        /// @brief Number of queued elements (snapshot).
+        size_t size() {
+            size_t nHead = m_nHead.load(std::memory_order_acquire);
+            size_t nTail = m_nTail.load(std::memory_order_acquire);
+            return((nTail + SLOTS - nHead) % SLOTS);
+        }
+        /// @brief Max. number of elements.
+        size_t capacity()           { return(nCapacity); }
+        /// @brief Number of elements rejected, because the queue was full.
+        unsigned long getDropped()  { return(m_ulDropped.load(std::memory_order_relaxed)); }
+};
@@ -0,0 +1,132 @@
+#pragma once
+/**
+ * Message bus recorder and replayer
+ *
+ * The recorder is attached to a message bus (CEventHandler::setEventRecorder()) and
+ * writes every top level event as one text line into a buffer (and optionally a file).
+ * The replayer reads these lines and sends the events again into a message bus
+ * with real modules registered - in original or accelerated speed.
+ * With profiling enabled on the message bus, this gives a repeatable benchmark
+ * of the loop costs, independend of WiFi, MQTT or button timing.
+ *
+ * Record format (one event per line, fields separated by TAB):
+ *   <ms since start> <msg> <class> <sender name> <kind> [payload fields]
+ *
+ * Payload kinds:
+ *   N  no payload (or payload not serializable, pointer is not recorded)
+ *   T  text (const char *)
+ *   J  JsonNode, serialized as compact json text
+ *   W  CWebSocketMessage, <message type> <text>
+ *   M  MQTTMessage, <topic> <message>
+ *   L  CLogRecord, recorded as formatted text with message MSG_LOG_ENTRY (replayed as T)
+ *
+ * TAB, CR, LF and backslash in payloads are escaped with a backslash.
+ */
+#include <Runtime.h>
+#include <EventHandler.h>
+#include <Msgs.h>
+#include <vector>
+
+#ifndef MSG_RECORDER_BUFFER_SIZE
+    #define MSG_RECORDER_BUFFER_SIZE    4096
+#endif
+
+#define MSG_PAYLOAD_NONE            'N'
+#define MSG_PAYLOAD_TEXT            'T'
+#define MSG_PAYLOAD_JSONNODE        'J'
+#define MSG_PAYLOAD_WEBSOCKET       'W'
+#define MSG_PAYLOAD_MQTT            'M'
+#define MSG_PAYLOAD_LOG_RECORD      'L'
+
+/**
+ * @brief Records the events of a message bus as text lines.
+ *        Register with CEventHandler::setEventRecorder() - not as normal receiver,
+ *        so nested events (i.E. log entries) are not recorded twice.
+ */
+class CMsgBusRecorder : public IMsgEventReceiver {
+    private:
+        CEventHandler * m_pEventHandler;
+        String          m_strBuffer;
+        size_t          m_nMaxBufferSize;
+        unsigned long   m_ulStartTime       = 0;
+        bool            m_bRecording        = false;
+        unsigned long   m_ulRecorded        = 0;
+        unsigned long   m_ulDropped         = 0;
+        const char    * m_pszFileName       = nullptr;
+        std::vector<std::pair<int,char>> m_tPayloadKinds;
+
+        void appendEscaped(const char *pszData);
+    public:
+        /// @brief Create a recorder for the message bus, the buffer is flushed when nMaxBufferSize is reached.
+        CMsgBusRecorder(CEventHandler * pEventHandler, size_t nMaxBufferSize = MSG_RECORDER_BUFFER_SIZE);
+        ~CMsgBusRecorder();
+
+        /// @brief Register this recorder on the message bus and start recording.
+        void start(const char *pszFileName = nullptr);
+        /// @brief Stop recording, flush the buffer and unregister from the message bus.
+        void stop();
+        /// @brief Write the buffered records into the file (if any) and clear the buffer.
+        bool flush();
+        /// @brief Return true while recording.
+        bool isRecording()          { return(m_bRecording); }
+
+        /// @brief Define the payload kind of an (application) message number (MSG_PAYLOAD_xxx).
+        void setPayloadKind(int nMsg, char cKind);
+        /// @brief Get the payload kind of a message number.
+        char getPayloadKind(int nMsg);
+
+        /// @brief Records that are currently in the buffer (not flushed into a file).
+        const char * getRecords()   { return(m_strBuffer.c_str()); }
+        /// @brief Number of recorded events since start().
+        unsigned long getRecordCount()  { return(m_ulRecorded); }
+        /// @brief Number of events lost, because the buffer was full and no file was specified.
+        unsigned long getDroppedCount() { return(m_ulDropped); }
+
+        int receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nClass) override;
+};
+
+/**
+ * @brief Replays recorded events into a message bus.
+ *        The modules have to be registered on the message bus before replaying.
+ */
+class CMsgBusReplayer {
+    private:
+        /// @brief One recorded event, payload fields are unescaped.
+        struct RecordedEvent {
+            unsigned long   Time    = 0;
+            int             Msg     = 0;
+            int             Class   = 0;
+            char            Kind    = MSG_PAYLOAD_NONE;
+            String          Sender;
+            String          Data;
+            String          Data2;
+        };
+        CEventHandler * m_pEventHandler;
+        std::vector<RecordedEvent> m_tEvents;
+        unsigned long   m_ulReplayMicros    = 0;
+
+        bool parseLine(const char *pszLine, size_t nLength);
+        int  sendRecordedEvent(RecordedEvent &oEvent);
+    public:
+        /// @brief Create a replayer for the message bus.
+        CMsgBusReplayer(CEventHandler * pEventHandler) : m_pEventHandler(pEventHandler) {}
+
+        /// @brief Load (add) the records from a text buffer, returns the number of loaded events.
+        size_t load(const char *pszRecords);
+        /// @brief Load (add) the records from a file, returns the number of loaded events.
+        size_t loadFile(const char *pszFileName);
+        /// @brief Remove all loaded events.
+        void   clear()                  { m_tEvents.clear(); }
+        /// @brief Number of loaded events.
+        size_t getEventCount()          { return(m_tEvents.size()); }
+
+        /**
+         * @brief Send all loaded events into the message bus.
+         * @param fSpeed 1.0 = original timing, 10.0 = ten times faster, 0 = as fast as possible.
+         * @param bProfile Enable the receiver profiling of the message bus before replaying.
+         * @return Number of events sent.
+         */
+        size_t replay(float fSpeed = 0, bool bProfile = true);
+        /// @brief Total time of the last replay in microseconds (including waits).
+        unsigned long getReplayMicros() { return(m_ulReplayMicros); }
+};
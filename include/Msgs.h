@@ -10,14 +10,17 @@
 #define MSG_APPL_STARTING           100    // Application starts - prepare, if needed
 #define MSG_APPL_INITIALIZED        102    // Application has been initialized... let's start.
 #define MSG_APPL_STARTED            103    // Application setup (init) is finished
-#define MSG_APPL_STATUS_CHANGED     105    // Application notification, Status has changed
+#define MSG_APPL_STATUS_CHANGED     105    // Application notification, Status has changed, pMessage = status section name (nullptr = all)
 #define MSG_APPL_LOOP               110    // Application loop message, pMessage and nClass are optional data   
 #define MSG_REBOOT_REQUEST          198    // Request a reboot, nClass = delay in ms
 #define MSG_RESTART_REQUEST         198    // Reqeust a restart/reboot - same as MSG_REBOOT_REQUEST
 #define MSG_APPL_SHUTDOWN           199    // Application is going down, modules should close connections and free resources
 
-#define MSG_LOG_ENTRY               201    // Log Entry request message see CLog
+// CEventLogger sends MSG_LOG_RECORD (not MSG_LOG_ENTRY) and only for log classes written by a CLogWriter.
+// Receivers of MSG_LOG_ENTRY have to be moved to a CLogWriter - see doc/Logging.md
+#define MSG_LOG_ENTRY               201    // Log Entry request, msg is the text - only sent by other modules, written by all CLogWriters
 #define MSG_LOG_ENTRY_JSON          202    // Log Entry request, msg is a json object 
+#define MSG_LOG_RECORD              203    // Log Entry from CEventLogger, msg is a CLogRecord (formatted on demand)
 
 
 #define MSG_BUTTON_CHANGED          1020
@@ -30,6 +30,7 @@
         bool    m_bIsInitialized = false;
         unsigned long m_uLastUpdate = 0;
         char m_szISODateTime[40];
+        CMsgPostQueue m_oPostQueue;     // Status change of the time service callback
 
     public:
         CNTPHandler(const char * pszAutoRegisterName = nullptr) {
@@ -1,12 +1,25 @@
 #pragma once
 #include <vector>
+#include <new>
 #include <LSCUtils.h>
 #include <DevelopmentHelper.h>
 
+// Keys up to this length (without terminator) are stored inside the entry
+#ifndef NAMED_VALUE_INLINE_KEY_SIZE
+    #define NAMED_VALUE_INLINE_KEY_SIZE 15
+#endif
+
+// Number of entries allocated at once by CNamedValueTable
+#ifndef NAMED_VALUE_TABLE_CHUNK_SIZE
+    #define NAMED_VALUE_TABLE_CHUNK_SIZE 8
+#endif
+
 /**
  * @brief Single key/value entry used by CNamedValueTable.
  *
- * The entry owns a copy of the key string. The value is stored directly and is
+ * The entry owns a copy of the key string: short keys are stored inside the
+ * entry, longer keys with strdup(). Keys with static lifetime (string literals)
+ * can be referenced without copying. The value is stored directly and is
  * intentionally public so callers can update it after a lookup without another
  * wrapper function.
  *
@@ -17,44 +30,102 @@ class CNamedValueEntry {
 
     protected:
         /**
-         * @brief Owned copy of the key string.
+         * @brief The key string.
          *
-         * The pointer is allocated with strdup() in the constructor and released
-         * in the destructor. A nullptr key is allowed, but it will not match any
-         * lookup key.
+         * Points to m_szInlineKey, to a strdup() copy (released in the
+         * destructor) or to a static key that is not owned by the entry.
+         * A nullptr key is allowed, but it will not match any lookup key.
          */
-        char * m_pszKey = nullptr;
+        const char * m_pszKey = nullptr;
+
+        /// @brief Storage for short keys, avoids an allocation per entry.
+        char m_szInlineKey[NAMED_VALUE_INLINE_KEY_SIZE + 1];
+
+        /// @brief true when m_pszKey was allocated with strdup().
+        bool m_bKeyAllocated = false;
+
+        /**
+         * @brief Case-folded hash of the key (see LSC::getHashNoCase()).
+         *
+         * Calculated once in the constructor and used by the hash index of
+         * CNamedValueTable, and to skip string compares of different keys.
+         */
+        uint32_t m_ulKeyHash = 0;
 
     public:
         /**
          * @brief Creates a new entry and copies the key.
          * @param pszKey Key name for this entry. May be nullptr.
          * @param value Initial value to store in the entry.
+         * @param bStaticKey true if pszKey stays valid for the lifetime of the
+         *        entry (e.g. a string literal) - the key is not copied then.
          */
-        CNamedValueEntry(const char *pszKey, TValue value) {
-            this->m_pszKey = pszKey ? strdup(pszKey) : nullptr;
+        CNamedValueEntry(const char *pszKey, TValue value, bool bStaticKey = false) {
+            setKey(pszKey,bStaticKey);
             this->value = value;
         }
 
+        // The key may point into the entry itself, so entries are not copied.
+        CNamedValueEntry(const CNamedValueEntry &) = delete;
+        CNamedValueEntry & operator=(const CNamedValueEntry &) = delete;
+
         /**
-         * @brief Releases the owned key string.
+         * @brief Releases the key string, if it was allocated.
          */
         ~CNamedValueEntry() {
-            if(m_pszKey != nullptr) {
+            if(m_bKeyAllocated) {
                 free((void*)m_pszKey);
-                m_pszKey = nullptr;
+                m_bKeyAllocated = false;
             }
+            m_pszKey = nullptr;
+        }
+
+        /**
+         * @brief Replaces the key of the entry.
+         *
+         * Only the entry is changed - an owning CNamedValueTable must be told
+         * with CNamedValueTable::setKey(), so its hash index follows the key.
+         *
+         * @param pszKey New key name. May be nullptr.
+         * @param bStaticKey true if pszKey stays valid for the lifetime of the
+         *        entry - the key is not copied then.
+         */
+        void setKey(const char *pszKey, bool bStaticKey = false) {
+            if(m_bKeyAllocated) free((void*)m_pszKey);
+            m_bKeyAllocated = false;
+            m_pszKey = nullptr;
+            if(pszKey) {
+                size_t nKeyLen = strlen(pszKey);
+                if(bStaticKey) {
+                    this->m_pszKey = pszKey;
+                } else if(nKeyLen <= NAMED_VALUE_INLINE_KEY_SIZE) {
+                    memcpy(m_szInlineKey,pszKey,nKeyLen + 1);
+                    this->m_pszKey = m_szInlineKey;
+                } else {
+                    this->m_pszKey = strdup(pszKey);
+                    this->m_bKeyAllocated = true;
+                }
+            }
+            this->m_ulKeyHash = LSC::getHashNoCase(pszKey);
         }
 
         /**
          * @brief Gets the stored key.
-         * @return Pointer to the owned key string, or nullptr if the entry was
+         * @return Pointer to the key string, or nullptr if the entry was
          *         created without a key.
          */
         const char * getKey() {
             return(m_pszKey);
         }
 
+        /**
+         * @brief Gets the case-folded hash of the key.
+         * @return Hash value, 0 if the entry has no key.
+         */
+        uint32_t getKeyHash() {
+            return(m_ulKeyHash);
+        }
+
         /**
          * @brief Checks if a lookup key matches this entry key.
          * @param pszKey Lookup key to compare with this entry key.
@@ -90,6 +161,9 @@ class CNamedValueEntry {
  * Key comparison can be case-sensitive or case-insensitive. When no matching
  * key exists, get() returns the configured default value.
  *
+ * Key lookups are linear by default. For larger tables, enableHashIndex()
+ * adds an open-addressing hash index, the insertion order stays unchanged.
+ *
  * @tparam TValue Type of the stored values. The value type must be copyable and
  *         comparable with operator== for value lookups and unique-value tables.
  */
@@ -130,16 +204,102 @@ class CNamedValueTable {
          * @brief Cached list of key pointers in insertion order.
          *
          * The pointers refer to keys owned by the entries in Entries. They stay
-         * valid for the lifetime of the table because entries are not removed.
+         * valid for the lifetime of the table because entries are not removed,
+         * setKey() updates the pointer of a renamed entry.
          */
         std::vector<const char *> m_tKeyNameCache;
-        
+
+        /**
+         * @brief Optional open-addressing hash index over Entries.
+         *
+         * Each slot holds an index into Entries, or -1 for a free slot.
+         * Collisions are resolved by linear probing. Entries are inserted in
+         * Entries order, so entries with the same key appear in the probe
+         * sequence in insertion order - findNextByKey() keeps its semantics.
+         * Empty when the index is disabled.
+         */
+        std::vector<int> m_tHashIndex;
+
+        /**
+         * @brief Memory blocks holding the entries.
+         *
+         * Entries are constructed in blocks of NAMED_VALUE_TABLE_CHUNK_SIZE,
+         * so a table needs one allocation per block instead of one per entry,
+         * and neighbouring entries are close together for scans. Blocks are
+         * never moved, pointers in Entries stay valid.
+         */
+        std::vector<void *> m_tEntryChunks;
+
+        /// @brief Number of used entries in the last block.
+        size_t m_nLastChunkUsed = 0;
+
+        /**
+         * @brief Constructs a new entry in the entry blocks.
+         * @return The new entry (not yet added to Entries).
+         */
+        CNamedValueEntry<TValue> * createEntry(const char *pszKey, const TValue value, bool bStaticKey) {
+            if(m_tEntryChunks.empty() || m_nLastChunkUsed >= NAMED_VALUE_TABLE_CHUNK_SIZE) {
+                m_tEntryChunks.push_back(malloc(sizeof(CNamedValueEntry<TValue>) * NAMED_VALUE_TABLE_CHUNK_SIZE));
+                m_nLastChunkUsed = 0;
+            }
+            void *pSlot = (char *) m_tEntryChunks.back() + sizeof(CNamedValueEntry<TValue>) * m_nLastChunkUsed++;
+            return(new(pSlot) CNamedValueEntry<TValue>(pszKey, value, bStaticKey));
+        }
+
+        /**
+         * @brief Inserts an entry into the hash index (without growing).
+         * @param nEntryIdx Index of the entry in Entries.
+         */
+        void addToHashIndex(int nEntryIdx) {
+            size_t nMask = m_tHashIndex.size() - 1;
+            size_t nSlot = Entries[nEntryIdx]->getKeyHash() & nMask;
+            while(m_tHashIndex[nSlot] >= 0) nSlot = (nSlot + 1) & nMask;
+            m_tHashIndex[nSlot] = nEntryIdx;
+        }
+
+        /**
+         * @brief Rebuilds the hash index with at least nMinSlots slots.
+         *
+         * The slot count is a power of two and at least twice the number of
+         * entries, so the probe sequences stay short.
+         */
+        void rebuildHashIndex(size_t nMinSlots) {
+            size_t nSlots = 8;
+            while(nSlots < nMinSlots || nSlots < Entries.size() * 2) nSlots <<= 1;
+            m_tHashIndex.assign(nSlots,-1);
+            for(size_t nIdx = 0; nIdx < Entries.size(); nIdx++) addToHashIndex((int) nIdx);
+        }
+
+        /**
+         * @brief Finds the next entry with the given key by the hash index.
+         * @see findNextByKey()
+         */
+        CNamedValueEntry<TValue> * findNextByKeyHashed(const char *pszKey, CNamedValueEntry<TValue> * pLastFound) {
+            CNamedValueEntry<TValue> * pResult = nullptr;
+            if(pszKey) {
+                uint32_t ulHash = LSC::getHashNoCase(pszKey);
+                size_t nMask = m_tHashIndex.size() - 1;
+                size_t nSlot = ulHash & nMask;
+                bool bSearch = pLastFound == nullptr;
+                for(int nEntryIdx = m_tHashIndex[nSlot]; nEntryIdx >= 0; nEntryIdx = m_tHashIndex[nSlot]) {
+                    CNamedValueEntry<TValue> * pEntry = Entries[nEntryIdx];
+                    if(bSearch) {
+                        if(pEntry->getKeyHash() == ulHash && pEntry->doesKeyMatch(pszKey,m_bCaseSensitive)) { pResult = pEntry; break; }
+                    } else {
+                        // This is the entry, start searching now...
+                        if(pEntry == pLastFound) bSearch = true;
+                    }
+                    nSlot = (nSlot + 1) & nMask;
+                }
+            }
+            return(pResult);
+        }
         
     public:
         /**
          * @brief Public entry list for direct iteration.
          *
-         * The table owns all pointers in this vector and deletes them in the
+         * The table owns all entries in this vector and destroys them in the
          * destructor. Callers may iterate over the entries, but should not delete
          * pointers or insert foreign pointers into this vector.
          */
@@ -157,15 +317,46 @@ class CNamedValueTable {
         }
 
         /**
-         * @brief Deletes all owned entries.
+         * @brief Destroys all owned entries and releases the entry blocks.
          */
         ~CNamedValueTable() {
             // Free the allocated keys
             for(auto * kvp : Entries) {
-                delete(kvp);
+                kvp->~CNamedValueEntry<TValue>();
+            }
+            for(void * pChunk : m_tEntryChunks) {
+                free(pChunk);
             }
         }
 
+        // Entries point into the own entry blocks, so tables are not copied.
+        CNamedValueTable(const CNamedValueTable &) = delete;
+        CNamedValueTable & operator=(const CNamedValueTable &) = delete;
+
+        /**
+         * @brief Enables or disables the hash index for key lookups.
+         *
+         * Without the index, key lookups compare the key with every entry.
+         * With the index, findFirstByKey(), findNextByKey(), hasKeyEntry(),
+         * get() and set() need O(1) on average, for the price of one int per
+         * slot (at least two slots per entry). Worth for larger tables or
+         * tables with frequent lookups.
+         *
+         * @param bEnable true to build and maintain the index, false to drop it.
+         */
+        void enableHashIndex(bool bEnable = true) {
+            if(bEnable) rebuildHashIndex(8);
+            else        std::vector<int>().swap(m_tHashIndex);
+        }
+
+        /**
+         * @brief Checks if the hash index is enabled.
+         * @return true when key lookups use the hash index.
+         */
+        bool hasHashIndex() {
+            return(!m_tHashIndex.empty());
+        }
+
 #pragma region search and find functions.
 
         /**
@@ -248,6 +439,11 @@ class CNamedValueTable {
          */
         CNamedValueEntry<TValue> * findNextByKey(const char *pszKey, CNamedValueEntry<TValue> * pLastFound = nullptr) {
             DEBUG_FUNC_START_PARMS("\"%s\",%p",pszKey,pLastFound);
+            if(hasHashIndex()) {
+                CNamedValueEntry<TValue> * pResult = findNextByKeyHashed(pszKey,pLastFound);
+                DEBUG_FUNC_END_PARMS("%p",pResult);
+                return(pResult);
+            }
             CNamedValueEntry<TValue> * pResult = nullptr;
             // If pLastFound is not null, search the entry first...
             // otherwise begin searching immediately
@@ -300,14 +496,18 @@ class CNamedValueTable {
          * @param pszKey Key for the entry. May be nullptr, but nullptr keys cannot
          *        be found by key lookup.
          * @param value Value to store.
+         * @param bStaticKey true if pszKey stays valid for the lifetime of the
+         *        table (e.g. a string literal), so a new entry references the
+         *        key instead of copying it.
          * @return Address of the inserted or updated entry, or nullptr when a
          *         uniqueness rule rejects the operation.
          */
-        CNamedValueEntry<TValue> *  set(const char *pszKey, const TValue value) {
+        CNamedValueEntry<TValue> *  set(const char *pszKey, const TValue value, bool bStaticKey = false) {
             CNamedValueEntry<TValue> * pEntry = nullptr;
             DEBUG_FUNC_START_PARMS("%s,%p",pszKey,value);
-            bool bHasKeyEntry   = hasKeyEntry(pszKey);
-            bool bHasValueEntry = hasValueEntry(value);
+            // Lookups are only needed for the uniqueness rules
+            bool bHasKeyEntry   = m_bOnlyUniqueKeys   && hasKeyEntry(pszKey);
+            bool bHasValueEntry = m_bOnlyUniqueValues && hasValueEntry(value);
 
             bool doInsert = true;
             if(m_bOnlyUniqueKeys && bHasKeyEntry) {
@@ -323,15 +523,45 @@ class CNamedValueTable {
                 if(pEntry) {
                     pEntry->value = value;
                 } else {
-                    pEntry = new CNamedValueEntry<TValue>(pszKey, value);
+                    pEntry = createEntry(pszKey, value, bStaticKey);
                     Entries.push_back(pEntry);
                     m_tKeyNameCache.push_back(pEntry->getKey());
+                    if(hasHashIndex()) {
+                        if(Entries.size() * 2 > m_tHashIndex.size()) rebuildHashIndex(m_tHashIndex.size() * 2);
+                        else                                         addToHashIndex((int) Entries.size() - 1);
+                    }
                 }
             }
             DEBUG_FUNC_END();
             return(pEntry);
         }
 
+        /**
+         * @brief Changes the key of an entry of this table.
+         *
+         * Renaming is rare, so the hash index is rebuilt instead of moving
+         * single slots.
+         *
+         * @param pEntry Entry of this table.
+         * @param pszKey New key name. May be nullptr.
+         * @param bStaticKey true if pszKey stays valid for the lifetime of the
+         *        table, so the key is referenced instead of copied.
+         * @return true when the entry belongs to this table and was renamed.
+         */
+        bool setKey(CNamedValueEntry<TValue> * pEntry, const char *pszKey, bool bStaticKey = false) {
+            bool bResult = false;
+            for(size_t nIdx = 0; nIdx < Entries.size(); nIdx++) {
+                if(Entries[nIdx] == pEntry) {
+                    pEntry->setKey(pszKey,bStaticKey);
+                    m_tKeyNameCache[nIdx] = pEntry->getKey();
+                    if(hasHashIndex()) rebuildHashIndex(m_tHashIndex.size());
+                    bResult = true;
+                    break;
+                }
+            }
+            return(bResult);
+        }
+
         /**
          * @brief Gets the number of entries in the table.
          * @return Current number of stored entries.
@@ -365,12 +595,8 @@ class CNamedValueTable {
          */
         TValue get(const char *pszKey) {
             TValue oResultValue = m_defaultValue;
-            for(CNamedValueEntry<TValue> * pEntry : Entries) {
-                if(pEntry->doesKeyMatch(pszKey,m_bCaseSensitive)) {
-                    oResultValue = pEntry->value;
-                    break;
-                }
-            }
+            CNamedValueEntry<TValue> * pEntry = findNextByKey(pszKey,nullptr);
+            if(pEntry) oResultValue = pEntry->value;
             return(oResultValue);
         }
 };
@@ -28,6 +28,9 @@
     #define SerialPrintf printf
     #define ICACHE_FLASH_ATTR
     #define F(value) value
+    #define vsnprintf_P vsnprintf
+
+    class __FlashStringHelper;
 
     class NativeSerial {
         public:
@@ -41,6 +44,8 @@
 
     char* strlwr(char* s);
     unsigned long millis();
+    unsigned long micros();
+    void delay(unsigned long ulMillis);
 #else
     #include <Arduino.h>
     
@@ -0,0 +1,125 @@
+#pragma once
+/**
+ * Status subscriptions with delta updates
+ *
+ * Instead of polling the whole status, a client subscribes to status sections, a
+ * status level and a max. push rate. The first push (and a resync) is a full
+ * snapshot, further pushes are merge patches (RFC 7386) with the changed fields
+ * only. They are sent, when a module marked its section dirty (markDirty(), i.E.
+ * on MSG_APPL_STATUS_CHANGED) and the min. interval of the subscription elapsed.
+ * A refresh interval marks the subscription dirty without a module, to keep
+ * values like the uptime current.
+ *
+ * Subscriptions with the same sections, level and intervals share a group - the
+ * status of a group is written and compared once per push, however many clients
+ * are subscribed. Each client has one subscription, a new one replaces it.
+ *
+ * Messages:
+ *      { "command":"update", "data":"status",      "payload": <snapshot> }
+ *      { "command":"update", "data":"statuspatch", "payload": <merge patch> }
+ */
+#include <Runtime.h>
+#include <StatusHandler.h>
+
+// Max. number of subscribed clients
+#ifndef STATUS_SUBSCRIPTION_CLIENTS
+    #define STATUS_SUBSCRIPTION_CLIENTS     8
+#endif
+// Max. number of different subscriptions (sections, level and intervals)
+#ifndef STATUS_SUBSCRIPTION_GROUPS
+    #define STATUS_SUBSCRIPTION_GROUPS      4
+#endif
+// Min. time (ms) between two pushes of a subscription
+#ifndef STATUS_SUBSCRIPTION_MIN_INTERVAL
+    #define STATUS_SUBSCRIPTION_MIN_INTERVAL 100
+#endif
+// Default time (ms) between two pushes of a subscription
+#ifndef STATUS_SUBSCRIPTION_INTERVAL
+    #define STATUS_SUBSCRIPTION_INTERVAL    1000
+#endif
+// Max. length of a section name
+#ifndef STATUS_SUBSCRIPTION_NAME_SIZE
+    #define STATUS_SUBSCRIPTION_NAME_SIZE   32
+#endif
+
+/**
+ * @brief Subscriptions of status sections, pushed as snapshot and merge patches.
+ *        Derived classes implement sendStatus() for their transport.
+ */
+class CStatusSubscriptions : public IStatusHandler {
+    private:
+        struct Group {
+            String          Sections;               // Comma separated section names, empty = whole status
+            int             Level       = STATUS_LEVEL_INFO;
+            unsigned long   Interval    = STATUS_SUBSCRIPTION_INTERVAL;
+            unsigned long   Refresh     = 0;        // Max. age (ms) of the last push, 0 = only when dirty
+            unsigned long   LastPush    = 0;        // millis() of the last push
+            bool            Dirty       = false;
+            bool            HasSnapshot = false;
+            size_t          Clients     = 0;
+            JsonNode        Snapshot;               // Status of the last push
+        };
+        struct Subscriber {
+            uint32_t        ClientId      = 0;
+            Group *         pGroup        = nullptr;  // nullptr = free slot
+            bool            NeedsSnapshot = false;
+        };
+        CStatusHandler *m_pStatus;
+        Group           m_tGroups[STATUS_SUBSCRIPTION_GROUPS];
+        Subscriber      m_tSubscribers[STATUS_SUBSCRIPTION_CLIENTS];
+
+        unsigned long   m_ulWrites    = 0;      // Status written (once per group and push)
+        unsigned long   m_ulSnapshots = 0;      // Snapshots sent
+        unsigned long   m_ulPatches   = 0;      // Patches sent
+        unsigned long   m_ulRejected  = 0;      // Subscriptions without free slot
+
+        Subscriber * getSubscriber(uint32_t ulClientId);
+        void         leaveGroup(Subscriber &oSubscriber);
+        void         writeGroupStatus(Group &oGroup, JsonNode &oStatus);
+        void         sendGroupSnapshot(Group &oGroup);
+
+    protected:
+        /// @brief Send a status message to a client, return false if the client is gone (it is unsubscribed).
+        virtual bool sendStatus(uint32_t ulClientId, JsonNode &oMessage) = 0;
+        /// @brief Return false if the client is gone (see purge()).
+        virtual bool isConnected(uint32_t ulClientId) { return(true); }
+
+    public:
+        /// @brief Create the subscriptions for the sections of a status handler (i.E. the application).
+        CStatusSubscriptions(CStatusHandler *pStatus) : m_pStatus(pStatus) {}
+        virtual ~CStatusSubscriptions() {}
+
+        /**
+         * @brief Subscribe a client (replaces its subscription), the snapshot is sent by the next process().
+         * @param ulClientId Client to send the status to.
+         * @param pszSections Comma separated section names, nullptr or empty = the whole status.
+         * @param nLevel Status level.
+         * @param ulInterval Min. time (ms) between two pushes.
+         * @param ulRefresh Max. time (ms) between two pushes, 0 = only when the status is dirty.
+         * @return false if no slot is free.
+         */
+        bool subscribe(uint32_t ulClientId, const char *pszSections, int nLevel = STATUS_LEVEL_INFO,
+                       unsigned long ulInterval = STATUS_SUBSCRIPTION_INTERVAL, unsigned long ulRefresh = 0);
+        /// @brief Send a snapshot to the client with the next process(), false if not subscribed.
+        bool resync(uint32_t ulClientId);
+        /// @brief Remove the subscription of a client (i.E. on disconnect).
+        void unsubscribe(uint32_t ulClientId);
+        /// @brief Remove the subscriptions of the clients, that are gone.
+        void purge();
+        /// @brief Mark a status section as changed, nullptr = all sections.
+        void markDirty(const char *pszSection = nullptr);
+        /// @brief Push the snapshots and patches, that are due (call it from the loop).
+        void process();
+
+        /// @brief Number of subscribed clients.
+        size_t getSubscribers();
+        /// @brief Number of groups in use.
+        size_t getGroups();
+        unsigned long getWrites()       { return(m_ulWrites); }
+        unsigned long getSnapshots()    { return(m_ulSnapshots); }
+        unsigned long getPatches()      { return(m_ulPatches); }
+        unsigned long getRejected()     { return(m_ulRejected); }
+
+        /// @brief Write the counters of the subscriptions.
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel = STATUS_LEVEL_INFO) override;
+};
@@ -0,0 +1,184 @@
+#pragma once
+/**
+ * Streaming template renderer
+ *
+ * A template is a (html) file with placeholders like $WiFi.SSID$ - the placeholder
+ * sign is TEMPLATE_PLACEHOLDER, as used by ESPAsyncWebServer ("$$" writes a single "$").
+ *
+ * Instead of processing the whole file for each request, the template is scanned
+ * once into a table of segments (static text / placeholder). The table is cached
+ * in RAM. Rendering streams the static segments directly from the file and resolves
+ * the placeholders one by one, so the memory used for a request does not depend on
+ * the size of the page - only on the size of the largest placeholder value.
+ *
+ * Values are resolved by an optional resolver function first, then by the var
+ * table (usually Appl.Config). Unknown placeholders are rendered as empty text.
+ */
+#include <Runtime.h>
+#include <Vars.h>
+#include <LSCUtils.h>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#ifndef TEMPLATE_PLACEHOLDER
+    #define TEMPLATE_PLACEHOLDER '%'
+#endif
+
+// Max. length of a placeholder name, longer names are treated as static text.
+#ifndef TEMPLATE_PARAM_NAME_LENGTH
+    #define TEMPLATE_PARAM_NAME_LENGTH 32
+#endif
+
+// Block size used to scan a template source
+#ifndef TEMPLATE_SCAN_BLOCK_SIZE
+    #define TEMPLATE_SCAN_BLOCK_SIZE 128
+#endif
+
+/**
+ * @brief Source of the template data (file or memory).
+ */
+class ITemplateSource {
+    public:
+        virtual ~ITemplateSource() {}
+        /// @brief Total size of the template data.
+        virtual size_t size() = 0;
+        /// @brief Read nLen bytes from position nOffset, returns the number of bytes read.
+        virtual size_t read(size_t nOffset, uint8_t *pBuffer, size_t nLen) = 0;
+        /// @brief Version of the content, changed by the writer of the data (i.E. CFileIndex::getVersion()), 0 if unknown.
+        virtual uint32_t getVersion() { return(0); }
+};
+
+/**
+ * @brief Template source for data in memory (not copied).
+ */
+class CMemoryTemplateSource : public ITemplateSource {
+    private:
+        const char * m_pszData;
+        size_t       m_nSize;
+        uint32_t     m_ulVersion;
+    public:
+        /// @param ulVersion Version of the data - the owner changes it, when the data is changed in place.
+        CMemoryTemplateSource(const char *pszData, uint32_t ulVersion = 0) 
+            : m_pszData(pszData), m_nSize(pszData ? strlen(pszData) : 0), m_ulVersion(ulVersion) {}
+        size_t size() override { return(m_nSize); }
+        size_t read(size_t nOffset, uint8_t *pBuffer, size_t nLen) override {
+            if(nOffset >= m_nSize) return(0);
+            if(nLen > m_nSize - nOffset) nLen = m_nSize - nOffset;
+            memcpy(pBuffer,m_pszData + nOffset,nLen);
+            return(nLen);
+        }
+        uint32_t getVersion() override { return(m_ulVersion); }
+};
+
+/**
+ * @brief One segment of a compiled template.
+ *        NameIdx < 0 : static text at Offset/Length in the source.
+ *        NameIdx >= 0: placeholder, name is CCompiledTemplate::getName(NameIdx).
+ */
+struct TemplateSegment {
+    uint32_t Offset  = 0;
+    uint32_t Length  = 0;
+    int16_t  NameIdx = -1;
+};
+
+/**
+ * @brief Segment table of a template source.
+ */
+class CCompiledTemplate {
+    private:
+        std::vector<TemplateSegment> m_tSegments;
+        std::vector<char *>          m_tNames;
+        size_t                       m_nSourceSize = 0;
+        uint32_t                     m_ulSourceVersion = 0;
+
+        void addStatic(size_t nStart, size_t nEnd);
+        void addPlaceholder(size_t nStart, size_t nEnd, const char *pszName);
+    public:
+        ~CCompiledTemplate();
+        /// @brief Scan the source and build the segment table.
+        bool compile(ITemplateSource &oSource);
+        /// @brief Segments in output order.
+        const std::vector<TemplateSegment> & getSegments() { return(m_tSegments); }
+        /// @brief Name of a placeholder.
+        const char * getName(int nNameIdx) { return(nNameIdx >= 0 && nNameIdx < (int) m_tNames.size() ? m_tNames[nNameIdx] : ""); }
+        /// @brief Number of placeholder segments.
+        size_t getPlaceholderCount() { return(m_tNames.size()); }
+        /// @brief Size of the source, when it was compiled.
+        size_t getSourceSize() { return(m_nSourceSize); }
+        /// @brief Version of the source (ITemplateSource::getVersion()), when it was compiled.
+        uint32_t getSourceVersion() { return(m_ulSourceVersion); }
+};
+
+/// @brief Function to resolve a placeholder, returns true if strValue was set.
+typedef std::function<bool(const char *pszName, String &strValue)> TemplateValueResolver;
+
+class CTemplateRenderer;
+
+/**
+ * @brief Rendering progress of one request.
+ *        Call fill() until it returns 0 (i.E. from a chunked response callback).
+ */
+class CTemplateRenderState {
+    private:
+        CTemplateRenderer                * m_pRenderer;
+        std::shared_ptr<CCompiledTemplate> m_pTemplate;
+        std::unique_ptr<ITemplateSource>   m_pSource;
+        size_t  m_nSegment       = 0;
+        size_t  m_nSegmentOffset = 0;
+        bool    m_bValueResolved = false;
+        String  m_strValue;
+    public:
+        CTemplateRenderState(CTemplateRenderer *pRenderer, std::shared_ptr<CCompiledTemplate> pTemplate, std::unique_ptr<ITemplateSource> pSource)
+            : m_pRenderer(pRenderer), m_pTemplate(pTemplate), m_pSource(std::move(pSource)) {}
+        /// @brief Write the next part of the output into the buffer, returns 0 when done.
+        size_t fill(uint8_t *pBuffer, size_t nMaxLen);
+        /// @brief Return true if the whole output has been written.
+        bool   isDone() { return(!m_pTemplate || m_nSegment >= m_pTemplate->getSegments().size()); }
+};
+
+/**
+ * @brief Caches compiled templates and resolves the placeholder values.
+ */
+class CTemplateRenderer {
+    private:
+        /// @brief Cache entry, templates are recompiled when the size or the version of the source changes.
+        struct CachedTemplate {
+            String                             Name;
+            std::shared_ptr<CCompiledTemplate> Template;
+        };
+        std::vector<CachedTemplate> m_tCache;
+        CVarTable                 * m_pVars = nullptr;
+        TemplateValueResolver       m_funcResolver;
+    public:
+        CTemplateRenderer(CVarTable *pVars = nullptr) : m_pVars(pVars) {}
+
+        /// @brief Set the var table used to resolve the placeholders.
+        void setVarTable(CVarTable *pVars)                  { m_pVars = pVars; }
+        /// @brief Return the var table used to resolve the placeholders.
+        CVarTable * getVarTable()                           { return(m_pVars); }
+        /// @brief Set a resolver, called before the var table is asked.
+        void setResolver(TemplateValueResolver funcResolver) { m_funcResolver = funcResolver; }
+        /// @brief Resolve a placeholder value, empty if unknown.
+        void resolve(const char *pszName, String &strValue);
+
+        /// @brief Get the compiled template (from cache or compiled now).
+        std::shared_ptr<CCompiledTemplate> getTemplate(const char *pszName, ITemplateSource &oSource);
+        /// @brief Remove a template from the cache (i.E. after an upload).
+        void invalidate(const char *pszName);
+        /// @brief Remove all templates from the cache.
+        void clear()                                        { m_tCache.clear(); }
+
+        /**
+         * @brief Start rendering a template.
+         * @param pszName Cache key (usually the file name).
+         * @param pSource Source of the template, owned by the returned state.
+         * @return State for fill(), or nullptr if the template can not be compiled.
+         */
+        std::shared_ptr<CTemplateRenderState> begin(const char *pszName, std::unique_ptr<ITemplateSource> pSource);
+
+        #ifndef NATIVE_RUNTIME
+            /// @brief Start rendering a template file from LittleFS, ulVersion is the version of the file (CFileIndex::getVersion()).
+            std::shared_ptr<CTemplateRenderState> beginFile(const char *pszFileName, uint32_t ulVersion = 0);
+        #endif
+};
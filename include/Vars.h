@@ -1,18 +1,40 @@
 #pragma once
 #include <ConfigHandler.h>
+#include <NamedValueTable.h>
 #include <vector>
 
-// class CVarTable;
-/// @brief Represents one named configuration variable.
+class CVarTable;
+/**
+ * @brief Represents one named configuration variable.
+ *
+ * The value is kept in the type it was set with (text, int, unsigned long or bool).
+ * The text representation is created only when getValue() is called, conversions
+ * into other types are done once and cached until the next setValue().
+ */
 class CVar  {
-        // friend class CVarTable;
+        friend class CVarTable;
+        enum VarType : uint8_t { VAR_TYPE_STRING, VAR_TYPE_INT, VAR_TYPE_ULONG, VAR_TYPE_BOOL };
+        // Flags for the values in m_nValid
+        static const uint8_t VALID_STRING = 0x01;
+        static const uint8_t VALID_INT    = 0x02;
+        static const uint8_t VALID_ULONG  = 0x04;
+        static const uint8_t VALID_BOOL   = 0x08;
+
         char * pszKeyName = nullptr;    // Key name (Real name, not case sensitive)
         char * pszName = nullptr;       // Real name, set by user
-        char * pszValue = nullptr;      // Value
+        char * pszValue = nullptr;      // Value as text (valid if VALID_STRING is set)
+        size_t m_nValueBufferSize = 0;  // Allocated size of pszValue, reused by the next value
+        int           m_nValue  = 0;    // Value as int (valid if VALID_INT is set)
+        unsigned long m_ulValue = 0;    // Value as unsigned long (valid if VALID_ULONG is set)
+        bool          m_bValue  = false;// Value as bool (valid if VALID_BOOL is set)
+        VarType m_eType  = VAR_TYPE_STRING; // Type of the last setValue()
+        uint8_t m_nValid = 0;           // Which of the values above are valid
         bool isCritical = false;        // is a critical value, like a password
+        CVarTable * m_pTable = nullptr; // Table holding the var, its index follows setVarName()
 
     protected:
-        
+        void storeText(const char *pszText);
+        const char * materializeText();
    
     public:
         /// @brief Release owned name/key/value buffers.
@@ -41,7 +63,7 @@ class CVar  {
             CVar * setValue(const __FlashStringHelper * strValue);
         #endif
 
-        /// @brief Set or replace the variable name and derived lookup key.
+        /// @brief Set or replace the variable name and derived lookup key, re-keys the owning table.
         void setVarName(const char * pszName);
         /// @brief Return the lookup key; original case can be requested.
         const char * getKeyName(bool bCaseSensitive = false);
@@ -69,6 +91,8 @@ class CVar  {
         const unsigned long     getUnsignedLongValue();
         /// @brief Return the value converted to bool.
         const bool              getBoolValue();
+        /// @brief Return true if the value was set as text (not as number or bool).
+        bool                    isTextValue() { return(m_eType == VAR_TYPE_STRING); }
     };
     
     /// @brief Collection of named variables exposed through IConfigHandler.
@@ -76,10 +100,12 @@ class CVar  {
             friend class CVar;
             std::vector<CVar *> tVarEntries;
             bool isCaseSensitive = false;
+            CNamedValueTable<CVar *> m_tVarIndex;   // Hashed lookup by var name, keys are the var names
             
         protected:
             bool prepareKeyName(char * szKeyName);
             CVar * getOrCreateVarEntry(const char *strName);
+            void renameVar(CVar *pVar);
            
         public:
             /// @brief Create a variable table with optional case-sensitive lookup.
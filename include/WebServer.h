@@ -4,6 +4,15 @@
 #include <Appl.h>
 #include <Network.h>
 #include <WebSocket.h>
+#include <TemplateRenderer.h>
+#include <FileLogWriter.h>
+#include <FileIndex.h>
+#include <FileUpload.h>
+
+// Cache-Control of delivered files - the client revalidates with the ETag
+#ifndef WEBSERVER_FILE_CACHE_CONTROL
+    #define WEBSERVER_FILE_CACHE_CONTROL "private, no-cache"
+#endif
 
 /// @brief Runtime configuration of the web server module.
 struct WebServerConfig {
@@ -49,7 +58,15 @@ class CWebServer : public AsyncWebServer, public IModule {
         WebServerConfig Config;
         /// @brief Status information about the webserver.
         WebServerStatus Status;
+        /// @brief Renderer for template pages (placeholders resolved by Appl.Config).
+        CTemplateRenderer Templates;
+        /// @brief Index of the delivered files (content hash for the ETag).
+        CFileIndex Files;
+        /// @brief Running uploads, one per request.
+        CFileUploads Uploads;
     protected:
+        CMsgPostQueue m_oPostQueue;     // Status changes of the request handlers (network task)
+        CSimpleDelay  m_oFileCheckDelay = CSimpleDelay(FILE_INDEX_CHECK_INTERVAL); // Check the next file of the index for changes
      
 
     public:
@@ -67,8 +84,12 @@ class CWebServer : public AsyncWebServer, public IModule {
     
         /// @brief Register routes used to serve static files from the file system.
         void registerFileAccess();
-        /// @brief Deliver a requested file or a fallback response.
+        /// @brief Deliver a requested file (content type, gzip, ETag and Range).
         void deliverFile(AsyncWebServerRequest *pRequest);
+        /// @brief Register a route that streams the log files of a file log writer.
+        void registerLogAccess(CFileLogWriter *pWriter, const char *pszUrl = "/files/log");
+        /// @brief Send a template file, streamed with the placeholders replaced.
+        void sendTemplate(AsyncWebServerRequest *pRequest, const char *pszFileName, const char *pszContentType = "text/html");
         /// @brief Register built-in routes such as status/config endpoints.
         void registerDefaults();
         /// @brief Add/update authentication headers on a response.
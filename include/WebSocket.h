@@ -6,9 +6,59 @@
 #include "JsonNode.h"
 #include "Network.h"
 #include "DevelopmentHelper.h"
-#include <queue>
+#include "MsgQueue.h"
+#include "BatchLogWriter.h"
+#include "FileLogWriter.h"
+#include "BufferPool.h"
+#include "NamedValueTable.h"
+#include "StatusSubscriptions.h"
+#include "WebSocketStream.h"
+#include "WebSocketQuotas.h"
+#include "WebSocketAuthSessions.h"
+#include "WebSocketProtocols.h"
+#include "WebSocketCommands.h"
+#include "FileUpload.h"
 
-/// @brief Owns a complete WebSocket message assembled from one or more frames.
+#ifndef WS_MSG_QUEUE_SIZE
+    #define WS_MSG_QUEUE_SIZE 16
+#endif
+// Number of pooled message objects (queued messages and messages being assembled)
+#ifndef WS_POOL_MSG_COUNT
+    #define WS_POOL_MSG_COUNT (WS_MSG_QUEUE_SIZE + 4)
+#endif
+// Time budget (micro seconds) for dispatching queued messages in one loop iteration
+#ifndef WS_DISPATCH_BUDGET_US
+    #define WS_DISPATCH_BUDGET_US       5000
+#endif
+// Number of buffers per size class (128/512/2K/8K bytes) of the message buffer pool
+#ifndef WS_POOL_COUNT_128
+    #define WS_POOL_COUNT_128   8
+#endif
+#ifndef WS_POOL_COUNT_512
+    #define WS_POOL_COUNT_512   4
+#endif
+#ifndef WS_POOL_COUNT_2K
+    #ifdef ESP8266
+        #define WS_POOL_COUNT_2K    1
+    #else
+        #define WS_POOL_COUNT_2K    2
+    #endif
+#endif
+#ifndef WS_POOL_COUNT_8K
+    #ifdef ESP8266
+        #define WS_POOL_COUNT_8K    0
+    #else
+        #define WS_POOL_COUNT_8K    1
+    #endif
+#endif
+
+/**
+ * @brief Owns a complete WebSocket message assembled from one or more frames.
+ *
+ * Message objects and message buffers come from preallocated pools (see
+ * getObjectPool() and getBufferPool()), so steady WebSocket traffic does not
+ * fragment the heap. Oversized messages fall back to the heap.
+ */
 class CWebSocketMessage {
 
     public:
@@ -22,6 +72,10 @@ class CWebSocketMessage {
         AsyncWebSocket       *pSocket              = NULL;
         /// @brief Client that sent the message.
         AsyncWebSocketClient *pClient              = NULL;
+        /// @brief Id of the client (the client may be gone, when the message is dispatched).
+        uint32_t              ClientId             = 0;
+        /// @brief Sequence of a binary message, returned in the response.
+        uint16_t              Sequence             = 0;
         
         /**
          * @brief Construct a new Web Socket Message object
@@ -34,21 +88,47 @@ class CWebSocketMessage {
             DEBUG_FUNC_START_PARMS("size=%d,type=%d",nMessageSize,nType);
             this->pSocket       = pSocket;
             this->pClient       = pClient;
+            this->ClientId      = pClient ? pClient->id() : 0;
             this->MessageSize  = nMessageSize;
             this->MessageType   = nType;
-            this->pSerializedMessage = (char *) malloc(nMessageSize + 1);
-            memset(this->pSerializedMessage,'\0',nMessageSize + 1);
+            // The frames fill the buffer, so it is not cleared - only empty and terminated
+            this->pSerializedMessage = (char *) getBufferPool().allocate(nMessageSize + 1);
+            if(this->pSerializedMessage) {
+                this->pSerializedMessage[0]            = '\0';
+                this->pSerializedMessage[nMessageSize] = '\0';
+            }
             DEBUG_FUNC_END();
         };
 
-        /// @brief Release the assembled message buffer.
+        /// @brief Give the assembled message buffer back to the pool.
         ~CWebSocketMessage() {
-            if (pSerializedMessage != NULL) {
-                free(pSerializedMessage);
-                pSerializedMessage = NULL;
-            }
+            getBufferPool().release(pSerializedMessage);
+            pSerializedMessage = NULL;
         };
 
+        /// @brief Message objects are taken from the object pool.
+        static void * operator new(size_t nSize)   { return(getObjectPool().allocate(nSize)); }
+        static void   operator delete(void *pObj)  { getObjectPool().release(pObj); }
+
+        /// @brief Pool of the message objects.
+        static CBufferPool & getObjectPool() {
+            static const BufferPoolClass tClasses[] = { { sizeof(CWebSocketMessage), WS_POOL_MSG_COUNT } };
+            static CBufferPool oPool(tClasses,1);
+            return(oPool);
+        }
+
+        /// @brief Pool of the message buffers (message and terminator).
+        static CBufferPool & getBufferPool() {
+            static const BufferPoolClass tClasses[] = {
+                {  128, WS_POOL_COUNT_128 },
+                {  512, WS_POOL_COUNT_512 },
+                { 2048, WS_POOL_COUNT_2K  },
+                { 8192, WS_POOL_COUNT_8K  }
+            };
+            static CBufferPool oPool(tClasses,sizeof(tClasses) / sizeof(tClasses[0]));
+            return(oPool);
+        }
+
         /**
          * @brief Set the message data (segment).
          * @param pData Pointer to the data to be stored
@@ -57,7 +137,7 @@ class CWebSocketMessage {
          * @returns this object for further processing...
          */
         CWebSocketMessage * setMessageData(uint8_t *pData, uint64_t nIndex, size_t nDataLen) {
-            if((nIndex + nDataLen) <= MessageSize) {
+            if(pSerializedMessage && (nIndex + nDataLen) <= MessageSize) {
                 memcpy(pSerializedMessage + nIndex,pData,nDataLen);
             }
             return(this);
@@ -69,11 +149,47 @@ class CWebSocketMessage {
 struct WebSocketStatus {
     /// @brief millis() snapshot used as simple uptime/status marker.
     long uptime = millis();
+    /// @brief Received messages dropped, because the dispatch queue was full.
+    unsigned long DroppedMessages = 0;
 };
 
-#ifndef WS_NEEDS_AUTH
-    #define WS_NEEDS_AUTH "saveconfig,getbackup,restorebackup,restart,factoryreset"
-#endif
+class CWebSocket;
+
+/**
+ * @brief Status subscriptions of the WebSocket clients (see StatusSubscriptions.h).
+ *
+ * Request:
+ *      { "command":"subscribe", "payload": { "sections":"wifi,mqtt", "level":5, "interval":1000, "refresh":0 } }
+ * All payload values are optional, the default is the whole status at info level.
+ * "resync" requests a new snapshot, "unsubscribe" ends the subscription.
+ */
+class CWebSocketStatusPush : public CStatusSubscriptions {
+    private:
+        CWebSocket *m_pSocket;
+    protected:
+        bool sendStatus(uint32_t ulClientId, JsonNode &oMessage) override;
+        bool isConnected(uint32_t ulClientId) override;
+    public:
+        /// @brief Create the subscriptions of the application status for the clients of a WebSocket.
+        CWebSocketStatusPush(CWebSocket *pSocket);
+};
+
+/**
+ * @brief Streams of the WebSocket clients (see WebSocketStream.h).
+ *
+ * A fragment is only sent, while the send queue of the client is not full.
+ */
+class CWebSocketStreamer : public CWebSocketStreams {
+    private:
+        CWebSocket *m_pSocket;
+    protected:
+        bool canSend(uint32_t ulClientId) override;
+        bool isConnected(uint32_t ulClientId) override;
+        bool sendFragment(uint32_t ulClientId, const uint8_t *pData, size_t nLen) override;
+    public:
+        /// @brief Create the streams for the clients of a WebSocket.
+        CWebSocketStreamer(CWebSocket *pSocket) : m_pSocket(pSocket) {}
+};
 
 /// @brief Function pointer to register the routes
 // typedef void (funcDispatchMessage)(const WebSocketMessage *pMessage);
@@ -82,24 +198,48 @@ struct WebSocketStatus {
  * @brief WebSocket endpoint that queues messages and dispatches JSON commands.
  *
  * Incoming multi-frame messages are captured as CWebSocketMessage objects,
- * queued, and later dispatched from the application loop. Selected commands can
- * require authentication before they are processed.
+ * queued, and later dispatched from the application loop. Commands are found in
+ * a registry (built-in commands and commands of registerCommand()), selected
+ * commands require authentication before they are processed.
+ * Clients can subscribe to the application status, changes are pushed as
+ * merge patches when a module sends MSG_APPL_STATUS_CHANGED (pMessage = name
+ * of its status section, nullptr = all).
+ * Large responses (backup, log) are streamed in fragments, paced by the send
+ * queue of the client (see WebSocketStream.h).
+ * Clients, that request the subprotocol WS_BINARY_PROTOCOL at connect, send and
+ * receive CBOR messages with a compact header instead of JSON text (see
+ * WebSocketBinaryHeader). Both kinds of clients are served by the same commands.
+ * The status (dropped messages, use of the message pools) can be published by
+ *      => Appl.addStatusHandler("websocket",&oWebSocket);
  */
-class CWebSocket : public AsyncWebSocket, public IMsgEventReceiver {
+class CWebSocket : public AsyncWebSocket, public IMsgEventReceiver, public IStatusHandler, public IWebSocketCommandHandler {
     private:
-        std::queue<CWebSocketMessage *> m_tMsgQueue;
+        CSPSCQueue<CWebSocketMessage *,WS_MSG_QUEUE_SIZE> m_tMsgQueue; // Producer: socket callback, consumer: application loop
+        unsigned long       m_ulDispatchBudget = WS_DISPATCH_BUDGET_US;
         // CWebSocketMessage * m_pMsgQueue = NULL;             // received socket messages to be dispatched
-        String              m_strNeedsAuth = WS_NEEDS_AUTH; // Simple auth string with names
+        CWebSocketCommands  m_oCommands;                    // Registered commands (built-in and application)
         CSimpleDelay        m_oClientCleanupDelay = CSimpleDelay(60000); // cleanup every minute
+        std::atomic<bool>   m_bClientGone { false };        // Set by the socket callback, status subscriptions are purged by the loop
+        CFileLogWriter *    m_pLogWriter = nullptr;         // Log files of the log command (registerLogAccess())
+        CWebSocketMessage * m_pDispatching = nullptr;       // Message being dispatched, its responses get its sequence
+        CFileUpload *       m_pRestore = nullptr;           // Backup restored in parts (one client at a time)
+        uint32_t            m_ulRestoreClient = 0;          // Client of m_pRestore
 
     public:
-        WebSocketStatus Status; // The status info of the Websocket
+        WebSocketStatus  Status; // The status info of the Websocket
+        CWebSocketQuotas Quotas; // Queue quotas and drop counters per client
+        CWebSocketAuthSessions AuthSessions; // Validated access tokens per client
+        CWebSocketStatusPush StatusPush; // Status subscriptions of the clients
+        CWebSocketStreamer   Streams;    // Streamed responses to the clients
+        CWebSocketProtocols  Protocols;  // Clients using the binary subprotocol
 
     public:
         /// @brief Create a WebSocket endpoint and optionally register on the message bus.
         CWebSocket(const char *pszSocketName, bool bRegisterOnMsgBus = true);
-        /// @brief Dispatch all queued WebSocket messages.
+        /// @brief Dispatch queued WebSocket messages, until the time budget is used.
 		void dispatchMessageQueue();
+        /// @brief Set the time budget (micro seconds) of dispatchMessageQueue().
+        void setDispatchBudget(unsigned long ulBudgetMicros) { m_ulDispatchBudget = ulBudgetMicros; }
         /// @brief Dispatch one assembled WebSocket message.
 		virtual bool dispatchMessage(CWebSocketMessage *pMessage);
         /// @brief Dispatch one parsed JSON WebSocket request.
@@ -110,20 +250,72 @@ class CWebSocket : public AsyncWebSocket, public IMsgEventReceiver {
         virtual String getNeedsAuth();
         /// @brief Return true if the command requires authentication.
         virtual bool inline needsAuth(String &strCommand);
+        /// @brief Register a command handler (application commands go directly to their handler).
+        void registerCommand(const char *pszCommand, IWebSocketCommandHandler *pHandler, int nCommandId = 0, bool bNeedsAuth = false) {
+            m_oCommands.registerCommand(pszCommand,pHandler,nCommandId,bNeedsAuth);
+        }
+        /**
+         * @brief Register a command (needs auth), that streams the log files to the client.
+         * Request payload: { "bytes":<max. number of bytes> } (optional, default = the whole log).
+         */
+        void registerLogAccess(CFileLogWriter *pWriter, const char *pszCommand = "getlog");
+        /// @brief Process the built-in commands.
+        bool onWebSocketCommand(int nCommandId, JsonNode &oRequest, CWebSocketMessage *pMessage, bool bAuthenticated) override;
         /// @brief React to application loop/status events.
         int receiveEvent(const void * pSender, int nMsgId, const void * pMessage, int nType);
+        /// @brief Write the dropped messages and the counters of the message pools.
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel = STATUS_LEVEL_INFO) override;
         /// @brief AsyncWebSocket callback used to capture incoming frames/events.
         virtual void onWebSocketEvent(AsyncWebSocket *pServer, AsyncWebSocketClient *pClient, AwsEventType eType, void *arg, uint8_t *pData, size_t nLen);
 		
         /// @brief Send a JSON access-denied response to a client.
         void ICACHE_FLASH_ATTR sendAccessDeniedMessage(JsonNode &oDoc,AsyncWebSocketClient *pClient);
+        /// @brief Send a JSON error message { "command":"error", "data":<code>, "payload":{ "msg", "command" } } to a client.
+        void ICACHE_FLASH_ATTR sendErrorMessage(AsyncWebSocketClient *pClient, const char *pszCode, const char *pszMsg, const char *pszCommand = "");
         /// @brief Serialize and send a JSON document to one client or all clients.
 		void ICACHE_FLASH_ATTR sendJsonDocMessage(JsonNode &oDoc, AsyncWebSocket *pSocket = nullptr, AsyncWebSocketClient *pClient = nullptr);
+        /// @brief Serialize a JSON document once and send it to the clients with the given ids.
+        void ICACHE_FLASH_ATTR sendJsonDocMessage(JsonNode &oDoc, const uint32_t *pClientIds, size_t nClients);
+        /// @brief Encode and send a JSON document as binary (CBOR) message to one client.
+        void ICACHE_FLASH_ATTR sendBinaryDocMessage(JsonNode &oDoc, AsyncWebSocketClient *pClient);
+        /// @brief Encode and send a JSON document as binary (CBOR) message to the client with the id.
+        void ICACHE_FLASH_ATTR sendBinaryDocMessage(JsonNode &oDoc, uint32_t ulClientId);
+        /// @brief Stream a JSON document to a client (takes the ownership), sent at once if no stream is free.
+        void ICACHE_FLASH_ATTR streamJsonDocMessage(JsonNode *pDoc, AsyncWebSocketClient *pClient);
 	
     private:
         // void addMessageToQueue(AsyncWebSocket *pSocket, AsyncWebSocketClient *pClient, int nMessageSize);
+        /// @brief Register the built-in commands.
+        void registerBuiltInCommands();
+        /// @brief Decode a binary message into a JSON request, false if it is invalid.
+        bool parseBinaryMessage(CWebSocketMessage *pMessage, JsonNode &oRequest);
         /// @brief Validate request credentials for authenticated commands.
         bool checkAuth(JsonNode &oRequestDoc, AsyncWebSocketClient *pClient);
         /// @brief Add an assembled message object to the dispatch queue.
         void addMessageToQueue(CWebSocketMessage *pMsgObj);
+        /// @brief Tell the client, that its message was rejected (too large or quota exceeded).
+        void sendRejectedMessage(AsyncWebSocketClient *pClient, size_t nSize);
+        /// @brief Write a part of a backup, the config file is replaced by the final part.
+        bool restoreBackupPart(JsonNode &oPart, CWebSocketMessage *pMessage);
+        /// @brief Check a backup file (JSON config with wifi.ap_mode), before it is restored.
+        bool isValidBackup(const char *pszFileName);
+        /// @brief Abort a restore in parts (the config file is not changed).
+        void abortRestore();
+};
+
+/**
+ * @brief Log writer, that sends the log entries in batches to all WebSocket clients.
+ *
+ * Message format: { "command":"log", "data":"entries", "payload": <batch> }
+ * Entries are only collected, while a client is connected.
+ */
+class CWebSocketLogWriter : public CBatchLogWriter {
+    private:
+        CWebSocket *m_pSocket;
+    protected:
+        bool isReady() override;
+        void sendBatch(JsonNode &oBatch) override;
+    public:
+        /// @brief Create a log writer for the clients of a WebSocket.
+        CWebSocketLogWriter(CWebSocket *pSocket) : m_pSocket(pSocket) {}
 };
@@ -0,0 +1,80 @@
+#pragma once
+/**
+ * Authenticated sessions of the WebSocket clients
+ *
+ * Commands like saveconfig or getbackup need a valid access token. Validating a
+ * token decodes, decrypts and parses it, so the result is cached per client -
+ * further commands with the same token are checked against the cached session.
+ */
+#include <Runtime.h>
+#include <JsonNode.h>
+#include <WebSocketQuotas.h>
+#include <atomic>
+#include <functional>
+
+// Max. number of cached authenticated sessions (one per client)
+#ifndef WS_AUTH_SESSIONS
+    #define WS_AUTH_SESSIONS            WS_QUOTA_CLIENTS
+#endif
+// Max. length of a client IP address (text, IPv6)
+#ifndef WS_AUTH_IP_SIZE
+    #define WS_AUTH_IP_SIZE             46
+#endif
+
+/// @brief Validates a token of a client (decode, decrypt, check IP and time), sets the time stamp of the token.
+typedef std::function<bool(const char *pszToken, const char *pszIPAddress, unsigned long &ulTimeStamp)> WebSocketTokenValidator;
+
+/**
+ * @brief Cache of the validated access tokens per client.
+ *
+ * Validating a token decodes, decrypts and parses it - too much work for each
+ * command of a config editor. After a successful validation, the session of the
+ * client remembers the hash of the token, the client IP and the time stamp of
+ * the token. Further commands of the client with the same token are checked
+ * against this small struct, until the token expires or the
+ * client disconnects. Client ids are not reused by the socket, so a session is
+ * bound to one connection.
+ * Sessions are stored and checked by the application loop, the socket callback
+ * only invalidates them.
+ */
+class CWebSocketAuthSessions {
+    public:
+        /// @brief Validated token of one client.
+        struct AuthSession {
+            std::atomic<bool> Valid { false };
+            uint32_t        ClientId  = 0;
+            uint32_t        TokenHash = 0;
+            size_t          TokenLen  = 0;
+            unsigned long   TimeStamp = 0;      // millis() of the token creation
+            unsigned long   Lifetime  = 0;      // Lifetime (ms) of the token
+            char            IPAddress[WS_AUTH_IP_SIZE] = {0};
+        };
+
+    private:
+        AuthSession     m_tSessions[WS_AUTH_SESSIONS];
+        unsigned long   m_ulHits   = 0;         // Commands authenticated by the cache
+        unsigned long   m_ulMisses = 0;         // Commands, that needed a full validation
+
+        AuthSession * find(uint32_t ulClientId);
+
+    public:
+        /// @brief Check the token of a client against its cached session, false if it has to be validated (and stored) again.
+        bool check(uint32_t ulClientId, const char *pszToken, const char *pszIPAddress);
+        /// @brief Store the session of a client after its token was validated.
+        void store(uint32_t ulClientId, const char *pszToken, const char *pszIPAddress, unsigned long ulTimeStamp, unsigned long ulLifetime);
+        /// @brief Authenticate a command of a client (cached session or fnValidate), true if the token is valid for the client.
+        bool authenticate(uint32_t ulClientId, const char *pszToken, const char *pszIPAddress, unsigned long ulLifetime, WebSocketTokenValidator fnValidate);
+        /// @brief Return true if the client has a valid session, that is not expired.
+        bool isAuthenticated(uint32_t ulClientId);
+        /// @brief Remove the session of a client (i.E. on disconnect or an invalid token).
+        void invalidate(uint32_t ulClientId);
+        /// @brief Copy the ids of the clients with a valid session, that is not expired - returns the number of ids.
+        size_t getClientIds(uint32_t *pClientIds, size_t nMaxIds);
+        /// @brief Number of valid sessions.
+        size_t getSessions();
+        unsigned long getHits()     { return(m_ulHits); }
+        unsigned long getMisses()   { return(m_ulMisses); }
+
+        /// @brief Write the number of sessions and the cache counters.
+        void writeStatusTo(JsonNode &oStatusNode);
+};
@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * Registry of the WebSocket commands
+ *
+ * The built-in commands of CWebSocket and the commands of the application
+ * (CWebSocket::registerCommand()) are found by their name, a binary message by
+ * the id of the name (see WebSocketBinaryHeader). Selected commands need an
+ * authentication (WS_NEEDS_AUTH or registered with bNeedsAuth).
+ */
+#include <Runtime.h>
+#include <JsonNode.h>
+#include <NamedValueTable.h>
+
+#ifndef WS_NEEDS_AUTH
+    #define WS_NEEDS_AUTH "saveconfig,getbackup,restorebackup,restart,factoryreset"
+#endif
+
+class CWebSocketMessage;
+
+/**
+ * @brief Handler of registered WebSocket commands (see CWebSocket::registerCommand()).
+ */
+class IWebSocketCommandHandler {
+    public:
+        /**
+         * @brief Process a command.
+         * @param nCommandId Id given at registration (one handler may serve many commands).
+         * @param oRequest Parsed request, can be reused for the response.
+         * @param pMessage Received message (socket and client).
+         * @param bAuthenticated true if the request carried a valid auth token.
+         * @return true if the command was handled.
+         */
+        virtual bool onWebSocketCommand(int nCommandId, JsonNode &oRequest, CWebSocketMessage *pMessage, bool bAuthenticated) = 0;
+};
+
+/// @brief Registered WebSocket command.
+struct WebSocketCommand {
+    IWebSocketCommandHandler *pHandler  = nullptr;
+    int                       CommandId = 0;
+    bool                      NeedsAuth = false;    // RegisteredAuth or in the auth list
+    bool                      RegisteredAuth = false; // Needs auth by registerCommand(), kept by setNeedsAuth()
+    uint32_t                  WireId    = 0;        // Command id of binary messages (see WebSocketBinaryHeader)
+};
+
+/**
+ * @brief Registry of WebSocket commands by name.
+ *
+ * Names are case insensitive and found by a hash index - a lookup needs no
+ * allocation and no lower case copy of the command. The list of commands, that
+ * need authentication, is matched by whole names (comma separated).
+ */
+class CWebSocketCommands {
+    private:
+        CUniqueNameMultiValueTable<WebSocketCommand *> m_tCommands { false, nullptr };
+        String m_strNeedsAuth = WS_NEEDS_AUTH;
+
+    public:
+        CWebSocketCommands() { m_tCommands.enableHashIndex(); }
+        ~CWebSocketCommands();
+
+        /// @brief Check if a name is in a comma separated list (whole names, case insensitive).
+        static bool isInList(const char *pszList, const char *pszName);
+
+        /**
+         * @brief Register (or replace) a command.
+         * @param pszCommand Name of the command, must stay valid (i.E. a string literal).
+         * @param pHandler Handler of the command.
+         * @param nCommandId Id passed to the handler.
+         * @param bNeedsAuth true if the command needs authentication (also if it is in the auth list).
+         */
+        void registerCommand(const char *pszCommand, IWebSocketCommandHandler *pHandler, int nCommandId = 0, bool bNeedsAuth = false);
+
+        /// @brief Find a registered command, nullptr if unknown.
+        WebSocketCommand * find(const char *pszCommand) { return(m_tCommands.get(pszCommand)); }
+        /// @brief Name of the command with the id of a binary message, nullptr if unknown.
+        const char * getName(uint32_t ulWireId);
+
+        /// @brief Set the comma separated list of commands, that need authentication (in addition to the ones registered with bNeedsAuth).
+        void setNeedsAuth(const String &strCommands);
+        /// @brief Comma separated list of commands, that need authentication.
+        const String & getNeedsAuth() { return(m_strNeedsAuth); }
+        /// @brief Check if a command (registered or not) needs authentication.
+        bool needsAuth(const char *pszCommand);
+};
@@ -0,0 +1,94 @@
+#pragma once
+/**
+ * Binary subprotocol of the WebSocket clients
+ *
+ * A client, that requests the subprotocol WS_BINARY_PROTOCOL at connect, sends
+ * and receives CBOR messages with a compact header (WebSocketBinaryHeader)
+ * instead of JSON text. The other clients use JSON text, both are served by the
+ * same commands.
+ */
+#include <Runtime.h>
+#include <JsonNode.h>
+#include <WebSocketQuotas.h>
+#include <atomic>
+
+// Name of the binary subprotocol (Sec-WebSocket-Protocol), other clients use JSON text
+#ifndef WS_BINARY_PROTOCOL
+    #define WS_BINARY_PROTOCOL          "lsc.cbor"
+#endif
+// Max. number of clients using the binary subprotocol
+#ifndef WS_BINARY_CLIENTS
+    #define WS_BINARY_CLIENTS           WS_QUOTA_CLIENTS
+#endif
+// Number of handshakes, that wait for their connect event
+#ifndef WS_BINARY_PENDING
+    #define WS_BINARY_PENDING           4
+#endif
+
+#define WS_BINARY_MAGIC             0xB1    // First byte of a binary message (version 1)
+#define WS_BINARY_HEADER_SIZE       8
+#define WS_BINARY_FLAG_RESPONSE     0x01    // Response to the request with the same sequence
+#define WS_BINARY_FLAG_ERROR        0x02    // Error message (i.E. access denied)
+
+/**
+ * @brief Header of a binary message (big endian).
+ *
+ *      [0]    WS_BINARY_MAGIC
+ *      [1]    Flags
+ *      [2..5] Command id - LSC::getHashNoCase() of the command name, 0 = the name is in the body
+ *      [6..7] Sequence - set by the client, returned in the response
+ * The header is followed by the CBOR encoded message (a map, like the JSON
+ * message), the body can be empty for commands without payload.
+ */
+struct WebSocketBinaryHeader {
+    uint8_t     Flags     = 0;
+    uint32_t    CommandId = 0;
+    uint16_t    Sequence  = 0;
+
+    /// @brief Id of a command name, 0 for an empty name.
+    static uint32_t getCommandId(const char *pszCommand);
+    /// @brief Write the header (WS_BINARY_HEADER_SIZE bytes).
+    void write(uint8_t *pBuffer) const;
+    /// @brief Read the header, false if the data is no binary message.
+    bool read(const uint8_t *pData, size_t nLen);
+};
+
+/**
+ * @brief Clients, that negotiated the binary subprotocol.
+ *
+ * A client requests WS_BINARY_PROTOCOL in the Sec-WebSocket-Protocol header of
+ * the handshake. The handshake has no client id yet, so its peer (IP and port)
+ * is remembered until the connect event of the client. The table has a fixed
+ * size, further clients use JSON text. Handshake, connect and disconnect come
+ * from the socket callback, the application loop only reads the table.
+ */
+class CWebSocketProtocols {
+    private:
+        std::atomic<uint32_t> m_tClients[WS_BINARY_CLIENTS];   // Client ids, 0 = free
+        std::atomic<uint32_t> m_tPending[WS_BINARY_PENDING];   // Peer keys of the handshakes
+        std::atomic<size_t>   m_nNextPending { 0 };
+        std::atomic<unsigned long> m_ulRejected { 0 };          // Binary clients without free slot
+
+    public:
+        CWebSocketProtocols();
+
+        /// @brief Key of a peer (IP address and port), never 0.
+        static uint32_t getPeerKey(const char *pszIPAddress, uint16_t usPort);
+        /// @brief Check if the binary subprotocol is in the requested protocols (comma separated).
+        static bool isRequested(const char *pszProtocols);
+
+        /// @brief Remember the peer of a handshake, that requested the binary subprotocol.
+        void offer(uint32_t ulPeerKey);
+        /// @brief Connect a client, true if it uses the binary subprotocol (its peer was offered).
+        bool connect(uint32_t ulClientId, uint32_t ulPeerKey);
+        /// @brief Remove a client (i.E. on disconnect).
+        void disconnect(uint32_t ulClientId);
+        /// @brief Check if a client uses the binary subprotocol.
+        bool isBinary(uint32_t ulClientId);
+        /// @brief Number of clients using the binary subprotocol.
+        size_t getBinaryClients();
+        unsigned long getRejected() { return(m_ulRejected); }
+
+        /// @brief Write the number of binary clients.
+        void writeStatusTo(JsonNode &oStatusNode);
+};
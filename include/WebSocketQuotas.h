@@ -0,0 +1,82 @@
+#pragma once
+/**
+ * Queue quotas of the WebSocket clients
+ *
+ * Received messages are queued by the socket callback and dispatched by the
+ * application loop. Each client may only fill its own share of the queue
+ * (number of messages and bytes), a chatty client can not starve the others.
+ * The table has one slot per connected client - it is also the list of the
+ * clients, a broadcast of the application loop is sent to.
+ */
+#include <Runtime.h>
+#include <JsonNode.h>
+#include <atomic>
+
+// Max. size of a received message, larger messages are rejected at the first frame (with an error message).
+// A larger backup is restored in parts (see restorebackup in doc/CWebSocket.md).
+#ifndef WS_MAX_MESSAGE_SIZE
+    #define WS_MAX_MESSAGE_SIZE         8192
+#endif
+// Max. number of queued messages of one client
+#ifndef WS_CLIENT_QUOTA_MESSAGES
+    #define WS_CLIENT_QUOTA_MESSAGES    4
+#endif
+// Max. number of queued bytes of one client
+#ifndef WS_CLIENT_QUOTA_BYTES
+    #define WS_CLIENT_QUOTA_BYTES       8192
+#endif
+// Max. number of clients with quota accounting (further clients are rejected)
+#ifndef WS_QUOTA_CLIENTS
+    #define WS_QUOTA_CLIENTS            8
+#endif
+
+/**
+ * @brief Per client accounting of the queued messages.
+ *
+ * The socket callback reserves the quota, before a message is allocated, the
+ * application loop releases it after the message has been dispatched. So a
+ * chatty client can only fill its own share of the queue. The table has a fixed
+ * size - a slot is reused, when its client disconnected and its messages are gone.
+ */
+class CWebSocketQuotas {
+    public:
+        /// @brief Accounting of one client.
+        struct ClientQuota {
+            std::atomic<uint32_t>       ClientId  { 0 };
+            std::atomic<bool>           Connected { false };
+            std::atomic<size_t>         Messages  { 0 };    // Queued messages
+            std::atomic<size_t>         Bytes     { 0 };    // Queued bytes
+            std::atomic<unsigned long>  Dropped   { 0 };    // Messages dropped (quota or queue full)
+            std::atomic<unsigned long>  Oversized { 0 };    // Messages rejected (larger than WS_MAX_MESSAGE_SIZE)
+        };
+
+    private:
+        ClientQuota     m_tClients[WS_QUOTA_CLIENTS];
+        size_t          m_nMaxMessages = WS_CLIENT_QUOTA_MESSAGES;
+        size_t          m_nMaxBytes    = WS_CLIENT_QUOTA_BYTES;
+        std::atomic<unsigned long> m_ulRejected { 0 };      // Messages of clients without slot
+
+        ClientQuota * getSlot(uint32_t ulClientId, bool bCreate);
+
+    public:
+        /// @brief Set the max. number of queued messages and bytes per client.
+        void setLimits(size_t nMaxMessages, size_t nMaxBytes) { m_nMaxMessages = nMaxMessages; m_nMaxBytes = nMaxBytes; }
+        /// @brief Take the slot of a new client (callback side), false if no slot is free.
+        bool connect(uint32_t ulClientId);
+        /// @brief Reserve the quota for a new message (callback side), false if it exceeds the quota of the client.
+        bool reserve(uint32_t ulClientId, size_t nSize);
+        /// @brief Release the quota of a dispatched or dropped message (either side).
+        void release(uint32_t ulClientId, size_t nSize, bool bDropped = false);
+        /// @brief Mark the client as disconnected, its slot is reused when its messages are gone.
+        void disconnect(uint32_t ulClientId);
+        /// @brief Copy the ids of the connected clients, returns the number of ids.
+        size_t getClientIds(uint32_t *pClientIds, size_t nMaxIds);
+
+        /// @brief Accounting of a client, nullptr if unknown.
+        ClientQuota * getClient(uint32_t ulClientId) { return(getSlot(ulClientId,false)); }
+        /// @brief Messages rejected, because no slot was free.
+        unsigned long getRejected() { return(m_ulRejected); }
+
+        /// @brief Write the accounting of the connected clients (section per client id).
+        void writeStatusTo(JsonNode &oStatusNode);
+};
@@ -0,0 +1,150 @@
+#pragma once
+/**
+ * Streamed WebSocket responses
+ *
+ * Large responses (backup, log files) are not built as one text and sent as one
+ * frame - on an ESP8266 the text alone may not fit into the heap. A stream sends
+ * one logical message as a sequence of binary fragments. The fragments are
+ * produced lazily by a filler function (like the chunked responses of the web
+ * server), only while the send queue of the client has room. The text of the
+ * message is never built - a filler reads a file (CWebSocketFileReader) or
+ * serializes a document (CJsonSerializer) fragment by fragment.
+ *
+ * Fragment format (binary frame, header is text):
+ *      "@<stream id>,<seq>,<final>[,<command>,<data>]\n" <fragment data>
+ * The first fragment (seq 0) carries command and data, empty for JSON streams.
+ * The last fragment has final = 1 and no data. The receiver concatenates the
+ * fragments of a stream; a JSON stream is a complete message, a text stream is
+ * the payload of { "command":<command>, "data":<data>, "payload":<text> }.
+ */
+#include <Runtime.h>
+#include <StatusHandler.h>
+#include <functional>
+#ifndef NATIVE_RUNTIME
+    #include <LittleFS.h>
+#endif
+
+// Max. number of data bytes in one fragment
+#ifndef WS_STREAM_FRAGMENT_SIZE
+    #define WS_STREAM_FRAGMENT_SIZE         1024
+#endif
+// Max. number of active streams (all clients)
+#ifndef WS_STREAM_MAX
+    #define WS_STREAM_MAX                   2
+#endif
+// Max. number of fragments of a stream sent in one loop iteration
+#ifndef WS_STREAM_FRAGMENTS_PER_LOOP
+    #define WS_STREAM_FRAGMENTS_PER_LOOP    4
+#endif
+// Max. size of a fragment header
+#ifndef WS_STREAM_HEADER_SIZE
+    #define WS_STREAM_HEADER_SIZE           64
+#endif
+
+/**
+ * @brief Produces the data of a stream.
+ * @param pBuffer Buffer to fill.
+ * @param nMaxLen Max. number of bytes.
+ * @param nIndex Number of bytes produced so far.
+ * @return Number of bytes written to the buffer, 0 at the end of the data.
+ */
+typedef std::function<size_t(uint8_t *pBuffer, size_t nMaxLen, size_t nIndex)> WebSocketStreamFiller;
+
+/**
+ * @brief Reads a file for a stream, enclosed in a prefix and a suffix
+ *        (i.E. a JSON file as payload of a message). The file is read from
+ *        the file system fragment by fragment, it is never loaded as a whole.
+ */
+class CWebSocketFileReader {
+    private:
+        String      m_strPrefix;
+        String      m_strSuffix;
+        #ifdef NATIVE_RUNTIME
+            FILE *  m_pFile = nullptr;
+        #else
+            File    m_oFile;
+        #endif
+        size_t      m_nFileSize = 0;
+        size_t      m_nIndex    = 0;            // Bytes read so far (prefix, file and suffix)
+
+        size_t readFile(uint8_t *pBuffer, size_t nMaxLen);
+
+    public:
+        CWebSocketFileReader(const char *pszPath, const char *pszPrefix = "", const char *pszSuffix = "");
+        ~CWebSocketFileReader();
+        CWebSocketFileReader(const CWebSocketFileReader &) = delete;
+        CWebSocketFileReader & operator=(const CWebSocketFileReader &) = delete;
+
+        /// @brief Size of the file, 0 if it cannot be opened.
+        size_t getFileSize() { return(m_nFileSize); }
+        /// @brief Read the next part, returns 0 at the end.
+        size_t read(uint8_t *pBuffer, size_t nMaxLen);
+};
+
+/**
+ * @brief Sends streams as fragments, paced by the send queues of the clients.
+ *        Derived classes implement the transport (canSend(), sendFragment()).
+ */
+class CWebSocketStreams : public IStatusHandler {
+    private:
+        struct Stream {
+            bool                    Active   = false;
+            uint32_t                Id       = 0;
+            uint32_t                ClientId = 0;
+            size_t                  Seq      = 0;       // Number of the next fragment
+            size_t                  Index    = 0;       // Bytes produced so far
+            WebSocketStreamFiller   Filler;
+            String                  Command;
+            String                  Data;
+        };
+        Stream          m_tStreams[WS_STREAM_MAX];
+        uint32_t        m_ulNextId   = 1;
+        uint8_t *       m_pFragment  = nullptr;         // Fragment buffer, only while streams are active
+
+        unsigned long   m_ulStreams   = 0;              // Started streams
+        unsigned long   m_ulFragments = 0;              // Sent fragments
+        unsigned long   m_ulBytes     = 0;              // Sent data bytes
+        unsigned long   m_ulWaits     = 0;              // Send queue of a client was full
+        unsigned long   m_ulAborted   = 0;              // Streams of gone clients
+        unsigned long   m_ulRejected  = 0;              // Streams without free slot
+
+        void finish(Stream &oStream);
+
+    protected:
+        /// @brief Return true if the send queue of the client has room for a fragment.
+        virtual bool canSend(uint32_t ulClientId) = 0;
+        /// @brief Return false if the client is gone (its streams are aborted).
+        virtual bool isConnected(uint32_t ulClientId) = 0;
+        /// @brief Send a fragment (binary) to the client, return false if it failed.
+        virtual bool sendFragment(uint32_t ulClientId, const uint8_t *pData, size_t nLen) = 0;
+
+    public:
+        virtual ~CWebSocketStreams();
+
+        /**
+         * @brief Start a stream to a client, it is sent by process().
+         * @param ulClientId Client to send the stream to.
+         * @param fnFiller Producer of the data.
+         * @param pszCommand Command of a text stream, nullptr for a JSON message.
+         * @param pszData Data type of a text stream.
+         * @return Id of the stream, 0 if no slot is free.
+         */
+        uint32_t start(uint32_t ulClientId, WebSocketStreamFiller fnFiller, const char *pszCommand = nullptr, const char *pszData = nullptr);
+        /// @brief Start a stream of a JSON message, the stream takes the ownership of the document.
+        uint32_t startJson(uint32_t ulClientId, JsonNode *pDoc);
+        /// @brief Send the next fragments of the active streams (call it from the loop).
+        void process();
+        /// @brief Stop all streams of a client.
+        void abort(uint32_t ulClientId);
+
+        /// @brief Number of active streams.
+        size_t getActive();
+        unsigned long getFragments()    { return(m_ulFragments); }
+        unsigned long getBytes()        { return(m_ulBytes); }
+        unsigned long getWaits()        { return(m_ulWaits); }
+        unsigned long getAborted()      { return(m_ulAborted); }
+        unsigned long getRejected()     { return(m_ulRejected); }
+
+        /// @brief Write the stream counters.
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel = STATUS_LEVEL_INFO) override;
+};
@@ -44,13 +44,20 @@
  * @brief Create the global application hub.
  *
  * The constructor initializes serial logging when enabled, wires the event log
- * to the message bus, registers the application itself as event receiver and
- * exposes the local variable table under the "cfg" config section.
+ * to the message bus (optionally through the log ring, see LSC_APPL_LOG_RING), registers the
+ * application itself as event receiver and exposes the local variable table under
+ * the "cfg" config section.
  */
 CAppl::CAppl() {
 	if(LSC_APPL_SERIAL_SPEED > 0) Serial.begin(LSC_APPL_SERIAL_SPEED);
-    Log = CEventLogger(&MsgBus);
 	MsgBus.registerEventReceiver(this,"Appl");
+	#if LSC_APPL_LOG_RING
+		Log = CEventLogger(&MsgBus,&LogRing);
+		MsgBus.registerEventReceiver(&LogRing,"LogRing");
+		addStatusHandler("logring",&LogRing);
+	#else
+		Log = CEventLogger(&MsgBus);
+	#endif
 	addConfigHandler("cfg",&Config);
 }  
 
@@ -84,10 +91,16 @@ void CAppl::start(void * pMsg, int nType) {
 
 /**
  * @brief Dispatch a periodic loop message to all registered event receivers.
+ *
+ * Events posted from other tasks (see CMsgPostQueue::post()) are sent first,
+ * so they are processed on the application task. Suppressed log repeats, whose
+ * window is over, are reported before the loop event.
  * @param nMsgType Optional message class/type.
  * @param pMsg Optional message payload.
  */
 void CAppl::dispatch(int nMsgType,const void *pMsg) {
+	this->MsgBus.dispatchPostedEvents();
+	this->Log.flushRepeats();
 	this->MsgBus.sendEvent(this,MSG_APPL_LOOP,pMsg,nMsgType);
 }
 
@@ -146,6 +159,9 @@ void CAppl::reboot(int nDelay, bool bForce) {
 	int nResult = MsgBus.sendEvent(this,MSG_APPL_SHUTDOWN,nullptr,0);
 	if(nResult == EVENT_MSG_RESULT_OK || bForce) {
 		Log.log("W",F("Restarting system..."));
+		#if LSC_APPL_LOG_RING
+			LogRing.flush();
+		#endif
 		delay(nDelay);
 		ESP.restart();
 	}
@@ -201,6 +217,11 @@ bool CAppl::readConfigFrom(const char *pszConfigFileName, int nJsonDocSize) {
 	
     if(oFS.loadJsonContentFromFile(pszConfigFileName,oCfgData)) {
 		DEBUG_INFOS("Configuration loaded from file: %s",pszConfigFileName);
+		// Apply the changes, saved after the file has been written
+		if(strcmp(pszConfigFileName,ConfigJournal.getBaseFile()) == 0) {
+			ConfigJournal.replayFile(oCfgData);
+			ConfigJournal.remember(oCfgData);
+		}
 		DEBUG_JSON_OBJ(oCfgData);
 		migrateConfig(oCfgData);
         readConfigFrom(oCfgData);
@@ -246,8 +267,9 @@ void CAppl::migrateConfig(JsonNode & oCfgData) {
 /** 
  * @brief Persist the current configuration to the file system.
  *
- * The existing config file is loaded first so unknown keys are preserved. Delete
- * the file beforehand if a clean generated config is desired.
+ * For JSON_APPL_CONFIG_FILE only the changed settings are appended to the config
+ * journal, the journal compacts itself into the config file when it gets too large.
+ * Other files are loaded first so unknown keys are preserved, then rewritten.
  *
  * @param pszConfigFileName The configuration FileName (Default is /config.json)
  * @param nJsonDocSize      The size of the expected total size, othterwies JSON_CONFIG_DEFAULT_SIZE is used.
@@ -258,15 +280,22 @@ bool CAppl::saveConfig(const char *pszConfigFileName, int nJsonDocSize) {
 	DEBUG_FUNC_START_PARMS("%s,%d",NULL_POINTER_STRING(pszConfigFileName),nJsonDocSize);
 	if(!pszConfigFileName) pszConfigFileName = JSON_APPL_CONFIG_FILE;
 	JsonNode oCfgDoc;
-	CFS oFS;
-	// load existing config file from the file system first, to keep unknown settings in place
-	// then write the current config into the loaded document...
-	oFS.loadJsonContentFromFile(pszConfigFileName,oCfgDoc);
-	// Add the current timestamp
-	oCfgDoc["TS"] = getISODateTime();
-	writeConfigTo(oCfgDoc,false);
-
-	bool bResult = oFS.saveJsonContentToFile(pszConfigFileName,oCfgDoc);
+	bool bResult = false;
+	if(strcmp(pszConfigFileName,ConfigJournal.getBaseFile()) == 0) {
+		// Unknown settings stay in the config file, the journal contains only changes
+		oCfgDoc["TS"] = getISODateTime();
+		writeConfigTo(oCfgDoc,false);
+		bResult = ConfigJournal.save(oCfgDoc);
+	} else {
+		CFS oFS;
+		// load existing config file from the file system first, to keep unknown settings in place
+		// then write the current config into the loaded document...
+		oFS.loadJsonContentFromFile(pszConfigFileName,oCfgDoc);
+		// Add the current timestamp
+		oCfgDoc["TS"] = getISODateTime();
+		writeConfigTo(oCfgDoc,false);
+		bResult = oFS.saveJsonContentToFile(pszConfigFileName,oCfgDoc);
+	}
 	DEBUG_FUNC_END_PARMS("%s",bResult ? "OK" : "ERROR");
     return(bResult);
 }
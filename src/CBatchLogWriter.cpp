@@ -0,0 +1,116 @@
+#ifndef DEBUG_LSC_LOGGING
+    #undef DEBUGINFOS
+#endif
+
+#include <BatchLogWriter.h>
+#include <DevelopmentHelper.h>
+#include <algorithm>
+
+#pragma region Implementation of CBatchLogWriter
+
+/**
+ * @brief Sets the rate limit.
+ * @param nEntriesPerSecond Max. number of entries per second, 0 = no limit.
+ */
+void CBatchLogWriter::setRateLimit(unsigned int nEntriesPerSecond) {
+    m_nRateLimit = nEntriesPerSecond;
+    m_ulTokens   = nEntriesPerSecond * 1000UL;
+    m_ulRateTime = millis();
+}
+
+/**
+ * @brief Takes a token of the rate limit (token bucket).
+ * The bucket is refilled with m_nRateLimit tokens per second, max. one second of tokens.
+ * @return false if the entry exceeds the rate limit.
+ */
+bool CBatchLogWriter::takeRateToken() {
+    if(m_nRateLimit == 0) return(true);
+    unsigned long ulNow = millis();
+    m_ulTokens   = std::min(m_ulTokens + (ulNow - m_ulRateTime) * m_nRateLimit,m_nRateLimit * 1000UL);
+    m_ulRateTime = ulNow;
+    if(m_ulTokens < 1000) return(false);
+    m_ulTokens -= 1000;
+    return(true);
+}
+
+/**
+ * @brief Adds a log entry to the batch.
+ *
+ * The entry is dropped, if the destination is not ready, the rate limit is
+ * exceeded or the entry is larger than the batch buffer. A full batch is sent
+ * before the entry is added.
+ */
+void CBatchLogWriter::writeLogEntry(const char *pszType, const char *pszMessage) {
+    if(m_bSending || !isReady() || !takeRateToken()) {
+        m_ulDropped++;
+        m_ulDroppedUnsent++;
+        return;
+    }
+    char szPrefix[24];
+    snprintf(szPrefix,sizeof(szPrefix),"%lu [%s] ",millis(),pszType ? pszType : "");
+    size_t nPrefixLen  = strlen(szPrefix);
+    size_t nMessageLen = pszMessage ? strlen(pszMessage) : 0;
+    size_t nLen = nPrefixLen + nMessageLen + 1;
+    if(nLen > LOG_BATCH_BUFFER_SIZE) {
+        m_ulDropped++;
+        m_ulDroppedUnsent++;
+        return;
+    }
+    if(m_nBatched + nLen > LOG_BATCH_BUFFER_SIZE) flush();
+    if(m_nEntries == 0) m_ulFirstEntry = millis();
+    memcpy(m_tBatch + m_nBatched,szPrefix,nPrefixLen);
+    if(nMessageLen > 0) memcpy(m_tBatch + m_nBatched + nPrefixLen,pszMessage,nMessageLen);
+    m_tBatch[m_nBatched + nLen - 1] = '\0';
+    m_nBatched += nLen;
+    m_nEntries++;
+}
+
+/**
+ * @brief Adds a JSON log entry as text to the batch.
+ */
+void CBatchLogWriter::writeLogEntry(const char *pszType, JsonNode *pDoc) {
+    if(pDoc) writeLogEntry(pszType,pDoc->getAsJsonText());
+}
+
+/**
+ * @brief Sends the collected entries as one batch.
+ * Log entries written while the batch is sent (i.E. by the destination) are dropped.
+ * If the destination is not ready, the collected entries are counted as dropped.
+ */
+void CBatchLogWriter::flush() {
+    DEBUG_FUNC_START();
+    if((m_nEntries > 0 || m_ulDroppedUnsent > 0) && isReady()) {
+        JsonNode oBatch;
+        oBatch.setValue("dropped",m_ulDroppedUnsent);
+        JsonNode *pEntries = oBatch.createArray("entries");
+        for(size_t nPos = 0; nPos < m_nBatched; nPos += strlen(m_tBatch + nPos) + 1) {
+            pEntries->createElement()->setValue(m_tBatch + nPos);
+        }
+        m_bSending = true;
+        sendBatch(oBatch);
+        m_bSending = false;
+        m_ulSent         += m_nEntries;
+        m_ulBatches++;
+        m_ulDroppedUnsent = 0;
+    } else if(m_nEntries > 0) {
+        // The destination is gone - the entries are lost
+        m_ulDropped       += m_nEntries;
+        m_ulDroppedUnsent += m_nEntries;
+    }
+    m_nBatched = 0;
+    m_nEntries = 0;
+    DEBUG_FUNC_END();
+}
+
+/**
+ * @brief Receives the log events, sends the batch when its first entry is older than the flush interval.
+ */
+int CBatchLogWriter::receiveEvent(const void *pSender, int nMsgType, const void *pMessage, int nClass) {
+    int nResult = CLogWriter::receiveEvent(pSender,nMsgType,pMessage,nClass);
+    if(nMsgType == MSG_APPL_LOOP && (m_nEntries > 0 || m_ulDroppedUnsent > 0)) {
+        if(millis() - m_ulFirstEntry >= m_ulFlushInterval) flush();
+    }
+    return(nResult);
+}
+
+#pragma endregion
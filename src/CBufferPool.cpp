@@ -0,0 +1,155 @@
+#include <BufferPool.h>
+
+// Buffers are aligned, so they can hold any object (i.E. via operator new)
+#define BUFFER_POOL_ALIGN(nSize)   (((nSize) + 7) & ~((size_t) 7))
+
+#pragma region Critical section
+
+void CBufferPool::lock() {
+    #ifdef NATIVE_RUNTIME
+        m_oLock.lock();
+    #elif defined(ESP32)
+        portENTER_CRITICAL_SAFE(&m_tLock);
+    #else
+        m_ulSavedPS = xt_rsil(15);
+    #endif
+}
+
+void CBufferPool::unlock() {
+    #ifdef NATIVE_RUNTIME
+        m_oLock.unlock();
+    #elif defined(ESP32)
+        portEXIT_CRITICAL_SAFE(&m_tLock);
+    #else
+        xt_wsr_ps(m_ulSavedPS);
+    #endif
+}
+
+#pragma endregion
+
+#pragma region Implementation of CBufferPool
+
+/**
+ * @brief Creates the pool and reserves one block for the buffers of all classes.
+ * If the block cannot be allocated, all requests are served by the heap.
+ */
+CBufferPool::CBufferPool(const BufferPoolClass *pClasses, size_t nClasses) {
+    m_nClasses = nClasses < BUFFER_POOL_MAX_CLASSES ? nClasses : BUFFER_POOL_MAX_CLASSES;
+    for(size_t nIdx = 0; nIdx < m_nClasses; nIdx++) {
+        m_tClasses[nIdx].Size  = BUFFER_POOL_ALIGN(pClasses[nIdx].Size);
+        m_tClasses[nIdx].Count = pClasses[nIdx].Count;
+        m_nBlockSize += m_tClasses[nIdx].Size * m_tClasses[nIdx].Count;
+    }
+    if(m_nBlockSize > 0) m_pBlock = (char *) malloc(m_nBlockSize);
+    if(!m_pBlock) {
+        m_nBlockSize = 0;
+        m_nClasses   = 0;
+    }
+    char *pNext = m_pBlock;
+    for(size_t nIdx = 0; nIdx < m_nClasses; nIdx++) {
+        PoolClass &oClass = m_tClasses[nIdx];
+        oClass.pBuffers = pNext;
+        oClass.pFree    = new void*[oClass.Count > 0 ? oClass.Count : 1];
+        for(size_t nBuffer = 0; nBuffer < oClass.Count; nBuffer++) {
+            oClass.pFree[oClass.nFree++] = pNext;
+            pNext += oClass.Size;
+        }
+    }
+}
+
+CBufferPool::~CBufferPool() {
+    for(size_t nIdx = 0; nIdx < m_nClasses; nIdx++) delete[] m_tClasses[nIdx].pFree;
+    if(m_pBlock) free(m_pBlock);
+}
+
+/**
+ * @brief Gets a buffer of at least nSize bytes.
+ *
+ * The smallest size class, that fits and has a free buffer, is used. Each class,
+ * that fits but is used up, counts as exhausted. Oversized requests and requests,
+ * that found no free buffer, are served by the heap.
+ * @param nSize Requested size in bytes.
+ * @return Buffer (not initialized), nullptr if the heap is out of memory.
+ */
+void * CBufferPool::allocate(size_t nSize) {
+    void *pBuffer = nullptr;
+    bool bFits = false;
+    lock();
+    for(size_t nIdx = 0; nIdx < m_nClasses && !pBuffer; nIdx++) {
+        PoolClass &oClass = m_tClasses[nIdx];
+        if(oClass.Size < nSize) continue;
+        bFits = true;
+        if(oClass.nFree == 0) {
+            oClass.Exhausted++;
+        } else {
+            pBuffer = oClass.pFree[--oClass.nFree];
+            if(oClass.Count - oClass.nFree > oClass.HighWater) oClass.HighWater = oClass.Count - oClass.nFree;
+            m_ulHits++;
+        }
+    }
+    if(!pBuffer) {
+        if(bFits) m_ulHeap++;
+        else      m_ulOversized++;
+    }
+    unlock();
+    if(!pBuffer) pBuffer = malloc(nSize > 0 ? nSize : 1);
+    return(pBuffer);
+}
+
+/**
+ * @brief Gives a buffer back - pool buffers go back to the free list of their class.
+ * @param pBuffer Buffer of allocate(), nullptr is ignored.
+ */
+void CBufferPool::release(void *pBuffer) {
+    if(!pBuffer) return;
+    if(!isPoolBuffer(pBuffer)) {
+        free(pBuffer);
+        return;
+    }
+    lock();
+    for(size_t nIdx = 0; nIdx < m_nClasses; nIdx++) {
+        PoolClass &oClass = m_tClasses[nIdx];
+        if((char *) pBuffer < oClass.pBuffers + oClass.Size * oClass.Count) {
+            oClass.pFree[oClass.nFree++] = pBuffer;
+            break;
+        }
+    }
+    unlock();
+}
+
+unsigned long CBufferPool::getExhausted() {
+    unsigned long ulExhausted = 0;
+    for(size_t nIdx = 0; nIdx < m_nClasses; nIdx++) ulExhausted += m_tClasses[nIdx].Exhausted;
+    return(ulExhausted);
+}
+
+size_t CBufferPool::getFree() {
+    size_t nFree = 0;
+    for(size_t nIdx = 0; nIdx < m_nClasses; nIdx++) nFree += m_tClasses[nIdx].nFree;
+    return(nFree);
+}
+
+/**
+ * @brief Writes the hit rate (percent of requests served by the pool), the heap
+ *        fallbacks and one section per size class (named by its size).
+ */
+void CBufferPool::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
+    unsigned long ulRequests = m_ulHits + m_ulHeap + m_ulOversized;
+    oStatusNode.setValue("hits",      m_ulHits);
+    oStatusNode.setValue("heap",      m_ulHeap);
+    oStatusNode.setValue("oversized", m_ulOversized);
+    oStatusNode.setValue("exhausted", getExhausted());
+    oStatusNode.setValue("hitrate",   (int) (ulRequests > 0 ? m_ulHits * 100 / ulRequests : 100));
+    if(nLevel >= STATUS_LEVEL_VERBOSE) {
+        for(size_t nIdx = 0; nIdx < m_nClasses; nIdx++) {
+            PoolClass &oClass = m_tClasses[nIdx];
+            JsonNode *pClass = oStatusNode.getObject(std::to_string(oClass.Size).c_str(),true);
+            pClass->setValue("count",     (int) oClass.Count);
+            pClass->setValue("free",      (int) oClass.nFree);
+            pClass->setValue("highwater", (int) oClass.HighWater);
+            pClass->setValue("exhausted", oClass.Exhausted);
+        }
+    }
+}
+
+#pragma endregion
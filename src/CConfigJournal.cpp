@@ -0,0 +1,308 @@
+#ifndef DEBUG_LSC_APPL
+    #undef DEBUGINFOS
+#endif
+
+#include <ConfigJournal.h>
+#include <LSCUtils.h>
+#include <DevelopmentHelper.h>
+#ifdef NATIVE_RUNTIME
+    #include <stdio.h>
+#else
+    #include <LittleFS.h>
+#endif
+
+#pragma region File access
+
+/**
+ * @brief Reads a whole file into a string.
+ * @return true if the file could be opened.
+ */
+static bool readJournalFile(const char *pszFileName, String &strData) {
+    bool bResult = false;
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszFileName,"r");
+        if(pFile) {
+            char szBuffer[512];
+            size_t nRead;
+            while((nRead = fread(szBuffer,1,sizeof(szBuffer),pFile)) > 0) strData.append(szBuffer,nRead);
+            fclose(pFile);
+            bResult = true;
+        }
+    #else
+        File oFile = LittleFS.open(pszFileName,"r");
+        if(oFile) {
+            strData = oFile.readString();
+            oFile.close();
+            bResult = true;
+        }
+    #endif
+    return(bResult);
+}
+
+/**
+ * @brief Writes or appends data to a file.
+ * @return true if all data has been written.
+ */
+static bool writeJournalFile(const char *pszFileName, const char *pszData, size_t nLen, bool bAppend) {
+    bool bResult = false;
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszFileName,bAppend ? "a" : "w");
+        if(pFile) {
+            bResult = fwrite(pszData,1,nLen,pFile) == nLen;
+            if(fclose(pFile) != 0) bResult = false;
+        }
+    #else
+        File oFile = LittleFS.open(pszFileName,bAppend ? "a" : "w");
+        if(oFile) {
+            bResult = oFile.write((const uint8_t *) pszData,nLen) == nLen;
+            oFile.close();
+        }
+    #endif
+    return(bResult);
+}
+
+/**
+ * @brief Renames a file, an existing target file is replaced.
+ */
+static bool renameJournalFile(const char *pszFrom, const char *pszTo) {
+    #ifdef NATIVE_RUNTIME
+        return(rename(pszFrom,pszTo) == 0);
+    #else
+        // LittleFS replaces the target in one step, other file systems need the target removed first
+        if(LittleFS.rename(pszFrom,pszTo)) return(true);
+        LittleFS.remove(pszTo);
+        return(LittleFS.rename(pszFrom,pszTo));
+    #endif
+}
+
+static bool existsJournalFile(const char *pszFileName) {
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszFileName,"r");
+        if(pFile) fclose(pFile);
+        return(pFile != nullptr);
+    #else
+        return(LittleFS.exists(pszFileName));
+    #endif
+}
+
+static void removeJournalFile(const char *pszFileName) {
+    #ifdef NATIVE_RUNTIME
+        remove(pszFileName);
+    #else
+        if(LittleFS.exists(pszFileName)) LittleFS.remove(pszFileName);
+    #endif
+}
+
+#pragma endregion
+
+#pragma region Implementation of CConfigJournal
+
+CConfigJournal::CConfigJournal(const char *pszBaseFile, const char *pszJournalFile)
+    : m_pszBaseFile(pszBaseFile), m_pszJournalFile(pszJournalFile) {}
+
+/**
+ * @brief Replays the records of a journal into the config document.
+ *
+ * Replay stops at the first incomplete or invalid record. The journal is compacted
+ * at the next save in this case, so no record is appended behind the broken one.
+ * @param pszJournal Content of the journal.
+ * @param oDoc Config document (base config), the records are merged into.
+ * @return Number of replayed records.
+ */
+size_t CConfigJournal::replay(const char *pszJournal, JsonNode &oDoc) {
+    DEBUG_FUNC_START();
+    size_t nRecords = 0;
+    const char *psz = pszJournal ? pszJournal : "";
+    while(*psz) {
+        char *pszEnd = nullptr;
+        unsigned long ulLen = strtoul(psz,&pszEnd,10);
+        if(pszEnd == psz || *pszEnd != '\t') break;
+        const char *pszRecord = pszEnd + 1;
+        if(strnlen(pszRecord,ulLen + 1) < ulLen + 1 || pszRecord[ulLen] != '\n') break;
+        char *pszJson = strndup(pszRecord,ulLen);
+        if(!pszJson) break;
+        JsonNode oRecord;
+        oRecord.parse(pszJson);
+        free(pszJson);
+        oDoc.merge(oRecord);
+        nRecords++;
+        psz = pszRecord + ulLen + 1;
+    }
+    m_nRecords         = nRecords;
+    m_nJournalSize     = psz - (pszJournal ? pszJournal : psz);
+    m_bNeedsCompaction = *psz != '\0';
+    DEBUG_FUNC_END_PARMS("%d",(int) nRecords);
+    return(nRecords);
+}
+
+/**
+ * @brief Replays the journal file into the config document.
+ * @param oDoc Config document (base config), the records are merged into.
+ * @return Number of replayed records.
+ */
+size_t CConfigJournal::replayFile(JsonNode &oDoc) {
+    String strJournal;
+    readJournalFile(m_pszJournalFile,strJournal);
+    return(replay(strJournal.c_str(),oDoc));
+}
+
+/**
+ * @brief Remembers a document as the persisted state.
+ * Call after the config has been loaded (base file + journal), so the next
+ * save writes only the settings that changed since.
+ */
+void CConfigJournal::remember(JsonNode &oDoc) {
+    m_pPersisted.reset(new CNamedValueTable<uint32_t>(true,0));
+    m_pPersisted->enableHashIndex();
+    String   strPath;
+    JsonNode oUnused;
+    collectChanges(oDoc,strPath,oUnused,false);
+}
+
+/**
+ * @brief Compares the settings with the persisted state.
+ *
+ * Objects are compared element by element, all other nodes (values and arrays) are
+ * compared by a hash of their JSON text. The persisted state is updated.
+ * @param oNode Node with the current settings.
+ * @param strPath Path of the node (names separated by TAB).
+ * @param oRecord Receives the changed settings, if bRecord is true.
+ * @param bRecord true to add the changes to oRecord.
+ * @return true if a setting has been changed.
+ */
+bool CConfigJournal::collectChanges(JsonNode &oNode, String &strPath, JsonNode &oRecord, bool bRecord) {
+    bool bChanged = false;
+    for(JsonNode *pNode : oNode.Elements) {
+        String strNodePath = strPath;
+        if(strNodePath.length() > 0) strNodePath += "\t";
+        strNodePath += pNode->Name;
+        if(pNode->isJsonObject()) {
+            JsonNode oSubRecord;
+            if(collectChanges(*pNode,strNodePath,oSubRecord,bRecord)) {
+                if(bRecord) oRecord.createObject(pNode->Name.c_str())->merge(oSubRecord);
+                bChanged = true;
+            }
+        } else {
+            uint32_t ulHash = LSC::getHash(pNode->getAsJsonText());
+            CNamedValueEntry<uint32_t> *pEntry = m_pPersisted->findFirstByKey(strNodePath.c_str());
+            if(!pEntry || pEntry->value != ulHash) {
+                if(pEntry)  pEntry->value = ulHash;
+                else        m_pPersisted->set(strNodePath.c_str(),ulHash);
+                if(bRecord) oRecord.createElement(pNode->Name.c_str())->copyFrom(*pNode);
+                bChanged = true;
+            }
+        }
+    }
+    return(bChanged);
+}
+
+/**
+ * @brief Creates a journal record with the changed settings.
+ * The settings in the record are taken as persisted.
+ * @param oCurrent Current configuration.
+ * @param strRecord Receives the record (incl. length prefix and line feed).
+ * @return true if a setting changed, false if nothing has to be written.
+ */
+bool CConfigJournal::createRecord(JsonNode &oCurrent, String &strRecord) {
+    if(!m_pPersisted) {
+        JsonNode oEmpty;
+        remember(oEmpty);
+    }
+    JsonNode oRecord;
+    String strPath;
+    bool bResult = collectChanges(oCurrent,strPath,oRecord,true);
+    if(bResult) {
+        const char *pszJson = oRecord.getAsJsonText();
+        char szLen[12];
+        snprintf(szLen,sizeof(szLen),"%u",(unsigned int) strlen(pszJson));
+        strRecord  = szLen;
+        strRecord += "\t";
+        strRecord += pszJson;
+        strRecord += "\n";
+    }
+    return(bResult);
+}
+
+/**
+ * @brief Persists the current configuration.
+ *
+ * The changed settings are appended to the journal. The base file is rewritten
+ * (compacted) instead, if no base file exists, the persisted state is unknown,
+ * the journal is damaged or the journal would exceed CONFIG_JOURNAL_MAX_SIZE.
+ * @param oCurrent Current configuration.
+ * @return true if the configuration has been written.
+ */
+bool CConfigJournal::save(JsonNode &oCurrent) {
+    DEBUG_FUNC_START();
+    bool bResult = true;
+    if(m_bNeedsCompaction || !m_pPersisted || !existsJournalFile(m_pszBaseFile)) {
+        bResult = compact(oCurrent);
+    } else {
+        String strRecord;
+        if(createRecord(oCurrent,strRecord)) {
+            if(m_nJournalSize + strRecord.length() > CONFIG_JOURNAL_MAX_SIZE) {
+                bResult = compact(oCurrent);
+            } else if(writeJournalFile(m_pszJournalFile,strRecord.c_str(),strRecord.length(),true)) {
+                m_nJournalSize += strRecord.length();
+                m_nRecords++;
+            } else {
+                m_bNeedsCompaction = true;
+                bResult = false;
+            }
+        }
+    }
+    DEBUG_FUNC_END_PARMS("%d",bResult);
+    return(bResult);
+}
+
+/**
+ * @brief Writes a new base file and removes the journal.
+ *
+ * The new base file contains the old base file, the journal and the current
+ * settings. It is written into a temp file first, then renamed - so the old
+ * base file and journal stay valid, until the new file is complete.
+ * @param oCurrent Current configuration.
+ * @return true if the new base file has been written.
+ */
+bool CConfigJournal::compact(JsonNode &oCurrent) {
+    DEBUG_FUNC_START();
+    JsonNode oDoc;
+    String strData;
+    if(readJournalFile(m_pszBaseFile,strData)) oDoc.parse(strData.c_str());
+    strData = "";
+    if(readJournalFile(m_pszJournalFile,strData)) replay(strData.c_str(),oDoc);
+    strData = "";
+    oDoc.merge(oCurrent);
+
+    String strTempFile = m_pszBaseFile;
+    strTempFile += ".tmp";
+    const char *pszJson = oDoc.getAsJsonText();
+    bool bResult = writeJournalFile(strTempFile.c_str(),pszJson,strlen(pszJson),false) &&
+                   renameJournalFile(strTempFile.c_str(),m_pszBaseFile);
+    if(bResult) {
+        removeJournalFile(m_pszJournalFile);
+        m_nJournalSize      = 0;
+        m_nRecords          = 0;
+        m_bNeedsCompaction  = false;
+        remember(oDoc);
+    } else {
+        m_bNeedsCompaction  = true;
+    }
+    DEBUG_FUNC_END_PARMS("%d",bResult);
+    return(bResult);
+}
+
+/**
+ * @brief Removes the journal and forgets the persisted state.
+ * Use it, when the base file has been replaced or deleted. The next save writes
+ * the complete base file.
+ */
+void CConfigJournal::clear() {
+    removeJournalFile(m_pszJournalFile);
+    m_pPersisted.reset();
+    m_nJournalSize      = 0;
+    m_nRecords          = 0;
+    m_bNeedsCompaction  = false;
+}
+
+#pragma endregion
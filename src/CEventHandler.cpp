@@ -2,7 +2,8 @@
     #undef DEBUGINFOS
 #endif
 #include <EventHandler.h>
-#include <Arduino.h>
+#include <Runtime.h>
+#include <algorithm>
 #include <DevelopmentHelper.h>
 
 /**
@@ -50,11 +51,33 @@ void CEventHandler::registerEventReceiver(IMsgEventReceiver *pEventReceiver, con
 }
 
 /**
+ * @brief Calls one receiver and collects its timing, if profiling is enabled.
+ * @param nIdx Index of the receiver in the receiver table.
+ * @return Result of the receiver.
+ */
+int CEventHandler::callReceiver(size_t nIdx, IMsgEventReceiver *pEventReceiver, void *pSender, int nMsg, const void *pMessage, int nClass) {
+    if(!m_bProfiling) return(pEventReceiver->receiveEvent(pSender,nMsg,pMessage,nClass));
+
+    unsigned long ulStart = micros();
+    int nResult = pEventReceiver->receiveEvent(pSender,nMsg,pMessage,nClass);
+    unsigned long ulDuration = micros() - ulStart;
+    if(nIdx >= m_tProfiles.size()) m_tProfiles.resize(m_tReceiverTable.Entries.size());
+    if(nIdx < m_tProfiles.size()) {
+        MsgReceiverProfile &oProfile = m_tProfiles[nIdx];
+        oProfile.Calls++;
+        oProfile.TotalMicros += ulDuration;
+        if(ulDuration > oProfile.MaxMicros) oProfile.MaxMicros = ulDuration;
+    }
+    return(nResult);
+}
+
+/**
  * @brief Sends an event to all registered receivers.
  *
  * The sender does not receive its own event. Receivers can return
  * EVENT_MSG_CALL_AGAIN_WHEN_ALL_OK to request a second callback only if the
  * first pass completes without warnings or errors.
+ * A registered event recorder gets top level events before any receiver.
  *
  * @param pSender Sender address, or nullptr for static/global events.
  * @param nMsg Message number, usually one of Msgs.h.
@@ -65,16 +88,20 @@ void CEventHandler::registerEventReceiver(IMsgEventReceiver *pEventReceiver, con
  */
 int CEventHandler::sendEvent(void *pSender, int nMsg, const void *pMessage, int nClass) {
     int nTotalResult = EVENT_MSG_RESULT_OK;
-    std::vector<IMsgEventReceiver*> tCallBackEventReceivers;
-    for(auto pEntry : m_tReceiverTable.Entries) {
-        IMsgEventReceiver *pEventReceiver = pEntry->value;
+    if(m_pEventRecorder && m_nSendDepth == 0) {
+        m_pEventRecorder->receiveEvent(pSender,nMsg,pMessage,nClass);
+    }
+    m_nSendDepth++;
+    std::vector<size_t> tCallBackEventReceivers;
+    for(size_t nIdx = 0; nIdx < m_tReceiverTable.Entries.size(); nIdx++) {
+        IMsgEventReceiver *pEventReceiver = m_tReceiverTable.Entries[nIdx]->value;
         if(pEventReceiver && pSender != pEventReceiver) {
             #ifdef LSC_ENABLE_EXCEPTIONS
             try {
             #endif
-                int nResult = pEventReceiver->receiveEvent(pSender,nMsg,pMessage,nClass);
+                int nResult = callReceiver(nIdx,pEventReceiver,pSender,nMsg,pMessage,nClass);
                 if(nResult == EVENT_MSG_CALL_AGAIN_WHEN_ALL_OK) {
-                    tCallBackEventReceivers.push_back(pEventReceiver);
+                    tCallBackEventReceivers.push_back(nIdx);
                 } else {
                     if(nResult > nTotalResult) nTotalResult = nResult;
                 }
@@ -88,11 +115,12 @@ int CEventHandler::sendEvent(void *pSender, int nMsg, const void *pMessage, int
     }
     // Call backs if all is ok..
     if(nTotalResult == EVENT_MSG_RESULT_OK) {
-        for(IMsgEventReceiver *pEventReceiver : tCallBackEventReceivers) {
+        for(size_t nIdx : tCallBackEventReceivers) {
+            IMsgEventReceiver *pEventReceiver = m_tReceiverTable.Entries[nIdx]->value;
             #ifdef LSC_ENABLE_EXCEPTIONS
             try {
             #endif
-                int nResult = pEventReceiver->receiveEvent(pSender,nMsg,pMessage,nClass);
+                int nResult = callReceiver(nIdx,pEventReceiver,pSender,nMsg,pMessage,nClass);
                 if(nResult > nTotalResult) nTotalResult = nResult;
             #ifdef LSC_ENABLE_EXCEPTIONS
             } catch(...) {
@@ -101,9 +129,96 @@ int CEventHandler::sendEvent(void *pSender, int nMsg, const void *pMessage, int
             #endif
         }
     }
+    m_nSendDepth--;
     return(nTotalResult);
 }
 
+/**
+ * @brief Registers the event queue of a producer on another task.
+ *
+ * Each producer needs its own queue, as the queues are lock free for exactly
+ * one producer and one consumer (the application task).
+ */
+void CEventHandler::registerPostQueue(CMsgPostQueue *pQueue) {
+    if(pQueue && std::find(m_tPostQueues.begin(),m_tPostQueues.end(),pQueue) == m_tPostQueues.end()) {
+        m_tPostQueues.push_back(pQueue);
+    }
+}
+
+/**
+ * @brief Sends all posted events of the registered queues.
+ *
+ * Only the events queued at call time are sent, so a producer posting
+ * continuously can not block the application loop.
+ *
+ * @return Number of events sent.
+ */
+int CEventHandler::dispatchPostedEvents() {
+    int nSent = 0;
+    for(CMsgPostQueue *pQueue : m_tPostQueues) {
+        size_t nPending = pQueue->size();
+        PostedEvent oEvent;
+        while(nPending-- > 0 && pQueue->pop(oEvent)) {
+            sendEvent(oEvent.pSender,oEvent.nMsg,oEvent.pMessage,oEvent.nClass);
+            if(oEvent.pfnRelease) oEvent.pfnRelease(oEvent.pMessage);
+            nSent++;
+        }
+    }
+    return(nSent);
+}
+
+/**
+ * @brief Gets the registered name of a receiver.
+ * @param pReceiver Receiver (or sender) address.
+ * @return Registered name, or nullptr if the address is unknown.
+ */
+const char * CEventHandler::getReceiverName(const void *pReceiver) {
+    const char *pszResult = nullptr;
+    for(auto pEntry : m_tReceiverTable.Entries) {
+        if(pEntry->value == pReceiver) { pszResult = pEntry->getKey(); break; }
+    }
+    return(pszResult);
+}
+
+/**
+ * @brief Gets the first receiver registered with the given name.
+ * @param pszReceiverName Name used in registerEventReceiver().
+ * @return Receiver, or nullptr if not found.
+ */
+IMsgEventReceiver * CEventHandler::getReceiver(const char *pszReceiverName) {
+    CNamedValueEntry<IMsgEventReceiver *> *pEntry = m_tReceiverTable.findFirstByKey(pszReceiverName);
+    return(pEntry ? pEntry->value : nullptr);
+}
+
+/**
+ * @brief Enables or disables receiver profiling.
+ *
+ * Enabling resets all previously collected timings.
+ */
+void CEventHandler::enableProfiling(bool bEnable) {
+    m_bProfiling = bEnable;
+    if(bEnable) {
+        m_tProfiles.clear();
+        m_tProfiles.resize(m_tReceiverTable.Entries.size());
+    }
+}
+
+/**
+ * @brief Gets the collected timings of a receiver.
+ * @param pszReceiverName Name used in registerEventReceiver().
+ * @return Profile data, or nullptr when the receiver is unknown or no data is collected.
+ */
+const MsgReceiverProfile * CEventHandler::getProfile(const char *pszReceiverName) {
+    const MsgReceiverProfile *pResult = nullptr;
+    for(size_t nIdx = 0; nIdx < m_tReceiverTable.Entries.size() && nIdx < m_tProfiles.size(); nIdx++) {
+        if(m_tReceiverTable.Entries[nIdx]->doesKeyMatch(pszReceiverName,true)) {
+            pResult = &m_tProfiles[nIdx];
+            break;
+        }
+    }
+    return(pResult);
+}
+
 /*int CEventHandler::sendEvent(void *pSender, int nMsg, const void *pMessage, int nClass) {
     int nTotalResult = EVENT_MSG_RESULT_OK;
     std::vector<IMsgEventReceiver*> tCallBackEventReceivers;
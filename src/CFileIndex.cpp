@@ -0,0 +1,376 @@
+#ifndef DEBUG_LSC_WEBSERVER
+    #undef DEBUGINFOS
+#endif
+#include <FileIndex.h>
+#include <LSCUtils.h>
+#include <DevelopmentHelper.h>
+#include <algorithm>
+#ifdef NATIVE_RUNTIME
+    #include <stdio.h>
+    #include <dirent.h>
+    #include <sys/stat.h>
+#else
+    #include <LittleFS.h>
+#endif
+
+#pragma region Implementation of CFileIndex
+
+/**
+ * @brief Position of the entry of a path, or the position to insert it.
+ * The first entry with the path hash is found by a binary search, the entries
+ * with the same hash (other paths) are skipped.
+ */
+std::vector<FileIndexEntry>::iterator CFileIndex::getPosition(uint32_t ulPathHash, const char *pszPath) {
+    auto itEntry = std::lower_bound(m_tEntries.begin(),m_tEntries.end(),ulPathHash,
+        [](const FileIndexEntry &oEntry, uint32_t ulHash) { return(oEntry.PathHash < ulHash); });
+    while(itEntry != m_tEntries.end() && itEntry->PathHash == ulPathHash && itEntry->Path != pszPath) ++itEntry;
+    return(itEntry);
+}
+
+/// @brief Return true if the position is the entry of the path.
+bool CFileIndex::isEntry(std::vector<FileIndexEntry>::iterator itEntry, uint32_t ulPathHash, const char *pszPath) {
+    return(itEntry != m_tEntries.end() && itEntry->PathHash == ulPathHash && itEntry->Path == pszPath);
+}
+
+FileIndexEntry * CFileIndex::find(const char *pszPath) {
+    if(!pszPath) return(nullptr);
+    m_ulLookups++;
+    uint32_t ulPathHash = LSC::getHash(pszPath);
+    auto itEntry = getPosition(ulPathHash,pszPath);
+    if(!isEntry(itEntry,ulPathHash,pszPath)) return(nullptr);
+    return(&*itEntry);
+}
+
+/**
+ * @brief Adds or updates the entry of a file.
+ * A new content hash replaces the known one - 0 lets hashNext() hash the file again.
+ */
+FileIndexEntry * CFileIndex::set(const char *pszPath, size_t nSize, uint32_t ulContentHash) {
+    if(!pszPath) return(nullptr);
+    uint32_t ulPathHash = LSC::getHash(pszPath);
+    auto itEntry = getPosition(ulPathHash,pszPath);
+    if(!isEntry(itEntry,ulPathHash,pszPath)) {
+        FileIndexEntry oEntry;
+        oEntry.Path     = pszPath;
+        oEntry.PathHash = ulPathHash;
+        itEntry = m_tEntries.insert(itEntry,oEntry);
+    }
+    itEntry->Size        = (uint32_t) nSize;
+    itEntry->Time        = 0;
+    itEntry->ContentHash = ulContentHash;
+    itEntry->Version     = ++m_ulVersion;
+    if(ulContentHash == 0) m_bPending = true;
+    // A known hash belongs to the file as it is now
+    size_t nFileSize = 0;
+    if(ulContentHash != 0 && statFile(pszPath,nFileSize,itEntry->Time)) itEntry->Size = (uint32_t) nFileSize;
+    return(&*itEntry);
+}
+
+/**
+ * @brief Version of a file, i.E. for the template cache.
+ * A new version is given by set() (upload) and when a file changed by others is found.
+ */
+uint32_t CFileIndex::getVersion(const char *pszPath) {
+    FileIndexEntry *pEntry = find(pszPath);
+    return(pEntry ? pEntry->Version : 0);
+}
+
+void CFileIndex::remove(const char *pszPath) {
+    if(!pszPath) return;
+    uint32_t ulPathHash = LSC::getHash(pszPath);
+    auto itEntry = getPosition(ulPathHash,pszPath);
+    if(isEntry(itEntry,ulPathHash,pszPath)) m_tEntries.erase(itEntry);
+}
+
+/**
+ * @brief Adds the files of a directory to the index.
+ * Only name and size are read, the content is hashed by hashNext().
+ * The index path is "<dir>/<name>", as it is requested by the web server.
+ */
+void CFileIndex::scan(const char *pszDir) {
+    DEBUG_FUNC_START_PARMS("%s",pszDir ? pszDir : "null");
+    String strDir = pszDir ? pszDir : "/";
+    if(strDir.length() == 0 || strDir[strDir.length() - 1] != '/') strDir += "/";
+    #if defined(NATIVE_RUNTIME)
+        DIR *pDir = opendir(strDir.c_str());
+        if(pDir) {
+            struct dirent *pEntry;
+            while((pEntry = readdir(pDir)) != nullptr) {
+                String strPath = strDir + pEntry->d_name;
+                struct stat oStat;
+                if(stat(strPath.c_str(),&oStat) == 0 && S_ISREG(oStat.st_mode)) set(strPath.c_str(),oStat.st_size);
+            }
+            closedir(pDir);
+        }
+    #elif defined(ARDUINO_ARCH_ESP32)
+        File oDirEntry = LittleFS.open(strDir.c_str());
+        if(oDirEntry && oDirEntry.isDirectory()) {
+            File oFile = oDirEntry.openNextFile();
+            while (oFile) {
+                if(!oFile.isDirectory()) {
+                    const char *pszName = oFile.name();
+                    if(pszName[0] == '/') pszName++;
+                    set((strDir + pszName).c_str(),oFile.size());
+                }
+                oFile = oDirEntry.openNextFile();
+            }
+        }
+    #else
+        Dir oDirEntry = LittleFS.openDir(strDir.c_str());
+        while (oDirEntry.next()) {
+            if(oDirEntry.isFile()) set((strDir + oDirEntry.fileName()).c_str(),oDirEntry.fileSize());
+        }
+    #endif
+    DEBUG_FUNC_END_PARMS("%u",(unsigned int) m_tEntries.size());
+}
+
+/**
+ * @brief Hashes the content of a file (LSC::updateHash()).
+ * @param nSize Size of the file (bytes read).
+ * @return Hash of the content, 0 if the file cannot be read.
+ */
+uint32_t CFileIndex::hashFile(const char *pszPath, size_t &nSize) {
+    uint8_t tBuffer[FILE_INDEX_READ_SIZE];
+    uint32_t ulHash = LSC_HASH_START;
+    nSize = 0;
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszPath,"rb");
+        if(!pFile) return(0);
+        size_t nRead;
+        while((nRead = fread(tBuffer,1,sizeof(tBuffer),pFile)) > 0) {
+            ulHash = LSC::updateHash(ulHash,tBuffer,nRead);
+            nSize += nRead;
+        }
+        fclose(pFile);
+    #else
+        File oFile = LittleFS.open(pszPath,"r");
+        if(!oFile) return(0);
+        size_t nRead;
+        while((nRead = oFile.read(tBuffer,sizeof(tBuffer))) > 0) {
+            ulHash = LSC::updateHash(ulHash,tBuffer,nRead);
+            nSize += nRead;
+        }
+        oFile.close();
+    #endif
+    // 0 is reserved for "not known"
+    return(ulHash == 0 ? 1 : ulHash);
+}
+
+/**
+ * @brief Size and modification time (seconds) of a file.
+ * @return false if the file does not exist.
+ */
+bool CFileIndex::statFile(const char *pszPath, size_t &nSize, uint32_t &ulTime) {
+    nSize  = 0;
+    ulTime = 0;
+    #ifdef NATIVE_RUNTIME
+        struct stat oStat;
+        if(stat(pszPath,&oStat) != 0) return(false);
+        nSize  = oStat.st_size;
+        ulTime = (uint32_t) oStat.st_mtime;
+    #else
+        File oFile = LittleFS.open(pszPath,"r");
+        if(!oFile) return(false);
+        nSize  = oFile.size();
+        ulTime = (uint32_t) oFile.getLastWrite();
+        oFile.close();
+    #endif
+    return(true);
+}
+
+/// @brief Marks the entry of a file changed by others, its content is hashed again by hashNext().
+void CFileIndex::setChanged(FileIndexEntry &oEntry) {
+    oEntry.ContentHash = 0;
+    oEntry.Version     = ++m_ulVersion;
+    m_bPending         = true;
+}
+
+/**
+ * @brief Hashes the next file without a known content hash.
+ * Called by the application loop, one file per call - a request never waits
+ * for a file to be read. A file that cannot be read is removed from the index.
+ * @return true if a file has been hashed (or removed), false if no file is pending.
+ */
+bool CFileIndex::hashNext() {
+    if(!m_bPending) return(false);
+    for(auto itEntry = m_tEntries.begin(); itEntry != m_tEntries.end(); ++itEntry) {
+        if(itEntry->ContentHash != 0) continue;
+        size_t nSize = 0;
+        uint32_t ulTime = 0;
+        uint32_t ulHash = statFile(itEntry->Path.c_str(),nSize,ulTime) ? hashFile(itEntry->Path.c_str(),nSize) : 0;
+        if(ulHash == 0) {
+            m_tEntries.erase(itEntry);
+        } else {
+            itEntry->ContentHash = ulHash;
+            itEntry->Size        = (uint32_t) nSize;
+            itEntry->Time        = ulTime;
+            m_ulHashed++;
+        }
+        return(true);
+    }
+    m_bPending = false;
+    return(false);
+}
+
+/**
+ * @brief Checks the next file of the index for changes by others.
+ * Called by the application loop (FILE_INDEX_CHECK_INTERVAL), one file per call.
+ * A file with another size or modification time is hashed again, a removed file
+ * is removed from the index.
+ */
+void CFileIndex::checkNext() {
+    if(m_tEntries.empty()) return;
+    if(m_nCheckPos >= m_tEntries.size()) m_nCheckPos = 0;
+    FileIndexEntry &oEntry = m_tEntries[m_nCheckPos];
+    // A pending file is checked by hashNext()
+    if(oEntry.ContentHash == 0) {
+        m_nCheckPos++;
+        return;
+    }
+    size_t nSize = 0;
+    uint32_t ulTime = 0;
+    if(!statFile(oEntry.Path.c_str(),nSize,ulTime)) {
+        m_tEntries.erase(m_tEntries.begin() + m_nCheckPos);
+        return;
+    }
+    if(oEntry.Size != nSize || oEntry.Time != ulTime) setChanged(oEntry);
+    m_nCheckPos++;
+}
+
+/**
+ * @brief Checks a delivered file against its entry.
+ * The size and modification time are taken from the opened file, so the
+ * delivery finds a file changed by others without reading it.
+ * @return true if the ETag of the entry is valid for the file.
+ */
+bool CFileIndex::verify(const char *pszPath, size_t nSize, uint32_t ulTime) {
+    FileIndexEntry *pEntry = find(pszPath);
+    if(!pEntry || pEntry->ContentHash == 0) return(false);
+    if(pEntry->Size == nSize && pEntry->Time == ulTime) return(true);
+    setChanged(*pEntry);
+    return(false);
+}
+
+/**
+ * @brief Gets the ETag of a file: "<content hash>-<size>".
+ * Only the known hash is used - the file is neither read nor checked, this is
+ * done by hashNext() and checkNext() in the application loop.
+ */
+bool CFileIndex::getETag(const char *pszPath, char *pszETag, size_t nETagSize) {
+    FileIndexEntry *pEntry = find(pszPath);
+    if(!pEntry || !pszETag || nETagSize == 0 || pEntry->ContentHash == 0) return(false);
+    snprintf(pszETag,nETagSize,"\"%08x-%x\"",(unsigned int) pEntry->ContentHash,(unsigned int) pEntry->Size);
+    return(true);
+}
+
+/**
+ * @brief Content type by the extension of the file.
+ * "index.html.gz" is "text/html" - the encoding is sent as Content-Encoding.
+ */
+const char * CFileIndex::getContentType(const char *pszPath) {
+    static const struct { const char *Ext; const char *Type; } tTypes[] = {
+        { "html", "text/html" },
+        { "htm",  "text/html" },
+        { "css",  "text/css" },
+        { "js",   "application/javascript" },
+        { "json", "application/json" },
+        { "txt",  "text/plain" },
+        { "log",  "text/plain" },
+        { "csv",  "text/csv" },
+        { "xml",  "text/xml" },
+        { "svg",  "image/svg+xml" },
+        { "png",  "image/png" },
+        { "jpg",  "image/jpeg" },
+        { "jpeg", "image/jpeg" },
+        { "gif",  "image/gif" },
+        { "ico",  "image/x-icon" },
+        { "woff", "font/woff" },
+        { "woff2","font/woff2" },
+        { "bin",  "application/octet-stream" },
+    };
+    const char *pszDefault = "application/octet-stream";
+    if(!pszPath) return(pszDefault);
+    size_t nLen = strlen(pszPath);
+    if(nLen > 3 && strcasecmp(pszPath + nLen - 3,".gz") == 0) nLen -= 3;
+    // Find the last '.' in front of nLen, not inside a directory name
+    size_t nDot = nLen;
+    while(nDot > 0 && pszPath[nDot - 1] != '.' && pszPath[nDot - 1] != '/') nDot--;
+    if(nDot == 0 || pszPath[nDot - 1] != '.') return(nLen < strlen(pszPath) ? "application/gzip" : pszDefault);
+    size_t nExtLen = nLen - nDot;
+    for(auto &oType : tTypes) {
+        if(strlen(oType.Ext) == nExtLen && strncasecmp(pszPath + nDot,oType.Ext,nExtLen) == 0) return(oType.Type);
+    }
+    return(pszDefault);
+}
+
+/**
+ * @brief Checks an ETag against an If-None-Match header.
+ * The header is a list of tags ("a", W/"b") or "*". Weak tags are compared by
+ * their value, as RFC 9110 asks for If-None-Match.
+ */
+bool CFileIndex::matchesETag(const char *pszIfNoneMatch, const char *pszETag) {
+    if(!pszIfNoneMatch || !pszETag || !*pszETag) return(false);
+    if(strncmp(pszETag,"W/",2) == 0) pszETag += 2;
+    size_t nETagLen = strlen(pszETag);
+    const char *pszPos = pszIfNoneMatch;
+    while(*pszPos) {
+        while(*pszPos == ' ' || *pszPos == ',' || *pszPos == '\t') pszPos++;
+        if(!*pszPos) break;
+        if(*pszPos == '*') return(true);
+        if(strncmp(pszPos,"W/",2) == 0) pszPos += 2;
+        const char *pszEnd = pszPos;
+        if(*pszEnd == '"') {
+            pszEnd = strchr(pszEnd + 1,'"');
+            pszEnd = pszEnd ? pszEnd + 1 : pszPos + strlen(pszPos);
+        } else {
+            while(*pszEnd && *pszEnd != ',' && *pszEnd != ' ') pszEnd++;
+        }
+        if((size_t)(pszEnd - pszPos) == nETagLen && strncmp(pszPos,pszETag,nETagLen) == 0) return(true);
+        pszPos = pszEnd;
+    }
+    return(false);
+}
+
+/**
+ * @brief Parses a single byte range.
+ * Multiple ranges and invalid syntax are ignored (the whole file is delivered),
+ * as RFC 9110 allows it. A range behind the end of the file is not satisfiable.
+ */
+int CFileIndex::parseRange(const char *pszRange, size_t nSize, size_t &nStart, size_t &nEnd) {
+    if(!pszRange || strncasecmp(pszRange,"bytes=",6) != 0) return(FILE_RANGE_NONE);
+    const char *pszSpec = pszRange + 6;
+    while(*pszSpec == ' ') pszSpec++;
+    if(strchr(pszSpec,',')) return(FILE_RANGE_NONE);
+    const char *pszDash = strchr(pszSpec,'-');
+    if(!pszDash) return(FILE_RANGE_NONE);
+    char *pszEnd = nullptr;
+    if(pszDash == pszSpec) {
+        // Suffix: the last n bytes
+        unsigned long ulSuffix = strtoul(pszDash + 1,&pszEnd,10);
+        if(pszEnd == pszDash + 1 || *pszEnd) return(FILE_RANGE_NONE);
+        if(ulSuffix == 0 || nSize == 0) return(FILE_RANGE_INVALID);
+        nStart = ulSuffix >= nSize ? 0 : nSize - ulSuffix;
+        nEnd   = nSize - 1;
+        return(FILE_RANGE_OK);
+    }
+    unsigned long ulFirst = strtoul(pszSpec,&pszEnd,10);
+    if(pszEnd != pszDash) return(FILE_RANGE_NONE);
+    unsigned long ulLast = nSize > 0 ? nSize - 1 : 0;
+    if(pszDash[1]) {
+        ulLast = strtoul(pszDash + 1,&pszEnd,10);
+        if(*pszEnd || ulLast < ulFirst) return(FILE_RANGE_NONE);
+        if(nSize > 0 && ulLast >= nSize) ulLast = nSize - 1;
+    }
+    if(ulFirst >= nSize) return(FILE_RANGE_INVALID);
+    nStart = ulFirst;
+    nEnd   = ulLast;
+    return(FILE_RANGE_OK);
+}
+
+void CFileIndex::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
+    oStatusNode.setValue("files",  (int) m_tEntries.size());
+    oStatusNode.setValue("hashed", m_ulHashed);
+    oStatusNode.setValue("lookups",m_ulLookups);
+}
+
+#pragma endregion
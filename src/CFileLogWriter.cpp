@@ -0,0 +1,329 @@
+#ifndef DEBUG_LSC_LOGGING
+    #undef DEBUGINFOS
+#endif
+
+#include <FileLogWriter.h>
+#include <DevelopmentHelper.h>
+#include <algorithm>
+#ifdef NATIVE_RUNTIME
+    #include <stdio.h>
+#else
+    #include <LittleFS.h>
+#endif
+
+#pragma region File access
+
+/**
+ * @brief Writes or appends data to a log file.
+ * @return true if all data has been written.
+ */
+static bool writeLogFile(const char *pszFileName, const char *pszData, size_t nLen, bool bAppend) {
+    bool bResult = false;
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszFileName,bAppend ? "a" : "w");
+        if(pFile) {
+            bResult = fwrite(pszData,1,nLen,pFile) == nLen;
+            if(fclose(pFile) != 0) bResult = false;
+        }
+    #else
+        File oFile = LittleFS.open(pszFileName,bAppend ? "a" : "w");
+        if(oFile) {
+            bResult = oFile.write((const uint8_t *) pszData,nLen) == nLen;
+            oFile.close();
+        }
+    #endif
+    return(bResult);
+}
+
+/**
+ * @brief Reads a part of a log file.
+ * @return Number of bytes read, 0 at the end of the file or if the file does not exist.
+ */
+static size_t readLogFile(const char *pszFileName, size_t nOffset, uint8_t *pBuffer, size_t nMaxLen) {
+    size_t nRead = 0;
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszFileName,"r");
+        if(pFile) {
+            if(fseek(pFile,nOffset,SEEK_SET) == 0) nRead = fread(pBuffer,1,nMaxLen,pFile);
+            fclose(pFile);
+        }
+    #else
+        File oFile = LittleFS.open(pszFileName,"r");
+        if(oFile) {
+            if(oFile.seek(nOffset)) nRead = oFile.read(pBuffer,nMaxLen);
+            oFile.close();
+        }
+    #endif
+    return(nRead);
+}
+
+/**
+ * @brief Gets the size of a log file.
+ * @return Size in bytes, 0 if the file does not exist.
+ */
+static size_t getLogFileSize(const char *pszFileName) {
+    size_t nSize = 0;
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszFileName,"r");
+        if(pFile) {
+            if(fseek(pFile,0,SEEK_END) == 0) nSize = ftell(pFile);
+            fclose(pFile);
+        }
+    #else
+        if(LittleFS.exists(pszFileName)) {
+            File oFile = LittleFS.open(pszFileName,"r");
+            if(oFile) {
+                nSize = oFile.size();
+                oFile.close();
+            }
+        }
+    #endif
+    return(nSize);
+}
+
+static void removeLogFile(const char *pszFileName) {
+    #ifdef NATIVE_RUNTIME
+        remove(pszFileName);
+    #else
+        if(LittleFS.exists(pszFileName)) LittleFS.remove(pszFileName);
+    #endif
+}
+
+#pragma endregion
+
+#pragma region Implementation of CFileLogWriter
+
+CFileLogWriter::CFileLogWriter(const char *pszBaseName) : m_strBaseName(pszBaseName) {}
+
+/**
+ * @brief Writes the buffered entries before the writer is destroyed.
+ */
+CFileLogWriter::~CFileLogWriter() {
+    if(m_nBuffered > 0) flush(true);
+}
+
+/**
+ * @brief Gets the name of the log file of a generation.
+ */
+String CFileLogWriter::getFileName(unsigned long ulGeneration) {
+    String strName = m_strBaseName;
+    strName += ".";
+    strName += std::to_string(ulGeneration % FILE_LOG_FILE_COUNT).c_str();
+    return(strName);
+}
+
+/**
+ * @brief Reads the index on first use, to continue the current log file.
+ * The file system is not accessed in the constructor, as it may not be mounted yet.
+ */
+void CFileLogWriter::open() {
+    if(!m_bOpened) {
+        m_bOpened = true;
+        String strIndexFile = m_strBaseName + ".idx";
+        char szIndex[16] = { 0 };
+        readLogFile(strIndexFile.c_str(),0,(uint8_t *) szIndex,sizeof(szIndex) - 1);
+        m_ulGeneration = strtoul(szIndex,nullptr,10);
+        m_nFileSize    = getLogFileSize(getFileName(m_ulGeneration).c_str());
+        if(m_nFileSize >= FILE_LOG_FILE_SIZE) rotate();
+    }
+}
+
+/**
+ * @brief Continues with the next log file.
+ * The next file is truncated (it holds the oldest entries) and the index is updated.
+ */
+void CFileLogWriter::rotate() {
+    m_ulGeneration++;
+    m_nFileSize = 0;
+    m_ulRotations++;
+    removeLogFile(getFileName(m_ulGeneration).c_str());
+    String strIndexFile = m_strBaseName + ".idx";
+    String strIndex = std::to_string(m_ulGeneration).c_str();
+    if(!writeLogFile(strIndexFile.c_str(),strIndex.c_str(),strIndex.length(),false)) m_ulErrors++;
+}
+
+/**
+ * @brief Appends the first bytes of the buffer to the current log file.
+ * The bytes are removed from the buffer, even if writing failed.
+ */
+void CFileLogWriter::write(size_t nLen) {
+    if(writeLogFile(getFileName(m_ulGeneration).c_str(),m_tBuffer,nLen,true)) {
+        m_nFileSize += nLen;
+        m_ulBytes   += nLen;
+    } else {
+        m_ulErrors++;
+    }
+    m_ulWrites++;
+    m_nBuffered -= nLen;
+    memmove(m_tBuffer,m_tBuffer + nLen,m_nBuffered);
+}
+
+/**
+ * @brief Writes the buffer into the log files.
+ *
+ * Without bAll, only so many bytes are written, that the log file ends on a page
+ * boundary - the rest stays in the buffer for the next write. A log file is never
+ * filled beyond FILE_LOG_FILE_SIZE, the rest goes into the next file.
+ * @param bAll true to write the whole buffer.
+ */
+void CFileLogWriter::flush(bool bAll) {
+    DEBUG_FUNC_START_PARMS("%d",bAll);
+    open();
+    size_t nLen = m_nBuffered;
+    if(!bAll) {
+        size_t nFirst = FILE_LOG_PAGE_SIZE - m_nFileSize % FILE_LOG_PAGE_SIZE;
+        nLen = m_nBuffered < nFirst ? 0 : nFirst + ((m_nBuffered - nFirst) / FILE_LOG_PAGE_SIZE) * FILE_LOG_PAGE_SIZE;
+    }
+    while(nLen > 0) {
+        size_t nChunk = std::min(nLen,(size_t) FILE_LOG_FILE_SIZE - m_nFileSize);
+        write(nChunk);
+        nLen -= nChunk;
+        if(m_nFileSize >= FILE_LOG_FILE_SIZE) rotate();
+    }
+    DEBUG_FUNC_END();
+}
+
+/**
+ * @brief Removes all log files and the buffered entries.
+ */
+void CFileLogWriter::clear() {
+    open();
+    for(unsigned long ulIdx = 0; ulIdx < FILE_LOG_FILE_COUNT; ulIdx++) {
+        removeLogFile(getFileName(ulIdx).c_str());
+    }
+    removeLogFile((m_strBaseName + ".idx").c_str());
+    m_ulGeneration = 0;
+    m_nFileSize    = 0;
+    m_nBuffered    = 0;
+}
+
+/**
+ * @brief Gets the generation of the oldest existing log file.
+ */
+unsigned long CFileLogWriter::getOldestGeneration() {
+    open();
+    return(m_ulGeneration >= FILE_LOG_FILE_COUNT ? m_ulGeneration - FILE_LOG_FILE_COUNT + 1 : 0);
+}
+
+/**
+ * @brief Gets the size of the log file of a generation.
+ */
+size_t CFileLogWriter::getFileSize(unsigned long ulGeneration) {
+    open();
+    if(ulGeneration == m_ulGeneration) return(m_nFileSize);
+    if(ulGeneration > m_ulGeneration || ulGeneration < getOldestGeneration()) return(0);
+    return(getLogFileSize(getFileName(ulGeneration).c_str()));
+}
+
+/**
+ * @brief Appends data to the buffer.
+ * When the buffer is full, the page aligned part is written.
+ */
+void CFileLogWriter::append(const char *pszData, size_t nLen) {
+    while(nLen > 0) {
+        if(m_nBuffered == FILE_LOG_BUFFER_SIZE) {
+            flush(false);
+            // Nothing written (buffer is smaller than the rest of the page) - write all
+            if(m_nBuffered == FILE_LOG_BUFFER_SIZE) flush(true);
+        }
+        size_t nCopy = std::min(nLen,FILE_LOG_BUFFER_SIZE - m_nBuffered);
+        memcpy(m_tBuffer + m_nBuffered,pszData,nCopy);
+        m_nBuffered += nCopy;
+        pszData     += nCopy;
+        nLen        -= nCopy;
+    }
+}
+
+/**
+ * @brief Adds a log line to the buffer.
+ * Line format: "<millis> [<type>] <message>"
+ */
+void CFileLogWriter::writeLogEntry(const char *pszType, const char *pszMessage) {
+    char szPrefix[24];
+    snprintf(szPrefix,sizeof(szPrefix),"%lu [%s] ",millis(),pszType ? pszType : "");
+    if(m_nBuffered == 0) m_ulFirstBuffered = millis();
+    append(szPrefix,strlen(szPrefix));
+    if(pszMessage) append(pszMessage,strlen(pszMessage));
+    append("\n",1);
+}
+
+/**
+ * @brief Adds a JSON log entry as one line to the buffer.
+ */
+void CFileLogWriter::writeLogEntry(const char *pszType, JsonNode *pDoc) {
+    if(pDoc) writeLogEntry(pszType,pDoc->getAsJsonText());
+}
+
+/**
+ * @brief Receives the log events, writes the buffer when it is due.
+ *
+ * On MSG_APPL_LOOP, the buffer is written when the oldest entry is older than
+ * FILE_LOG_FLUSH_INTERVAL, on MSG_APPL_SHUTDOWN it is written always.
+ */
+int CFileLogWriter::receiveEvent(const void *pSender, int nMsgType, const void *pMessage, int nClass) {
+    int nResult = CLogWriter::receiveEvent(pSender,nMsgType,pMessage,nClass);
+    if(m_nBuffered > 0) {
+        if(nMsgType == MSG_APPL_SHUTDOWN ||
+          (nMsgType == MSG_APPL_LOOP && millis() - m_ulFirstBuffered >= FILE_LOG_FLUSH_INTERVAL)) {
+            flush(true);
+        }
+    }
+    return(nResult);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CFileLogReader
+
+/**
+ * @brief Creates a reader, positioned nMaxBytes before the end of the log.
+ * The writer is flushed, so the reader sees all entries.
+ */
+CFileLogReader::CFileLogReader(CFileLogWriter *pWriter, size_t nMaxBytes) : m_pWriter(pWriter) {
+    m_pWriter->flush(true);
+    m_ulGeneration = m_pWriter->getOldestGeneration();
+    m_nOffset      = 0;
+    if(nMaxBytes > 0) {
+        // Walk back from the newest file, until nMaxBytes are collected
+        size_t nBytes = 0;
+        unsigned long ulGeneration = m_pWriter->getGeneration();
+        while(true) {
+            size_t nSize = m_pWriter->getFileSize(ulGeneration);
+            if(nBytes + nSize >= nMaxBytes) {
+                m_ulGeneration = ulGeneration;
+                m_nOffset      = nSize - (nMaxBytes - nBytes);
+                break;
+            }
+            nBytes += nSize;
+            if(ulGeneration == m_ulGeneration) break;
+            ulGeneration--;
+        }
+    }
+}
+
+/**
+ * @brief Reads the next part of the log.
+ *
+ * If the writer rotated over the file that has been read, the reader continues
+ * with the oldest existing file.
+ * @return Number of bytes read, 0 at the end of the log.
+ */
+size_t CFileLogReader::read(uint8_t *pBuffer, size_t nMaxLen) {
+    size_t nRead = 0;
+    if(m_ulGeneration < m_pWriter->getOldestGeneration()) {
+        m_ulGeneration = m_pWriter->getOldestGeneration();
+        m_nOffset      = 0;
+    }
+    while(nRead == 0 && nMaxLen > 0 && m_ulGeneration <= m_pWriter->getGeneration()) {
+        nRead = readLogFile(m_pWriter->getFileName(m_ulGeneration).c_str(),m_nOffset,pBuffer,nMaxLen);
+        m_nOffset += nRead;
+        if(nRead == 0) {
+            if(m_ulGeneration == m_pWriter->getGeneration()) break;
+            m_ulGeneration++;
+            m_nOffset = 0;
+        }
+    }
+    return(nRead);
+}
+
+#pragma endregion
@@ -0,0 +1,272 @@
+#ifndef DEBUG_LSC_WEBSERVER
+    #undef DEBUGINFOS
+#endif
+#include <FileUpload.h>
+#include <LSCUtils.h>
+#include <DevelopmentHelper.h>
+#include <algorithm>
+#ifdef NATIVE_RUNTIME
+    #include <stdio.h>
+#endif
+
+#pragma region Implementation of CFileUpload
+
+// Number of started uploads, it makes the temporary files unique
+static unsigned long g_ulUploadCount = 0;
+
+CFileUpload::~CFileUpload() {
+    if(m_bOpen) abort();
+    if(m_pBuffer) free(m_pBuffer);
+}
+
+/**
+ * @brief Creates the temporary file and the write buffer.
+ * @return false if the file cannot be created or there is no memory for the buffer.
+ */
+bool CFileUpload::begin(const char *pszPath) {
+    DEBUG_FUNC_START_PARMS("%s",pszPath ? pszPath : "null");
+    if(m_bOpen) abort();
+    m_strPath     = pszPath ? pszPath : "";
+    char szTempExt[16];
+    snprintf(szTempExt,sizeof(szTempExt),".%lx" FILE_UPLOAD_TEMP_EXT,++g_ulUploadCount & 0xFFFF);
+    m_strTempPath = m_strPath + szTempExt;
+    m_nBuffered   = 0;
+    m_nSize       = 0;
+    m_ulHash      = LSC_HASH_START;
+    m_ulWrites    = 0;
+    m_bFailed     = true;
+    if(!m_pBuffer) m_pBuffer = (uint8_t *) malloc(FILE_UPLOAD_BUFFER_SIZE);
+    if(m_pBuffer && m_strPath.length() > 0) {
+        #ifdef NATIVE_RUNTIME
+            m_pFile = fopen(m_strTempPath.c_str(),"wb");
+            m_bOpen = m_pFile != nullptr;
+        #else
+            m_oFile = LittleFS.open(m_strTempPath.c_str(),"w");
+            m_bOpen = (bool) m_oFile;
+        #endif
+        m_bFailed = !m_bOpen;
+    }
+    DEBUG_FUNC_END_PARMS("%d",m_bOpen);
+    return(m_bOpen);
+}
+
+/**
+ * @brief Writes the first nLen bytes of the buffer and keeps the rest.
+ */
+bool CFileUpload::writeBuffer(size_t nLen) {
+    if(nLen == 0) return(true);
+    size_t nWritten = 0;
+    #ifdef NATIVE_RUNTIME
+        nWritten = fwrite(m_pBuffer,1,nLen,m_pFile);
+    #else
+        nWritten = m_oFile.write(m_pBuffer,nLen);
+    #endif
+    m_ulWrites++;
+    if(nWritten != nLen) {
+        m_bFailed = true;
+        return(false);
+    }
+    m_nBuffered -= nLen;
+    if(m_nBuffered > 0) memmove(m_pBuffer,m_pBuffer + nLen,m_nBuffered);
+    return(true);
+}
+
+/**
+ * @brief Adds data to the upload. The data is hashed and buffered, the buffer
+ * is written, when it is full - always as a multiple of the flash page size.
+ */
+bool CFileUpload::write(const uint8_t *pData, size_t nLen) {
+    if(!m_bOpen || m_bFailed) return(false);
+    m_ulHash = LSC::updateHash(m_ulHash,pData,nLen);
+    m_nSize += nLen;
+    while(nLen > 0) {
+        size_t nCopy = std::min(nLen,(size_t) FILE_UPLOAD_BUFFER_SIZE - m_nBuffered);
+        memcpy(m_pBuffer + m_nBuffered,pData,nCopy);
+        m_nBuffered += nCopy;
+        pData += nCopy;
+        nLen  -= nCopy;
+        if(m_nBuffered == FILE_UPLOAD_BUFFER_SIZE) {
+            if(!writeBuffer(m_nBuffered - (m_nBuffered % FILE_UPLOAD_PAGE_SIZE))) return(false);
+        }
+    }
+    return(true);
+}
+
+void CFileUpload::closeFile() {
+    #ifdef NATIVE_RUNTIME
+        if(m_pFile && fclose(m_pFile) != 0) m_bFailed = true;
+        m_pFile = nullptr;
+    #else
+        m_oFile.close();
+    #endif
+    m_bOpen = false;
+}
+
+/**
+ * @brief Writes the rest of the buffer and replaces the file by the temporary file.
+ * The rename replaces the old file in one step, a reader sees the old or the new file.
+ * @return false if a write failed, the temporary file is removed then.
+ */
+bool CFileUpload::finish() {
+    DEBUG_FUNC_START_PARMS("%s",m_strPath.c_str());
+    if(!m_bOpen) {
+        DEBUG_FUNC_END();
+        return(false);
+    }
+    if(!m_bFailed) writeBuffer(m_nBuffered);
+    closeFile();
+    if(!m_bFailed) {
+        #ifdef NATIVE_RUNTIME
+            m_bFailed = rename(m_strTempPath.c_str(),m_strPath.c_str()) != 0;
+        #else
+            m_bFailed = !LittleFS.rename(m_strTempPath.c_str(),m_strPath.c_str());
+        #endif
+    }
+    if(m_bFailed) {
+        #ifdef NATIVE_RUNTIME
+            remove(m_strTempPath.c_str());
+        #else
+            LittleFS.remove(m_strTempPath.c_str());
+        #endif
+    }
+    if(m_pBuffer) {
+        free(m_pBuffer);
+        m_pBuffer = nullptr;
+    }
+    DEBUG_FUNC_END_PARMS("%d",!m_bFailed);
+    return(!m_bFailed);
+}
+
+void CFileUpload::abort() {
+    if(m_bOpen) {
+        closeFile();
+        #ifdef NATIVE_RUNTIME
+            remove(m_strTempPath.c_str());
+        #else
+            LittleFS.remove(m_strTempPath.c_str());
+        #endif
+    }
+    m_bFailed = true;
+}
+
+#pragma endregion
+
+#pragma region Implementation of CFileUploads
+
+CFileUploads::~CFileUploads() {
+    for(Slot &oSlot : m_tSlots) freeSlot(oSlot);
+}
+
+/// @brief Deletes the upload of a slot, an unfinished upload is aborted.
+void CFileUploads::freeSlot(Slot &oSlot) {
+    if(oSlot.Upload) delete oSlot.Upload;
+    oSlot.Upload = nullptr;
+    oSlot.Owner  = nullptr;
+}
+
+/// @brief The result of the owner, it is created with the first upload.
+CFileUploads::Result & CFileUploads::getResult(const void *pOwner) {
+    for(Result &oResult : m_tResults) {
+        if(oResult.Owner == pOwner) return(oResult);
+    }
+    Result oResult;
+    oResult.Owner = pOwner;
+    m_tResults.push_back(oResult);
+    return(m_tResults.back());
+}
+
+/**
+ * @brief Starts an upload in a free slot. A running upload of the owner for the
+ * same path is replaced - the other files of the owner are not touched.
+ */
+CFileUpload * CFileUploads::begin(const void *pOwner, const char *pszPath) {
+    if(!pOwner) return(nullptr);
+    for(Slot &oSlot : m_tSlots) {
+        if(oSlot.Owner == pOwner && pszPath && strcmp(oSlot.Upload->getPath(),pszPath) == 0) freeSlot(oSlot);
+    }
+    for(Slot &oSlot : m_tSlots) {
+        if(oSlot.Owner) continue;
+        CFileUpload *pUpload = new CFileUpload();
+        if(!pUpload->begin(pszPath)) {
+            delete pUpload;
+            m_ulFailed++;
+            getResult(pOwner).Failed = true;
+            return(nullptr);
+        }
+        oSlot.Owner  = pOwner;
+        oSlot.Upload = pUpload;
+        return(pUpload);
+    }
+    m_ulRejected++;
+    getResult(pOwner).Failed = true;
+    return(nullptr);
+}
+
+CFileUpload * CFileUploads::get(const void *pOwner, const char *pszPath) {
+    if(!pOwner || !pszPath) return(nullptr);
+    for(Slot &oSlot : m_tSlots) {
+        if(oSlot.Owner == pOwner && strcmp(oSlot.Upload->getPath(),pszPath) == 0) return(oSlot.Upload);
+    }
+    return(nullptr);
+}
+
+/**
+ * @brief Counts a finished upload for the owner and deletes it, so the slot is
+ * free for the next file of the request.
+ */
+void CFileUploads::done(const void *pOwner, CFileUpload *pUpload) {
+    for(Slot &oSlot : m_tSlots) {
+        if(!pUpload || oSlot.Owner != pOwner || oSlot.Upload != pUpload) continue;
+        bool bSuccess = !pUpload->isOpen() && !pUpload->hasFailed();
+        Result &oResult = getResult(pOwner);
+        if(bSuccess) {
+            m_ulCompleted++;
+            oResult.Completed++;
+        } else {
+            m_ulFailed++;
+            oResult.Failed = true;
+        }
+        freeSlot(oSlot);
+    }
+}
+
+/**
+ * @brief Deletes the uploads and the result of the owner.
+ * Unfinished uploads (i.E. of a disconnected request) are aborted and counted as failed.
+ */
+bool CFileUploads::release(const void *pOwner) {
+    if(!pOwner) return(false);
+    bool bFailed = false;
+    for(Slot &oSlot : m_tSlots) {
+        if(oSlot.Owner == pOwner) {
+            m_ulFailed++;
+            bFailed = true;
+            freeSlot(oSlot);
+        }
+    }
+    size_t nCompleted = 0;
+    for(auto itResult = m_tResults.begin(); itResult != m_tResults.end(); ++itResult) {
+        if(itResult->Owner == pOwner) {
+            bFailed    = bFailed || itResult->Failed;
+            nCompleted = itResult->Completed;
+            m_tResults.erase(itResult);
+            break;
+        }
+    }
+    return(nCompleted > 0 && !bFailed);
+}
+
+size_t CFileUploads::getActive() {
+    size_t nActive = 0;
+    for(Slot &oSlot : m_tSlots) if(oSlot.Owner) nActive++;
+    return(nActive);
+}
+
+void CFileUploads::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
+    oStatusNode.setValue("active",   (int) getActive());
+    oStatusNode.setValue("completed",m_ulCompleted);
+    oStatusNode.setValue("failed",   m_ulFailed);
+    oStatusNode.setValue("rejected", m_ulRejected);
+}
+
+#pragma endregion
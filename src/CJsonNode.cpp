@@ -4,6 +4,10 @@
 #include "JsonNode.h"
 #include "LSCUtils.h"
 #include "DevelopmentHelper.h"
+#include <algorithm>
+#include <math.h>
+#include <errno.h>
+#include <ext/base64.h>
 
 /**
  * @brief Create a JSON node with an optional name and explicit node type.
@@ -177,6 +181,113 @@ void CJsonNode::remove(const char* pszName) {
     }
 }
 
+/**
+ * @brief Replace the content of this node by a deep copy of the source.
+ * The name of this node is kept, child nodes get the names of the source.
+ */
+void CJsonNode::copyFrom(CJsonNode & oSource) {
+    if(&oSource == this) return;
+    clear();
+    m_nObjectType           = oSource.m_nObjectType;
+    m_bWriteValueWithQuotes = oSource.m_bWriteValueWithQuotes;
+    m_strValue              = oSource.m_strValue;
+    for(CJsonNode *pSourceNode : oSource.Elements) {
+        CJsonNode *pNode = new CJsonNode();
+        pNode->setParentNode(this);
+        pNode->Name = pSourceNode->Name;
+        pNode->copyFrom(*pSourceNode);
+        Elements.push_back(pNode);
+    }
+}
+
+/**
+ * @brief Merge the source node into this node.
+ * If both nodes are objects, the source elements are merged recursively by name,
+ * missing elements are added. Otherwise this node becomes a copy of the source.
+ * Elements that are not in the source are kept.
+ */
+void CJsonNode::merge(CJsonNode & oSource) {
+    if(&oSource == this) return;
+    if(!isJsonObject() || !oSource.isJsonObject()) {
+        copyFrom(oSource);
+        return;
+    }
+    for(CJsonNode *pSourceNode : oSource.Elements) {
+        CJsonNode *pNode = pSourceNode->Name.length() > 0 ? find(pSourceNode->Name.c_str(),false) : nullptr;
+        if(!pNode) {
+            pNode = new CJsonNode();
+            pNode->setParentNode(this);
+            pNode->Name = pSourceNode->Name;
+            Elements.push_back(pNode);
+            pNode->copyFrom(*pSourceNode);
+        } else {
+            pNode->merge(*pSourceNode);
+        }
+    }
+}
+
+/**
+ * @brief Compare the content of two node trees.
+ * Names of the root nodes are not compared. Object elements are compared in
+ * their order, so a status written by the same code compares as expected.
+ */
+bool CJsonNode::isEqual(CJsonNode & oOther) {
+    if(&oOther == this) return(true);
+    if(m_nObjectType != oOther.m_nObjectType || Elements.size() != oOther.Elements.size()) return(false);
+    if(m_nObjectType == ELEMENT_TYPE::VALUE) {
+        return(m_bWriteValueWithQuotes == oOther.m_bWriteValueWithQuotes && m_strValue == oOther.m_strValue);
+    }
+    for(size_t nIdx = 0; nIdx < Elements.size(); nIdx++) {
+        if(Elements[nIdx]->Name != oOther.Elements[nIdx]->Name) return(false);
+        if(!Elements[nIdx]->isEqual(*oOther.Elements[nIdx])) return(false);
+    }
+    return(true);
+}
+
+/**
+ * @brief Create the merge patch (RFC 7386), that turns oOld into oNew.
+ * Objects are compared recursively, changed values and arrays are copied as a
+ * whole, removed elements are written as null. If the nodes are not both
+ * objects, the patch is a copy of oNew.
+ * @return true if the patch contains changes.
+ */
+bool CJsonNode::createMergePatch(CJsonNode & oOld, CJsonNode & oNew) {
+    clear();
+    m_nObjectType = ELEMENT_TYPE::OBJECT;
+    if(!oOld.isJsonObject() || !oNew.isJsonObject()) {
+        if(oOld.isEqual(oNew)) return(false);
+        copyFrom(oNew);
+        return(true);
+    }
+    for(CJsonNode *pNewNode : oNew.Elements) {
+        CJsonNode *pOldNode = oOld.find(pNewNode->Name.c_str(),false);
+        CJsonNode *pPatch   = new CJsonNode();
+        pPatch->setParentNode(this);
+        pPatch->Name = pNewNode->Name;
+        bool bChanged = true;
+        if(!pOldNode) {
+            pPatch->copyFrom(*pNewNode);
+        } else if(pOldNode->isJsonObject() && pNewNode->isJsonObject()) {
+            bChanged = pPatch->createMergePatch(*pOldNode,*pNewNode);
+        } else if(pOldNode->isEqual(*pNewNode)) {
+            bChanged = false;
+        } else {
+            pPatch->copyFrom(*pNewNode);
+        }
+        if(bChanged) Elements.push_back(pPatch);
+        else         delete(pPatch);
+    }
+    for(CJsonNode *pOldNode : oOld.Elements) {
+        if(!oNew.find(pOldNode->Name.c_str(),false)) {
+            CJsonNode *pRemoved = new CJsonNode(pOldNode->Name.c_str(),"null");
+            pRemoved->m_bWriteValueWithQuotes = false;
+            pRemoved->setParentNode(this);
+            Elements.push_back(pRemoved);
+        }
+    }
+    return(!Elements.empty());
+}
+
 #pragma region set the value
 
 /**
@@ -942,6 +1053,104 @@ const char* CJsonNode::getAsJsonTextPretty() {
     return(m_strSerializationCache.c_str());
 }
 
+/**
+ * @brief Writes JSON text into a fixed buffer, or only counts the length.
+ * Text beyond the buffer is counted, but not written.
+ */
+class CJsonTextWriter {
+    private:
+        char   *m_pBuffer;
+        size_t  m_nBufferSize;
+        size_t  m_nLen = 0;
+    public:
+        CJsonTextWriter(char *pBuffer, size_t nBufferSize) : m_pBuffer(pBuffer), m_nBufferSize(pBuffer ? nBufferSize : 0) {}
+        void write(const char *pszData, size_t nLen) {
+            if(m_nLen < m_nBufferSize) memcpy(m_pBuffer + m_nLen,pszData,std::min(nLen,m_nBufferSize - m_nLen));
+            m_nLen += nLen;
+        }
+        void write(const char *pszData) { write(pszData,strlen(pszData)); }
+        /// @brief Write a value, with backslash and quote escaped.
+        void writeEscaped(const char *pszData) {
+            const char *pszRun = pszData;
+            for(; *pszData; pszData++) {
+                if(*pszData == '\\' || *pszData == '"') {
+                    write(pszRun,pszData - pszRun);
+                    write("\\",1);
+                    pszRun = pszData;
+                }
+            }
+            write(pszRun,pszData - pszRun);
+        }
+        /// @brief Terminate the text, if there is room for the terminator.
+        size_t finish() {
+            if(m_nLen < m_nBufferSize) m_pBuffer[m_nLen] = '\0';
+            return(m_nLen);
+        }
+};
+
+/**
+ * @brief Length of the compact JSON text, as getAsJsonText() would produce it.
+ * The tree is walked once, nothing is allocated - use it to size a send buffer.
+ * @return Number of chars without terminator.
+ */
+size_t CJsonNode::measureJson() {
+    CJsonTextWriter oWriter(nullptr,0);
+    writeNode(oWriter);
+    return(oWriter.finish());
+}
+
+/**
+ * @brief Serialize this node tree as compact JSON directly into a buffer.
+ *
+ * The text is the same as getAsJsonText(), but no String is built. If the
+ * buffer is too small, the text is cut - the terminator is only written, if
+ * there is room for it. To send a large document in parts, use CJsonSerializer.
+ * @param pBuffer Target buffer.
+ * @param nBufferSize Size of the buffer.
+ * @return Length of the complete text (without terminator), like measureJson().
+ */
+size_t CJsonNode::serializeTo(char *pBuffer, size_t nBufferSize) {
+    CJsonTextWriter oWriter(pBuffer,nBufferSize);
+    writeNode(oWriter);
+    return(oWriter.finish());
+}
+
+/**
+ * @brief Recursively write this node as compact JSON.
+ * @see serializeNode()
+ */
+void CJsonNode::writeNode(CJsonTextWriter & oWriter) {
+    switch(this->m_nObjectType) {
+        case ELEMENT_TYPE::VALUE:
+            if(m_bWriteValueWithQuotes) oWriter.write("\"",1);
+            oWriter.writeEscaped(getValueAsCharPointer(""));
+            if(m_bWriteValueWithQuotes) oWriter.write("\"",1);
+            break;
+
+        case ELEMENT_TYPE::OBJECT:
+        case ELEMENT_TYPE::ARRAY:
+            {
+                bool bFirstElement = true;
+                oWriter.write(m_nObjectType == ELEMENT_TYPE::OBJECT ? "{" : "[",1);
+                for(CJsonNode *pChildNode : this->Elements) {
+                    if(!bFirstElement) oWriter.write(",",1);
+                    if(pChildNode->Name.length() > 0) {
+                        oWriter.write("\"",1);
+                        oWriter.write(pChildNode->Name.c_str(),pChildNode->Name.length());
+                        oWriter.write("\":",2);
+                    }
+                    pChildNode->writeNode(oWriter);
+                    bFirstElement = false;
+                }
+                oWriter.write(m_nObjectType == ELEMENT_TYPE::OBJECT ? "}" : "]",1);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
 /**
  * @brief Append indentation spaces used by pretty JSON serialization.
  */
@@ -1022,10 +1231,127 @@ const char* CJsonNode::serializeNode(String & strResultString, int nIdentDeep) {
 }
 
 
+#pragma endregion
+
+#pragma region Implementation of CJsonSerializer
+
+CJsonSerializer::CJsonSerializer(CJsonNode *pRoot) {
+    if(pRoot) m_tStack.push_back({ pRoot, 0, false });
+}
+
+void CJsonSerializer::addPiece(const char *pszText, size_t nLen, bool bEscaped) {
+    m_tPieces[m_nPieces++] = { pszText, nLen, bEscaped };
+}
+
+/**
+ * @brief Walks one step through the tree and collects the text of this step.
+ * The steps are the same as in CJsonNode::writeNode().
+ * @return false at the end of the tree.
+ */
+bool CJsonSerializer::next() {
+    m_nPieces = 0;
+    m_nPiece  = 0;
+    while(m_nPieces == 0 && !m_tStack.empty()) {
+        Frame &oFrame = m_tStack.back();
+        CJsonNode *pNode = oFrame.Node;
+        bool bObject = pNode->m_nObjectType == CJsonNode::ELEMENT_TYPE::OBJECT;
+        if(pNode->m_nObjectType == CJsonNode::ELEMENT_TYPE::VALUE) {
+            const char *pszValue = pNode->getValueAsCharPointer("");
+            if(pNode->m_bWriteValueWithQuotes) addPiece("\"",1);
+            addPiece(pszValue,strlen(pszValue),true);
+            if(pNode->m_bWriteValueWithQuotes) addPiece("\"",1);
+            m_tStack.pop_back();
+        } else if(!bObject && pNode->m_nObjectType != CJsonNode::ELEMENT_TYPE::ARRAY) {
+            m_tStack.pop_back();
+        } else if(!oFrame.Opened) {
+            oFrame.Opened = true;
+            addPiece(bObject ? "{" : "[",1);
+        } else if(oFrame.Child < pNode->Elements.size()) {
+            CJsonNode *pChildNode = pNode->Elements[oFrame.Child];
+            if(oFrame.Child > 0) addPiece(",",1);
+            if(pChildNode->Name.length() > 0) {
+                addPiece("\"",1);
+                addPiece(pChildNode->Name.c_str(),pChildNode->Name.length());
+                addPiece("\":",2);
+            }
+            oFrame.Child++;
+            m_tStack.push_back({ pChildNode, 0, false });
+        } else {
+            addPiece(bObject ? "}" : "]",1);
+            m_tStack.pop_back();
+        }
+    }
+    return(m_nPieces > 0);
+}
+
+/**
+ * @brief Writes the next part of the text into the buffer.
+ * An escaped char may be split from its backslash, it starts the next part then.
+ * @return Number of chars written, 0 at the end of the text.
+ */
+size_t CJsonSerializer::read(char *pBuffer, size_t nMaxLen) {
+    size_t nLen = 0;
+    while(nLen < nMaxLen) {
+        if(m_cPending) {
+            pBuffer[nLen++] = m_cPending;
+            m_cPending = 0;
+            continue;
+        }
+        if(m_nPiece >= m_nPieces && !next()) break;
+        Piece &oPiece = m_tPieces[m_nPiece];
+        if(oPiece.Escaped) {
+            while(oPiece.Len > 0 && nLen < nMaxLen) {
+                char c = *oPiece.Text++;
+                oPiece.Len--;
+                if(c == '\\' || c == '"') {
+                    pBuffer[nLen++] = '\\';
+                    if(nLen == nMaxLen) {
+                        m_cPending = c;
+                        break;
+                    }
+                }
+                pBuffer[nLen++] = c;
+            }
+        } else {
+            size_t nCopy = std::min(oPiece.Len,nMaxLen - nLen);
+            memcpy(pBuffer + nLen,oPiece.Text,nCopy);
+            oPiece.Text += nCopy;
+            oPiece.Len  -= nCopy;
+            nLen        += nCopy;
+        }
+        if(oPiece.Len == 0) m_nPiece++;
+    }
+    return(nLen);
+}
+
 #pragma endregion
 
 #pragma region parsing the input
 
+/// @brief Append the character of a "\uXXXX" escape as UTF-8 (surrogates are not combined).
+/// @param pszJsonData Input string positioned at the 'u'.
+/// @return Pointer to the last character of the escape.
+static const char* parseUnicodeEscape(const char* pszJsonData, String& strValueData) {
+    unsigned int unCode = 0;
+    int nDigits = 0;
+    for (; nDigits < 4 && isxdigit((unsigned char) pszJsonData[nDigits + 1]); nDigits++) {
+        char cDigit = pszJsonData[nDigits + 1];
+        unCode = (unCode << 4) | (unsigned int) (cDigit <= '9' ? cDigit - '0' : (cDigit | 0x20) - 'a' + 10);
+    }
+    if (nDigits < 4) { strValueData += 'u'; return(pszJsonData); }
+    if (unCode < 0x80) {
+        strValueData += (char) unCode;
+    } else if (unCode < 0x800) {
+        strValueData += (char) (0xC0 | (unCode >> 6));
+        strValueData += (char) (0x80 | (unCode & 0x3F));
+    } else {
+        strValueData += (char) (0xE0 | (unCode >> 12));
+        strValueData += (char) (0x80 | ((unCode >> 6) & 0x3F));
+        strValueData += (char) (0x80 | (unCode & 0x3F));
+    }
+    return(pszJsonData + 4);
+}
+
 /// @brief Parse a scalar JSON token from the input string.
 /// @param pszJsonData Input string positioned at the value start.
 /// @param strValueData Parsed value text is written here.
@@ -1066,7 +1392,20 @@ const char* CJsonNode::parseValue(const char* pszJsonData, String& strValueData,
             // If a quoted string is active, insert data as is.
             // If it is non quoted, ignore all non white spaces
             // TODO: Optimize, cause only numbers and bools are outside a string.
-            if (LSC::isWhite(*pszJsonData)) {
+            if (bEscapeIsActive) {
+                // Control characters, as written by other JSON encoders (browser)
+                switch (*pszJsonData) {
+                    case 'n': strValueData += '\n'; break;
+                    case 'r': strValueData += '\r'; break;
+                    case 't': strValueData += '\t'; break;
+                    case 'b': strValueData += '\b'; break;
+                    case 'f': strValueData += '\f'; break;
+                    case 'u': pszJsonData = parseUnicodeEscape(pszJsonData,strValueData); break;
+                    default:  strValueData += *pszJsonData; break;
+                }
+                bEscapeIsActive = false;
+            }
+            else if (LSC::isWhite(*pszJsonData)) {
                 if (bStringIsActive)    strValueData += *pszJsonData;
             }
             else                      strValueData += *pszJsonData;
@@ -1145,3 +1484,291 @@ const char* CJsonNode::parse(const char* pszJsonData) {
 
 
 #pragma #endregion
+
+#pragma region CBOR encoding (RFC 8949)
+
+#define CBOR_MAJOR_UINT     0
+#define CBOR_MAJOR_NINT     1
+#define CBOR_MAJOR_BYTES    2
+#define CBOR_MAJOR_TEXT     3
+#define CBOR_MAJOR_ARRAY    4
+#define CBOR_MAJOR_MAP      5
+#define CBOR_MAJOR_TAG      6
+#define CBOR_MAJOR_SIMPLE   7
+#define CBOR_INDEFINITE     31
+#define CBOR_BREAK          0xFF
+
+/**
+ * @brief Writes CBOR into a fixed buffer, or only counts the length.
+ * Data beyond the buffer is counted, but not written.
+ */
+class CJsonCborWriter {
+    private:
+        uint8_t *m_pBuffer;
+        size_t   m_nBufferSize;
+        size_t   m_nLen = 0;
+    public:
+        CJsonCborWriter(uint8_t *pBuffer, size_t nBufferSize) : m_pBuffer(pBuffer), m_nBufferSize(pBuffer ? nBufferSize : 0) {}
+        void write(const void *pData, size_t nLen) {
+            if(m_nLen < m_nBufferSize) memcpy(m_pBuffer + m_nLen,pData,std::min(nLen,m_nBufferSize - m_nLen));
+            m_nLen += nLen;
+        }
+        void writeByte(uint8_t byData) { write(&byData,1); }
+        /// @brief Write the initial byte and the argument (big endian, shortest form).
+        void writeHead(uint8_t byMajor, uint64_t ullValue) {
+            uint8_t tHead[9];
+            size_t  nArgLen = ullValue < 24 ? 0 : ullValue <= 0xFF ? 1 : ullValue <= 0xFFFF ? 2 : ullValue <= 0xFFFFFFFFULL ? 4 : 8;
+            tHead[0] = (uint8_t) (byMajor << 5) | (nArgLen == 0 ? (uint8_t) ullValue : nArgLen == 1 ? 24 : nArgLen == 2 ? 25 : nArgLen == 4 ? 26 : 27);
+            for(size_t nIdx = 0; nIdx < nArgLen; nIdx++) tHead[nArgLen - nIdx] = (uint8_t) (ullValue >> (nIdx * 8));
+            write(tHead,nArgLen + 1);
+        }
+        void writeText(const char *pszText, size_t nLen) {
+            writeHead(CBOR_MAJOR_TEXT,nLen);
+            write(pszText,nLen);
+        }
+        size_t getLength() { return(m_nLen); }
+};
+
+/**
+ * @brief Recursively write this node as CBOR.
+ *
+ * Quoted values are text strings. Unquoted values are written as their type:
+ * true/false/null as simple values, integers as (negative) integers, other
+ * numbers as float - single precision, if no precision is lost. Unquoted text,
+ * that is no literal, is written as text string.
+ */
+void CJsonNode::writeCbor(CJsonCborWriter & oWriter) {
+    switch(this->m_nObjectType) {
+        case ELEMENT_TYPE::VALUE: {
+            const char *pszValue = getValueAsCharPointer("");
+            if(m_bWriteValueWithQuotes || !*pszValue) {
+                oWriter.writeText(pszValue,strlen(pszValue));
+            } else if(strcmp(pszValue,"true") == 0) {
+                oWriter.writeByte(0xF5);
+            } else if(strcmp(pszValue,"false") == 0) {
+                oWriter.writeByte(0xF4);
+            } else if(strcmp(pszValue,"null") == 0) {
+                oWriter.writeByte(0xF6);
+            } else {
+                char *pszEnd = nullptr;
+                bool bIsFloat = strpbrk(pszValue,".eE") != nullptr;
+                errno = 0;
+                long long llValue = bIsFloat ? 0 : strtoll(pszValue,&pszEnd,10);
+                if(!bIsFloat && *pszEnd == '\0' && errno == 0) {
+                    if(llValue >= 0) oWriter.writeHead(CBOR_MAJOR_UINT,(uint64_t) llValue);
+                    else             oWriter.writeHead(CBOR_MAJOR_NINT,(uint64_t) (-1 - llValue));
+                    break;
+                }
+                double dValue = strtod(pszValue,&pszEnd);
+                if(*pszEnd != '\0') {
+                    oWriter.writeText(pszValue,strlen(pszValue));
+                } else if((double) (float) dValue == dValue) {
+                    float fValue = (float) dValue;
+                    uint32_t ulBits;
+                    memcpy(&ulBits,&fValue,sizeof(ulBits));
+                    oWriter.writeByte(0xFA);
+                    for(int nShift = 24; nShift >= 0; nShift -= 8) oWriter.writeByte((uint8_t) (ulBits >> nShift));
+                } else {
+                    uint64_t ullBits;
+                    memcpy(&ullBits,&dValue,sizeof(ullBits));
+                    oWriter.writeByte(0xFB);
+                    for(int nShift = 56; nShift >= 0; nShift -= 8) oWriter.writeByte((uint8_t) (ullBits >> nShift));
+                }
+            }
+            break;
+        }
+        case ELEMENT_TYPE::OBJECT:
+            oWriter.writeHead(CBOR_MAJOR_MAP,Elements.size());
+            for(CJsonNode *pChildNode : this->Elements) {
+                oWriter.writeText(pChildNode->Name.c_str(),pChildNode->Name.length());
+                pChildNode->writeCbor(oWriter);
+            }
+            break;
+
+        case ELEMENT_TYPE::ARRAY:
+            oWriter.writeHead(CBOR_MAJOR_ARRAY,Elements.size());
+            for(CJsonNode *pChildNode : this->Elements) pChildNode->writeCbor(oWriter);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Length of the CBOR encoding of this node tree, nothing is allocated.
+ */
+size_t CJsonNode::measureCbor() {
+    CJsonCborWriter oWriter(nullptr,0);
+    writeCbor(oWriter);
+    return(oWriter.getLength());
+}
+
+/**
+ * @brief Encode this node tree as CBOR (RFC 8949) directly into a buffer.
+ *
+ * Objects become maps, arrays arrays and values their CBOR type (see writeCbor()).
+ * If the buffer is too small, the data is cut.
+ * @param pBuffer Target buffer.
+ * @param nBufferSize Size of the buffer.
+ * @return Length of the complete encoding, like measureCbor().
+ */
+size_t CJsonNode::serializeCborTo(uint8_t *pBuffer, size_t nBufferSize) {
+    CJsonCborWriter oWriter(pBuffer,nBufferSize);
+    writeCbor(oWriter);
+    return(oWriter.getLength());
+}
+
+/**
+ * @brief Reads the argument of a CBOR head.
+ * @return Position after the argument, nullptr if the data is too short or reserved.
+ */
+static const uint8_t * readCborArgument(const uint8_t *pData, const uint8_t *pEnd, uint8_t byInfo, uint64_t &ullValue) {
+    size_t nArgLen = byInfo < 24 ? 0 : byInfo == 24 ? 1 : byInfo == 25 ? 2 : byInfo == 26 ? 4 : byInfo == 27 ? 8 : 99;
+    if(nArgLen == 99 || (size_t) (pEnd - pData) < nArgLen) return(nullptr);
+    ullValue = nArgLen == 0 ? byInfo : 0;
+    for(size_t nIdx = 0; nIdx < nArgLen; nIdx++) ullValue = (ullValue << 8) | *pData++;
+    return(pData);
+}
+
+/**
+ * @brief Formats a float as shortest text, that reads back to the same value.
+ */
+static void formatCborFloat(double dValue, bool bSingle, String &strValue) {
+    char szBuffer[32];
+    for(int nPrecision = bSingle ? 6 : 15; nPrecision <= 17; nPrecision++) {
+        snprintf(szBuffer,sizeof(szBuffer),"%.*g",nPrecision,dValue);
+        double dRead = strtod(szBuffer,nullptr);
+        if(bSingle ? (float) dRead == (float) dValue : dRead == dValue) break;
+    }
+    strValue = szBuffer;
+}
+
+/**
+ * @brief Recursively read one CBOR item into this node.
+ *
+ * Maps become objects (text or unsigned keys), arrays arrays, byte strings
+ * base64 text, tags are skipped. NaN, infinity and undefined become null.
+ * Indefinite length maps and arrays are supported, indefinite strings not.
+ * @return Position after the item, nullptr if the data is invalid.
+ */
+const uint8_t * CJsonNode::readCbor(const uint8_t *pData, const uint8_t *pEnd, int nDepth) {
+    if(!pData || pData >= pEnd || nDepth > JSON_CBOR_MAX_DEPTH) return(nullptr);
+    uint8_t  byMajor = *pData >> 5;
+    uint8_t  byInfo  = *pData & 0x1F;
+    uint64_t ullArg  = 0;
+    pData++;
+    bool bIndefinite = byInfo == CBOR_INDEFINITE && (byMajor == CBOR_MAJOR_ARRAY || byMajor == CBOR_MAJOR_MAP);
+    if(!bIndefinite && byMajor != CBOR_MAJOR_SIMPLE) {
+        pData = readCborArgument(pData,pEnd,byInfo,ullArg);
+        if(!pData) return(nullptr);
+    }
+    char szBuffer[32];
+    switch(byMajor) {
+        case CBOR_MAJOR_UINT:
+            snprintf(szBuffer,sizeof(szBuffer),"%llu",(unsigned long long) ullArg);
+            setValue(szBuffer)->m_bWriteValueWithQuotes = false;
+            break;
+
+        case CBOR_MAJOR_NINT:
+            if(ullArg == UINT64_MAX) return(nullptr);
+            snprintf(szBuffer,sizeof(szBuffer),"-%llu",(unsigned long long) ullArg + 1);
+            setValue(szBuffer)->m_bWriteValueWithQuotes = false;
+            break;
+
+        case CBOR_MAJOR_BYTES:
+        case CBOR_MAJOR_TEXT: {
+            if((uint64_t) (pEnd - pData) < ullArg) return(nullptr);
+            if(byMajor == CBOR_MAJOR_TEXT) {
+                String strText;
+                strText.reserve((size_t) ullArg);
+                for(uint64_t ullIdx = 0; ullIdx < ullArg; ullIdx++) strText += (char) pData[ullIdx];
+                setValue(strText);
+            } else {
+                int nEncodedLen = 0;
+                char *pszEncoded = base64(pData,(int) ullArg,&nEncodedLen);
+                setValue(pszEncoded ? pszEncoded : "");
+                if(pszEncoded) free(pszEncoded);
+            }
+            pData += ullArg;
+            break;
+        }
+        case CBOR_MAJOR_ARRAY:
+        case CBOR_MAJOR_MAP: {
+            clear();
+            m_nObjectType = byMajor == CBOR_MAJOR_MAP ? ELEMENT_TYPE::OBJECT : ELEMENT_TYPE::ARRAY;
+            for(uint64_t ullIdx = 0; bIndefinite || ullIdx < ullArg; ullIdx++) {
+                if(pData >= pEnd) return(nullptr);
+                if(bIndefinite && *pData == CBOR_BREAK) { pData++; break; }
+                CJsonNode *pChildNode = new CJsonNode();
+                pChildNode->setParentNode(this);
+                Elements.push_back(pChildNode);
+                if(byMajor == CBOR_MAJOR_MAP) {
+                    // The key is read as node, only text and unsigned keys are valid
+                    if(pData >= pEnd || (*pData >> 5) > CBOR_MAJOR_TEXT || (*pData >> 5) == CBOR_MAJOR_NINT || (*pData >> 5) == CBOR_MAJOR_BYTES) return(nullptr);
+                    pData = pChildNode->readCbor(pData,pEnd,nDepth + 1);
+                    if(!pData) return(nullptr);
+                    pChildNode->Name = pChildNode->getValueAsCharPointer("");
+                }
+                pData = pChildNode->readCbor(pData,pEnd,nDepth + 1);
+                if(!pData) return(nullptr);
+            }
+            break;
+        }
+        case CBOR_MAJOR_TAG:
+            return(readCbor(pData,pEnd,nDepth + 1));
+
+        case CBOR_MAJOR_SIMPLE: {
+            if(byInfo >= 25 && byInfo <= 27) {
+                uint64_t ullBits = 0;
+                pData = readCborArgument(pData,pEnd,byInfo,ullBits);
+                if(!pData) return(nullptr);
+                double dValue;
+                if(byInfo == 25) {
+                    // Half precision: sign, 5 bit exponent, 10 bit mantissa
+                    int nExp = (ullBits >> 10) & 0x1F;
+                    int nMant = ullBits & 0x3FF;
+                    dValue = nExp == 0 ? ldexp(nMant,-24) : nExp == 31 ? (nMant ? NAN : INFINITY) : ldexp(nMant + 1024,nExp - 25);
+                    if(ullBits & 0x8000) dValue = -dValue;
+                } else if(byInfo == 26) {
+                    uint32_t ulBits = (uint32_t) ullBits;
+                    float fValue;
+                    memcpy(&fValue,&ulBits,sizeof(fValue));
+                    dValue = fValue;
+                } else {
+                    memcpy(&dValue,&ullBits,sizeof(dValue));
+                }
+                if(dValue - dValue != 0) {             // NaN or infinity, JSON has no literal for them
+                    setValue("null")->m_bWriteValueWithQuotes = false;
+                } else {
+                    String strValue;
+                    formatCborFloat(dValue,byInfo != 27,strValue);
+                    setValue(strValue)->m_bWriteValueWithQuotes = false;
+                }
+            } else if(byInfo == 20 || byInfo == 21) {
+                setValue(byInfo == 21);
+            } else if(byInfo == 22 || byInfo == 23) {
+                setValue("null")->m_bWriteValueWithQuotes = false;
+            } else {
+                return(nullptr);
+            }
+            break;
+        }
+        default:
+            return(nullptr);
+    }
+    return(pData);
+}
+
+/**
+ * @brief Decode one CBOR item (RFC 8949) into this node tree.
+ * @param pData CBOR data.
+ * @param nLen Length of the data.
+ * @return Number of bytes read, 0 if the data is invalid (the node content is undefined then).
+ */
+size_t CJsonNode::parseCbor(const uint8_t *pData, size_t nLen) {
+    const uint8_t *pNext = pData ? readCbor(pData,pData + nLen,0) : nullptr;
+    return(pNext ? (size_t) (pNext - pData) : 0);
+}
+
+#pragma endregion
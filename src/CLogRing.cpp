@@ -0,0 +1,215 @@
+#ifndef DEBUG_LSC_LOGGING
+    #undef DEBUGINFOS
+#endif
+
+#include <LogRing.h>
+#include <Logging.h>
+#include <Msgs.h>
+#include <DevelopmentHelper.h>
+
+#pragma region Critical section
+
+/**
+ * @brief Checks if the caller runs in an interrupt handler (or with disabled interrupts).
+ * The caller must not wait for the writers in this case.
+ */
+static bool isInInterrupt() {
+    #ifdef NATIVE_RUNTIME
+        return(false);
+    #elif defined(ESP32)
+        return(xPortInIsrContext());
+    #else
+        uint32_t ulPS;
+        __asm__ __volatile__("rsr %0,ps" : "=a"(ulPS));
+        return((ulPS & 0x0F) != 0);
+    #endif
+}
+
+void CLogRing::lock() {
+    #ifdef NATIVE_RUNTIME
+        m_oLock.lock();
+    #elif defined(ESP32)
+        portENTER_CRITICAL_SAFE(&m_tLock);
+    #else
+        m_ulSavedPS = xt_rsil(15);
+    #endif
+}
+
+void CLogRing::unlock() {
+    #ifdef NATIVE_RUNTIME
+        m_oLock.unlock();
+    #elif defined(ESP32)
+        portEXIT_CRITICAL_SAFE(&m_tLock);
+    #else
+        xt_wsr_ps(m_ulSavedPS);
+    #endif
+}
+
+#pragma endregion
+
+#pragma region Implementation of CLogRing
+
+/**
+ * @brief Adds a log entry to the ring.
+ *
+ * If the ring is full, the policy decides: drop the oldest entry, drop the new
+ * entry or write the oldest entry synchronously (LOG_RING_BLOCK). An interrupt
+ * handler or a writer (while the ring is drained) never blocks, the new entry is
+ * dropped instead.
+ * @param cType Log class character.
+ * @param pszText Text of the entry, truncated to LOG_RING_TEXT_SIZE - 1 chars.
+ * @return true if the entry has been added.
+ */
+bool CLogRing::push(char cType, const char *pszText) {
+    if(!pszText) pszText = "";
+    if(m_ePolicy == LOG_RING_BLOCK && !m_bDraining && !isInInterrupt()) {
+        char szText[LOG_RING_TEXT_SIZE];
+        char cOldType;
+        while(m_nCount >= LOG_RING_SIZE && pop(cOldType,szText)) {
+            m_ulBlocked++;
+            send(cOldType,szText);
+        }
+    }
+    bool bResult = true;
+    lock();
+    if(m_nCount >= LOG_RING_SIZE) {
+        m_ulDropped++;
+        if(m_ePolicy == LOG_RING_DROP_OLDEST) {
+            m_nHead = (m_nHead + 1) % LOG_RING_SIZE;
+            m_nCount--;
+        } else {
+            bResult = false;
+        }
+    }
+    if(bResult) {
+        LogRingEntry &oEntry = m_tSlots[(m_nHead + m_nCount) % LOG_RING_SIZE];
+        oEntry.Type = cType;
+        size_t nLen = strnlen(pszText,LOG_RING_TEXT_SIZE);
+        if(nLen >= LOG_RING_TEXT_SIZE) {
+            nLen = LOG_RING_TEXT_SIZE - 1;
+            m_ulTruncated++;
+        }
+        memcpy(oEntry.Text,pszText,nLen);
+        oEntry.Text[nLen] = '\0';
+        m_nCount++;
+        m_ulWritten++;
+        if(m_nCount > m_nHighWater) m_nHighWater = m_nCount;
+    }
+    unlock();
+    return(bResult);
+}
+
+/**
+ * @brief Formats a log entry on the stack and adds it to the ring.
+ * The text is formatted outside of the critical section.
+ * @param cType Log class character.
+ * @param pszFormat printf-style format (may be a flash string).
+ * @param pArgs Arguments of the format.
+ * @return true if the entry has been added.
+ */
+bool CLogRing::pushFormatted(char cType, const char *pszFormat, va_list *pArgs) {
+    // One char more than a slot, so push() detects the truncation
+    char szText[LOG_RING_TEXT_SIZE + 1];
+    va_list args;
+    va_copy(args,*pArgs);
+    vsnprintf_P(szText,sizeof(szText),pszFormat,args);
+    va_end(args);
+    return(push(cType,szText));
+}
+
+/**
+ * @brief Removes the oldest entry.
+ * @param cType Receives the log class character.
+ * @param pszText Receives the text, buffer of LOG_RING_TEXT_SIZE chars.
+ * @return false if the ring is empty.
+ */
+bool CLogRing::pop(char &cType, char *pszText) {
+    bool bResult = false;
+    lock();
+    if(m_nCount > 0) {
+        LogRingEntry &oEntry = m_tSlots[m_nHead];
+        cType = oEntry.Type;
+        memcpy(pszText,oEntry.Text,strlen(oEntry.Text) + 1);
+        m_nHead = (m_nHead + 1) % LOG_RING_SIZE;
+        m_nCount--;
+        bResult = true;
+    }
+    unlock();
+    return(bResult);
+}
+
+/**
+ * @brief Sends an entry as formatted log record to the writers.
+ */
+void CLogRing::send(char cType, const char *pszText) {
+    if(m_pEventHandler) {
+        bool bDraining = m_bDraining;
+        m_bDraining = true;
+        CLogRecord oRecord(cType,pszText);
+        m_pEventHandler->sendEvent(this,MSG_LOG_RECORD,&oRecord,cType);
+        m_bDraining = bDraining;
+    }
+}
+
+/**
+ * @brief Sends queued entries to the writers.
+ *
+ * At least one entry is sent, then entries are sent until the time budget is used.
+ * Entries logged by a writer during the drain are sent in a later call.
+ * @param ulBudgetMicros Time budget in micro seconds.
+ * @return Number of sent entries.
+ */
+size_t CLogRing::drain(unsigned long ulBudgetMicros) {
+    size_t nSent = 0;
+    if(m_bDraining) return(nSent);
+    char szText[LOG_RING_TEXT_SIZE];
+    char cType;
+    unsigned long ulStart = micros();
+    size_t nMax = m_nCount;
+    while(nSent < nMax && pop(cType,szText)) {
+        send(cType,szText);
+        nSent++;
+        if(micros() - ulStart >= ulBudgetMicros) break;
+    }
+    return(nSent);
+}
+
+/**
+ * @brief Sends all queued entries to the writers, without time budget.
+ * @return Number of sent entries.
+ */
+size_t CLogRing::flush() {
+    size_t nSent = 0;
+    if(m_bDraining) return(nSent);
+    char szText[LOG_RING_TEXT_SIZE];
+    char cType;
+    while(pop(cType,szText)) {
+        send(cType,szText);
+        nSent++;
+    }
+    return(nSent);
+}
+
+/**
+ * @brief Drains the ring once per loop iteration.
+ */
+int CLogRing::receiveEvent(const void *pSender, int nMsg, const void *pMessage, int nClass) {
+    if(nMsg == MSG_APPL_LOOP) drain();
+    return(EVENT_MSG_RESULT_OK);
+}
+
+/**
+ * @brief Writes the fill level and the counters of the ring.
+ */
+void CLogRing::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
+    oStatusNode.setValue("size",      (int) LOG_RING_SIZE);
+    oStatusNode.setValue("used",      (int) m_nCount);
+    oStatusNode.setValue("highwater", (int) m_nHighWater);
+    oStatusNode.setValue("written",   m_ulWritten);
+    oStatusNode.setValue("dropped",   m_ulDropped);
+    oStatusNode.setValue("truncated", m_ulTruncated);
+    oStatusNode.setValue("blocked",   m_ulBlocked);
+    oStatusNode.setValue("policy",    (int) m_ePolicy);
+}
+
+#pragma endregion
@@ -2,13 +2,287 @@
     #undef DEBUGINFOS
 #endif
 
-#include <Arduino.h>
+#include <Runtime.h>
 #include <JsonNode.h>
 #include <Logging.h>
 #include <Msgs.h>
 #include <DevelopmentHelper.h>
+#include <vector>
+#include <algorithm>
 
-#define LOG_ENTRY_BUFFER_SIZE  512
+#pragma region Log class lookup
+
+/**
+ * @brief Lookup table log class character -> log class number.
+ *        Built once from LOG_CLASS_LEVEL_MASK and LOG_CLASS_TYPE_ALWAYS.
+ */
+struct LogClassTable {
+    uint8_t  Level[128] = { 0 };
+    uint16_t AlwaysMask = 0;
+    LogClassTable() {
+        const char *pszLevelMask = LOG_CLASS_LEVEL_MASK;
+        for(int nIdx = (int) strlen(pszLevelMask) - 1; nIdx >= 0; nIdx--) {
+            Level[pszLevelMask[nIdx] & 0x7F] = nIdx;
+        }
+        for(const char *psz = LOG_CLASS_TYPE_ALWAYS; *psz; psz++) {
+            AlwaysMask |= 1 << Level[*psz & 0x7F];
+        }
+    }
+};
+
+static const LogClassTable & getLogClassTable() {
+    static const LogClassTable oTable;
+    return(oTable);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CLogFields
+
+/**
+ * @brief Adds a field.
+ * @return The new field, nullptr if the record is full (the field is dropped).
+ */
+CLogFields::LogField * CLogFields::addField(const char *pszName, char cType) {
+    if(m_nFields >= LOG_KV_MAX_FIELDS) {
+        m_nDropped++;
+        return(nullptr);
+    }
+    LogField *pField = &m_tFields[m_nFields++];
+    pField->Name = pszName ? pszName : "";
+    pField->Type = cType;
+    return(pField);
+}
+
+/**
+ * @brief Appends printf-style formatted text to a buffer.
+ * The position is advanced, even if the text has been truncated.
+ */
+static void appendText(char *pszBuffer, size_t nBufferSize, size_t &nPos, const char *pszFormat, ...) {
+    va_list args;
+    va_start(args,pszFormat);
+    int nLen = vsnprintf(pszBuffer + std::min(nPos,nBufferSize - 1),nPos < nBufferSize ? nBufferSize - nPos : 1,pszFormat,args);
+    va_end(args);
+    if(nLen > 0) nPos += nLen;
+}
+
+/**
+ * @brief Appends raw text to a buffer (truncated at the end of the buffer).
+ */
+static void appendRaw(char *pszBuffer, size_t nBufferSize, size_t &nPos, const char *pszText, size_t nLen) {
+    if(nPos + 1 < nBufferSize) {
+        size_t nCopy = std::min(nLen,nBufferSize - 1 - nPos);
+        memcpy(pszBuffer + nPos,pszText,nCopy);
+        pszBuffer[nPos + nCopy] = '\0';
+    }
+    nPos += nLen;
+}
+
+/**
+ * @brief Appends a JSON string (quoted and escaped) to a buffer.
+ * Runs of characters that need no escaping are copied in one step.
+ */
+static void appendJsonString(char *pszBuffer, size_t nBufferSize, size_t &nPos, const char *pszValue) {
+    appendRaw(pszBuffer,nBufferSize,nPos,"\"",1);
+    const char *pszRun = pszValue;
+    for(const char *psz = pszValue; ; psz++) {
+        unsigned char c = *psz;
+        if(c == '\0' || c == '"' || c == '\\' || c < 0x20) {
+            appendRaw(pszBuffer,nBufferSize,nPos,pszRun,psz - pszRun);
+            if(c == '\0') break;
+            if(c == '"' || c == '\\') {
+                char szEscaped[2] = { '\\', (char) c };
+                appendRaw(pszBuffer,nBufferSize,nPos,szEscaped,2);
+            } else if(c == '\n') {
+                appendRaw(pszBuffer,nBufferSize,nPos,"\\n",2);
+            } else {
+                appendText(pszBuffer,nBufferSize,nPos,"\\u%04x",c);
+            }
+            pszRun = psz + 1;
+        }
+    }
+    appendRaw(pszBuffer,nBufferSize,nPos,"\"",1);
+}
+
+/**
+ * @brief Appends the value of a field to a buffer.
+ * @param bJson true to write strings as JSON strings.
+ */
+static void appendFieldValue(char *pszBuffer, size_t nBufferSize, size_t &nPos, CLogFields::LogField &oField, bool bJson) {
+    switch(oField.Type) {
+        case 'i': appendText(pszBuffer,nBufferSize,nPos,"%lld",oField.lValue); break;
+        case 'u': appendText(pszBuffer,nBufferSize,nPos,"%llu",oField.ulValue); break;
+        case 'f': appendText(pszBuffer,nBufferSize,nPos,"%g",oField.dValue); break;
+        case 'b': appendText(pszBuffer,nBufferSize,nPos,"%s",oField.bValue ? "true" : "false"); break;
+        default:
+            if(!oField.pszValue)    appendText(pszBuffer,nBufferSize,nPos,"null");
+            else if(bJson)          appendJsonString(pszBuffer,nBufferSize,nPos,oField.pszValue);
+            else                    appendText(pszBuffer,nBufferSize,nPos,"\"%s\"",oField.pszValue);
+            break;
+    }
+}
+
+/**
+ * @brief Renders the record as text: event name=value name="text" ...
+ * @return Length of the complete text (may be larger than the buffer, like snprintf).
+ */
+size_t CLogFields::renderText(char *pszBuffer, size_t nBufferSize) {
+    size_t nPos = 0;
+    if(nBufferSize == 0) return(nPos);
+    pszBuffer[0] = '\0';
+    appendText(pszBuffer,nBufferSize,nPos,"%s",m_pszEvent ? m_pszEvent : "");
+    for(size_t nIdx = 0; nIdx < m_nFields; nIdx++) {
+        appendText(pszBuffer,nBufferSize,nPos," %s=",m_tFields[nIdx].Name);
+        appendFieldValue(pszBuffer,nBufferSize,nPos,m_tFields[nIdx],false);
+    }
+    if(m_nDropped > 0) appendText(pszBuffer,nBufferSize,nPos," (+%u fields)",(unsigned int) m_nDropped);
+    return(nPos);
+}
+
+/**
+ * @brief Renders the record as JSON object: {"event":"...","name":value,...}
+ * @return Length of the complete text (may be larger than the buffer, like snprintf).
+ */
+size_t CLogFields::renderJson(char *pszBuffer, size_t nBufferSize) {
+    size_t nPos = 0;
+    if(nBufferSize == 0) return(nPos);
+    pszBuffer[0] = '\0';
+    appendText(pszBuffer,nBufferSize,nPos,"{\"event\":");
+    appendJsonString(pszBuffer,nBufferSize,nPos,m_pszEvent ? m_pszEvent : "");
+    for(size_t nIdx = 0; nIdx < m_nFields; nIdx++) {
+        appendText(pszBuffer,nBufferSize,nPos,",");
+        appendJsonString(pszBuffer,nBufferSize,nPos,m_tFields[nIdx].Name);
+        appendText(pszBuffer,nBufferSize,nPos,":");
+        appendFieldValue(pszBuffer,nBufferSize,nPos,m_tFields[nIdx],true);
+    }
+    appendText(pszBuffer,nBufferSize,nPos,"}");
+    return(nPos);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CLogRecord
+
+/**
+ * @brief Returns the formatted text, formats it on the first call.
+ * Structured entries are rendered as text (see CLogFields::renderText()).
+ */
+const char * CLogRecord::getText() {
+    if(!m_bFormatted && m_pFields) {
+        m_pFields->renderText(m_pszBuffer,m_nBufferSize);
+        m_bFormatted = true;
+    }
+    if(!m_bFormatted) {
+        va_list args;
+        va_copy(args,*m_pArgs);
+        vsnprintf_P(m_pszBuffer, m_nBufferSize, m_pszFormat, args);
+        va_end(args);
+        m_bFormatted = true;
+    }
+    return(m_pszBuffer);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CLogSuppressor
+
+CLogSuppressor::CLogSuppressor() {
+    for(int nIdx = 0; nIdx < 10; nIdx++) {
+        m_tSampleEvery[nIdx] = 1;
+        m_tSampleCount[nIdx] = 0;
+    }
+}
+
+/**
+ * @brief Sets the sampling of a log class.
+ * @param cType Log class character.
+ * @param nEvery Pass only every n-th entry, 0 or 1 = pass all.
+ */
+void CLogSuppressor::setSampling(char cType, uint16_t nEvery) {
+    int nClass = CEventLogger::getLogClassNumberFrom(cType);
+    m_tSampleEvery[nClass] = nEvery > 0 ? nEvery : 1;
+    m_tSampleCount[nClass] = 0;
+}
+
+/**
+ * @brief Moves the unreported repeats of an entry into a report.
+ */
+void CLogSuppressor::takeReport(SuppressEntry &oEntry, LogRepeatReport &oReport) {
+    oReport.Type    = oEntry.Type;
+    oReport.Repeats = oEntry.Repeats;
+    if(oEntry.Repeats > 0) m_nPending--;
+    oEntry.Repeats  = 0;
+}
+
+/**
+ * @brief Checks if a log call passes.
+ *
+ * Sampling is applied first. Then the call is looked up in the table (a pair of
+ * entries per hash of key and class): a repeat within the window is counted and
+ * dropped. Any other call takes over its expired entry, a free or the older entry
+ * of the pair - if the previous call of this entry has been repeated, the repeats
+ * are returned in oReport, to be logged before the call.
+ * @param cType Log class character.
+ * @param pKey Address of the format string (or event name).
+ * @param oReport Receives the repeats of the replaced entry (Repeats = 0 if none).
+ * @return false if the call is dropped.
+ */
+bool CLogSuppressor::accept(char cType, const void *pKey, LogRepeatReport &oReport) {
+    oReport.Repeats = 0;
+    int nClass = CEventLogger::getLogClassNumberFrom(cType);
+    if(m_tSampleEvery[nClass] > 1) {
+        if(m_tSampleCount[nClass]++ % m_tSampleEvery[nClass] != 0) {
+            m_ulSampledOut++;
+            return(false);
+        }
+    }
+    if(m_ulWindow == 0 || !pKey) return(true);
+
+    // Two entries per hash value, so two colliding calls do not evict each other
+    uintptr_t ulHash = ((uintptr_t) pKey >> 2) ^ ((uintptr_t) pKey >> 7) ^ ((uintptr_t) cType * 31);
+    SuppressEntry *pPair = &m_tEntries[(ulHash << 1) & (LOG_SUPPRESS_TABLE_SIZE - 1)];
+    SuppressEntry *pEntry = nullptr;
+    for(int nIdx = 0; nIdx < 2 && !pEntry; nIdx++) {
+        if(pPair[nIdx].Key == pKey && pPair[nIdx].Type == cType) pEntry = &pPair[nIdx];
+    }
+    unsigned long ulNow = millis();
+    if(pEntry && ulNow - pEntry->Start < m_ulWindow) {
+        if(pEntry->Repeats++ == 0) m_nPending++;
+        m_ulSuppressed++;
+        return(false);
+    }
+    // Reuse the own expired entry, else a free one, else the older one
+    if(!pEntry) {
+        if(!pPair[0].Key)      pEntry = &pPair[0];
+        else if(!pPair[1].Key) pEntry = &pPair[1];
+        else                   pEntry = (long) (pPair[0].Start - pPair[1].Start) <= 0 ? &pPair[0] : &pPair[1];
+    }
+    SuppressEntry &oEntry = *pEntry;
+    takeReport(oEntry,oReport);
+    oEntry.Key   = pKey;
+    oEntry.Type  = cType;
+    oEntry.Start = ulNow;
+    return(true);
+}
+
+/**
+ * @brief Takes the repeats of an entry, whose window is over.
+ * @return false if there are no repeats to report.
+ */
+bool CLogSuppressor::takeExpired(LogRepeatReport &oReport) {
+    if(m_nPending == 0) return(false);
+    unsigned long ulNow = millis();
+    for(SuppressEntry &oEntry : m_tEntries) {
+        if(oEntry.Repeats > 0 && ulNow - oEntry.Start >= m_ulWindow) {
+            takeReport(oEntry,oReport);
+            oEntry.Key = nullptr;
+            return(true);
+        }
+    }
+    return(false);
+}
+
+#pragma endregion
 
 #pragma region Implementation of CEventLogger
 
@@ -22,56 +296,144 @@ CEventLogger::CEventLogger() { pEventHandler = nullptr;}
 
 /**
  * @brief Creates a logger that publishes log events to an event handler.
- * @param oEventHandler Message bus that receives MSG_LOG_ENTRY events.
+ * @param oEventHandler Message bus that receives the log records (MSG_LOG_RECORD).
  */
 CEventLogger::CEventLogger(CEventHandler *oEventHandler) {
     pEventHandler = oEventHandler;
 }
 
+/**
+ * @brief Creates a logger that queues log entries in a log ring.
+ *
+ * The entries are formatted when logged and sent to the writers, when the ring is
+ * drained (see CLogRing::drain()). So the caller never waits for a slow writer.
+ * @param oEventHandler Message bus that receives the log records.
+ * @param pRing Log ring, the entries are queued in.
+ */
+CEventLogger::CEventLogger(CEventHandler *oEventHandler, CLogRing *pRing) {
+    pEventHandler = oEventHandler;
+    m_pRing = pRing;
+}
+
 /**
  * @brief Converts a log class character to its numeric priority.
  * @param cClass Log class character such as 'I', 'W' or 'E'.
  * @return Index in LOG_CLASS_LEVEL_MASK, or 0 when not found.
  */
 int CEventLogger::getLogClassNumberFrom(const char cClass) {
-    int nResult = 0;
-    const char *strLevelMask = LOG_CLASS_LEVEL_MASK; 
-    for(size_t nIdx = 0; nIdx < strlen(strLevelMask); nIdx++) {
-        if(strLevelMask[nIdx] == cClass) {
-            nResult = nIdx; break;
-        }
+    return(getLogClassTable().Level[cClass & 0x7F]);
+}
+
+/**
+ * @brief Checks if any registered log writer writes entries of a log class.
+ * @param cClass Log class character.
+ * @return false if the entry would be dropped by all writers.
+ */
+bool CEventLogger::isClassEnabled(const char cClass) {
+    return((CLogWriter::getAcceptedClasses() & (1 << getLogClassNumberFrom(cClass))) != 0);
+}
+
+/**
+ * @brief Sends a log record into the message bus, or queues it in the log ring.
+ * The text buffer is reserved here, but only filled if a writer needs the text.
+ */
+void CEventLogger::sendRecord(char cType, const char *pszFormat, va_list *pArgs) {
+    if(m_pRing) {
+        m_pRing->pushFormatted(cType,pszFormat,pArgs);
+    } else {
+        char tBuffer[LOG_ENTRY_BUFFER_SIZE];
+        tBuffer[0] = '\0';
+        CLogRecord oRecord(cType,pszFormat,pArgs,tBuffer,sizeof(tBuffer));
+        pEventHandler->sendEvent(this, MSG_LOG_RECORD, &oRecord, cType);
+    }
+}
+
+/**
+ * @brief Sends a log message, that is not checked for repeats.
+ */
+void CEventLogger::sendText(char cType, const char *pszFormat, ...) {
+    va_list args;
+    va_start(args, pszFormat);
+    sendRecord(cType,pszFormat,&args);
+    va_end(args);
+}
+
+/**
+ * @brief Checks if a log call is suppressed (repeat or sampling).
+ * The repeats of a replaced call are logged first.
+ * @param cType Log class character.
+ * @param pKey Address of the format string (or event name).
+ * @return true if the call has to be dropped.
+ */
+bool CEventLogger::isSuppressed(char cType, const void *pKey) {
+    LogRepeatReport oReport;
+    // With a ring, the callers may be other tasks or interrupts - the table is guarded by the ring lock
+    if(m_pRing) m_pRing->lock();
+    bool bAccepted = Suppressor.accept(cType,pKey,oReport);
+    if(m_pRing) m_pRing->unlock();
+    if(oReport.Repeats > 0) sendText(oReport.Type,"last message repeated %lu times",oReport.Repeats);
+    return(!bAccepted);
+}
+
+/**
+ * @brief Logs the repeats of suppressed calls, whose window is over.
+ * Without this call, the repeats are reported when the call is logged again.
+ */
+void CEventLogger::flushRepeats() {
+    if(!pEventHandler) return;
+    LogRepeatReport oReport;
+    while(true) {
+        if(m_pRing) m_pRing->lock();
+        bool bExpired = Suppressor.takeExpired(oReport);
+        if(m_pRing) m_pRing->unlock();
+        if(!bExpired) break;
+        sendText(oReport.Type,"last message repeated %lu times",oReport.Repeats);
     }
-    return(nResult);
 }
 
 /**
- * @brief Formats a flash-string log message and publishes it as an event.
+ * @brief Sends a structured log record into the message bus, or queues its text in the log ring.
+ */
+void CEventLogger::sendFields(char cType, CLogFields &oFields) {
+    char tBuffer[LOG_ENTRY_BUFFER_SIZE];
+    tBuffer[0] = '\0';
+    if(m_pRing) {
+        oFields.renderText(tBuffer,sizeof(tBuffer));
+        m_pRing->push(cType,tBuffer);
+    } else {
+        CLogRecord oRecord(cType,&oFields,tBuffer,sizeof(tBuffer));
+        pEventHandler->sendEvent(this, MSG_LOG_RECORD, &oRecord, cType);
+    }
+}
+
+/**
+ * @brief Publishes a flash-string log message as a log record.
+ * Returns immediately, if no writer writes the log class or the call is suppressed.
  * @param pszType Log class string. The first character is used.
  * @param pszMessage printf-style flash string.
  */
 void CEventLogger::log(const char * pszType, const __FlashStringHelper* pszMessage,...) {
+    char cType = pszType == nullptr ? 'I' : pszType[0];
+    if(!pEventHandler || !isClassEnabled(cType) || isSuppressed(cType,pszMessage)) return;
     va_list args;
-    va_start(args, (const char*)pszMessage);
-    char strBuffer[LOG_ENTRY_BUFFER_SIZE];
-    vsnprintf_P(strBuffer, sizeof(strBuffer), (const char *) pszMessage, args);
+    va_start(args, pszMessage);
+    sendRecord(cType,(const char *) pszMessage,&args);
     va_end(args);
-    char cType = pszType == nullptr ? 'I' : pszType[0];
-    pEventHandler->sendEvent(this, MSG_LOG_ENTRY, strBuffer,cType );
 }
 
 /**
- * @brief Formats a RAM-string log message and publishes it as an event.
+ * @brief Publishes a RAM-string log message as a log record.
+ * Returns immediately, if no writer writes the log class or the call is suppressed.
  * @param pszType Log class string. The first character is used.
  * @param pszMessage printf-style string.
  */
 void CEventLogger::log(const char * pszType, const char *pszMessage, ...) {
+    char cType = pszType == nullptr ? 'I' : pszType[0];
+    if(!pEventHandler || !isClassEnabled(cType) || isSuppressed(cType,pszMessage)) return;
     va_list args;
     va_start(args, pszMessage);
-    char tBuffer[LOG_ENTRY_BUFFER_SIZE];
-    vsnprintf_P(tBuffer, sizeof(tBuffer), pszMessage, args);
+    sendRecord(cType,pszMessage,&args);
     va_end(args);
-    char cType = pszType == nullptr ? 'I' : pszType[0];
-    pEventHandler->sendEvent(this, MSG_LOG_ENTRY, tBuffer, cType );
 }
 
 /**
@@ -81,12 +443,48 @@ void CEventLogger::log(const char * pszType, const char *pszMessage, ...) {
  */
 void CEventLogger::log(const char * pszType, JsonNode *pDoc) {
     char cType = pszType == nullptr ? 'I' : pszType[0];
+    if(!pEventHandler || !isClassEnabled(cType)) return;
     pEventHandler->sendEvent(this, MSG_LOG_ENTRY_JSON,pDoc, cType );
 }
 #pragma endregion
 
 #pragma region CLogWriter, Base Class for all Log Writers
 
+/// @brief All existing log writers, to calculate the accepted log classes.
+static std::vector<CLogWriter *> g_tLogWriters;
+/// @brief Bit mask of the log class numbers, written by at least one writer.
+static uint16_t g_nAcceptedLogClasses = 0;
+
+CLogWriter::CLogWriter() {
+    g_tLogWriters.push_back(this);
+    updateAcceptedClasses();
+}
+
+CLogWriter::~CLogWriter() {
+    g_tLogWriters.erase(std::remove(g_tLogWriters.begin(),g_tLogWriters.end(),this),g_tLogWriters.end());
+    updateAcceptedClasses();
+}
+
+/**
+ * @brief Recalculates the log classes written by any writer.
+ */
+void CLogWriter::updateAcceptedClasses() {
+    uint16_t nMask = 0;
+    for(CLogWriter *pWriter : g_tLogWriters) {
+        if((int) pWriter->m_nLogLevel >= 0) nMask |= (uint16_t) ((2UL << std::min((int) pWriter->m_nLogLevel,15)) - 1);
+        nMask |= getLogClassTable().AlwaysMask;
+    }
+    g_nAcceptedLogClasses = nMask;
+}
+
+/**
+ * @brief Gets the log classes written by any writer.
+ * @return Bit mask, bit n is set if log class number n is written.
+ */
+uint16_t CLogWriter::getAcceptedClasses() {
+    return(g_nAcceptedLogClasses);
+}
+
 /**
  * @brief Gets the current maximum log level.
  * @return Numeric log level threshold.
@@ -103,6 +501,7 @@ int CLogWriter::getLogLevel() {
 int CLogWriter::setLogLevel(int nLogLevel) {
     int nOldLevel = m_nLogLevel;
     m_nLogLevel = nLogLevel;
+    updateAcceptedClasses();
     return(nOldLevel);
 }
 
@@ -112,13 +511,7 @@ int CLogWriter::setLogLevel(int nLogLevel) {
  * @return true for classes listed in LOG_CLASS_TYPE_ALWAYS.
  */
 bool CLogWriter::isTypeToWriteAlways(const char cType) {
-    bool bResult = false;
-    for(size_t nIdx = 0; nIdx < strlen(LOG_CLASS_TYPE_ALWAYS); nIdx++) {
-        if(cType == LOG_CLASS_TYPE_ALWAYS[nIdx]) {
-            bResult = true; break;
-        }
-    }
-    return(bResult);
+    return((getLogClassTable().AlwaysMask & (1 << CEventLogger::getLogClassNumberFrom(cType))) != 0);
 }
 
 /**
@@ -127,12 +520,26 @@ bool CLogWriter::isTypeToWriteAlways(const char cType) {
  * @return true when the class priority is within the configured threshold.
  */
 bool CLogWriter::isLogLevelToWrite(const char cType) {
-    bool bResult = false;
-    int nClass = CEventLogger::getLogClassNumberFrom(cType);
-    if(nClass >= 0 && nClass <= m_nLogLevel) {
-        bResult = true;
-    }
-    return(bResult);
+    return(CEventLogger::getLogClassNumberFrom(cType) <= m_nLogLevel);
+}
+
+/**
+ * @brief Checks if this writer writes a log class.
+ * @param cType Log class character.
+ * @return true if the level is within the threshold or the class is written always.
+ */
+bool CLogWriter::isClassToWrite(const char cType) {
+    return(isLogLevelToWrite(cType) || isTypeToWriteAlways(cType));
+}
+
+/**
+ * @brief Writes a log record.
+ *
+ * The base implementation formats the text (once for all writers) and calls
+ * writeLogEntry(). Writers that store or forward the raw record can override it.
+ */
+void CLogWriter::writeLogRecord(const char *pszType, CLogRecord *pRecord) {
+    writeLogEntry(pszType,pRecord->getText());
 }
 
 /**
@@ -156,22 +563,24 @@ void CLogWriter::writeLogEntry(const char *pszType, const char *pszMessage) {
 /**
  * @brief Receives log events and forwards accepted entries to writer hooks.
  * @param pSender Sender of the event.
- * @param nMsgType MSG_LOG_ENTRY or MSG_LOG_ENTRY_JSON.
- * @param pMessage Text pointer or JsonNode pointer depending on nMsgType.
+ * @param nMsgType MSG_LOG_RECORD, MSG_LOG_ENTRY or MSG_LOG_ENTRY_JSON.
+ * @param pMessage CLogRecord, text or JsonNode pointer depending on nMsgType.
  * @param nClass Log class character passed as an int.
  * @return EVENT_MSG_RESULT_OK after processing.
  */
 int CLogWriter::receiveEvent(const void *pSender, int nMsgType, const void *pMessage, int nClass) {
-    if(nMsgType == MSG_LOG_ENTRY || nMsgType == MSG_LOG_ENTRY_JSON) {
-        String strType = "";
+    if(nMsgType == MSG_LOG_RECORD || nMsgType == MSG_LOG_ENTRY || nMsgType == MSG_LOG_ENTRY_JSON) {
         char cLogClass = nClass;
-        if(isLogLevelToWrite(cLogClass) || isTypeToWriteAlways(cLogClass)) {
-            strType = cLogClass;
-            if(nMsgType == MSG_LOG_ENTRY) {
-                writeLogEntry(strType.c_str(),(const char *) pMessage);
+        if(isClassToWrite(cLogClass)) {
+            char szType[2] = { cLogClass, '\0' };
+            if(nMsgType == MSG_LOG_RECORD) {
+                writeLogRecord(szType,(CLogRecord *) pMessage);
+            }
+            else if(nMsgType == MSG_LOG_ENTRY) {
+                writeLogEntry(szType,(const char *) pMessage);
             } 
             else if (nMsgType == MSG_LOG_ENTRY_JSON) {
-                writeLogEntry(strType.c_str(),(JsonNode *)(pMessage));
+                writeLogEntry(szType,(JsonNode *)(pMessage));
             }
         }
     }
@@ -180,6 +589,7 @@ int CLogWriter::receiveEvent(const void *pSender, int nMsgType, const void *pMes
 
 #pragma endregion
 
+#ifndef NATIVE_RUNTIME
 /**
  * @brief Creates a log writer for an Arduino Stream.
  * @param pStream Stream destination, for example Serial.
@@ -210,6 +620,7 @@ void CStreamLogWriter::writeLogEntry(const char *pszType, JsonNode *pDoc) {
         pStream->println();
     }
 }
+#endif
 
 
 
@@ -116,17 +116,6 @@ bool CMQTTController::isDeviceCommandTopic(const char *pszTopic) {
 }
 
 
-/**
- * @brief Gets the cached base topic for device commands.
- * @return PublishTopicPrefix + "/cmd".
- */
-const char * CMQTTController::getDeviceCommandBaseTopicPath(){
-    if(m_pszDeviceCommandTopics == nullptr) {
-        m_pszDeviceCommandTopics = strdup((Config.PublishTopicPrefix + "/cmd").c_str());
-    }
-    return(m_pszDeviceCommandTopics);
-}
-
 #pragma endregion
 
 #pragma region Application interface implementation
@@ -182,6 +171,7 @@ void CMQTTController::writeStatusTo(JsonNode &oStatus, int nLevel) {
         oStatus.setValue("disconTS",        Status.ConEnd);
         oStatus.setValue("disconReasonRC",  (int) Status.DisConReason);
         oStatus.setValue("disconReason",    Status.DisConReasonString);
+        oStatus.setValue("droppedMsgs",     m_tMessageQeue.getDropped());
     }
 }
 
@@ -297,6 +287,7 @@ void CMQTTController::setup(int nPublishInterval) {
             m_pszHomeAssistantStatusTopic = strdup((Config.HADiscoveryPrefix + "/" + MQTT_MSG_TOPIC_STATUS).c_str());
         }
 
+        // The callbacks run on the network task - their events are handled by the application loop (dispatch())
         onDisconnect(std::bind(&CMQTTController::onMqttDisconnect, this, std::placeholders::_1));
     
         onConnect(std::bind(&CMQTTController::onMqttConnect, this, std::placeholders::_1));
@@ -324,10 +315,10 @@ void CMQTTController::setup(int nPublishInterval) {
 void CMQTTController::dispatch() {
     enableConnection();
     publishHeartBeat(false);
-    while(!m_tMessageQeue.empty()) {
-        MQTTMessage * pMessage = m_tMessageQeue.front();
+    dispatchConnectionEvents();
+    MQTTMessage * pMessage;
+    while(m_tMessageQeue.pop(pMessage)) {
         Appl.MsgBus.sendEvent(this,MSG_MQTT_MSG_RECEIVED,pMessage,0);
-        m_tMessageQeue.pop();
         delete pMessage;
     }
 }
@@ -510,8 +501,9 @@ void CMQTTController::publishHomeAssistantDiscovery() {
 /**
  * @brief Callback invoked after the broker connection was established.
  *
- * Subscribes to Home Assistant status and device command topics, publishes
- * availability, and notifies the application bus.
+ * Subscribes to Home Assistant status and device command topics and publishes
+ * availability. The callback runs on the network task (ESP32), so it only
+ * queues the event - status, log and bus are handled by dispatchConnectionEvents().
  */
 void CMQTTController::onMqttConnect(bool sessionPresent)
 {
@@ -520,8 +512,10 @@ void CMQTTController::onMqttConnect(bool sessionPresent)
                          Config.HADiscoveryPrefix.length() :
                          Config.PublishTopicPrefix.length();
     char szBuffer[nBufferSize + 20]; // Buffer to create the subscribe topic strings
-
-    Status.ConStart = millis();
+    MQTTConnectionEvent oEvent;
+    oEvent.Connected      = true;
+    oEvent.SessionPresent = sessionPresent;
+    oEvent.Time           = millis();
     
     // Listen on Home Assistant status topic to get the session status of Home Assistant
     if(Config.useHA && Config.HADiscoveryPrefix.length() > 0) {
@@ -537,51 +531,75 @@ void CMQTTController::onMqttConnect(bool sessionPresent)
     // Notify in the state availabilty
     publishDeviceTopic(MQTT_MSG_TOPIC_STATUS,MQTT_STATE_AVAILABLE, 2, true);
 
-    ApplLogInfoWithParms("MQTT session established (%d/%d)",sessionPresent,connected());
-    Appl.MsgBus.sendEvent(this,MSG_MQTT_CONNECTED,this,0);
+    m_tConnectionEvents.push(oEvent);
     DEBUG_FUNC_END();
 }
 
 /**
  * @brief Callback invoked after the broker connection was lost.
  *
- * Stores the disconnect reason in Status and emits MSG_MQTT_DISCONNECTED.
+ * The callback runs on the network task (ESP32), it only queues the reason -
+ * status, log and bus are handled by dispatchConnectionEvents().
  */
 void CMQTTController::onMqttDisconnect(AsyncMqttClientDisconnectReason oReason)
 {
-    Status.ConEnd = millis();
-	Status.DisConReason = oReason;
-	switch (oReason)
-	{
-        case (AsyncMqttClientDisconnectReason::TCP_DISCONNECTED):
-            Status.DisConReasonString = F("TCP Disconnected");
-            break;
-        case (AsyncMqttClientDisconnectReason::MQTT_UNACCEPTABLE_PROTOCOL_VERSION):
-            Status.DisConReasonString  = F("MQTT unacceptable protocol version");
-            break;
-        case (AsyncMqttClientDisconnectReason::MQTT_IDENTIFIER_REJECTED):
-            Status.DisConReasonString  = F("MQTT identifier rejected");
-            break;
-        case (AsyncMqttClientDisconnectReason::MQTT_SERVER_UNAVAILABLE):
-            Status.DisConReasonString  = F("MQTT server unavailable");
-            break;
-        case (AsyncMqttClientDisconnectReason::MQTT_MALFORMED_CREDENTIALS):
-            Status.DisConReasonString  = F("MQTT malformed credentials");
-            break;
-        case (AsyncMqttClientDisconnectReason::MQTT_NOT_AUTHORIZED):
-            Status.DisConReasonString  = F("MQTT not authorized");
-            break;
-        case (AsyncMqttClientDisconnectReason::ESP8266_NOT_ENOUGH_SPACE):
-            Status.DisConReasonString  = F("ESP not enough space");
-            break;
-        default:
-            Status.DisConReasonString  = F("Unknown");
-            break;
-	}
-    Appl.MsgBus.sendEvent(this,MSG_MQTT_DISCONNECTED,this,(int) oReason);
-    ApplLogInfoWithParms("MQTT disconnected (%d) - %s",
-                          oReason,
-                          Status.DisConReasonString.c_str());
+    MQTTConnectionEvent oEvent;
+    oEvent.Connected = false;
+    oEvent.Reason    = oReason;
+    oEvent.Time      = millis();
+    m_tConnectionEvents.push(oEvent);
+}
+
+/**
+ * @brief Handles the connect/disconnect events of the callbacks in the application loop.
+ *
+ * Updates Status (with the text of the disconnect reason), writes the log line
+ * and sends MSG_MQTT_CONNECTED / MSG_MQTT_DISCONNECTED and MSG_APPL_STATUS_CHANGED.
+ */
+void CMQTTController::dispatchConnectionEvents() {
+    MQTTConnectionEvent oEvent;
+    while(m_tConnectionEvents.pop(oEvent)) {
+        if(oEvent.Connected) {
+            Status.ConStart = oEvent.Time;
+            ApplLogInfoWithParms("MQTT session established (%d/%d)",oEvent.SessionPresent,connected());
+            Appl.MsgBus.sendEvent(this,MSG_MQTT_CONNECTED,this,0);
+        } else {
+            Status.ConEnd       = oEvent.Time;
+            Status.DisConReason = oEvent.Reason;
+            switch (oEvent.Reason)
+            {
+                case (AsyncMqttClientDisconnectReason::TCP_DISCONNECTED):
+                    Status.DisConReasonString = F("TCP Disconnected");
+                    break;
+                case (AsyncMqttClientDisconnectReason::MQTT_UNACCEPTABLE_PROTOCOL_VERSION):
+                    Status.DisConReasonString  = F("MQTT unacceptable protocol version");
+                    break;
+                case (AsyncMqttClientDisconnectReason::MQTT_IDENTIFIER_REJECTED):
+                    Status.DisConReasonString  = F("MQTT identifier rejected");
+                    break;
+                case (AsyncMqttClientDisconnectReason::MQTT_SERVER_UNAVAILABLE):
+                    Status.DisConReasonString  = F("MQTT server unavailable");
+                    break;
+                case (AsyncMqttClientDisconnectReason::MQTT_MALFORMED_CREDENTIALS):
+                    Status.DisConReasonString  = F("MQTT malformed credentials");
+                    break;
+                case (AsyncMqttClientDisconnectReason::MQTT_NOT_AUTHORIZED):
+                    Status.DisConReasonString  = F("MQTT not authorized");
+                    break;
+                case (AsyncMqttClientDisconnectReason::ESP8266_NOT_ENOUGH_SPACE):
+                    Status.DisConReasonString  = F("ESP not enough space");
+                    break;
+                default:
+                    Status.DisConReasonString  = F("Unknown");
+                    break;
+            }
+            ApplLogInfoWithParms("MQTT disconnected (%d) - %s",
+                                  (int) oEvent.Reason,
+                                  Status.DisConReasonString.c_str());
+            Appl.MsgBus.sendEvent(this,MSG_MQTT_DISCONNECTED,this,(int) oEvent.Reason);
+        }
+        Appl.MsgBus.sendEvent(this,MSG_APPL_STATUS_CHANGED,nullptr,0);
+    }
 }
 
 /**
@@ -589,6 +607,8 @@ void CMQTTController::onMqttDisconnect(AsyncMqttClientDisconnectReason oReason)
  *
  * The callback assembles fragmented payloads in a temporary buffer and queues a
  * complete MQTTMessage for later dispatch in the main loop.
+ * The callback runs on the network task (ESP32), the queue is lock free for this
+ * single producer. When the queue is full, the message is dropped.
  */
 void CMQTTController::onMqttMessage(char *pszTopic, char *pszPayload, AsyncMqttClientMessageProperties properties, size_t nLen, size_t nIndex, size_t nTotal)
 {
@@ -612,7 +632,7 @@ void CMQTTController::onMqttMessage(char *pszTopic, char *pszPayload, AsyncMqttC
     if(nIndex + nLen == nTotal) {
         DEBUG_INFOS("MQTT status message received \"%s\"",m_pszMessageBuffer);
         MQTTMessage *pMessage = new MQTTMessage( pszTopic, m_pszMessageBuffer, this);
-        m_tMessageQeue.push(pMessage);
+        if(!m_tMessageQeue.push(pMessage)) delete pMessage;   // Queue full, loop is too slow...
         free(m_pszMessageBuffer);
         m_pszMessageBuffer = nullptr;
         m_nMessageBufferSize = 0;
@@ -621,3 +641,22 @@ void CMQTTController::onMqttMessage(char *pszTopic, char *pszPayload, AsyncMqttC
 }
 
 #pragma endregion
+
+#pragma region MQTT Log Writer
+
+/**
+ * @brief Checks if the controller is connected to the broker.
+ * Checked before publishing, as publishDeviceTopic() logs a warning if not connected.
+ */
+bool CMQTTLogWriter::isReady() {
+    return(m_pController && m_pController->connected());
+}
+
+/**
+ * @brief Publishes a batch of log entries to the log topic.
+ */
+void CMQTTLogWriter::sendBatch(JsonNode &oBatch) {
+    m_pController->publishDeviceTopic(m_pszTopic,oBatch);
+}
+
+#pragma endregion
@@ -0,0 +1,347 @@
+#ifndef DEBUG_LSC_APPL
+    #undef DEBUGINFOS
+#endif
+
+#include <MsgRecorder.h>
+#include <JsonNode.h>
+#include <WebSocket.h>
+#include <MQTTController.h>
+#include <Logging.h>
+#include <DevelopmentHelper.h>
+#ifdef NATIVE_RUNTIME
+    #include <stdio.h>
+#else
+    #include <LittleFS.h>
+#endif
+
+#pragma region Implementation of CMsgBusRecorder
+
+/**
+ * @brief Creates a recorder for a message bus.
+ * @param pEventHandler Message bus to record.
+ * @param nMaxBufferSize Buffer size; when reached the buffer is flushed into the file.
+ */
+CMsgBusRecorder::CMsgBusRecorder(CEventHandler *pEventHandler, size_t nMaxBufferSize) {
+    m_pEventHandler  = pEventHandler;
+    m_nMaxBufferSize = nMaxBufferSize;
+    // Library messages with a known payload...
+    setPayloadKind(MSG_LOG_ENTRY,               MSG_PAYLOAD_TEXT);
+    setPayloadKind(MSG_LOG_ENTRY_JSON,          MSG_PAYLOAD_JSONNODE);
+    setPayloadKind(MSG_LOG_RECORD,              MSG_PAYLOAD_LOG_RECORD);
+    setPayloadKind(MSG_WEBSOCKET_SEND_JSONNODE, MSG_PAYLOAD_JSONNODE);
+    setPayloadKind(MSG_WEBSOCKET_DATA_RECEIVED, MSG_PAYLOAD_WEBSOCKET);
+    setPayloadKind(MSG_MQTT_MSG_RECEIVED,       MSG_PAYLOAD_MQTT);
+    setPayloadKind(MSG_MQTT_SEND_JSONNODE,      MSG_PAYLOAD_JSONNODE);
+    setPayloadKind(MSG_MQTT_SEND_TEXTSTATE,     MSG_PAYLOAD_TEXT);
+    setPayloadKind(MSG_MQTT_SEND_JSONSTATE,     MSG_PAYLOAD_JSONNODE);
+}
+
+CMsgBusRecorder::~CMsgBusRecorder() {
+    if(m_bRecording) stop();
+    if(m_pszFileName) free((void *)m_pszFileName);
+}
+
+/**
+ * @brief Defines how the payload of a message is recorded.
+ * @param nMsg Message number.
+ * @param cKind One of MSG_PAYLOAD_xxx.
+ */
+void CMsgBusRecorder::setPayloadKind(int nMsg, char cKind) {
+    for(auto &tEntry : m_tPayloadKinds) {
+        if(tEntry.first == nMsg) { tEntry.second = cKind; return; }
+    }
+    m_tPayloadKinds.push_back(std::make_pair(nMsg,cKind));
+}
+
+/**
+ * @brief Gets the payload kind of a message.
+ * @param nMsg Message number.
+ * @return MSG_PAYLOAD_xxx, MSG_PAYLOAD_NONE if unknown.
+ */
+char CMsgBusRecorder::getPayloadKind(int nMsg) {
+    for(auto &tEntry : m_tPayloadKinds) {
+        if(tEntry.first == nMsg) return(tEntry.second);
+    }
+    return(MSG_PAYLOAD_NONE);
+}
+
+/**
+ * @brief Starts recording.
+ * @param pszFileName Optional file, the records will be appended when the buffer is full or on stop().
+ */
+void CMsgBusRecorder::start(const char *pszFileName) {
+    if(m_pszFileName) free((void *)m_pszFileName);
+    m_pszFileName = pszFileName ? strdup(pszFileName) : nullptr;
+    m_strBuffer   = "";
+    m_strBuffer.reserve(m_nMaxBufferSize);
+    m_ulRecorded  = 0;
+    m_ulDropped   = 0;
+    m_ulStartTime = millis();
+    m_bRecording  = true;
+    if(m_pEventHandler) m_pEventHandler->setEventRecorder(this);
+}
+
+/**
+ * @brief Stops recording and flushes the remaining records into the file.
+ */
+void CMsgBusRecorder::stop() {
+    if(m_pEventHandler) m_pEventHandler->setEventRecorder(nullptr);
+    m_bRecording = false;
+    if(m_pszFileName) flush();
+}
+
+/**
+ * @brief Appends the buffered records to the file and clears the buffer.
+ * @return true if written, false if no file is specified or the file could not be opened.
+ */
+bool CMsgBusRecorder::flush() {
+    bool bResult = false;
+    if(m_pszFileName) {
+        #ifdef NATIVE_RUNTIME
+            FILE *pFile = fopen(m_pszFileName,"a");
+            if(pFile) {
+                fwrite(m_strBuffer.c_str(),1,m_strBuffer.length(),pFile);
+                fclose(pFile);
+                bResult = true;
+            }
+        #else
+            File oFile = LittleFS.open(m_pszFileName,"a");
+            if(oFile) {
+                oFile.write((const uint8_t *)m_strBuffer.c_str(),m_strBuffer.length());
+                oFile.close();
+                bResult = true;
+            }
+        #endif
+        m_strBuffer = "";
+    }
+    return(bResult);
+}
+
+/**
+ * @brief Appends data to the buffer, TAB, CR, LF and backslash are escaped.
+ */
+void CMsgBusRecorder::appendEscaped(const char *pszData) {
+    if(!pszData) return;
+    for(const char *p = pszData; *p; p++) {
+        switch(*p) {
+            case '\t': m_strBuffer += "\\t";  break;
+            case '\n': m_strBuffer += "\\n";  break;
+            case '\r': m_strBuffer += "\\r";  break;
+            case '\\': m_strBuffer += "\\\\"; break;
+            default:   m_strBuffer += *p;
+        }
+    }
+}
+
+/**
+ * @brief Records one event as a text line.
+ * @return Always EVENT_MSG_RESULT_OK, the recorder never influences the processing.
+ */
+int CMsgBusRecorder::receiveEvent(const void *pSender, int nMsg, const void *pMessage, int nClass) {
+    if(!m_bRecording) return(EVENT_MSG_RESULT_OK);
+    if(m_strBuffer.length() >= m_nMaxBufferSize && !flush()) {
+        m_ulDropped++;
+        return(EVENT_MSG_RESULT_OK);
+    }
+    char szHeader[64];
+    const char *pszSender = (pSender && m_pEventHandler) ? m_pEventHandler->getReceiverName(pSender) : nullptr;
+    char cKind = pMessage ? getPayloadKind(nMsg) : MSG_PAYLOAD_NONE;
+    if(cKind == MSG_PAYLOAD_LOG_RECORD) {
+        // The record is valid during this call only - keep the text
+        nMsg  = MSG_LOG_ENTRY;
+        cKind = MSG_PAYLOAD_TEXT;
+        pMessage = ((CLogRecord *)pMessage)->getText();
+    }
+    snprintf(szHeader,sizeof(szHeader),"%lu\t%d\t%d\t",millis() - m_ulStartTime,nMsg,nClass);
+    m_strBuffer += szHeader;
+    appendEscaped(pszSender ? pszSender : "-");
+    m_strBuffer += '\t';
+    m_strBuffer += cKind;
+    switch(cKind) {
+        case MSG_PAYLOAD_TEXT:
+            m_strBuffer += '\t';
+            appendEscaped((const char *)pMessage);
+            break;
+        case MSG_PAYLOAD_JSONNODE:
+            m_strBuffer += '\t';
+            appendEscaped(((JsonNode *)pMessage)->getAsJsonText());
+            break;
+        case MSG_PAYLOAD_WEBSOCKET: {
+                CWebSocketMessage *pWSMessage = (CWebSocketMessage *)pMessage;
+                snprintf(szHeader,sizeof(szHeader),"\t%d\t",pWSMessage->MessageType);
+                m_strBuffer += szHeader;
+                appendEscaped(pWSMessage->pSerializedMessage);
+            }
+            break;
+        case MSG_PAYLOAD_MQTT: {
+                MQTTMessage *pMQTTMessage = (MQTTMessage *)pMessage;
+                m_strBuffer += '\t';
+                appendEscaped(pMQTTMessage->Topic);
+                m_strBuffer += '\t';
+                appendEscaped(pMQTTMessage->Message);
+            }
+            break;
+    }
+    m_strBuffer += '\n';
+    m_ulRecorded++;
+    return(EVENT_MSG_RESULT_OK);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CMsgBusReplayer
+
+/**
+ * @brief Reads one TAB separated field and removes the escaping.
+ * @return Pointer behind the field (at the TAB or the end of the line).
+ */
+static const char * readField(const char *pszData, const char *pszEnd, String &strField) {
+    strField = "";
+    while(pszData < pszEnd && *pszData != '\t') {
+        if(*pszData == '\\' && pszData + 1 < pszEnd) {
+            pszData++;
+            switch(*pszData) {
+                case 't': strField += '\t'; break;
+                case 'n': strField += '\n'; break;
+                case 'r': strField += '\r'; break;
+                default:  strField += *pszData;
+            }
+        } else {
+            strField += *pszData;
+        }
+        pszData++;
+    }
+    return(pszData);
+}
+
+/**
+ * @brief Parses one record line and adds the event.
+ * @return true if the line is a valid record.
+ */
+bool CMsgBusReplayer::parseLine(const char *pszLine, size_t nLength) {
+    const char *pszEnd = pszLine + nLength;
+    String strField;
+    RecordedEvent oEvent;
+    const char *p = readField(pszLine,pszEnd,strField);
+    if(p >= pszEnd) return(false);
+    oEvent.Time = strtoul(strField.c_str(),nullptr,10);
+    p = readField(p + 1,pszEnd,strField);
+    if(p >= pszEnd) return(false);
+    oEvent.Msg = atoi(strField.c_str());
+    p = readField(p + 1,pszEnd,strField);
+    if(p >= pszEnd) return(false);
+    oEvent.Class = atoi(strField.c_str());
+    p = readField(p + 1,pszEnd,oEvent.Sender);
+    if(p >= pszEnd) return(false);
+    p = readField(p + 1,pszEnd,strField);
+    oEvent.Kind = strField.length() > 0 ? strField[0] : MSG_PAYLOAD_NONE;
+    if(p < pszEnd) p = readField(p + 1,pszEnd,oEvent.Data);
+    if(p < pszEnd) p = readField(p + 1,pszEnd,oEvent.Data2);
+    m_tEvents.push_back(oEvent);
+    return(true);
+}
+
+/**
+ * @brief Loads records from a text buffer (one record per line).
+ * @param pszRecords Records as written by CMsgBusRecorder.
+ * @return Number of loaded events.
+ */
+size_t CMsgBusReplayer::load(const char *pszRecords) {
+    size_t nLoaded = 0;
+    while(pszRecords && *pszRecords) {
+        const char *pszLineEnd = strchr(pszRecords,'\n');
+        size_t nLength = pszLineEnd ? (size_t)(pszLineEnd - pszRecords) : strlen(pszRecords);
+        if(nLength > 0 && parseLine(pszRecords,nLength)) nLoaded++;
+        pszRecords = pszLineEnd ? pszLineEnd + 1 : pszRecords + nLength;
+    }
+    return(nLoaded);
+}
+
+/**
+ * @brief Loads records from a file.
+ * @param pszFileName File written by CMsgBusRecorder.
+ * @return Number of loaded events.
+ */
+size_t CMsgBusReplayer::loadFile(const char *pszFileName) {
+    String strRecords;
+    #ifdef NATIVE_RUNTIME
+        FILE *pFile = fopen(pszFileName,"r");
+        if(pFile) {
+            char szBuffer[512];
+            size_t nRead;
+            while((nRead = fread(szBuffer,1,sizeof(szBuffer),pFile)) > 0) strRecords.append(szBuffer,nRead);
+            fclose(pFile);
+        }
+    #else
+        File oFile = LittleFS.open(pszFileName,"r");
+        if(oFile) {
+            strRecords = oFile.readString();
+            oFile.close();
+        }
+    #endif
+    return(load(strRecords.c_str()));
+}
+
+/**
+ * @brief Rebuilds the payload of an event and sends it into the message bus.
+ * @return Result of the message bus.
+ */
+int CMsgBusReplayer::sendRecordedEvent(RecordedEvent &oEvent) {
+    int nResult = EVENT_MSG_RESULT_OK;
+    void *pSender = (void *) m_pEventHandler->getReceiver(oEvent.Sender.c_str());
+    switch(oEvent.Kind) {
+        case MSG_PAYLOAD_TEXT:
+            nResult = m_pEventHandler->sendEvent(pSender,oEvent.Msg,oEvent.Data.c_str(),oEvent.Class);
+            break;
+        case MSG_PAYLOAD_JSONNODE: {
+                JsonNode oNode;
+                oNode.parse(oEvent.Data.c_str());
+                nResult = m_pEventHandler->sendEvent(pSender,oEvent.Msg,&oNode,oEvent.Class);
+            }
+            break;
+        case MSG_PAYLOAD_WEBSOCKET: {
+                CWebSocketMessage oMessage(nullptr,nullptr,oEvent.Data2.length(),atoi(oEvent.Data.c_str()));
+                oMessage.setMessageData((uint8_t *)oEvent.Data2.c_str(),0,oEvent.Data2.length());
+                nResult = m_pEventHandler->sendEvent(pSender,oEvent.Msg,&oMessage,oEvent.Class);
+            }
+            break;
+        case MSG_PAYLOAD_MQTT: {
+                MQTTMessage oMessage(oEvent.Data.c_str(),oEvent.Data2.c_str());
+                nResult = m_pEventHandler->sendEvent(pSender,oEvent.Msg,&oMessage,oEvent.Class);
+            }
+            break;
+        default:
+            nResult = m_pEventHandler->sendEvent(pSender,oEvent.Msg,nullptr,oEvent.Class);
+    }
+    return(nResult);
+}
+
+/**
+ * @brief Sends the loaded events into the message bus.
+ *
+ * With profiling enabled, the timings per receiver are available by
+ * CEventHandler::getProfile() / dumpProfile() after the replay.
+ *
+ * @param fSpeed 1.0 = original timing, > 1.0 faster, 0 = without any wait.
+ * @param bProfile Enable (and reset) the receiver profiling of the message bus.
+ * @return Number of events sent.
+ */
+size_t CMsgBusReplayer::replay(float fSpeed, bool bProfile) {
+    size_t nSent = 0;
+    if(!m_pEventHandler) return(nSent);
+    if(bProfile) m_pEventHandler->enableProfiling();
+    unsigned long ulStartMillis = millis();
+    unsigned long ulStartMicros = micros();
+    for(RecordedEvent &oEvent : m_tEvents) {
+        if(fSpeed > 0) {
+            unsigned long ulDue = (unsigned long)(oEvent.Time / fSpeed);
+            while(millis() - ulStartMillis < ulDue) delay(1);
+        }
+        sendRecordedEvent(oEvent);
+        nSent++;
+    }
+    m_ulReplayMicros = micros() - ulStartMicros;
+    return(nSent);
+}
+
+#pragma endregion
@@ -107,6 +107,8 @@ int CNTPHandler::receiveEvent(const void * pSender, int nMsgType, const void * p
 void CNTPHandler::timeUpdatedByService() {
     DEBUG_FUNC_START();
     this->m_uLastUpdate = millis();
+    // The time of the status jumped - the event is sent from the application loop
+    m_oPostQueue.post(this,MSG_APPL_STATUS_CHANGED,nullptr,0);
     DEBUG_FUNC_END();
 }
 
@@ -123,6 +125,7 @@ void CNTPHandler::setup(void) {
         TrivialCB funcOnEvent;
         // Prepare the bind of the own onWebSocketEvent Handler function
         funcOnEvent = std::bind(&CNTPHandler::timeUpdatedByService,this);
+        Appl.MsgBus.registerPostQueue(&m_oPostQueue);
         settimeofday_cb (funcOnEvent);
         DEBUG_INFOS(" calling => configTime(\"%s\",\"%s\")",Config.TZ.c_str(),Config.NTPServer.c_str());
         configTime(Config.TZ.c_str(), Config.NTPServer.c_str());
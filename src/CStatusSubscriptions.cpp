@@ -0,0 +1,223 @@
+#ifndef DEBUG_LSC_STATUSHANDLER
+    #undef DEBUGINFOS
+#endif
+#include <StatusSubscriptions.h>
+#include <LSCUtils.h>
+#include <DevelopmentHelper.h>
+
+#pragma region Implementation of CStatusSubscriptions
+
+/**
+ * @brief Gets the subscription of a client, nullptr if the client is not subscribed.
+ */
+CStatusSubscriptions::Subscriber * CStatusSubscriptions::getSubscriber(uint32_t ulClientId) {
+    for(Subscriber &oSubscriber : m_tSubscribers) {
+        if(oSubscriber.pGroup && oSubscriber.ClientId == ulClientId) return(&oSubscriber);
+    }
+    return(nullptr);
+}
+
+/**
+ * @brief Removes a subscriber from its group, the group is free when its last client left.
+ */
+void CStatusSubscriptions::leaveGroup(Subscriber &oSubscriber) {
+    if(oSubscriber.pGroup && oSubscriber.pGroup->Clients > 0) oSubscriber.pGroup->Clients--;
+    oSubscriber.pGroup        = nullptr;
+    oSubscriber.NeedsSnapshot = false;
+}
+
+/**
+ * @brief Subscribes a client to status sections.
+ *
+ * A group with the same sections, level and intervals is shared, otherwise a
+ * free group is used. The previous subscription of the client is replaced.
+ * @return false if no subscriber slot or group is free (the client has no subscription then).
+ */
+bool CStatusSubscriptions::subscribe(uint32_t ulClientId, const char *pszSections, int nLevel, unsigned long ulInterval, unsigned long ulRefresh) {
+    DEBUG_FUNC_START_PARMS("%u,%s",ulClientId,pszSections ? pszSections : "");
+    if(!pszSections) pszSections = "";
+    if(ulInterval < STATUS_SUBSCRIPTION_MIN_INTERVAL) ulInterval = STATUS_SUBSCRIPTION_MIN_INTERVAL;
+    if(ulRefresh > 0 && ulRefresh < ulInterval) ulRefresh = ulInterval;
+
+    Subscriber *pSubscriber = getSubscriber(ulClientId);
+    if(pSubscriber) leaveGroup(*pSubscriber);
+    else {
+        for(Subscriber &oSubscriber : m_tSubscribers) {
+            if(!oSubscriber.pGroup) { pSubscriber = &oSubscriber; break; }
+        }
+    }
+    Group *pGroup = nullptr;
+    Group *pFree  = nullptr;
+    for(Group &oGroup : m_tGroups) {
+        if(oGroup.Clients == 0) {
+            if(!pFree) pFree = &oGroup;
+        } else if(oGroup.Level == nLevel && oGroup.Interval == ulInterval && oGroup.Refresh == ulRefresh &&
+                  LSC::stricmp(oGroup.Sections.c_str(),pszSections) == 0) {
+            pGroup = &oGroup;
+            break;
+        }
+    }
+    if(!pGroup && pFree) {
+        pGroup = pFree;
+        pGroup->Sections    = pszSections;
+        pGroup->Level       = nLevel;
+        pGroup->Interval    = ulInterval;
+        pGroup->Refresh     = ulRefresh;
+        pGroup->Dirty       = false;
+        pGroup->HasSnapshot = false;
+        pGroup->Snapshot.clear();
+    }
+    if(!pSubscriber || !pGroup) {
+        m_ulRejected++;
+        DEBUG_FUNC_END();
+        return(false);
+    }
+    pGroup->Clients++;
+    pSubscriber->ClientId      = ulClientId;
+    pSubscriber->pGroup        = pGroup;
+    pSubscriber->NeedsSnapshot = true;
+    DEBUG_FUNC_END();
+    return(true);
+}
+
+bool CStatusSubscriptions::resync(uint32_t ulClientId) {
+    Subscriber *pSubscriber = getSubscriber(ulClientId);
+    if(pSubscriber) pSubscriber->NeedsSnapshot = true;
+    return(pSubscriber != nullptr);
+}
+
+void CStatusSubscriptions::unsubscribe(uint32_t ulClientId) {
+    Subscriber *pSubscriber = getSubscriber(ulClientId);
+    if(pSubscriber) leaveGroup(*pSubscriber);
+}
+
+void CStatusSubscriptions::purge() {
+    for(Subscriber &oSubscriber : m_tSubscribers) {
+        if(oSubscriber.pGroup && !isConnected(oSubscriber.ClientId)) leaveGroup(oSubscriber);
+    }
+}
+
+/**
+ * @brief Marks the groups dirty, that contain the section (or the whole status).
+ * @param pszSection Name of the status section, nullptr = all groups.
+ */
+void CStatusSubscriptions::markDirty(const char *pszSection) {
+    for(Group &oGroup : m_tGroups) {
+        if(oGroup.Clients == 0) continue;
+        if(!pszSection || oGroup.Sections.length() == 0 || LSC::isInList(oGroup.Sections.c_str(),pszSection)) {
+            oGroup.Dirty = true;
+        }
+    }
+}
+
+/**
+ * @brief Writes the status of a group - the whole status, or one object per section.
+ * Sections without a registered status handler are skipped.
+ */
+void CStatusSubscriptions::writeGroupStatus(Group &oGroup, JsonNode &oStatus) {
+    m_ulWrites++;
+    if(oGroup.Sections.length() == 0) {
+        m_pStatus->writeStatusTo(oStatus,oGroup.Level);
+        return;
+    }
+    char szSection[STATUS_SUBSCRIPTION_NAME_SIZE];
+    const char *pszNext = oGroup.Sections.c_str();
+    while(*pszNext) {
+        pszNext = LSC::getListItem(pszNext,szSection,sizeof(szSection));
+        IStatusHandler *pHandler = *szSection ? m_pStatus->getStatusHandler(szSection) : nullptr;
+        if(pHandler && pHandler->hasStatusValues(oGroup.Level)) {
+            pHandler->writeStatusTo(*oStatus.getObject(szSection,true),oGroup.Level);
+        }
+    }
+}
+
+/**
+ * @brief Pushes the status of the groups, that are due.
+ *
+ * A group is due, if it is dirty (or the refresh interval elapsed) and the min.
+ * interval elapsed. The status is written and compared once per group: new
+ * clients get the snapshot, the other clients the merge patch - if anything
+ * changed. A client, that joins a group between two pushes, gets the status of
+ * the last push - the next patch of the group continues from it, the other
+ * clients get nothing before their interval.
+ */
+void CStatusSubscriptions::process() {
+    unsigned long ulNow = millis();
+    for(Group &oGroup : m_tGroups) {
+        if(oGroup.Clients == 0) continue;
+        bool bSnapshot = false;
+        for(Subscriber &oSubscriber : m_tSubscribers) {
+            if(oSubscriber.pGroup == &oGroup && oSubscriber.NeedsSnapshot) { bSnapshot = true; break; }
+        }
+        unsigned long ulAge = ulNow - oGroup.LastPush;
+        bool bDue = (oGroup.Dirty || (oGroup.Refresh > 0 && ulAge >= oGroup.Refresh)) && ulAge >= oGroup.Interval;
+        if(!bSnapshot && !bDue) continue;
+        if(!bDue && oGroup.HasSnapshot) {
+            sendGroupSnapshot(oGroup);
+            continue;
+        }
+
+        JsonNode  oMessage;
+        JsonNode *pStatus = oMessage.createPayloadStructure("update","status");
+        writeGroupStatus(oGroup,*pStatus);
+        JsonNode  oPatchMessage;
+        JsonNode *pPatch  = oPatchMessage.createPayloadStructure("update","statuspatch");
+        bool bChanged = !oGroup.HasSnapshot || pPatch->createMergePatch(oGroup.Snapshot,*pStatus);
+
+        for(Subscriber &oSubscriber : m_tSubscribers) {
+            if(oSubscriber.pGroup != &oGroup) continue;
+            bool bSent = true;
+            if(oSubscriber.NeedsSnapshot) {
+                oSubscriber.NeedsSnapshot = false;
+                bSent = sendStatus(oSubscriber.ClientId,oMessage);
+                m_ulSnapshots++;
+            } else if(bChanged) {
+                bSent = sendStatus(oSubscriber.ClientId,oPatchMessage);
+                m_ulPatches++;
+            }
+            if(!bSent) leaveGroup(oSubscriber);
+        }
+        if(bChanged) oGroup.Snapshot.copyFrom(*pStatus);
+        oGroup.HasSnapshot = true;
+        oGroup.Dirty       = false;
+        oGroup.LastPush    = ulNow;
+    }
+}
+
+/**
+ * @brief Sends the status of the last push of a group to its new clients.
+ */
+void CStatusSubscriptions::sendGroupSnapshot(Group &oGroup) {
+    JsonNode  oMessage;
+    JsonNode *pStatus = oMessage.createPayloadStructure("update","status");
+    pStatus->copyFrom(oGroup.Snapshot);
+    for(Subscriber &oSubscriber : m_tSubscribers) {
+        if(oSubscriber.pGroup != &oGroup || !oSubscriber.NeedsSnapshot) continue;
+        oSubscriber.NeedsSnapshot = false;
+        m_ulSnapshots++;
+        if(!sendStatus(oSubscriber.ClientId,oMessage)) leaveGroup(oSubscriber);
+    }
+}
+
+size_t CStatusSubscriptions::getSubscribers() {
+    size_t nSubscribers = 0;
+    for(Subscriber &oSubscriber : m_tSubscribers) if(oSubscriber.pGroup) nSubscribers++;
+    return(nSubscribers);
+}
+
+size_t CStatusSubscriptions::getGroups() {
+    size_t nGroups = 0;
+    for(Group &oGroup : m_tGroups) if(oGroup.Clients > 0) nGroups++;
+    return(nGroups);
+}
+
+void CStatusSubscriptions::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
+    oStatusNode.setValue("subscribers",(int) getSubscribers());
+    oStatusNode.setValue("groups",     (int) getGroups());
+    oStatusNode.setValue("writes",     m_ulWrites);
+    oStatusNode.setValue("snapshots",  m_ulSnapshots);
+    oStatusNode.setValue("patches",    m_ulPatches);
+    oStatusNode.setValue("rejected",   m_ulRejected);
+}
+
+#pragma endregion
@@ -0,0 +1,264 @@
+#ifndef DEBUG_LSC_WEBSERVER
+    #undef DEBUGINFOS
+#endif
+
+#include <TemplateRenderer.h>
+#include <DevelopmentHelper.h>
+#ifndef NATIVE_RUNTIME
+    #include <LittleFS.h>
+#endif
+
+#pragma region Implementation of CCompiledTemplate
+
+CCompiledTemplate::~CCompiledTemplate() {
+    for(char *pszName : m_tNames) free(pszName);
+}
+
+/**
+ * @brief Adds a static text segment (empty segments are skipped).
+ */
+void CCompiledTemplate::addStatic(size_t nStart, size_t nEnd) {
+    if(nEnd > nStart) {
+        TemplateSegment oSegment;
+        oSegment.Offset = nStart;
+        oSegment.Length = nEnd - nStart;
+        m_tSegments.push_back(oSegment);
+    }
+}
+
+/**
+ * @brief Adds a placeholder segment, Offset/Length describe the placeholder in the source.
+ */
+void CCompiledTemplate::addPlaceholder(size_t nStart, size_t nEnd, const char *pszName) {
+    TemplateSegment oSegment;
+    oSegment.Offset  = nStart;
+    oSegment.Length  = nEnd - nStart;
+    oSegment.NameIdx = m_tNames.size();
+    m_tNames.push_back(strdup(pszName));
+    m_tSegments.push_back(oSegment);
+}
+
+/**
+ * @brief Scans the source blockwise and builds the segment table.
+ *
+ * Rules (compatible to ESPAsyncWebServer templates):
+ * - $name$ is a placeholder, name may contain letters, digits, '_', '.', '-'.
+ * - $$ is written as a single $.
+ * - A $ that does not start a valid placeholder is static text.
+ *
+ * @return true if the whole source has been scanned.
+ */
+bool CCompiledTemplate::compile(ITemplateSource &oSource) {
+    DEBUG_FUNC_START();
+    for(char *pszName : m_tNames) free(pszName);
+    m_tNames.clear();
+    m_tSegments.clear();
+    m_nSourceSize = oSource.size();
+    m_ulSourceVersion = oSource.getVersion();
+
+    uint8_t tBlock[TEMPLATE_SCAN_BLOCK_SIZE];
+    char    szName[TEMPLATE_PARAM_NAME_LENGTH + 1];
+    size_t  nNameLen     = 0;
+    size_t  nTextStart   = 0;       // Start of the current static text
+    size_t  nMarkerPos   = 0;       // Position of the opening placeholder sign
+    bool    bInName      = false;
+    size_t  nPos         = 0;
+    while(nPos < m_nSourceSize) {
+        size_t nRead = oSource.read(nPos,tBlock,sizeof(tBlock));
+        if(nRead == 0) break;
+        for(size_t nIdx = 0; nIdx < nRead; nIdx++, nPos++) {
+            char c = (char) tBlock[nIdx];
+            if(!bInName) {
+                if(c == TEMPLATE_PLACEHOLDER) {
+                    bInName    = true;
+                    nMarkerPos = nPos;
+                    nNameLen   = 0;
+                }
+            } else if(c == TEMPLATE_PLACEHOLDER) {
+                if(nNameLen == 0) {
+                    // Escaped sign - keep the first one as text, skip the second
+                    addStatic(nTextStart,nMarkerPos + 1);
+                } else {
+                    szName[nNameLen] = '\0';
+                    addStatic(nTextStart,nMarkerPos);
+                    addPlaceholder(nMarkerPos,nPos + 1,szName);
+                }
+                nTextStart = nPos + 1;
+                bInName    = false;
+            } else if(nNameLen < TEMPLATE_PARAM_NAME_LENGTH && (isalnum((unsigned char) c) || c == '_' || c == '.' || c == '-')) {
+                szName[nNameLen++] = c;
+            } else {
+                // Not a placeholder, the sign stays static text
+                bInName = false;
+            }
+        }
+    }
+    addStatic(nTextStart,nPos);
+    DEBUG_FUNC_END_PARMS("%d",nPos == m_nSourceSize);
+    return(nPos == m_nSourceSize);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CTemplateRenderState
+
+/**
+ * @brief Writes the next part of the output.
+ *
+ * Static segments are read from the source, placeholder values are resolved
+ * when the segment is reached and released after it is written.
+ *
+ * @param pBuffer Output buffer.
+ * @param nMaxLen Size of the output buffer.
+ * @return Bytes written, 0 when the output is complete (or the source failed).
+ */
+size_t CTemplateRenderState::fill(uint8_t *pBuffer, size_t nMaxLen) {
+    size_t nWritten = 0;
+    if(!m_pTemplate) return(nWritten);
+    const std::vector<TemplateSegment> & tSegments = m_pTemplate->getSegments();
+    while(nWritten < nMaxLen && m_nSegment < tSegments.size()) {
+        const TemplateSegment & oSegment = tSegments[m_nSegment];
+        size_t nSegmentLen = 0;
+        if(oSegment.NameIdx < 0) {
+            nSegmentLen = oSegment.Length;
+            size_t nToRead = std::min(nMaxLen - nWritten,nSegmentLen - m_nSegmentOffset);
+            size_t nRead = m_pSource->read(oSegment.Offset + m_nSegmentOffset,pBuffer + nWritten,nToRead);
+            if(nRead == 0) {
+                // Source changed or failed, stop the output
+                m_nSegment = tSegments.size();
+                break;
+            }
+            nWritten         += nRead;
+            m_nSegmentOffset += nRead;
+        } else {
+            if(!m_bValueResolved) {
+                m_pRenderer->resolve(m_pTemplate->getName(oSegment.NameIdx),m_strValue);
+                m_bValueResolved = true;
+            }
+            nSegmentLen = m_strValue.length();
+            size_t nToCopy = std::min(nMaxLen - nWritten,nSegmentLen - m_nSegmentOffset);
+            memcpy(pBuffer + nWritten,m_strValue.c_str() + m_nSegmentOffset,nToCopy);
+            nWritten         += nToCopy;
+            m_nSegmentOffset += nToCopy;
+        }
+        if(m_nSegmentOffset >= nSegmentLen) {
+            m_nSegment++;
+            m_nSegmentOffset = 0;
+            if(m_bValueResolved) {
+                m_strValue = "";
+                m_bValueResolved = false;
+            }
+        }
+    }
+    return(nWritten);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CTemplateRenderer
+
+/**
+ * @brief Resolves a placeholder by the resolver function or the var table.
+ * @param pszName Placeholder name.
+ * @param strValue Receives the value, empty if the name is unknown.
+ */
+void CTemplateRenderer::resolve(const char *pszName, String &strValue) {
+    strValue = "";
+    if(m_funcResolver && m_funcResolver(pszName,strValue)) return;
+    if(m_pVars) {
+        CVar *pVar = m_pVars->find(pszName);
+        if(pVar && !pVar->isCriticalVar() && pVar->getValue()) strValue = pVar->getValue();
+    }
+}
+
+/**
+ * @brief Gets a compiled template from the cache, or compiles it.
+ *
+ * A cached template is compiled again when the size or the version of the
+ * source changed - an edit may keep the size. The version is set by the writer
+ * of the data, the source is not read for the check.
+ * @return Compiled template, or nullptr if the source could not be scanned.
+ */
+std::shared_ptr<CCompiledTemplate> CTemplateRenderer::getTemplate(const char *pszName, ITemplateSource &oSource) {
+    for(CachedTemplate &oEntry : m_tCache) {
+        if(oEntry.Name == pszName) {
+            if(oEntry.Template->getSourceSize()    == oSource.size() &&
+               oEntry.Template->getSourceVersion() == oSource.getVersion()) return(oEntry.Template);
+            invalidate(pszName);
+            break;
+        }
+    }
+    std::shared_ptr<CCompiledTemplate> pTemplate = std::make_shared<CCompiledTemplate>();
+    if(!pTemplate->compile(oSource)) return(nullptr);
+    CachedTemplate oEntry;
+    oEntry.Name     = pszName;
+    oEntry.Template = pTemplate;
+    m_tCache.push_back(oEntry);
+    return(pTemplate);
+}
+
+/**
+ * @brief Removes a template from the cache.
+ *
+ * Requests that are currently rendering keep their (old) segment table.
+ */
+void CTemplateRenderer::invalidate(const char *pszName) {
+    for(auto it = m_tCache.begin(); it != m_tCache.end(); ++it) {
+        if(it->Name == pszName) { m_tCache.erase(it); break; }
+    }
+}
+
+/**
+ * @brief Starts rendering a template.
+ * @return Render state, or nullptr when the template is not available.
+ */
+std::shared_ptr<CTemplateRenderState> CTemplateRenderer::begin(const char *pszName, std::unique_ptr<ITemplateSource> pSource) {
+    std::shared_ptr<CTemplateRenderState> pState;
+    if(pSource) {
+        std::shared_ptr<CCompiledTemplate> pTemplate = getTemplate(pszName,*pSource);
+        if(pTemplate) pState = std::make_shared<CTemplateRenderState>(this,pTemplate,std::move(pSource));
+    }
+    return(pState);
+}
+
+#ifndef NATIVE_RUNTIME
+/**
+ * @brief Template source reading a LittleFS file.
+ *        The file is read sequentially, seek is only called when needed.
+ */
+class CFileTemplateSource : public ITemplateSource {
+    private:
+        File     m_oFile;
+        size_t   m_nPos = 0;
+        uint32_t m_ulVersion;
+    public:
+        CFileTemplateSource(const char *pszFileName, uint32_t ulVersion) : m_ulVersion(ulVersion) { m_oFile = LittleFS.open(pszFileName,"r"); }
+        ~CFileTemplateSource() { if(m_oFile) m_oFile.close(); }
+        bool   isOpen()         { return((bool) m_oFile); }
+        size_t size() override  { return(m_oFile ? m_oFile.size() : 0); }
+        uint32_t getVersion() override { return(m_ulVersion); }
+        size_t read(size_t nOffset, uint8_t *pBuffer, size_t nLen) override {
+            if(!m_oFile) return(0);
+            if(nOffset != m_nPos) {
+                if(!m_oFile.seek(nOffset)) return(0);
+                m_nPos = nOffset;
+            }
+            size_t nRead = m_oFile.read(pBuffer,nLen);
+            m_nPos += nRead;
+            return(nRead);
+        }
+};
+
+/**
+ * @brief Starts rendering a template file from LittleFS.
+ * @param ulVersion Version of the file, a cached template of another version is compiled again.
+ * @return Render state, or nullptr when the file does not exist.
+ */
+std::shared_ptr<CTemplateRenderState> CTemplateRenderer::beginFile(const char *pszFileName, uint32_t ulVersion) {
+    std::unique_ptr<CFileTemplateSource> pSource(new CFileTemplateSource(pszFileName,ulVersion));
+    if(!pSource->isOpen()) return(nullptr);
+    return(begin(pszFileName,std::move(pSource)));
+}
+#endif
+
+#pragma endregion
@@ -7,6 +7,12 @@
 #include <LSCUtils.h>
 #include <DevelopmentHelper.h>
 
+// Min. size of the text buffer - large enough for any number, so switching
+// between numbers does not reallocate.
+#ifndef LSC_VARS_MIN_VALUE_BUFFER
+    #define LSC_VARS_MIN_VALUE_BUFFER 24
+#endif
+
 #pragma region constructors
 
 /**
@@ -121,6 +127,46 @@ void CVar::setVarName(const char *pszName) {
     if(pszKeyName) free(pszKeyName);
     pszKeyName = strdup(pszName ? pszName : "");
     strlwr(pszKeyName);
+
+    // Lookups by the table use the new name from now on
+    if(m_pTable) m_pTable->renameVar(this);
+}
+
+/**
+ * @brief Copies text into the value buffer.
+ *
+ * The buffer is reused when the text fits, so repeated setValue() calls do not
+ * allocate. Marks the text as valid, other flags are not changed.
+ *
+ * @param pszText Text to store, must not be nullptr.
+ */
+void CVar::storeText(const char *pszText) {
+    size_t nLen = strlen(pszText);
+    if(nLen + 1 > m_nValueBufferSize) {
+        if(pszValue) free((void *) pszValue);
+        m_nValueBufferSize = nLen + 1 < LSC_VARS_MIN_VALUE_BUFFER ? LSC_VARS_MIN_VALUE_BUFFER : nLen + 1;
+        pszValue = (char *) malloc(m_nValueBufferSize);
+    }
+    memcpy(pszValue,pszText,nLen + 1);
+    m_nValid |= VALID_STRING;
+}
+
+/**
+ * @brief Creates the text representation of a typed value, if not done yet.
+ * @return The value as text, nullptr if no value was set.
+ */
+const char * CVar::materializeText() {
+    if(!(m_nValid & VALID_STRING)) {
+        char szValue[LSC_VARS_MIN_VALUE_BUFFER];
+        switch(m_eType) {
+            case VAR_TYPE_INT:   snprintf(szValue,sizeof(szValue), "%d", m_nValue);   break;
+            case VAR_TYPE_ULONG: snprintf(szValue,sizeof(szValue), "%lu", m_ulValue); break;
+            case VAR_TYPE_BOOL:  strcpy(szValue, m_bValue ? "1" : "0");              break;
+            default:             return(nullptr);   // Text var without any value
+        }
+        storeText(szValue);
+    }
+    return(pszValue);
 }
 
 #pragma endregion
@@ -143,8 +189,9 @@ CVar * CVar::setCriticalVar(bool bIsCritical) {
  * @return this for chained calls.
  */
 CVar * CVar::setValue(const char *pszValue){
-    if(this->pszValue)  free((void *) this->pszValue);
-    this->pszValue = strdup(pszValue ? pszValue : "");
+    m_eType  = VAR_TYPE_STRING;
+    m_nValid = 0;
+    storeText(pszValue ? pszValue : "");
     return(this);
 }
 
@@ -161,33 +208,35 @@ CVar * CVar::setValue(const __FlashStringHelper *pszValue){
 #endif
 
 /**
- * @brief Stores an integer value as text.
+ * @brief Stores an integer value, the text is created on demand.
  * @return this for chained calls.
  */
 CVar * CVar::setValue(const int nValue) {
-    char szValue[80];
-    snprintf(szValue,sizeof(szValue), "%d", nValue);
-    setValue(szValue);
+    m_eType  = VAR_TYPE_INT;
+    m_nValue = nValue;
+    m_nValid = VALID_INT;
     return(this);
 }
 
 /**
- * @brief Stores an unsigned long value as text.
+ * @brief Stores an unsigned long value, the text is created on demand.
  * @return this for chained calls.
  */
 CVar * CVar::setValue(const unsigned long ulValue) {
-    char szValue[80];
-    snprintf(szValue,sizeof(szValue), "%lu", ulValue);
-    setValue(szValue);
+    m_eType   = VAR_TYPE_ULONG;
+    m_ulValue = ulValue;
+    m_nValid  = VALID_ULONG;
     return(this);
 }
 
 /**
- * @brief Stores a boolean value as "1" or "0".
+ * @brief Stores a boolean value, the text is "1" or "0".
  * @return this for chained calls.
  */
 CVar * CVar::setValue(const bool bValue) {
-    setValue(bValue ? "1" : "0");
+    m_eType  = VAR_TYPE_BOOL;
+    m_bValue = bValue;
+    m_nValid = VALID_BOOL;
     return(this);
 }
 
@@ -230,34 +279,66 @@ const char * CVar::getName() {
 
 /**
  * @brief Gets the stored value as text.
- * @return Value pointer.
+ *
+ * Numbers and booleans are converted on the first call. The pointer stays
+ * valid until the next setValue().
+ *
+ * @return Value pointer, nullptr if no value was set.
  */
 const char * CVar::getValue() {
-    return(pszValue);
+    return(materializeText());
 }
 
 /**
  * @brief Converts the stored value to int.
- * @return atoi() result.
+ *
+ * Text values are parsed once, the result is cached until the next setValue().
+ * @return The int value, or the atoi() result of the text.
  */
 const int CVar::getIntValue() {
-    return(atoi(pszValue));
+    if(!(m_nValid & VALID_INT)) {
+        if(m_eType == VAR_TYPE_BOOL) {
+            m_nValue = m_bValue ? 1 : 0;
+        } else {
+            const char *pszText = materializeText();
+            m_nValue = atoi(pszText ? pszText : "");
+        }
+        m_nValid |= VALID_INT;
+    }
+    return(m_nValue);
 }
 
 /**
  * @brief Converts the stored value to bool.
- * @return Result of LSC::isTrueValue() in non-explicit mode.
+ *
+ * Text values are parsed once, the result is cached until the next setValue().
+ * @return The bool value, or the result of LSC::isTrueValue() in non-explicit mode.
  */
 const bool CVar::getBoolValue() {
-    return(LSC::isTrueValue(pszValue,false));
+    if(!(m_nValid & VALID_BOOL)) {
+        m_bValue = LSC::isTrueValue(materializeText(),false);
+        m_nValid |= VALID_BOOL;
+    }
+    return(m_bValue);
 }
 
 /**
  * @brief Converts the stored value to unsigned long.
- * @return strtoul() result using base 10.
+ *
+ * Text values are parsed once, the result is cached until the next setValue().
+ * @return The unsigned long value, or the strtoul() result (base 10) of the text.
  */
 const unsigned long CVar::getUnsignedLongValue() {
-    return(strtoul(pszValue, nullptr, 10));
+    if(!(m_nValid & VALID_ULONG)) {
+        if(m_eType == VAR_TYPE_BOOL) {
+            m_ulValue = m_bValue ? 1 : 0;
+        } else {
+            const char *pszText = materializeText();
+            m_ulValue = strtoul(pszText ? pszText : "", nullptr, 10);
+        }
+        m_nValid |= VALID_ULONG;
+    }
+    return(m_ulValue);
 }
 
 #pragma endregion
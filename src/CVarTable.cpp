@@ -71,8 +71,9 @@
  * @brief constructor 
  * @param isCaseSensitive Set var names case sensitive == true  
  */
- CVarTable::CVarTable(bool isCaseSensitive) {
+ CVarTable::CVarTable(bool isCaseSensitive) : m_tVarIndex(isCaseSensitive,nullptr) {
     this->isCaseSensitive = isCaseSensitive;
+    m_tVarIndex.enableHashIndex();
 }
 
 CVarTable::~CVarTable() {
@@ -118,23 +119,14 @@ bool CVarTable::hasCriticalVars() {
 
 /**
  * @brief find the var inside the table
+ * @details Uses the hash index over the var names, no key preparation needed.
  * @param pszName Name of the var to be searched
  * @return nullptr or the var object
  */
 CVar * CVarTable::find(const char * pszName) {
     CVar *pResult = nullptr;
     if(pszName) {
-        char szKeyName[80];
-        strncpy(szKeyName,pszName,sizeof(szKeyName));
-        if(!isCaseSensitive) strlwr(szKeyName);
-        for(CVar * pVar : this->tVarEntries) {
-            if(pVar) {
-                if(strcmp(pVar->getKeyName(isCaseSensitive),szKeyName) == 0) {
-                    pResult = pVar;
-                    break;
-                }
-            }
-        }
+        pResult = m_tVarIndex.get(pszName);
     }
     return(pResult);
 }
@@ -159,11 +151,24 @@ CVar * CVarTable::getOrCreateVarEntry(const char *pszName) {
     // Insert a new entriy if it does not exist
     if(pVar == nullptr) {
         pVar = new CVar(pszName);
+        pVar->m_pTable = this;
         tVarEntries.push_back(pVar);
+        // The key is copied - CVar::setVarName() frees the name buffer of the var.
+        m_tVarIndex.set(pVar->getName(),pVar,false);
     }
     return(pVar);
 }
 
+/**
+ * @brief Re-keys the index entry of a renamed var.
+ * @details Called by CVar::setVarName(), so find() matches the current name of the var.
+ * @param pVar Var of this table with the new name already set.
+ */
+void CVarTable::renameVar(CVar *pVar) {
+    CNamedValueEntry<CVar *> *pEntry = m_tVarIndex.findFirstByValue(pVar);
+    if(pEntry) m_tVarIndex.setKey(pEntry,pVar->getName());
+}
+
 #pragma endregion
 
 
@@ -10,6 +10,8 @@
 
 
 #define WEBSERVER_STATUS_DOC_SIZE  2048
+#define WEBSERVER_FILES_GET_URL    "/files/get/"
+#define WEBSERVER_FILES_GET_PREFIX "/files/get/*"
 
 const char * WEBSERVER_AUTOREDIRECT_MODE       = "autoRedirectMode";
 
@@ -55,17 +57,27 @@ void CWebServer::writeConfigTo(JsonNode &oCfgNode,bool bHideCritical) {
 void CWebServer::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
     oStatusNode["started"] = Status.Started;
     oStatusNode[WEBSERVER_AUTOREDIRECT_MODE] = Status.AutoRedirectMode;
+    Files.writeStatusTo(*oStatusNode.getObject("files",true),nLevel);
+    Uploads.writeStatusTo(*oStatusNode.getObject("uploads",true),nLevel);
 }   
 
 
 
 /**
  * @brief Receives application events that affect web server state.
+ * MSG_APPL_LOOP hashes the next file of the file index without an ETag, or
+ * checks the next file for changes - the requests never read a file for its ETag.
  * @return EVENT_MSG_RESULT_OK after processing.
  */
 int CWebServer::receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nClass) {
     int nResult = EVENT_MSG_RESULT_OK;
     switch(nMsg) {
+        case MSG_APPL_LOOP:
+            if(!Files.hashNext() && m_oFileCheckDelay.isDone()) {
+                Files.checkNext();
+                m_oFileCheckDelay.restart();
+            }
+            break;
         case MSG_CAPTIVE_PORTAL_STARTED: {
             Status.AutoRedirectMode = true;
             DEBUG_INFO("WEB: Autoredirect mode enabled");
@@ -97,20 +109,117 @@ void CWebServer::setNewAuthHeader(AsyncWebServerRequest *pRequest, AsyncWebServe
 #pragma region Registered File Access Routes
 
 /**
- * @brief Handles an authenticated file delivery request.
+ * @brief Delivers a file of LittleFS, streamed from the file.
  *
- * The current implementation returns a success response with a refreshed auth
- * token. Actual file streaming and content-type handling are still TODO.
+ * All files are served by one prefix route (/files/get/<path>). The path is
+ * looked up in the sorted file index (binary search), LittleFS is only asked
+ * for files that are not indexed yet (written by other modules).
+ * - The content type is taken from the extension of the file.
+ * - If the client accepts gzip and "<file>.gz" exists, the compressed file is
+ *   sent with Content-Encoding gzip (also if only the .gz file exists).
+ * - The ETag is the content hash of the file index, hashed by the application
+ *   loop (a file is sent without an ETag until it is hashed). A request with a
+ *   matching If-None-Match is answered with 304, without reading the file.
+ * - If a .gz variant exists, the response varies by Accept-Encoding (Vary).
+ * - A single byte range (Range) is answered with 206, only that part is read.
+ * The file is read in the chunks requested by the server, so the memory does
+ * not depend on the size of the file.
  */
 void CWebServer::deliverFile(AsyncWebServerRequest *pRequest) { 
         DEBUG_FUNC_START_PARMS("%s",pRequest->url().c_str());
         if (!Config.authenticate(pRequest,"file",true)) {
             return pRequest->requestAuthentication();
 		}
-        AsyncWebServerResponse *response = pRequest->beginResponse(200, "text/plain", "Success");
-        setNewAuthHeader(pRequest,response);
-        // TODO: implement proper file delivery with correct content-type
-		pRequest->send(response);
+        String strPath = pRequest->url();
+        if(strPath.startsWith(WEBSERVER_FILES_GET_URL)) strPath = strPath.substring(strlen(WEBSERVER_FILES_GET_URL) - 1);
+        if(strPath.indexOf("..") >= 0) {
+            pRequest->send(400, "text/plain", "Invalid path");
+            DEBUG_FUNC_END();
+            return;
+        }
+        CFS oFS;
+        // Resolved by the file index, LittleFS is only asked for files written by others
+        auto isFile = [this,&oFS](const String &strFile) -> bool {
+            if(Files.find(strFile.c_str())) return(true);
+            if(!oFS.getBaseFS().exists(strFile)) return(false);
+            // A directory is not delivered (and not indexed)
+            File oFile = oFS.getBaseFS().open(strFile,"r");
+            if(!oFile || oFile.isDirectory()) return(false);
+            Files.set(strFile.c_str(),oFile.size());
+            return(true);
+        };
+        String strDeliverPath = strPath;
+        bool bGzip = false;
+        String strGzipPath = strPath + ".gz";
+        bool bAcceptsGzip = pRequest->hasHeader("Accept-Encoding") && 
+                            pRequest->getHeader("Accept-Encoding")->value().indexOf("gzip") >= 0;
+        bool bPlainFile = isFile(strPath);
+        // The .gz variant of an indexed file is only looked up in the index
+        bool bGzipFile  = bPlainFile ? Files.find(strGzipPath.c_str()) != nullptr : isFile(strGzipPath);
+        if(bGzipFile && (bAcceptsGzip || !bPlainFile)) {
+            strDeliverPath = strGzipPath;
+            bGzip = true;
+        } else if(!bPlainFile) {
+            pRequest->send(404, "text/plain", "Not found");
+            DEBUG_FUNC_END();
+            return;
+        }
+        char szETag[FILE_INDEX_ETAG_SIZE] = "";
+        Files.getETag(strDeliverPath.c_str(),szETag,sizeof(szETag));
+        if(szETag[0] && pRequest->hasHeader("If-None-Match") &&
+           CFileIndex::matchesETag(pRequest->getHeader("If-None-Match")->value().c_str(),szETag)) {
+            AsyncWebServerResponse *pResponse = pRequest->beginResponse(304);
+            pResponse->addHeader("ETag",szETag);
+            if(bGzipFile) pResponse->addHeader("Vary","Accept-Encoding");
+            pResponse->addHeader("Cache-Control",WEBSERVER_FILE_CACHE_CONTROL);
+            setNewAuthHeader(pRequest,pResponse);
+            pRequest->send(pResponse);
+            DEBUG_FUNC_END();
+            return;
+        }
+        std::shared_ptr<File> pFile = std::make_shared<File>(oFS.getBaseFS().open(strDeliverPath,"r"));
+        if(!*pFile) {
+            Files.remove(strDeliverPath.c_str());
+            pRequest->send(404, "text/plain", "Not found");
+            DEBUG_FUNC_END();
+            return;
+        }
+        size_t nSize  = pFile->size();
+        // A file changed by others is sent without the old ETag, the loop hashes it again
+        if(szETag[0] && !Files.verify(strDeliverPath.c_str(),nSize,(uint32_t) pFile->getLastWrite())) szETag[0] = '\0';
+        size_t nStart = 0;
+        size_t nEnd   = nSize > 0 ? nSize - 1 : 0;
+        int nRange = FILE_RANGE_NONE;
+        // A range of the compressed file is of no use for the client
+        if(!bGzip && pRequest->hasHeader("Range")) {
+            nRange = CFileIndex::parseRange(pRequest->getHeader("Range")->value().c_str(),nSize,nStart,nEnd);
+        }
+        if(nRange == FILE_RANGE_INVALID) {
+            AsyncWebServerResponse *pResponse = pRequest->beginResponse(416);
+            pResponse->addHeader("Content-Range","bytes */" + String((unsigned long) nSize));
+            pRequest->send(pResponse);
+            DEBUG_FUNC_END();
+            return;
+        }
+        size_t nLen = nSize > 0 ? nEnd - nStart + 1 : 0;
+        AsyncWebServerResponse *pResponse = pRequest->beginResponse(CFileIndex::getContentType(strPath.c_str()),nLen,
+            [pFile,nStart,nLen](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t {
+                if(nIndex >= nLen) return(0);
+                if(pFile->position() != nStart + nIndex) pFile->seek(nStart + nIndex);
+                return(pFile->read(pBuffer,std::min(nMaxLen,nLen - nIndex)));
+            });
+        if(nRange == FILE_RANGE_OK) {
+            pResponse->setCode(206);
+            pResponse->addHeader("Content-Range","bytes " + String((unsigned long) nStart) + "-" + 
+                                                   String((unsigned long) nEnd) + "/" + String((unsigned long) nSize));
+        }
+        if(!bGzip) pResponse->addHeader("Accept-Ranges","bytes");
+        if(bGzip) pResponse->addHeader("Content-Encoding","gzip");
+        if(bGzipFile) pResponse->addHeader("Vary","Accept-Encoding");
+        if(szETag[0]) pResponse->addHeader("ETag",szETag);
+        pResponse->addHeader("Cache-Control",WEBSERVER_FILE_CACHE_CONTROL);
+        setNewAuthHeader(pRequest,pResponse);
+		pRequest->send(pResponse);
         DEBUG_FUNC_END();
     }
 /**
@@ -118,7 +227,7 @@ void CWebServer::deliverFile(AsyncWebServerRequest *pRequest) {
  *
  * Routes:
  * - /files/list lists LittleFS files.
- * - /files/get/<filename> delivers a registered file route.
+ * - /files/get/<filename> delivers a file, one prefix route for all files (see deliverFile()).
  * - /files/upload serves and handles a simple upload form.
  */
 void CWebServer::registerFileAccess() {
@@ -134,31 +243,46 @@ void CWebServer::registerFileAccess() {
                                         "</form>");
     });
 
-	 // Upload-Handler
+	 // Upload-Handler - each file of a request has its own upload (see CFileUploads)
     on("/files/upload", HTTP_POST, 
         [this](AsyncWebServerRequest *pRequest) {
             if (!Config.authenticate(pRequest,"files/upload",true)) {
+                Uploads.release(pRequest);
                 return pRequest->requestAuthentication();
 		    }
-            pRequest->send(200);
+            // The files have been finished with their last chunk
+            bool bSuccess = Uploads.release(pRequest);
+            pRequest->send(bSuccess ? 200 : 500);
         }, 
         [this](AsyncWebServerRequest *pRequest, const String& strFilename, size_t index, uint8_t *pData, size_t nLen, bool bFinal) {
-            static File oFile;
-            CFS oFS;
-            if (index == 0) {  // Open new file
+            String strPath = "/" + strFilename;
+            if (index == 0) {  // Start a new upload
+                // The data is only written for an authenticated request, it is logged by the request handler
+                if(!Config.authenticate(pRequest,"files/upload",false)) return;
+                if(strFilename.length() == 0 || strFilename.indexOf("..") >= 0 || strFilename.indexOf('/') >= 0) {
+                    ApplLogWarnWithParms(F("Upload rejected: %s"), strFilename.c_str());
+                    return;
+                }
                 ApplLogInfoWithParms(F("Saving File: %s"), strFilename.c_str());
-                oFile =  oFS.getBaseFS().open("/" + strFilename, "w");
-            }
-            if (oFile) {
-                oFile.write(pData, nLen);
+                // An aborted request removes its temporary files and its result
+                pRequest->onDisconnect([this,pRequest]() { Uploads.release(pRequest); });
+                if(!Uploads.begin(pRequest,strPath.c_str())) return;
             }
-            if (bFinal) {  // Close file
-                oFile.close();
-                // TODO: check if duplicate route registration runs into problems...
-                std::function<void(	AsyncWebServerRequest *)> funcDeliverFile;
-                funcDeliverFile = std::bind(&CWebServer::deliverFile,this,std::placeholders::_1);
-                on("/files/get/" + strFilename, HTTP_GET, funcDeliverFile);
-                ApplLogInfoWithParms(F("Upload finished: %s"), strFilename.c_str());
+            CFileUpload *pUpload = Uploads.get(pRequest,strPath.c_str());
+            if (!pUpload) return;
+            pUpload->write(pData, nLen);
+            if (bFinal) {
+                // The file is replaced now, the next file of the request gets the slot
+                if(pUpload->finish()) {
+                    Templates.invalidate(pUpload->getPath());
+                    // The hash has been computed while the data was written
+                    Files.set(pUpload->getPath(),pUpload->getSize(),pUpload->getHash());
+                    ApplLogInfoWithParms(F("Upload finished: %s"), pUpload->getPath());
+                } else {
+                    ApplLogWarnWithParms(F("Upload failed: %s"), pUpload->getPath());
+                }
+                Uploads.done(pRequest,pUpload);
+                m_oPostQueue.post(this,MSG_APPL_STATUS_CHANGED,nullptr,0);
             }
         }
     );
@@ -173,20 +297,67 @@ void CWebServer::registerFileAccess() {
         pRequest->send(200, "application/json", strFileList);
     });
 
-    // Register file download routes...
-    CFS oFS;
-    Dir oDirEntry = oFS.getBaseFS().openDir("/");
-    
+    // Index of the files (routing and ETag), the content is hashed on the first delivery
+    Files.scan("/");
+    // Finished uploads change the status (files, uploads) - sent from the application loop
+    Appl.MsgBus.registerPostQueue(&m_oPostQueue);
 
-	// Prepare the bind of the own onWebSocketEvent Handler function
-	std::function<void(	AsyncWebServerRequest *)> funcDeliverFile;
-    funcDeliverFile = std::bind(&CWebServer::deliverFile,this,std::placeholders::_1);
-    
-    while (oDirEntry.next()) {    
-        if(oDirEntry.isFile()) {
-            on("/files/get/" + oDirEntry.fileName(), HTTP_GET, funcDeliverFile);
-        } 
+    // One prefix route for all files - the path is resolved by deliverFile()
+    on(WEBSERVER_FILES_GET_PREFIX, HTTP_GET, std::bind(&CWebServer::deliverFile,this,std::placeholders::_1));
+}
+
+/**
+ * @brief Registers an authenticated route, that streams the log files.
+ *
+ * The log is sent as chunked response from the oldest to the newest entry, read
+ * in small parts from the files. The optional parameter "bytes" limits the
+ * response to the last n bytes of the log (i.E. /files/log?bytes=4096).
+ *
+ * @param pWriter File log writer, the log files are read from.
+ * @param pszUrl Url of the route.
+ */
+void CWebServer::registerLogAccess(CFileLogWriter *pWriter, const char *pszUrl) {
+    on(pszUrl, HTTP_GET, [this,pWriter](AsyncWebServerRequest *pRequest) {
+        if (!Config.authenticate(pRequest,"files/log",true)) {
+            return pRequest->requestAuthentication();
+		}
+        size_t nMaxBytes = 0;
+        if(pRequest->hasParam("bytes")) nMaxBytes = pRequest->getParam("bytes")->value().toInt();
+        std::shared_ptr<CFileLogReader> pReader = std::make_shared<CFileLogReader>(pWriter,nMaxBytes);
+        AsyncWebServerResponse *pResponse = pRequest->beginChunkedResponse("text/plain",
+            [pReader](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t {
+                return(pReader->read(pBuffer,nMaxLen));
+            });
+        pRequest->send(pResponse);
+    });
+}
+
+/**
+ * @brief Sends a template file as chunked response.
+ *
+ * The compiled segment table of the file is cached by Templates, static text is
+ * streamed from the file and only the placeholder values are held in RAM.
+ * Placeholders are resolved by Appl.Config, if no other var table has been set.
+ *
+ * @param pRequest Request to answer.
+ * @param pszFileName Template file on LittleFS.
+ * @param pszContentType Content type of the response.
+ */
+void CWebServer::sendTemplate(AsyncWebServerRequest *pRequest, const char *pszFileName, const char *pszContentType) {
+    DEBUG_FUNC_START_PARMS("%s",pszFileName);
+    if(!Templates.getVarTable()) Templates.setVarTable(&Appl.Config);
+    // The index changes the version, when the file is uploaded or changed by others
+    std::shared_ptr<CTemplateRenderState> pState = Templates.beginFile(pszFileName,Files.getVersion(pszFileName));
+    if(!pState) {
+        pRequest->send(404, "text/plain", "Not found");
+    } else {
+        AsyncWebServerResponse *pResponse = pRequest->beginChunkedResponse(pszContentType,
+            [pState](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t {
+                return(pState->fill(pBuffer,nMaxLen));
+            });
+        pRequest->send(pResponse);
     }
+    DEBUG_FUNC_END();
 }
 
 #pragma endregion
@@ -26,7 +26,7 @@
  * @param strSocketName URL/path of the WebSocket endpoint.
  * @param bRegisterOnMsgBus Reserved flag for message bus registration.
  */	
-CWebSocket::CWebSocket(const char* strSocketName, bool bRegisterOnMsgBus) : AsyncWebSocket(strSocketName){
+CWebSocket::CWebSocket(const char* strSocketName, bool bRegisterOnMsgBus) : AsyncWebSocket(strSocketName), StatusPush(this), Streams(this) {
 	DEBUG_FUNC_START_PARMS("%s,%d",NULL_POINTER_STRING(strSocketName),bRegisterOnMsgBus);
 	std::function<void(	AsyncWebSocket *, 
 						AsyncWebSocketClient *, 
@@ -46,6 +46,15 @@ CWebSocket::CWebSocket(const char* strSocketName, bool bRegisterOnMsgBus) : Asyn
 
 	// Register the onEventCallback to the socket
 	onEvent(funcOnEvent);
+	// Remember the handshakes, that request the binary subprotocol (the client id is known at connect)
+	handleHandshake([this](AsyncWebServerRequest *pRequest) -> bool {
+		const AsyncWebHeader *pProtocol = pRequest->getHeader("Sec-WebSocket-Protocol");
+		if(pProtocol && CWebSocketProtocols::isRequested(pProtocol->value().c_str())) {
+			Protocols.offer(CWebSocketProtocols::getPeerKey(pRequest->client()->remoteIP().toString().c_str(),pRequest->client()->remotePort()));
+		}
+		return(true);
+	});
+	registerBuiltInCommands();
 
 	// Now listen on the message bus for incomming commands....
 	// if(bRegisterOnMsgBus) Appl.MsgBus.registerEventReceiver(this,"WebSocket");
@@ -56,8 +65,10 @@ CWebSocket::CWebSocket(const char* strSocketName, bool bRegisterOnMsgBus) : Asyn
 /**
  * @brief Handles application events relevant to WebSocket processing.
  *
- * MSG_APPL_LOOP drains queued WebSocket messages and periodically cleans up
- * inactive clients. JSON send events are serialized to all clients.
+ * MSG_APPL_LOOP drains queued WebSocket messages, pushes the subscribed status,
+ * sends the next fragments of the streams and periodically cleans up inactive clients. MSG_APPL_STATUS_CHANGED marks the
+ * status section (pMessage) of the subscriptions dirty. JSON send events are
+ * serialized to all clients.
  *
  * @return EVENT_MSG_RESULT_OK after processing.
  */
@@ -66,12 +77,22 @@ int CWebSocket::receiveEvent(const void * pSender, int nMsgId, const void * pMes
 		case MSG_APPL_LOOP: 
 			// Dispatch the messages and cleanup inactive clients
 			dispatchMessageQueue(); 
+			if(m_bClientGone.exchange(false)) {
+				StatusPush.purge();
+				if(m_pRestore && !client(m_ulRestoreClient)) abortRestore();
+			}
+			StatusPush.process();
+			Streams.process();
 			if(m_oClientCleanupDelay.isDone()) {
 				cleanupClients();
 				m_oClientCleanupDelay.restart();
 			}
 			break;
 
+		case MSG_APPL_STATUS_CHANGED:
+			StatusPush.markDirty((const char *) pMessage);
+			break;
+
 		case MSG_WEBSOCKET_SEND_JSONNODE :
         case MSG_WIFI_SCAN_RESULT : if(pMessage != nullptr) {
 										JsonNode *pDoc = ( JsonNode *) pMessage;
@@ -83,12 +104,29 @@ int CWebSocket::receiveEvent(const void * pSender, int nMsgId, const void * pMes
     return(EVENT_MSG_RESULT_OK);
 }
 
+/**
+ * @brief Writes the dropped messages, the quotas of the clients and the counters of the message pools.
+ */
+void CWebSocket::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
+	oStatusNode.setValue("dropped",m_tMsgQueue.getDropped());
+	Quotas.writeStatusTo(*oStatusNode.getObject("clients",true));
+	AuthSessions.writeStatusTo(*oStatusNode.getObject("auth",true));
+	StatusPush.writeStatusTo(*oStatusNode.getObject("subscriptions",true),nLevel);
+	Streams.writeStatusTo(*oStatusNode.getObject("streams",true),nLevel);
+	Protocols.writeStatusTo(*oStatusNode.getObject("binary",true));
+	CWebSocketMessage::getBufferPool().writeStatusTo(*oStatusNode.getObject("buffers",true),nLevel);
+	CWebSocketMessage::getObjectPool().writeStatusTo(*oStatusNode.getObject("messages",true),nLevel);
+}
+
 /** 
  * @brief Captures WebSocket events and queues complete messages.
  *
  * Incoming data is copied into CWebSocketMessage objects. Single-frame messages
  * are queued immediately; multi-frame messages are assembled in the client's
  * temporary object and queued only after the final frame.
+ * A message, that is larger than WS_MAX_MESSAGE_SIZE or exceeds the quota of the
+ * client, is rejected at its first frame - nothing is allocated for it, the
+ * client gets an error message.
  *
  * @param pSocket Socket receiving the event.
  * @param pClient Client that sent the data.
@@ -110,10 +148,23 @@ void CWebSocket::onWebSocketEvent(AsyncWebSocket *pSocket, AsyncWebSocketClient
 	else if (eType == WS_EVT_CONNECT) {
 		// Client connected
 		DEBUG_INFOS("WS: - WS_EVT_CONNECT : (Client ID: %u IP: %s)", pClient->id(), pClient->remoteIP().toString().c_str()	);
+		Protocols.connect(pClient->id(),CWebSocketProtocols::getPeerKey(pClient->remoteIP().toString().c_str(),pClient->remotePort()));
+		// The quota slot is also the entry of the client for broadcasts of the application loop
+		Quotas.connect(pClient->id());
 	}
 	else if (eType == WS_EVT_DISCONNECT) {
-		// Client connected
+		// Client disconnected - drop a partly received message and free the quota slot
 		DEBUG_INFOS("WS: - WS_EVT_DISCONNECT : (Client ID: %u IP: %s)", pClient->id(), pClient->remoteIP().toString().c_str()	);
+		CWebSocketMessage * pMsgObj = (CWebSocketMessage *) pClient->_tempObject;
+		if(pMsgObj) {
+			Quotas.release(pMsgObj->ClientId,pMsgObj->MessageSize);
+			delete(pMsgObj);
+			pClient->_tempObject = nullptr;
+		}
+		Quotas.disconnect(pClient->id());
+		AuthSessions.invalidate(pClient->id());
+		Protocols.disconnect(pClient->id());
+		m_bClientGone = true;
 	}
 	else if (eType == WS_EVT_DATA) {
 	
@@ -138,17 +189,32 @@ void CWebSocket::onWebSocketEvent(AsyncWebSocket *pSocket, AsyncWebSocketClient
 			} else {
 				DEBUG_INFO("WS: - EVT_DATA : (Single Message Frame - OTHER)");
 			}
-			CWebSocketMessage * pMsgObj = new CWebSocketMessage(pSocket,pClient,nFrameDataLen,pFrameInfo->opcode);
-			pMsgObj->setMessageData(pData,0,nFrameDataLen);
-			addMessageToQueue(pMsgObj);
+			if(Quotas.reserve(pClient->id(),nFrameDataLen)) {
+				CWebSocketMessage * pMsgObj = new CWebSocketMessage(pSocket,pClient,nFrameDataLen,pFrameInfo->opcode);
+				pMsgObj->setMessageData(pData,0,nFrameDataLen);
+				addMessageToQueue(pMsgObj);
+			} else {
+				sendRejectedMessage(pClient,nFrameDataLen);
+			}
 		}
 		// Handle segmented messages
 		else {
 			DEBUG_INFO("============ New Multi Socket Message received =============");
-			// First frame ? allocate the WebSocket message object in temp of client
+			// First frame ? allocate the WebSocket message object in temp of client,
+			// if the message fits into the quota of the client (the rest of a rejected message is ignored)
 			if(pFrameInfo->index == 0) {
-				DEBUG_INFO("WS:   - allocating new message object..");
-				pClient->_tempObject = new CWebSocketMessage(pSocket,pClient,pFrameInfo->len,pFrameInfo->opcode);
+				CWebSocketMessage * pIncomplete = (CWebSocketMessage *) pClient->_tempObject;
+				if(pIncomplete) {
+					Quotas.release(pIncomplete->ClientId,pIncomplete->MessageSize,true);
+					delete(pIncomplete);
+				}
+				pClient->_tempObject = nullptr;
+				if(Quotas.reserve(pClient->id(),pFrameInfo->len)) {
+					DEBUG_INFO("WS:   - allocating new message object..");
+					pClient->_tempObject = new CWebSocketMessage(pSocket,pClient,pFrameInfo->len,pFrameInfo->opcode);
+				} else {
+					sendRejectedMessage(pClient,pFrameInfo->len);
+				}
 			}
 			// Move date into WebSocket message object...
 			CWebSocketMessage * pMsgObj = (CWebSocketMessage *) pClient->_tempObject;
@@ -162,6 +228,7 @@ void CWebSocket::onWebSocketEvent(AsyncWebSocket *pSocket, AsyncWebSocketClient
 			if(pFrameInfo->final && (pFrameInfo->index + nFrameDataLen) == pFrameInfo->len) {
 				DEBUG_INFO("WS:   - pushing message to queue...");
 				addMessageToQueue(pMsgObj);
+				pClient->_tempObject = nullptr;
 			}
 		}
 	}
@@ -173,12 +240,20 @@ void CWebSocket::onWebSocketEvent(AsyncWebSocket *pSocket, AsyncWebSocketClient
  * @brief Adds a completed message to the internal processing queue.
  *
  * Messages are processed outside the socket callback to keep the callback short.
+ * The socket callback may run on another task (ESP32), so the queue is a lock free
+ * single producer queue. If it is full, the message is dropped and counted (also
+ * for the client).
  */
 void CWebSocket::addMessageToQueue(CWebSocketMessage *pMsgObj)
 {
 	DEBUG_FUNC_START();
 	if(pMsgObj) {
-		m_tMsgQueue.push(pMsgObj);
+		if(!m_tMsgQueue.push(pMsgObj)) {
+			Quotas.release(pMsgObj->ClientId,pMsgObj->MessageSize,true);
+			delete(pMsgObj);
+			DEBUG_FUNC_END();
+			return;
+		}
 		#ifdef DEBUGINFOS
 			if(pMsgObj->MessageType == WS_TEXT) {
 				DEBUG_INFO("WS: message pushed to queue :");
@@ -190,6 +265,23 @@ void CWebSocket::addMessageToQueue(CWebSocketMessage *pMsgObj)
 	DEBUG_FUNC_END();
 }
 
+/**
+ * @brief Tells the client, that its message was not accepted.
+ *
+ * Called by the socket callback, so the text is built without a document. The
+ * code is 413 for a message larger than WS_MAX_MESSAGE_SIZE, 429 if the queue
+ * quota of the client is used up.
+ */
+void CWebSocket::sendRejectedMessage(AsyncWebSocketClient *pClient, size_t nSize) {
+	char szMessage[160];
+	bool bTooLarge = nSize > WS_MAX_MESSAGE_SIZE;
+	snprintf(szMessage,sizeof(szMessage),
+		"{\"command\":\"error\",\"data\":\"%s\",\"payload\":{\"msg\":\"%s\",\"command\":\"\",\"size\":%u,\"max\":%u}}",
+		bTooLarge ? "413" : "429",bTooLarge ? "message too large" : "too many messages",
+		(unsigned int) nSize,(unsigned int) WS_MAX_MESSAGE_SIZE);
+	pClient->text(szMessage);
+}
+
 #pragma endregion
 
 #pragma region Message Sending
@@ -205,17 +297,31 @@ void CWebSocket::addMessageToQueue(CWebSocketMessage *pMsgObj)
 	DEBUG_FUNC_START();
 	// If no socket is in place, use your own socket...
 	if(!pSocket) pSocket = this;
+	if(pClient && Protocols.isBinary(pClient->id())) {
+		sendBinaryDocMessage(oDoc,pClient);
+		DEBUG_FUNC_END();
+		return;
+	}
+	if(!pClient && pSocket == this && Protocols.getBinaryClients() > 0) {
+		// Binary clients connected - they get the CBOR message, the others the text
+		uint32_t tClientIds[WS_QUOTA_CLIENTS];
+		sendJsonDocMessage(oDoc,tClientIds,Quotas.getClientIds(tClientIds,WS_QUOTA_CLIENTS));
+		DEBUG_FUNC_END();
+		return;
+	}
 
-    // Serialize the message to be sent...
-	String strData = oDoc.getAsJsonText();
-	size_t nSize = strData.length();
+	// Measure the document, then serialize it once, directly into the message buffer.
+	// The buffer is shared by all recipients (textAll).
+	size_t nSize = oDoc.measureJson();
 	DEBUG_INFOS("WS: - allocating buffer(%u bytes)",nSize);
 	AsyncWebSocketMessageBuffer* pBuffer = pSocket->makeBuffer(nSize);
-	#ifdef DEBUG_LSC_WEBSOCKET
-		assert(pBuffer);
-	#endif
-	strncpy((char *) pBuffer->get(),strData.c_str(),nSize);
-	// serializeJson(oDoc,pBuffer->get(),nSize);
+	if(!pBuffer || !pBuffer->get()) {
+		ApplLogErrorWithParms("WS: no memory for message (%u bytes)",nSize);
+		if(pBuffer) delete(pBuffer);
+		DEBUG_FUNC_END();
+		return;
+	}
+	oDoc.serializeTo((char *) pBuffer->get(),nSize);
 	#ifdef DEBUGINFOS
 		DEBUG_INFOS("WS: - sending message (%u bytes)\n",nSize);
 		for(size_t nIdx = 0; nIdx < nSize; nIdx++) Serial.printf("%c",pBuffer->get()[nIdx]);
@@ -226,6 +332,106 @@ void CWebSocket::addMessageToQueue(CWebSocketMessage *pMsgObj)
 	DEBUG_FUNC_END();
 }
 
+/**
+ * @brief Sends a JsonNode to a list of clients of this socket.
+ *
+ * The clients are sent to by their id - the application loop does not walk the
+ * client list of the socket, that is changed by the socket callback. The text is
+ * serialized once for all text clients, clients of the binary subprotocol get
+ * the CBOR message. Clients, that are gone, are skipped by the socket.
+ * @param oDoc Document to send.
+ * @param pClientIds Ids of the clients (i.E. CWebSocketQuotas::getClientIds()).
+ * @param nClients Number of ids.
+ */
+void ICACHE_FLASH_ATTR CWebSocket::sendJsonDocMessage(JsonNode &oDoc, const uint32_t *pClientIds, size_t nClients) {
+	DEBUG_FUNC_START_PARMS("%u",(unsigned int) nClients);
+	char * pszText = nullptr;
+	size_t nSize   = 0;
+	for(size_t nIdx = 0; nIdx < nClients; nIdx++) {
+		if(Protocols.isBinary(pClientIds[nIdx])) {
+			sendBinaryDocMessage(oDoc,pClientIds[nIdx]);
+			continue;
+		}
+		if(!pszText) {
+			nSize   = oDoc.measureJson();
+			pszText = (char *) malloc(nSize + 1);
+			if(!pszText) {
+				ApplLogErrorWithParms("WS: no memory for message (%u bytes)",nSize);
+				break;
+			}
+			oDoc.serializeTo(pszText,nSize + 1);
+		}
+		text(pClientIds[nIdx],pszText,nSize);
+	}
+	if(pszText) free(pszText);
+	DEBUG_FUNC_END();
+}
+
+/**
+ * @brief Sends a JsonNode as binary message (header and CBOR) to a client of the binary subprotocol.
+ *
+ * The command id of the header is the id of the "command" of the document. A
+ * response to the message being dispatched gets its sequence and the response flag.
+ * @param oDoc Document to encode.
+ * @param pClient Client to send the message to.
+ */
+void ICACHE_FLASH_ATTR CWebSocket::sendBinaryDocMessage(JsonNode &oDoc, AsyncWebSocketClient *pClient) {
+	if(pClient) sendBinaryDocMessage(oDoc,pClient->id());
+}
+
+/**
+ * @brief Sends a JsonNode as binary message to a client of the binary subprotocol, by the id of the client.
+ * @param ulClientId Id of the client, a client that is gone is skipped by the socket.
+ */
+void ICACHE_FLASH_ATTR CWebSocket::sendBinaryDocMessage(JsonNode &oDoc, uint32_t ulClientId) {
+	DEBUG_FUNC_START();
+	WebSocketBinaryHeader oHeader;
+	const char *pszCommand = oDoc.getValue("command","");
+	oHeader.CommandId = WebSocketBinaryHeader::getCommandId(pszCommand);
+	if(strcmp(pszCommand,"error") == 0) oHeader.Flags |= WS_BINARY_FLAG_ERROR;
+	if(m_pDispatching && m_pDispatching->ClientId == ulClientId) {
+		oHeader.Flags   |= WS_BINARY_FLAG_RESPONSE;
+		oHeader.Sequence = m_pDispatching->Sequence;
+	}
+	size_t nSize = oDoc.measureCbor();
+	AsyncWebSocketMessageBuffer* pBuffer = makeBuffer(WS_BINARY_HEADER_SIZE + nSize);
+	if(!pBuffer || !pBuffer->get()) {
+		ApplLogErrorWithParms("WS: no memory for message (%u bytes)",WS_BINARY_HEADER_SIZE + nSize);
+		if(pBuffer) delete(pBuffer);
+		DEBUG_FUNC_END();
+		return;
+	}
+	oHeader.write(pBuffer->get());
+	oDoc.serializeCborTo(pBuffer->get() + WS_BINARY_HEADER_SIZE,nSize);
+	binary(ulClientId,pBuffer);
+	DEBUG_FUNC_END();
+}
+
+/**
+ * @brief Streams a JSON document to a client.
+ *
+ * The document is serialized in fragments, while the send queue of the client
+ * has room - the text of the whole document is never built. If no stream is
+ * free, the document is sent as one message - also to clients of the binary
+ * subprotocol, the CBOR encoding is much smaller than the text.
+ * @param pDoc Document to send, it is deleted when the stream is done.
+ * @param pClient Client to send the document to.
+ */
+void ICACHE_FLASH_ATTR CWebSocket::streamJsonDocMessage(JsonNode *pDoc, AsyncWebSocketClient *pClient) {
+	DEBUG_FUNC_START();
+	if(pDoc && pClient) {
+		if(Streams.getActive() < WS_STREAM_MAX && !Protocols.isBinary(pClient->id())) {
+			Streams.startJson(pClient->id(),pDoc);
+		} else {
+			sendJsonDocMessage(*pDoc,nullptr,pClient);
+			delete pDoc;
+		}
+	} else if(pDoc) {
+		delete pDoc;
+	}
+	DEBUG_FUNC_END();
+}
+
 /** 
  * @brief Sends an access-denied payload to a specific client.
  *
@@ -249,6 +455,16 @@ void ICACHE_FLASH_ATTR CWebSocket::sendAccessDeniedMessage(JsonNode &oRequestDoc
 	}
 }
 
+void ICACHE_FLASH_ATTR CWebSocket::sendErrorMessage(AsyncWebSocketClient *pClient, const char *pszCode, const char *pszMsg, const char *pszCommand) {
+	if(pClient) {
+		JsonNode oDoc;
+		JsonNode * pPayload = oDoc.createPayloadStructure("error",pszCode);
+		pPayload->setValue("msg",pszMsg);
+		pPayload->setValue("command",pszCommand ? pszCommand : "");
+		sendJsonDocMessage(oDoc,nullptr,pClient);
+	}
+}
+
 #pragma endregion
 
 #pragma region Authentication
@@ -258,29 +474,33 @@ void ICACHE_FLASH_ATTR CWebSocket::sendAccessDeniedMessage(JsonNode &oRequestDoc
  * @return Stored command list.
  */
 String CWebSocket::setNeedsAuth(const String &strCommands) {
-	m_strNeedsAuth = strCommands;
-	return m_strNeedsAuth;
+	m_oCommands.setNeedsAuth(strCommands);
+	return m_oCommands.getNeedsAuth();
 };
 
 /**
  * @brief Gets the comma-delimited command list that requires auth.
  */
 String CWebSocket::getNeedsAuth() {
-	return m_strNeedsAuth;
+	return m_oCommands.getNeedsAuth();
 };
 
 
 /**
- * @brief Checks whether a command is listed as requiring authentication.
- * @param strCommand Lowercase command name.
- * @return true when the command appears in m_strNeedsAuth.
+ * @brief Checks whether a command requires authentication.
+ * Registered commands carry the flag, other commands are matched by whole name
+ * against the list (so "restart" does not match "restartlater").
+ * @param strCommand Command name (case insensitive).
+ * @return true when the command requires authentication.
  */
 bool inline CWebSocket::needsAuth(String &strCommand) {
-	return(m_strNeedsAuth.indexOf(strCommand) > -1);
+	return(m_oCommands.needsAuth(strCommand.c_str()));
 }
 
 /**
  * @brief Validates the token in a request against the client IP address.
+ * A validated token is cached in the session of the client, later commands
+ * with the same token are checked against the session only.
  * @param oJsonRequest Request document containing a "token" value.
  * @param pClient Requesting client.
  * @return true when token structure, IP and application key are valid.
@@ -289,14 +509,19 @@ bool CWebSocket::checkAuth(JsonNode &oJsonRequest, AsyncWebSocketClient *pClient
 	DEBUG_FUNC_START();
 	DEBUG_JSON_OBJ(oJsonRequest);
 	bool isAuthenticated = false;
-	String strAuthToken = oJsonRequest.getValue("token");
-	DEBUG_INFOS("Auth Token : %s",strAuthToken.c_str());
-	DEBUG_INFOS(" - Length check %d && Client Check (%d)",strAuthToken.length() > 10, pClient ? 1 : 0);
-	if(strAuthToken.length() > 10 && pClient) {
+	const char *pszAuthToken = oJsonRequest.getValue("token","");
+	DEBUG_INFOS("Auth Token : %s",pszAuthToken);
+	DEBUG_INFOS(" - Length check %d && Client Check (%d)",strlen(pszAuthToken) > 10, pClient ? 1 : 0);
+	if(pClient) {
 		String strClientRemoteIP = pClient->remoteIP().toString();
-		CAccessToken oToken(strAuthToken.c_str());
-		
-		isAuthenticated = oToken.isAuthValid(strClientRemoteIP.c_str(),APPL_SECURITY_TOKEN_KEY);
+		// A known session of this client saves the decoding and decryption of the token
+		isAuthenticated = AuthSessions.authenticate(pClient->id(),pszAuthToken,strClientRemoteIP.c_str(),TOKEN_TIME_ALIVE,
+			[](const char *pszToken, const char *pszIPAddress, unsigned long &ulTimeStamp) {
+				CAccessToken oToken(pszToken);
+				bool bValid = oToken.isAuthValid(pszIPAddress,APPL_SECURITY_TOKEN_KEY);
+				ulTimeStamp = oToken.getTimeStamp();
+				return(bValid);
+			});
 	}
 	DEBUG_FUNC_END_PARMS("%d",isAuthenticated);
 	return(isAuthenticated);
@@ -308,27 +533,82 @@ bool CWebSocket::checkAuth(JsonNode &oJsonRequest, AsyncWebSocketClient *pClient
 
      
 /**
- * @brief Processes and deletes all queued WebSocket messages.
+ * @brief Processes and deletes queued WebSocket messages.
  *
  * Call this from the main loop or via MSG_APPL_LOOP to keep socket callbacks
- * lightweight and avoid unbounded queue growth.
+ * lightweight. At least one message is processed, then messages are processed
+ * until the dispatch budget is used - the rest waits for the next loop iteration.
+ * The quota of a processed message is given back to its client.
  */
 void CWebSocket::dispatchMessageQueue()
 {
-	while(!m_tMsgQueue.empty()) {
-		CWebSocketMessage * pMessageToProcess = m_tMsgQueue.front();
-		dispatchMessage(pMessageToProcess);
+	CWebSocketMessage * pMessageToProcess;
+	unsigned long ulStart = micros();
+	while(m_tMsgQueue.pop(pMessageToProcess)) {
+		// The client may be gone, since the message was queued - it is found again by its id
+		pMessageToProcess->pClient = client(pMessageToProcess->ClientId);
+		if(pMessageToProcess->pClient) dispatchMessage(pMessageToProcess);
+		Quotas.release(pMessageToProcess->ClientId,pMessageToProcess->MessageSize,pMessageToProcess->pClient == nullptr);
 		delete(pMessageToProcess);
-		m_tMsgQueue.pop();
+		if(micros() - ulStart >= m_ulDispatchBudget) break;
 	}
+	Status.DroppedMessages = m_tMsgQueue.getDropped();
+}
+
+/// @brief Ids of the built-in commands
+enum WebSocketBuiltInCommand {
+	WS_CMD_GETSYSSTATUS = 1,
+	WS_CMD_GETSTATUS,
+	WS_CMD_GETCONFIG,
+	WS_CMD_SAVECONFIG,
+	WS_CMD_RESTART,
+	WS_CMD_SCANWIFI,
+	WS_CMD_SCANRF433,
+	WS_CMD_GETBACKUP,
+	WS_CMD_RESTOREBACKUP,
+	WS_CMD_FACTORYRESET,
+	WS_CMD_SUBSCRIBE,
+	WS_CMD_RESYNC,
+	WS_CMD_UNSUBSCRIBE,
+	WS_CMD_GETLOG
+};
+
+/**
+ * @brief Registers the built-in commands.
+ * Called by the constructor - application commands registered later replace them.
+ */
+void CWebSocket::registerBuiltInCommands() {
+	registerCommand("getsysstatus", this,WS_CMD_GETSYSSTATUS);
+	registerCommand("getstatus",    this,WS_CMD_GETSTATUS);
+	registerCommand("getconfig",    this,WS_CMD_GETCONFIG);
+	registerCommand("saveconfig",   this,WS_CMD_SAVECONFIG);
+	registerCommand("restart",      this,WS_CMD_RESTART);
+	registerCommand("scanwifi",     this,WS_CMD_SCANWIFI);
+	registerCommand("scanrf433",    this,WS_CMD_SCANRF433);
+	registerCommand("getbackup",    this,WS_CMD_GETBACKUP);
+	registerCommand("restorebackup",this,WS_CMD_RESTOREBACKUP);
+	registerCommand("factoryreset", this,WS_CMD_FACTORYRESET);
+	registerCommand("subscribe",    this,WS_CMD_SUBSCRIBE);
+	registerCommand("resync",       this,WS_CMD_RESYNC);
+	registerCommand("unsubscribe",  this,WS_CMD_UNSUBSCRIBE);
+}
+
+/**
+ * @brief Registers the command, that streams the log files to a client.
+ * The log is read in fragments, while the client can receive them.
+ */
+void CWebSocket::registerLogAccess(CFileLogWriter *pWriter, const char *pszCommand) {
+	m_pLogWriter = pWriter;
+	registerCommand(pszCommand,this,WS_CMD_GETLOG,true);
 }
 
 /**
- * @brief Dispatches a parsed JSON request.
+ * @brief Dispatches a parsed JSON request to the handler of its command.
  *
- * Built-in commands cover status/config retrieval, authenticated config changes,
- * restart, scans, backup/restore and factory reset. Unknown commands return
- * false so application code can handle them through MSG_WEBSOCKET_DATA_RECEIVED.
+ * The command is looked up in the registry (hashed, case insensitive). If it
+ * needs authentication and the request has no valid token, access-denied is
+ * sent. Unknown commands return false so application code can handle them
+ * through MSG_WEBSOCKET_DATA_RECEIVED.
  *
  * @param oJsonRequest Parsed request document.
  * @param pMessage Original WebSocket message metadata.
@@ -337,46 +617,59 @@ void CWebSocket::dispatchMessageQueue()
 bool CWebSocket::dispatchJsonMessage(JsonNode & oJsonRequest, CWebSocketMessage *pMessage) {
 	DEBUG_FUNC_START();
 	bool bResult = true;
-	CFS oFS;
-	// Json Document is ready...
 	// Web Browser sends some commands, check which command is given
-	String strCommand = oJsonRequest.getValue("command");
-	strCommand.toLowerCase();
-	DEBUG_INFOS("WS: dispatching command \"%s\"",strCommand.c_str());
-	bool isAuthNeeded = needsAuth(strCommand);
+	const char *pszCommand = oJsonRequest.getValue("command","");
+	DEBUG_INFOS("WS: dispatching command \"%s\"",pszCommand);
+	WebSocketCommand *pCommand = m_oCommands.find(pszCommand);
+	bool isAuthNeeded = pCommand ? pCommand->NeedsAuth : m_oCommands.needsAuth(pszCommand);
 	bool isAuthenticated = isAuthNeeded ? checkAuth(oJsonRequest,pMessage->pClient) : false;
 	DEBUG_INFOS("WS: Auth needed : %d, Authenticated : %d",isAuthNeeded,isAuthenticated);
 	if(isAuthNeeded && !isAuthenticated) {
-		ApplLogErrorWithParms("WS: Access denied - %s",strCommand.c_str());
+		ApplLogErrorWithParms("WS: Access denied - %s",pszCommand);
 		sendAccessDeniedMessage(oJsonRequest,pMessage->pClient);
+	} else if(pCommand && pCommand->pHandler) {
+		bResult = pCommand->pHandler->onWebSocketCommand(pCommand->CommandId,oJsonRequest,pMessage,isAuthenticated);
 	} else {
-		// bool isAuthenticated = bNeedsAuth ? isAuthTokenValid(strAuthToken, strClientRemoteIP) : true;
-		if (strCommand.equalsIgnoreCase(F("getsysstatus")))
-		{
+		bResult = false;
+	}
+	DEBUG_FUNC_END_PARMS("%d",bResult);
+	return bResult;
+}
+
+/**
+ * @brief Processes the built-in commands.
+ *
+ * Built-in commands cover status/config retrieval, authenticated config changes,
+ * restart, scans, backup/restore and factory reset.
+ * @return true when the command was handled.
+ */
+bool CWebSocket::onWebSocketCommand(int nCommandId, JsonNode &oJsonRequest, CWebSocketMessage *pMessage, bool isAuthenticated) {
+	DEBUG_FUNC_START_PARMS("%d",nCommandId);
+	bool bResult = true;
+	CFS oFS;
+	switch(nCommandId) {
+		case WS_CMD_GETSYSSTATUS: {
 			JsonNode * pPayloadNode = oJsonRequest.createPayloadStructure("update","sysstatus");
 			Appl.writeSystemStatusTo(*pPayloadNode);
 			sendJsonDocMessage(oJsonRequest,pMessage->pSocket,pMessage->pClient);
+			break;
 		}
-		if (strCommand.equalsIgnoreCase(F("getstatus")))
-		{
+		case WS_CMD_GETSTATUS: {
 			const char * pszStatus = Appl.getStatusAsText();
 			oJsonRequest.createPayloadStructure("update","status",pszStatus);
-			// JsonObject oStatusNode = LSC::createPayloadStructure(F("update"),F("status"),oJsonRequest);
-			// Appl.writeStatusTo(oStatusNode);
 			sendJsonDocMessage(oJsonRequest,pMessage->pSocket,pMessage->pClient);
+			break;
 		}
-		else if (strCommand.equalsIgnoreCase(F("getconfig")))
-		{
+		case WS_CMD_GETCONFIG: {
 			// NO authentication needed, cause critical informations are hidde (!)
 			JsonNode * pCfgNode = oJsonRequest.createPayloadStructure("update","config");
 			Appl.writeConfigTo(*pCfgNode,true);
 			sendJsonDocMessage(oJsonRequest,pMessage->pSocket,pMessage->pClient);
+			break;
 		}
-		else if (strCommand.equalsIgnoreCase(F("saveconfig")))
-		{
+		case WS_CMD_SAVECONFIG: {
 			JsonNode * pPayload = oJsonRequest.getObject("payload");
 			if(isAuthenticated && pPayload) {
-				
 				// First load the config - to enable validation of settings (!)
 				// then write the new config file to the file system
 				// ... and ask for a reboot !
@@ -387,68 +680,187 @@ bool CWebSocket::dispatchJsonMessage(JsonNode & oJsonRequest, CWebSocketMessage
 				DEBUG_INFO(" - requesting reboot...");
 				Appl.MsgBus.sendEvent(this,MSG_REBOOT_REQUEST,nullptr,0);
 			}
-		} 
-		else if (strCommand.equalsIgnoreCase(F("restart")))
-		{
+			break;
+		}
+		case WS_CMD_RESTART:
 			if(isAuthenticated) {
 				Appl.MsgBus.sendEvent(this,MSG_REBOOT_REQUEST,nullptr,0);
 			}
-		}
-		else if (strCommand.equalsIgnoreCase(F("scanwifi")))
-		{
+			break;
+		case WS_CMD_SCANWIFI:
 			DEBUG_INFO("WS: sending scan wifi request...");
 			Appl.MsgBus.sendEvent(this,MSG_WIFI_SCAN,pMessage->pClient,0);
-		}
-		else if (strCommand.equalsIgnoreCase(F("scanrf433")))
-		{
+			break;
+		case WS_CMD_SCANRF433:
 			Appl.MsgBus.sendEvent(this,MSG_RF433_SCAN,pMessage->pClient,0);
-		}
-		else if (strCommand.equalsIgnoreCase(F("getbackup"))) 
-		{
+			break;
+		case WS_CMD_GETBACKUP:
 			if(isAuthenticated) { // To ensure - only if authenticated...
-				// DynamicJsonDocument oResponseDoc(DEFAULT_RESPONSE_DOC_SIZE);
-				JsonNode * pPayload = oJsonRequest.createPayloadStructure("backup","config");
-				if(oFS.fileExists(JSON_APPL_CONFIG_FILE)) {
-					// loadJsonContentFromFile(JSON_CONFIG_DEFAULT_NAME,oXChangeDoc);
-					String strData;
-					oFS.loadFileToString(JSON_APPL_CONFIG_FILE,strData);
-					pPayload->parse(strData.c_str());
+				// The backup is read only: the saved config (config file + journal) with the current settings,
+				// also the ones not saved yet. The document is streamed in fragments (or sent at once).
+				JsonNode * pBackup  = new JsonNode();
+				JsonNode * pPayload = pBackup->createPayloadStructure("backup","config");
+				if(oFS.loadJsonContentFromFile(JSON_APPL_CONFIG_FILE,*pPayload)) {
+					Appl.ConfigJournal.replayFile(*pPayload);
 				} else {
 					ApplLogWarnWithParms(F("WS: Config file %s not found, using current config"),JSON_APPL_CONFIG_FILE);
-				} 
+				}
 				Appl.writeConfigTo(*pPayload,false);
-				sendJsonDocMessage(oJsonRequest,pMessage->pSocket,pMessage->pClient);
-			} 
-		}
-		else if (strCommand.equalsIgnoreCase(F("restorebackup"))) 
-		{
+				streamJsonDocMessage(pBackup,pMessage->pClient);
+			}
+			break;
+		case WS_CMD_RESTOREBACKUP:
 			if(isAuthenticated) { // To ensure - only if authenticated...
 				JsonNode * pCfgData = oJsonRequest.getObject("payload");
-				ApplLogInfo("WS: Restoring config from backup...");
-				DEBUG_JSON_OBJ((*pCfgData));
-				oFS.saveJsonContentToFile(JSON_APPL_CONFIG_FILE,*pCfgData);
-				Appl.MsgBus.sendEvent(this,MSG_REBOOT_REQUEST,nullptr,0);
+				if(pCfgData && pCfgData->exists("part")) {
+					// A backup larger than a message is sent in parts
+					restoreBackupPart(*pCfgData,pMessage);
+				} else if(pCfgData) {
+					ApplLogInfo("WS: Restoring config from backup...");
+					DEBUG_JSON_OBJ((*pCfgData));
+					oFS.saveJsonContentToFile(JSON_APPL_CONFIG_FILE,*pCfgData);
+					Appl.ConfigJournal.clear();
+					Appl.MsgBus.sendEvent(this,MSG_REBOOT_REQUEST,nullptr,0);
+				}
 			}
-		}
-		else if (strCommand.equalsIgnoreCase(F("factoryreset")))
-		{
+			break;
+		case WS_CMD_FACTORYRESET:
 			if(isAuthenticated) { 
 				ApplLogInfo("WS: Restoring factory settings...");
 				oFS.deleteFile("/config.json");
+				Appl.ConfigJournal.clear();
 				Appl.MsgBus.sendEvent(this,MSG_REBOOT_REQUEST,nullptr,0);
 			}
+			break;
+		case WS_CMD_SUBSCRIBE: {
+			// The snapshot is sent by the next loop, shared with the clients of the same subscription
+			JsonNode * pPayload = oJsonRequest.getObject("payload");
+			const char *pszSections  = pPayload ? pPayload->getValue("sections","") : "";
+			int nLevel               = pPayload ? pPayload->getValueAsInt("level",STATUS_LEVEL_INFO) : STATUS_LEVEL_INFO;
+			unsigned long ulInterval = pPayload ? pPayload->getValueAsUnsignedLong("interval",STATUS_SUBSCRIPTION_INTERVAL) : STATUS_SUBSCRIPTION_INTERVAL;
+			unsigned long ulRefresh  = pPayload ? pPayload->getValueAsUnsignedLong("refresh",0) : 0;
+			if(!StatusPush.subscribe(pMessage->ClientId,pszSections,nLevel,ulInterval,ulRefresh)) {
+				ApplLogWarnWithParms("WS: no subscription slot for client %u",pMessage->ClientId);
+			}
+			break;
 		}
-		else bResult = false;
+		case WS_CMD_RESYNC:
+			if(!StatusPush.resync(pMessage->ClientId)) StatusPush.subscribe(pMessage->ClientId,nullptr);
+			break;
+		case WS_CMD_UNSUBSCRIBE:
+			StatusPush.unsubscribe(pMessage->ClientId);
+			break;
+		case WS_CMD_GETLOG:
+			if(isAuthenticated && m_pLogWriter) {
+				JsonNode * pPayload = oJsonRequest.getObject("payload");
+				size_t nMaxBytes = pPayload ? pPayload->getValueAsUnsignedLong("bytes",0) : 0;
+				std::shared_ptr<CFileLogReader> pReader = std::make_shared<CFileLogReader>(m_pLogWriter,nMaxBytes);
+				uint32_t ulStreamId = Streams.start(pMessage->ClientId,
+					[pReader](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t {
+						return(pReader->read(pBuffer,nMaxLen));
+					},"log","file");
+				if(ulStreamId == 0) ApplLogWarnWithParms("WS: no stream free for client %u",pMessage->ClientId);
+			}
+			break;
+		default:
+			bResult = false;
+			break;
 	}
 	DEBUG_FUNC_END_PARMS("%d",bResult);
 	return bResult;
 }
 
+/**
+ * @brief Writes a part of a backup, that is restored in several messages.
+ *
+ * The client sends the text of the config file in parts of any size below
+ * WS_MAX_MESSAGE_SIZE: { "part":"<text>", "offset":<bytes sent before>, "final":1 }.
+ * Each part is confirmed by { "command":"backup", "data":"part", "payload":{ "offset":<bytes> } },
+ * the client sends the next part then. The parts are written to a temporary
+ * file (CFileUpload), the config file is only replaced by the final part.
+ * A part with offset 0 starts a new restore - a running restore of another
+ * client is aborted.
+ * @return false if the part was rejected (the client gets an error message).
+ */
+bool CWebSocket::restoreBackupPart(JsonNode &oPart, CWebSocketMessage *pMessage) {
+	DEBUG_FUNC_START();
+	size_t nOffset = oPart.getValueAsUnsignedLong("offset",0);
+	if(nOffset == 0) {
+		abortRestore();
+		m_pRestore = new CFileUpload();
+		m_ulRestoreClient = pMessage->ClientId;
+		if(!m_pRestore->begin(JSON_APPL_CONFIG_FILE)) abortRestore();
+		else ApplLogInfo("WS: Restoring config from backup (parts)...");
+	}
+	// Parts must continue the restore of this client, without gap
+	if(!m_pRestore || m_ulRestoreClient != pMessage->ClientId || m_pRestore->getSize() != nOffset) {
+		ApplLogWarnWithParms("WS: backup part at %u of client %u rejected",(unsigned int) nOffset,pMessage->ClientId);
+		sendErrorMessage(pMessage->pClient,"409","backup part does not continue the restore","restorebackup");
+		DEBUG_FUNC_END_PARMS("%d",false);
+		return(false);
+	}
+	const char *pszPart = oPart.getValue("part","");
+	bool bResult = m_pRestore->write((const uint8_t *) pszPart,strlen(pszPart));
+	if(bResult && oPart.getValueAsInt("final",0) != 0) {
+		// The temporary file must be a config (as checked by the backup page), before it replaces the config file
+		if(!isValidBackup(m_pRestore->getTempPath())) {
+			abortRestore();
+			ApplLogError("WS: Restoring config from backup failed - no valid config");
+			sendErrorMessage(pMessage->pClient,"400","backup is no valid config","restorebackup");
+			DEBUG_FUNC_END_PARMS("%d",false);
+			return(false);
+		}
+		bResult = m_pRestore->finish();
+		delete m_pRestore;
+		m_pRestore = nullptr;
+		m_ulRestoreClient = 0;
+		if(bResult) {
+			Appl.ConfigJournal.clear();
+			Appl.MsgBus.sendEvent(this,MSG_REBOOT_REQUEST,nullptr,0);
+		}
+	} else if(bResult) {
+		// The client sends the next part, when this part is confirmed (its messages are limited by the quota)
+		JsonNode oConfirm;
+		JsonNode * pPayload = oConfirm.createPayloadStructure("backup","part");
+		pPayload->setValue("offset",(unsigned long) m_pRestore->getSize());
+		sendJsonDocMessage(oConfirm,nullptr,pMessage->pClient);
+	}
+	if(!bResult) {
+		abortRestore();
+		ApplLogError("WS: Restoring config from backup failed");
+		sendErrorMessage(pMessage->pClient,"500","backup could not be written","restorebackup");
+	}
+	DEBUG_FUNC_END_PARMS("%d",bResult);
+	return(bResult);
+}
+
+/**
+ * @brief Checks a backup file before it is restored.
+ * The backup must be a JSON config with the WiFi settings (wifi.ap_mode), as
+ * checked by the backup page - otherwise the device would not be reachable
+ * after the reboot.
+ */
+bool CWebSocket::isValidBackup(const char *pszFileName) {
+	CFS oFS;
+	JsonNode oBackup;
+	if(!oFS.loadJsonContentFromFile(pszFileName,oBackup)) return(false);
+	JsonNode * pWiFi = oBackup.getObject("wifi");
+	return(pWiFi && pWiFi->exists("ap_mode"));
+}
+
+void CWebSocket::abortRestore() {
+	if(m_pRestore) delete m_pRestore;
+	m_pRestore = nullptr;
+	m_ulRestoreClient = 0;
+}
+
 /**
  * @brief Parses and dispatches one queued WebSocket message.
  *
- * Non-JSON messages and unknown commands are forwarded to the application
- * message bus for custom handling.
+ * Binary messages of clients, that use the binary subprotocol, are decoded
+ * from CBOR - all other messages are parsed as JSON text. Non-JSON messages
+ * and unknown commands are forwarded to the application message bus for
+ * custom handling.
  *
  * @param pMessage Queued message to process.
  * @return true when the message was parsed and handled by built-in dispatch.
@@ -466,13 +878,17 @@ bool CWebSocket::dispatchMessage( CWebSocketMessage *pMessage) {
 	// AsyncWebSocketClient *pClient = pMessage->pClient;
 	// cast to const char * to avoid in-place editing of serializedMessage
 	// auto error = deserializeJson(oXChangeDoc, (const char *)pMessage->pSerializedMessage);
-	const char *psz = oXChangeDoc.parse((const char *)pMessage->pSerializedMessage);
-    if(*psz != '\0') {
+	bool bIsBinary = pMessage->MessageType == WS_BINARY && Protocols.isBinary(pMessage->ClientId);
+	bool bParsed = bIsBinary ? parseBinaryMessage(pMessage,oXChangeDoc) :
+							   *oXChangeDoc.parse((const char *)pMessage->pSerializedMessage) == '\0';
+    if(!bParsed) {
         ApplLogError(F("WS: Parse message error"));
 		Appl.MsgBus.sendEvent(this,MSG_WEBSOCKET_DATA_RECEIVED,pMessage,0);
 		bResult = false;
     } else {
+		m_pDispatching = pMessage;
 		bResult = dispatchJsonMessage(oXChangeDoc,pMessage);
+		m_pDispatching = nullptr;
 		if(!bResult) {
 			Appl.MsgBus.sendEvent(this,MSG_WEBSOCKET_DATA_RECEIVED,pMessage,1);
 		}
@@ -481,4 +897,103 @@ bool CWebSocket::dispatchMessage( CWebSocketMessage *pMessage) {
 	return(bResult);
 }
 
+/**
+ * @brief Decodes a binary message (header and CBOR map) into a JSON request.
+ *
+ * The sequence is stored in the message, for the response. If the body has no
+ * "command", the name of the registered command with the id of the header is set.
+ * @return false if the message has no valid header or body.
+ */
+bool CWebSocket::parseBinaryMessage(CWebSocketMessage *pMessage, JsonNode &oRequest) {
+	WebSocketBinaryHeader oHeader;
+	const uint8_t *pData = (const uint8_t *) pMessage->pSerializedMessage;
+	if(!oHeader.read(pData,pMessage->MessageSize)) return(false);
+	size_t nBodyLen = pMessage->MessageSize - WS_BINARY_HEADER_SIZE;
+	if(nBodyLen > 0 && (oRequest.parseCbor(pData + WS_BINARY_HEADER_SIZE,nBodyLen) != nBodyLen || !oRequest.isJsonObject())) return(false);
+	pMessage->Sequence = oHeader.Sequence;
+	if(!oRequest.exists("command")) {
+		const char *pszCommand = m_oCommands.getName(oHeader.CommandId);
+		if(pszCommand) oRequest.setValue("command",pszCommand);
+	}
+	return(true);
+}
+
+#pragma endregion
+
+#pragma region WebSocket Status Push
+
+CWebSocketStatusPush::CWebSocketStatusPush(CWebSocket *pSocket) : CStatusSubscriptions(&Appl), m_pSocket(pSocket) {}
+
+/**
+ * @brief Checks if the client is still connected.
+ */
+bool CWebSocketStatusPush::isConnected(uint32_t ulClientId) {
+	return(m_pSocket->client(ulClientId) != nullptr);
+}
+
+/**
+ * @brief Sends a status message to one client.
+ * @return false if the client is gone.
+ */
+bool CWebSocketStatusPush::sendStatus(uint32_t ulClientId, JsonNode &oMessage) {
+	AsyncWebSocketClient *pClient = m_pSocket->client(ulClientId);
+	if(!pClient) return(false);
+	m_pSocket->sendJsonDocMessage(oMessage,nullptr,pClient);
+	return(true);
+}
+
+#pragma endregion
+
+#pragma region WebSocket Streams
+
+/**
+ * @brief Checks if the send queue of the client has room for a fragment.
+ */
+bool CWebSocketStreamer::canSend(uint32_t ulClientId) {
+	AsyncWebSocketClient *pClient = m_pSocket->client(ulClientId);
+	return(pClient && !pClient->queueIsFull());
+}
+
+bool CWebSocketStreamer::isConnected(uint32_t ulClientId) {
+	return(m_pSocket->client(ulClientId) != nullptr);
+}
+
+/**
+ * @brief Sends a fragment as binary frame.
+ * @return false if the client is gone.
+ */
+bool CWebSocketStreamer::sendFragment(uint32_t ulClientId, const uint8_t *pData, size_t nLen) {
+	AsyncWebSocketClient *pClient = m_pSocket->client(ulClientId);
+	if(!pClient) return(false);
+	pClient->binary(pData,nLen);
+	return(true);
+}
+
+#pragma endregion
+
+#pragma region WebSocket Log Writer
+
+/**
+ * @brief Checks if a client is connected.
+ */
+bool CWebSocketLogWriter::isReady() {
+	return(m_pSocket && m_pSocket->count() > 0 && m_pSocket->AuthSessions.getSessions() > 0);
+}
+
+/**
+ * @brief Sends a batch of log entries to the authenticated clients.
+ *
+ * The log is only readable with authentication (like getlog), so a client gets
+ * the entries, when it has a valid session - it sent a command with a valid token.
+ * The batch is serialized once for all text clients.
+ */
+void CWebSocketLogWriter::sendBatch(JsonNode &oBatch) {
+	uint32_t tClientIds[WS_AUTH_SESSIONS];
+	size_t nClients = m_pSocket->AuthSessions.getClientIds(tClientIds,WS_AUTH_SESSIONS);
+	if(nClients == 0) return;
+	JsonNode oMsg;
+	oMsg.createPayloadStructure("log","entries")->copyFrom(oBatch);
+	m_pSocket->sendJsonDocMessage(oMsg,tClientIds,nClients);
+}
+
 #pragma endregion
@@ -0,0 +1,116 @@
+#ifndef DEBUG_LSC_WEBSOCKET
+    #undef DEBUGINFOS
+#endif
+#include <WebSocketAuthSessions.h>
+#include <LSCUtils.h>
+#include <DevelopmentHelper.h>
+
+#pragma region Implementation of CWebSocketAuthSessions
+
+CWebSocketAuthSessions::AuthSession * CWebSocketAuthSessions::find(uint32_t ulClientId) {
+    for(AuthSession &oSession : m_tSessions) {
+        if(oSession.Valid && oSession.ClientId == ulClientId) return(&oSession);
+    }
+    return(nullptr);
+}
+
+/**
+ * @brief Checks the token of a client against its cached session.
+ * @return true if the client has a valid session for the same token and IP.
+ *         false means, the token has to be validated (and stored) again.
+ */
+bool CWebSocketAuthSessions::check(uint32_t ulClientId, const char *pszToken, const char *pszIPAddress) {
+    AuthSession *pSession = find(ulClientId);
+    bool bValid = pSession && pszToken && pszIPAddress &&
+                  millis() - pSession->TimeStamp < pSession->Lifetime &&
+                  pSession->TokenLen  == strlen(pszToken) &&
+                  pSession->TokenHash == LSC::getHash(pszToken) &&
+                  strcmp(pSession->IPAddress,pszIPAddress) == 0;
+    if(bValid) m_ulHits++;
+    else       m_ulMisses++;
+    return(bValid);
+}
+
+/**
+ * @brief Stores the session of a client after its token was validated.
+ * The session of the client, a free slot or the oldest session is used.
+ * @param ulTimeStamp Time stamp (millis()) of the token.
+ * @param ulLifetime Lifetime (ms) of the token (TOKEN_TIME_ALIVE).
+ */
+void CWebSocketAuthSessions::store(uint32_t ulClientId, const char *pszToken, const char *pszIPAddress, unsigned long ulTimeStamp, unsigned long ulLifetime) {
+    AuthSession *pSession = find(ulClientId);
+    for(AuthSession &oSession : m_tSessions) {
+        if(pSession) break;
+        if(!oSession.Valid) pSession = &oSession;
+    }
+    if(!pSession) {
+        pSession = &m_tSessions[0];
+        for(AuthSession &oSession : m_tSessions) {
+            if(millis() - oSession.TimeStamp > millis() - pSession->TimeStamp) pSession = &oSession;
+        }
+    }
+    pSession->Valid     = false;
+    pSession->ClientId  = ulClientId;
+    pSession->TokenLen  = strlen(pszToken);
+    pSession->TokenHash = LSC::getHash(pszToken);
+    pSession->TimeStamp = ulTimeStamp;
+    pSession->Lifetime  = ulLifetime;
+    strncpy(pSession->IPAddress,pszIPAddress,sizeof(pSession->IPAddress) - 1);
+    pSession->IPAddress[sizeof(pSession->IPAddress) - 1] = '\0';
+    pSession->Valid     = true;
+}
+
+/**
+ * @brief Authenticates a command of a client (the path of CWebSocket::checkAuth()).
+ * A cached session saves the validation, otherwise the token is validated and
+ * the session is stored - or removed, if the token is invalid.
+ * @param ulLifetime Lifetime (ms) of the token (TOKEN_TIME_ALIVE).
+ * @return true if the token is valid for the client.
+ */
+bool CWebSocketAuthSessions::authenticate(uint32_t ulClientId, const char *pszToken, const char *pszIPAddress, unsigned long ulLifetime, WebSocketTokenValidator fnValidate) {
+    if(!pszToken || !pszIPAddress || strlen(pszToken) <= 10) return(false);
+    if(check(ulClientId,pszToken,pszIPAddress)) return(true);
+    unsigned long ulTimeStamp = 0;
+    bool bValid = fnValidate && fnValidate(pszToken,pszIPAddress,ulTimeStamp);
+    if(bValid) store(ulClientId,pszToken,pszIPAddress,ulTimeStamp,ulLifetime);
+    else       invalidate(ulClientId);
+    return(bValid);
+}
+
+bool CWebSocketAuthSessions::isAuthenticated(uint32_t ulClientId) {
+    AuthSession *pSession = find(ulClientId);
+    return(pSession && millis() - pSession->TimeStamp < pSession->Lifetime);
+}
+
+void CWebSocketAuthSessions::invalidate(uint32_t ulClientId) {
+    AuthSession *pSession = find(ulClientId);
+    if(pSession) pSession->Valid = false;
+}
+
+/**
+ * @brief Copies the ids of the authenticated clients (application loop).
+ * Used to send to the clients by id, instead of walking the client list of the socket.
+ * @return Number of ids copied.
+ */
+size_t CWebSocketAuthSessions::getClientIds(uint32_t *pClientIds, size_t nMaxIds) {
+    size_t nIds = 0;
+    for(AuthSession &oSession : m_tSessions) {
+        if(nIds >= nMaxIds) break;
+        if(oSession.Valid && millis() - oSession.TimeStamp < oSession.Lifetime) pClientIds[nIds++] = oSession.ClientId;
+    }
+    return(nIds);
+}
+
+size_t CWebSocketAuthSessions::getSessions() {
+    size_t nSessions = 0;
+    for(AuthSession &oSession : m_tSessions) if(oSession.Valid) nSessions++;
+    return(nSessions);
+}
+
+void CWebSocketAuthSessions::writeStatusTo(JsonNode &oStatusNode) {
+    oStatusNode.setValue("sessions",(int) getSessions());
+    oStatusNode.setValue("hits",    m_ulHits);
+    oStatusNode.setValue("misses",  m_ulMisses);
+}
+
+#pragma endregion
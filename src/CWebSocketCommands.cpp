@@ -0,0 +1,51 @@
+#ifndef DEBUG_LSC_WEBSOCKET
+    #undef DEBUGINFOS
+#endif
+#include <WebSocketCommands.h>
+#include <WebSocketProtocols.h>
+#include <LSCUtils.h>
+#include <DevelopmentHelper.h>
+
+#pragma region Implementation of CWebSocketCommands
+
+CWebSocketCommands::~CWebSocketCommands() {
+    for(auto *pEntry : m_tCommands.Entries) delete(pEntry->value);
+}
+
+bool CWebSocketCommands::isInList(const char *pszList, const char *pszName) {
+    return(LSC::isInList(pszList,pszName));
+}
+
+void CWebSocketCommands::registerCommand(const char *pszCommand, IWebSocketCommandHandler *pHandler, int nCommandId, bool bNeedsAuth) {
+    WebSocketCommand *pCommand = m_tCommands.get(pszCommand);
+    if(!pCommand) {
+        pCommand = new WebSocketCommand();
+        m_tCommands.set(pszCommand,pCommand,true);
+    }
+    pCommand->pHandler  = pHandler;
+    pCommand->CommandId = nCommandId;
+    pCommand->RegisteredAuth = bNeedsAuth;
+    pCommand->NeedsAuth = bNeedsAuth || isInList(m_strNeedsAuth.c_str(),pszCommand);
+    pCommand->WireId    = WebSocketBinaryHeader::getCommandId(pszCommand);
+}
+
+const char * CWebSocketCommands::getName(uint32_t ulWireId) {
+    for(auto *pEntry : m_tCommands.Entries) {
+        if(ulWireId && pEntry->value->WireId == ulWireId) return(pEntry->getKey());
+    }
+    return(nullptr);
+}
+
+void CWebSocketCommands::setNeedsAuth(const String &strCommands) {
+    m_strNeedsAuth = strCommands;
+    for(auto *pEntry : m_tCommands.Entries) {
+        pEntry->value->NeedsAuth = pEntry->value->RegisteredAuth || isInList(m_strNeedsAuth.c_str(),pEntry->getKey());
+    }
+}
+
+bool CWebSocketCommands::needsAuth(const char *pszCommand) {
+    WebSocketCommand *pCommand = find(pszCommand);
+    return(pCommand ? pCommand->NeedsAuth : isInList(m_strNeedsAuth.c_str(),pszCommand));
+}
+
+#pragma endregion
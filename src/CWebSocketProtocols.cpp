@@ -0,0 +1,95 @@
+#ifndef DEBUG_LSC_WEBSOCKET
+    #undef DEBUGINFOS
+#endif
+#include <WebSocketProtocols.h>
+#include <LSCUtils.h>
+#include <DevelopmentHelper.h>
+
+#pragma region Implementation of WebSocketBinaryHeader
+
+uint32_t WebSocketBinaryHeader::getCommandId(const char *pszCommand) {
+    return(pszCommand && *pszCommand ? LSC::getHashNoCase(pszCommand) : 0);
+}
+
+void WebSocketBinaryHeader::write(uint8_t *pBuffer) const {
+    pBuffer[0] = WS_BINARY_MAGIC;
+    pBuffer[1] = Flags;
+    for(int nIdx = 0; nIdx < 4; nIdx++) pBuffer[2 + nIdx] = (uint8_t) (CommandId >> (24 - nIdx * 8));
+    pBuffer[6] = (uint8_t) (Sequence >> 8);
+    pBuffer[7] = (uint8_t) Sequence;
+}
+
+bool WebSocketBinaryHeader::read(const uint8_t *pData, size_t nLen) {
+    if(!pData || nLen < WS_BINARY_HEADER_SIZE || pData[0] != WS_BINARY_MAGIC) return(false);
+    Flags     = pData[1];
+    CommandId = ((uint32_t) pData[2] << 24) | ((uint32_t) pData[3] << 16) | ((uint32_t) pData[4] << 8) | pData[5];
+    Sequence  = (uint16_t) ((pData[6] << 8) | pData[7]);
+    return(true);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CWebSocketProtocols
+
+CWebSocketProtocols::CWebSocketProtocols() {
+    for(auto &ulClientId : m_tClients) ulClientId = 0;
+    for(auto &ulPeerKey  : m_tPending) ulPeerKey  = 0;
+}
+
+uint32_t CWebSocketProtocols::getPeerKey(const char *pszIPAddress, uint16_t usPort) {
+    uint32_t ulKey = (LSC::getHash(pszIPAddress) ^ usPort) * 16777619UL;
+    return(ulKey ? ulKey : 1);
+}
+
+bool CWebSocketProtocols::isRequested(const char *pszProtocols) {
+    return(LSC::isInList(pszProtocols,WS_BINARY_PROTOCOL));
+}
+
+void CWebSocketProtocols::offer(uint32_t ulPeerKey) {
+    m_tPending[m_nNextPending++ % WS_BINARY_PENDING] = ulPeerKey;
+}
+
+/**
+ * @brief Connects a client - it uses the binary subprotocol, if its peer was offered.
+ * @return true if the client uses the binary subprotocol.
+ */
+bool CWebSocketProtocols::connect(uint32_t ulClientId, uint32_t ulPeerKey) {
+    bool bOffered = false;
+    for(auto &ulPending : m_tPending) {
+        uint32_t ulExpected = ulPeerKey;
+        if(ulPending.compare_exchange_strong(ulExpected,0)) { bOffered = true; break; }
+    }
+    if(!bOffered || ulClientId == 0) return(false);
+    for(auto &ulSlot : m_tClients) {
+        uint32_t ulFree = 0;
+        if(ulSlot.compare_exchange_strong(ulFree,ulClientId)) return(true);
+    }
+    m_ulRejected++;
+    return(false);
+}
+
+void CWebSocketProtocols::disconnect(uint32_t ulClientId) {
+    for(auto &ulSlot : m_tClients) {
+        uint32_t ulExpected = ulClientId;
+        if(ulClientId && ulSlot.compare_exchange_strong(ulExpected,0)) break;
+    }
+}
+
+bool CWebSocketProtocols::isBinary(uint32_t ulClientId) {
+    for(auto &ulSlot : m_tClients) if(ulClientId && ulSlot == ulClientId) return(true);
+    return(false);
+}
+
+size_t CWebSocketProtocols::getBinaryClients() {
+    size_t nClients = 0;
+    for(auto &ulSlot : m_tClients) if(ulSlot != 0) nClients++;
+    return(nClients);
+}
+
+void CWebSocketProtocols::writeStatusTo(JsonNode &oStatusNode) {
+    oStatusNode.setValue("protocol",WS_BINARY_PROTOCOL);
+    oStatusNode.setValue("clients", (int) getBinaryClients());
+    oStatusNode.setValue("rejected",getRejected());
+}
+
+#pragma endregion
@@ -0,0 +1,105 @@
+#ifndef DEBUG_LSC_WEBSOCKET
+    #undef DEBUGINFOS
+#endif
+#include <WebSocketQuotas.h>
+#include <DevelopmentHelper.h>
+#include <string>
+
+#pragma region Implementation of CWebSocketQuotas
+
+/**
+ * @brief Finds the slot of a client, or takes a free one (callback side only).
+ * @param bCreate true to take a free slot, if the client has none.
+ * @return Slot of the client, nullptr if it has none (and no slot is free).
+ */
+CWebSocketQuotas::ClientQuota * CWebSocketQuotas::getSlot(uint32_t ulClientId, bool bCreate) {
+    ClientQuota *pFree = nullptr;
+    for(ClientQuota &oClient : m_tClients) {
+        if(oClient.Connected && oClient.ClientId == ulClientId) return(&oClient);
+        if(!pFree && !oClient.Connected && oClient.Messages == 0) pFree = &oClient;
+    }
+    if(!bCreate || !pFree) return(nullptr);
+    pFree->ClientId  = ulClientId;
+    pFree->Bytes     = 0;
+    pFree->Dropped   = 0;
+    pFree->Oversized = 0;
+    pFree->Connected = true;
+    return(pFree);
+}
+
+/**
+ * @brief Takes the slot of a client, when it connects.
+ * The client gets broadcasts of the application loop (see getClientIds()), also
+ * before it sent its first message.
+ */
+bool CWebSocketQuotas::connect(uint32_t ulClientId) {
+    return(getSlot(ulClientId,true) != nullptr);
+}
+
+/**
+ * @brief Reserves the quota for a new message (callback side).
+ * @return false if the message exceeds the quota of the client - it is counted as dropped.
+ */
+bool CWebSocketQuotas::reserve(uint32_t ulClientId, size_t nSize) {
+    ClientQuota *pClient = getSlot(ulClientId,true);
+    if(!pClient) {
+        m_ulRejected++;
+        return(false);
+    }
+    if(nSize > WS_MAX_MESSAGE_SIZE) {
+        pClient->Oversized++;
+        return(false);
+    }
+    if(pClient->Messages >= m_nMaxMessages || pClient->Bytes + nSize > m_nMaxBytes) {
+        pClient->Dropped++;
+        return(false);
+    }
+    pClient->Messages++;
+    pClient->Bytes += nSize;
+    return(true);
+}
+
+void CWebSocketQuotas::release(uint32_t ulClientId, size_t nSize, bool bDropped) {
+    for(ClientQuota &oClient : m_tClients) {
+        if(oClient.ClientId == ulClientId && oClient.Messages > 0) {
+            oClient.Messages--;
+            oClient.Bytes -= nSize;
+            if(bDropped) oClient.Dropped++;
+            break;
+        }
+    }
+}
+
+void CWebSocketQuotas::disconnect(uint32_t ulClientId) {
+    ClientQuota *pClient = getSlot(ulClientId,false);
+    if(pClient) pClient->Connected = false;
+}
+
+/**
+ * @brief Copies the ids of the connected clients (application loop).
+ * The loop does not walk the client list of the socket, that is changed by the
+ * socket callback - the ids are sent to by id (AsyncWebSocket::text(id,...)).
+ * @return Number of ids copied.
+ */
+size_t CWebSocketQuotas::getClientIds(uint32_t *pClientIds, size_t nMaxIds) {
+    size_t nIds = 0;
+    for(ClientQuota &oClient : m_tClients) {
+        if(nIds >= nMaxIds) break;
+        if(oClient.Connected) pClientIds[nIds++] = oClient.ClientId;
+    }
+    return(nIds);
+}
+
+void CWebSocketQuotas::writeStatusTo(JsonNode &oStatusNode) {
+    oStatusNode.setValue("rejected",(unsigned long) m_ulRejected);
+    for(ClientQuota &oClient : m_tClients) {
+        if(!oClient.Connected) continue;
+        JsonNode *pClient = oStatusNode.getObject(std::to_string(oClient.ClientId).c_str(),true);
+        pClient->setValue("queued",   (int) oClient.Messages);
+        pClient->setValue("bytes",    (int) oClient.Bytes);
+        pClient->setValue("dropped",  (unsigned long) oClient.Dropped);
+        pClient->setValue("oversized",(unsigned long) oClient.Oversized);
+    }
+}
+
+#pragma endregion
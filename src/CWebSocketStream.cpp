@@ -0,0 +1,211 @@
+#ifndef DEBUG_LSC_WEBSOCKET
+    #undef DEBUGINFOS
+#endif
+#include <WebSocketStream.h>
+#include <DevelopmentHelper.h>
+#include <memory>
+#include <algorithm>
+#ifdef NATIVE_RUNTIME
+    #include <stdio.h>
+#endif
+
+#pragma region Implementation of CWebSocketFileReader
+
+CWebSocketFileReader::CWebSocketFileReader(const char *pszPath, const char *pszPrefix, const char *pszSuffix) :
+    m_strPrefix(pszPrefix ? pszPrefix : ""), m_strSuffix(pszSuffix ? pszSuffix : "") {
+    #ifdef NATIVE_RUNTIME
+        m_pFile = pszPath ? fopen(pszPath,"rb") : nullptr;
+        if(m_pFile && fseek(m_pFile,0,SEEK_END) == 0) {
+            long lSize = ftell(m_pFile);
+            m_nFileSize = lSize > 0 ? (size_t) lSize : 0;
+            fseek(m_pFile,0,SEEK_SET);
+        }
+    #else
+        if(pszPath && LittleFS.exists(pszPath)) m_oFile = LittleFS.open(pszPath,"r");
+        if(m_oFile) m_nFileSize = m_oFile.size();
+    #endif
+}
+
+CWebSocketFileReader::~CWebSocketFileReader() {
+    #ifdef NATIVE_RUNTIME
+        if(m_pFile) fclose(m_pFile);
+    #else
+        if(m_oFile) m_oFile.close();
+    #endif
+}
+
+size_t CWebSocketFileReader::readFile(uint8_t *pBuffer, size_t nMaxLen) {
+    #ifdef NATIVE_RUNTIME
+        return(m_pFile ? fread(pBuffer,1,nMaxLen,m_pFile) : 0);
+    #else
+        return(m_oFile ? m_oFile.read(pBuffer,nMaxLen) : 0);
+    #endif
+}
+
+/**
+ * @brief Reads the next part: the prefix, the file and the suffix.
+ * A file, that gets shorter while it is read, ends early - the suffix follows anyway.
+ */
+size_t CWebSocketFileReader::read(uint8_t *pBuffer, size_t nMaxLen) {
+    size_t nLen = 0;
+    size_t nPrefixLen = m_strPrefix.length();
+    if(m_nIndex < nPrefixLen) {
+        nLen = std::min(nPrefixLen - m_nIndex,nMaxLen);
+        memcpy(pBuffer,m_strPrefix.c_str() + m_nIndex,nLen);
+    } else if(m_nIndex < nPrefixLen + m_nFileSize) {
+        nLen = readFile(pBuffer,std::min(nPrefixLen + m_nFileSize - m_nIndex,nMaxLen));
+        if(nLen == 0) m_nFileSize = m_nIndex - nPrefixLen;
+    }
+    if(nLen == 0 && m_nIndex >= nPrefixLen + m_nFileSize) {
+        size_t nSuffixIndex = m_nIndex - nPrefixLen - m_nFileSize;
+        if(nSuffixIndex < m_strSuffix.length()) {
+            nLen = std::min(m_strSuffix.length() - nSuffixIndex,nMaxLen);
+            memcpy(pBuffer,m_strSuffix.c_str() + nSuffixIndex,nLen);
+        }
+    }
+    m_nIndex += nLen;
+    return(nLen);
+}
+
+#pragma endregion
+
+#pragma region Implementation of CWebSocketStreams
+
+CWebSocketStreams::~CWebSocketStreams() {
+    if(m_pFragment) free(m_pFragment);
+}
+
+/**
+ * @brief Starts a stream. The fragment buffer is allocated with the first active stream.
+ * @return Id of the stream, 0 if no slot is free or there is no memory for the fragment buffer.
+ */
+uint32_t CWebSocketStreams::start(uint32_t ulClientId, WebSocketStreamFiller fnFiller, const char *pszCommand, const char *pszData) {
+    DEBUG_FUNC_START_PARMS("%u",ulClientId);
+    Stream *pStream = nullptr;
+    for(Stream &oStream : m_tStreams) {
+        if(!oStream.Active) { pStream = &oStream; break; }
+    }
+    if(pStream && !m_pFragment) m_pFragment = (uint8_t *) malloc(WS_STREAM_HEADER_SIZE + WS_STREAM_FRAGMENT_SIZE);
+    if(!pStream || !m_pFragment) {
+        m_ulRejected++;
+        DEBUG_FUNC_END();
+        return(0);
+    }
+    if(m_ulNextId == 0) m_ulNextId = 1;
+    pStream->Active   = true;
+    pStream->Id       = m_ulNextId++;
+    pStream->ClientId = ulClientId;
+    pStream->Seq      = 0;
+    pStream->Index    = 0;
+    pStream->Filler   = fnFiller;
+    pStream->Command  = pszCommand ? pszCommand : "";
+    pStream->Data     = pszData    ? pszData    : "";
+    m_ulStreams++;
+    DEBUG_FUNC_END_PARMS("%u",pStream->Id);
+    return(pStream->Id);
+}
+
+/**
+ * @brief Starts a stream of a JSON document.
+ * A serializer keeps its position in the document between the fragments, so
+ * the document is walked once and its text is never held in memory. The
+ * document is deleted with the stream.
+ * @return Id of the stream, 0 if no slot is free (the document is deleted then).
+ */
+uint32_t CWebSocketStreams::startJson(uint32_t ulClientId, JsonNode *pDoc) {
+    std::shared_ptr<JsonNode> pSharedDoc(pDoc);
+    std::shared_ptr<CJsonSerializer> pSerializer = std::make_shared<CJsonSerializer>(pDoc);
+    return(start(ulClientId,[pSharedDoc,pSerializer](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t {
+        return(pSerializer->read((char *) pBuffer,nMaxLen));
+    }));
+}
+
+/**
+ * @brief Ends a stream and releases its filler (and the data it holds).
+ * The fragment buffer is freed with the last active stream.
+ */
+void CWebSocketStreams::finish(Stream &oStream) {
+    oStream.Active = false;
+    oStream.Filler = nullptr;
+    oStream.Command.clear();
+    oStream.Data.clear();
+    if(getActive() == 0 && m_pFragment) {
+        free(m_pFragment);
+        m_pFragment = nullptr;
+    }
+}
+
+/**
+ * @brief Sends the next fragments of the active streams.
+ *
+ * A fragment is only produced, if the send queue of the client has room - so
+ * a slow client slows down its stream instead of filling the heap. Streams of
+ * gone clients are aborted.
+ */
+void CWebSocketStreams::process() {
+    for(Stream &oStream : m_tStreams) {
+        if(!oStream.Active) continue;
+        if(!isConnected(oStream.ClientId)) {
+            m_ulAborted++;
+            finish(oStream);
+            continue;
+        }
+        for(int nFragment = 0; nFragment < WS_STREAM_FRAGMENTS_PER_LOOP && oStream.Active; nFragment++) {
+            if(!canSend(oStream.ClientId)) {
+                m_ulWaits++;
+                break;
+            }
+            // The final flag is a single char - it is set after the data has been read
+            char *pszHeader = (char *) m_pFragment;
+            int nHeaderLen = oStream.Seq == 0 ?
+                snprintf(pszHeader,WS_STREAM_HEADER_SIZE,"@%u,0,0,%s,%s\n",(unsigned int) oStream.Id,oStream.Command.c_str(),oStream.Data.c_str()) :
+                snprintf(pszHeader,WS_STREAM_HEADER_SIZE,"@%u,%u,0\n",(unsigned int) oStream.Id,(unsigned int) oStream.Seq);
+            if(nHeaderLen < 0 || nHeaderLen >= WS_STREAM_HEADER_SIZE) nHeaderLen = WS_STREAM_HEADER_SIZE - 1;
+            size_t nLen = oStream.Filler(m_pFragment + nHeaderLen,WS_STREAM_FRAGMENT_SIZE,oStream.Index);
+            if(nLen > WS_STREAM_FRAGMENT_SIZE) nLen = WS_STREAM_FRAGMENT_SIZE;
+            bool bFinal = nLen == 0;
+            if(bFinal) {
+                char *pszFlag = strchr(pszHeader + 1,',');
+                if(pszFlag) pszFlag = strchr(pszFlag + 1,',');
+                if(pszFlag) pszFlag[1] = '1';
+            }
+            if(!sendFragment(oStream.ClientId,m_pFragment,nHeaderLen + nLen)) {
+                m_ulAborted++;
+                finish(oStream);
+                break;
+            }
+            oStream.Seq++;
+            oStream.Index += nLen;
+            m_ulFragments++;
+            m_ulBytes += nLen;
+            if(bFinal) finish(oStream);
+        }
+    }
+}
+
+void CWebSocketStreams::abort(uint32_t ulClientId) {
+    for(Stream &oStream : m_tStreams) {
+        if(oStream.Active && oStream.ClientId == ulClientId) {
+            m_ulAborted++;
+            finish(oStream);
+        }
+    }
+}
+
+size_t CWebSocketStreams::getActive() {
+    size_t nActive = 0;
+    for(Stream &oStream : m_tStreams) if(oStream.Active) nActive++;
+    return(nActive);
+}
+
+void CWebSocketStreams::writeStatusTo(JsonNode &oStatusNode, int nLevel) {
+    oStatusNode.setValue("active",   (int) getActive());
+    oStatusNode.setValue("streams",  m_ulStreams);
+    oStatusNode.setValue("fragments",m_ulFragments);
+    oStatusNode.setValue("bytes",    m_ulBytes);
+    oStatusNode.setValue("waits",    m_ulWaits);
+    oStatusNode.setValue("aborted",  m_ulAborted);
+    oStatusNode.setValue("rejected", m_ulRejected);
+}
+
+#pragma endregion
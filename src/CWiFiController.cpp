@@ -317,6 +317,7 @@ bool CWiFiController::startAccessPoint(const char * pszSSID,
             Status.wifiStatus = WL_IDLE_STATUS;
             Status.startTimeInMillis = millis();
             Appl.MsgBus.sendEvent(this,MSG_WIFI_CONNECTED,nullptr,WIFI_ACCESS_POINT_MODE);
+            Appl.MsgBus.sendEvent(this,MSG_APPL_STATUS_CHANGED,nullptr,0);
         }
     }
     DEBUG_FUNC_END_PARMS("%d",Status.isWiFiConnected);
@@ -377,6 +378,7 @@ bool CWiFiController::joinNetwork(const char *pszSSID, const char *pszPassword,
         Appl.MsgBus.sendEvent(this,MSG_WIFI_CONNECTED,nullptr,WIFI_STATION_MODE);
         Status.isWiFiConnected  = true;
         Status.startTimeInMillis = millis();
+        Appl.MsgBus.sendEvent(this,MSG_APPL_STATUS_CHANGED,nullptr,0);
     } else {
         Appl.MsgBus.sendEvent(this,MSG_WIFI_ERROR,nullptr,Status.wifiStatus);
         ApplLogErrorWithParms(F(" - failed to connect to %s"),Config.wifi_ssid.c_str());
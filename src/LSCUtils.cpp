@@ -3,6 +3,7 @@
 #endif
 #include <LSCUtils.h>
 #include <stdlib.h>
+#include <algorithm>
 
 // #include <DevelopmentHelper.h>
 
@@ -62,6 +63,46 @@ namespace LSC {
         return(psz);
     }
 
+    /**
+     * @brief Checks if a name is in a comma separated list.
+     * Whole names are compared (case insensitive), white space around the names is ignored.
+     */
+    bool isInList(const char *pszList, const char *pszName) {
+        if(!pszList || !pszName) return(false);
+        size_t nNameLen = strlen(pszName);
+        while(*pszList) {
+            pszList = skipWhite(pszList);
+            const char *pszEnd = pszList;
+            while(*pszEnd && *pszEnd != ',') pszEnd++;
+            const char *pszLast = pszEnd;
+            while(pszLast > pszList && isWhite(*(pszLast - 1))) pszLast--;
+            if((size_t) (pszLast - pszList) == nNameLen && strncasecmp(pszList,pszName,nNameLen) == 0) return(true);
+            pszList = *pszEnd ? pszEnd + 1 : pszEnd;
+        }
+        return(false);
+    }
+
+    /**
+     * @brief Copies the next item of a comma separated list, without white space around.
+     * Items longer than the buffer are truncated.
+     * @return Position of the following item (end of string after the last item).
+     */
+    const char * getListItem(const char *pszList, char *pszItem, size_t nItemSize) {
+        if(nItemSize > 0) *pszItem = '\0';
+        if(!pszList) return("");
+        pszList = skipWhite(pszList);
+        const char *pszEnd = pszList;
+        while(*pszEnd && *pszEnd != ',') pszEnd++;
+        const char *pszLast = pszEnd;
+        while(pszLast > pszList && isWhite(*(pszLast - 1))) pszLast--;
+        if(nItemSize > 0) {
+            size_t nLen = std::min((size_t) (pszLast - pszList),nItemSize - 1);
+            memcpy(pszItem,pszList,nLen);
+            pszItem[nLen] = '\0';
+        }
+        return(*pszEnd ? pszEnd + 1 : pszEnd);
+    }
+
     /**
      * @brief Case-insensitive string comparison.
      *
@@ -82,6 +123,56 @@ namespace LSC {
         return toupper(*(unsigned const char *)psz1) - toupper(*(unsigned const char *)(psz2));
     }
 
+    /**
+     * @brief Calculates a FNV-1a hash of a string.
+     * @return Hash value, 0 for nullptr.
+     */
+    uint32_t getHash(const char *psz) {
+        uint32_t ulHash = 0;
+        if(psz) {
+            ulHash = 2166136261UL;
+            while(*psz) {
+                ulHash ^= (uint32_t) (unsigned char) *psz++;
+                ulHash *= 16777619UL;
+            }
+        }
+        return(ulHash);
+    }
+
+    /**
+     * @brief Continues a FNV-1a hash with a block of data.
+     * Start with LSC_HASH_START, the hash of data given in parts is the same
+     * as the hash of the whole data.
+     * @return Updated hash value.
+     */
+    uint32_t updateHash(uint32_t ulHash, const void *pData, size_t nLen) {
+        const uint8_t *pBytes = (const uint8_t *) pData;
+        while(nLen-- > 0) {
+            ulHash ^= (uint32_t) *pBytes++;
+            ulHash *= 16777619UL;
+        }
+        return(ulHash);
+    }
+
+    /**
+     * @brief Calculates a case-folded FNV-1a hash of a string.
+     *
+     * Keys that are equal for stricmp() get the same hash, so one hash value
+     * works for case-sensitive and case-insensitive lookups.
+     * @return Hash value, 0 for nullptr.
+     */
+    uint32_t getHashNoCase(const char *psz) {
+        uint32_t ulHash = 0;
+        if(psz) {
+            ulHash = 2166136261UL;
+            while(*psz) {
+                ulHash ^= (uint32_t) toupper((unsigned char) *psz++);
+                ulHash *= 16777619UL;
+            }
+        }
+        return(ulHash);
+    }
+
     /**
      * @brief Finds the first index of a character in a string.
      * @return Zero-based index, or -1 when not found or psz is nullptr.
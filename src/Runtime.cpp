@@ -1,6 +1,8 @@
 #include "Runtime.h"
 
 #ifdef NATIVE_RUNTIME
+    #include <thread>
+
     /**
      * @brief Minimal Serial replacement for native tests.
      */
@@ -36,6 +38,28 @@
             std::chrono::duration_cast<std::chrono::milliseconds>(oElapsed).count()
         );
     }
+
+    /**
+     * @brief Native replacement for Arduino micros().
+     * @return Microseconds since the first call.
+     */
+    unsigned long micros()
+    {
+        static const auto oStartTime = std::chrono::steady_clock::now();
+        const auto oElapsed = std::chrono::steady_clock::now() - oStartTime;
+        return static_cast<unsigned long>(
+            std::chrono::duration_cast<std::chrono::microseconds>(oElapsed).count()
+        );
+    }
+
+    /**
+     * @brief Native replacement for Arduino delay().
+     * @param ulMillis Milliseconds to wait.
+     */
+    void delay(unsigned long ulMillis)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ulMillis));
+    }
 #else
 
 
@@ -31,6 +31,9 @@ const DEFAULTS = {
     DEBUG_TOKEN            : "JoWaschlEmulator",// Default Debug Access Token (for emulator)
     GET_CONFIG_COMMAND     : "getconfig",       // Websocket get configuration
     GET_STATUS_COMMAND     : "getstatus",       // Websocket get status
+    SUBSCRIBE_STATUS_COMMAND : "subscribe",     // Websocket subscribe the status (snapshot, then patches)
+    STATUS_PUSH_INTERVAL   : 1000,              // Min. time (ms) between two status pushes
+    STATUS_PUSH_REFRESH    : 10000,             // Max. time (ms) between two status pushes
     RESTART_COMMAND        : "restart",         // Websocket restart
     SAVE_CONFIG_COMMAND    : "saveconfig",      // Websocket save configuration
     FACTORY_RESET_COMMAND  : "factoryreset",    // Websocket factory reset the device
@@ -341,6 +344,23 @@ class Utils {
         return(typeof oData === 'string');
     }
 
+    /**
+     * Apply a JSON merge patch (RFC 7386) to an object.
+     * Objects are merged recursively, null removes the element, all other values are replaced.
+     * @param {*} oTarget object to be patched (changed in place)
+     * @param {*} oPatch the merge patch
+     * @returns the patched object
+     */
+    static applyMergePatch(oTarget, oPatch) {
+        if(!Utils.isObj(oPatch)) return(oPatch);
+        if(!Utils.isObj(oTarget)) oTarget = {};
+        for(const strKey of Object.keys(oPatch)) {
+            if(oPatch[strKey] === null) delete oTarget[strKey];
+            else oTarget[strKey] = Utils.applyMergePatch(oTarget[strKey],oPatch[strKey]);
+        }
+        return(oTarget);
+    }
+
     static isBoolean(oData) {
         return(typeof oData === 'boolean');
     }
@@ -2508,6 +2528,7 @@ class CWebSocketV2 {
     _isConnectionAvailable = false;    // Is the connection activ and available ?
     _nReConTimer = 0;           // Avoids multiple timers to be in place...
     _gotInitialData = false;           // Did we already received the initial data ?
+    _tStreams = {};                    // Streamed messages being received (fragments by stream id)
     
     Log = new CLog();
     _callBacks;
@@ -2565,6 +2586,41 @@ class CWebSocketV2 {
         if(this._callBacks.onMessage) this._callBacks.onMessage(oMsg,this);
     }
 
+    /**
+     * Reassemble a streamed message (binary fragments).
+     * Fragment: "@<id>,<seq>,<final>[,<command>,<data>]\n" <data>
+     * With the final fragment, the message is delivered like a text message - a
+     * stream with a command is delivered as { command, data, payload: <text> }.
+     * @param {ArrayBuffer} oBuffer the received fragment
+     */
+    _onFragmentReceived(oBuffer) {
+        let tBytes = new Uint8Array(oBuffer);
+        let nHeaderEnd = tBytes.indexOf(10);
+        if(tBytes[0] !== 64 || nHeaderEnd < 0) return;
+        let tHeader = new TextDecoder().decode(tBytes.subarray(1,nHeaderEnd)).split(",");
+        let strId = tHeader[0];
+        let nSeq = parseInt(tHeader[1]);
+        if(nSeq === 0) this._tStreams[strId] = { command: tHeader[3] ?? "", data: tHeader[4] ?? "", parts: [] };
+        let oStream = this._tStreams[strId];
+        if(!oStream) return;
+        oStream.parts.push(tBytes.slice(nHeaderEnd + 1));
+        if(tHeader[2] === "1") {
+            delete this._tStreams[strId];
+            let strText = new TextDecoder().decode(this._concatParts(oStream.parts));
+            if(oStream.command) strText = JSON.stringify({ command: oStream.command, data: oStream.data, payload: strText });
+            this.Log.logTrace("WS: Stream received (" + strText.length + " chars)");
+            this._onMsgReceived({ data: strText });
+        }
+    }
+
+    _concatParts(tParts) {
+        let nLen = tParts.reduce((nSum,tPart) => nSum + tPart.length,0);
+        let tResult = new Uint8Array(nLen);
+        let nPos = 0;
+        for(let tPart of tParts) { tResult.set(tPart,nPos); nPos += tPart.length; }
+        return(tResult);
+    }
+
     // #endregion
 
     // #region open, close and monitor the connection
@@ -2573,10 +2629,13 @@ class CWebSocketV2 {
         if(!this._isConnectionAvailable) {    
             this.Log.logVerbose("WS: creating WebSocket");
             this._oWebSocket = new WebSocket(this._getConnectionUri());
+            this._oWebSocket.binaryType = "arraybuffer";  // Streamed messages are sent as binary fragments
+            this._tStreams = {};
             let oSelf = this;
             // Register the handler....
             this._oWebSocket.addEventListener("message", function(oMsg) {
-                oSelf._onMsgReceived(oMsg,this);
+                if(oMsg.data instanceof ArrayBuffer) oSelf._onFragmentReceived(oMsg.data);
+                else oSelf._onMsgReceived(oMsg,this);
             });
             this._oWebSocket.onopen  = function(evt) { 
                 oSelf._isConnectionAvailable = true;
@@ -3345,6 +3404,12 @@ class CAppl {
                 this.sendSocketCommand(DEFAULTS.GET_CONFIG_COMMAND);
                 this._bInitialDataReceived = true;
             }
+            // Subscribe (again) the status - the device sends a snapshot, then the changes only
+            this.sendSocketCommand(DEFAULTS.SUBSCRIBE_STATUS_COMMAND,null,{
+                "level"   : 5,
+                "interval": DEFAULTS.STATUS_PUSH_INTERVAL,
+                "refresh" : DEFAULTS.STATUS_PUSH_REFRESH
+            });
         }
     }
     /**
@@ -3406,6 +3471,10 @@ class CAppl {
                     this.setNewStatus(oMsg.payload);
                     break;
 
+                case "statuspatch": // Changes of the subscribed status received
+                    this.setNewStatus(Utils.applyMergePatch(this.DeviceStatus,oMsg.payload));
+                    break;
+
                 case "config":
                     this.Config.setConfig(oMsg.payload);
                     if(this._pCurHandler) this._pCurHandler.loadPageConfig(this.MainView,this);
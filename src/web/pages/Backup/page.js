@@ -33,13 +33,13 @@ class CBackupPage extends CPageHandler {
                             // alert("You did not select file to restore!");
                         } else {
                             let oReader = new FileReader();
-                            oReader.onload = function() {
+                            oReader.onload = () => {
                                 try {
                                     let oConfigData = JSON.parse(oReader.result);
                                     // Check if structure could be a config file...
                                     if (oConfigData.wifi && oConfigData.wifi.hasOwnProperty("ap_mode")) {
                                         if (confirm("File seems to be valid, do you wish to continue?")) {
-                                            this.m_oAPP.WS.sendCommandMessage(RESTORE_BACKUP_COMMAND,"",oConfigData);
+                                            this._restoreBackup(oReader.result);
                                         }
                                     } else {
                                         oAlert.showModal({body: "i18n:SysCfg.Restore.invalidFile"});
@@ -60,6 +60,35 @@ class CBackupPage extends CPageHandler {
         }
     }
     
+    /**
+     * Start to restore a backup. The device accepts messages up to WS_MAX_MESSAGE_SIZE,
+     * so the text is sent in parts - the next part, when the device has confirmed the last one.
+     * @param {string} strBackup text of the backup file
+     */
+    _restoreBackup(strBackup) {
+        this._strBackup = strBackup;
+        this._nBackupPos = 0;
+        this._sendBackupPart(0);
+    }
+
+    /**
+     * Send the next part of the backup. The offset counts the UTF-8 bytes sent before.
+     * @param {number} nOffset bytes confirmed by the device
+     */
+    _sendBackupPart(nOffset) {
+        const nPartSize = 2048;
+        let nEnd = Math.min(this._nBackupPos + nPartSize, this._strBackup.length);
+        // Do not split a surrogate pair
+        if (nEnd < this._strBackup.length && this._strBackup.charCodeAt(nEnd - 1) >= 0xD800 && this._strBackup.charCodeAt(nEnd - 1) <= 0xDBFF) nEnd--;
+        let strPart = this._strBackup.substring(this._nBackupPos, nEnd);
+        this._nBackupPos = nEnd;
+        this._oApp.sendSocketCommand(DEFAULTS.RESTORE_BACKUP_COMMAND,"",{
+            "part"  : strPart,
+            "offset": nOffset,
+            "final" : nEnd >= this._strBackup.length ? 1 : 0
+        });
+    }
+
      /**
      * listen on the socket message and check if the message is a "ssidlist" message.
      * @param {*} pView 
@@ -77,6 +106,9 @@ class CBackupPage extends CPageHandler {
                     dlAnchorElem.setAttribute("download", `${this._oApp.Vars.getValue("prog_name")} - settings.json`);
                     dlAnchorElem.click();
                     break;
+                case "part":    // A part of the restored backup is confirmed, send the next one
+                    if (this._strBackup && this._nBackupPos < this._strBackup.length) this._sendBackupPart(oMsg.payload.offset);
+                    break;
             }
         }
     }
@@ -4,5 +4,23 @@
 #include <../src/LSCUtils.cpp>
 #include <../src/CJsonNode.cpp>
 #include <../src/CConfigHandler.cpp>
+#include <../src/CConfigJournal.cpp>
 #include <../src/CVar.cpp>
-#include <../src/CVarTable.cpp>
\ No newline at end of file
+#include <../src/CVarTable.cpp>
+#include <../src/CEventHandler.cpp>
+#include <../src/CLogging.cpp>
+#include <../src/CLogRing.cpp>
+#include <../src/CFileLogWriter.cpp>
+#include <../src/CBatchLogWriter.cpp>
+#include <../src/CBufferPool.cpp>
+#include <../src/CStatusHandler.cpp>
+#include <../src/CStatusSubscriptions.cpp>
+#include <../src/CWebSocketStream.cpp>
+#include <../src/CWebSocketQuotas.cpp>
+#include <../src/CWebSocketAuthSessions.cpp>
+#include <../src/CWebSocketProtocols.cpp>
+#include <../src/CWebSocketCommands.cpp>
+#include <../src/CMsgRecorder.cpp>
+#include <../src/CTemplateRenderer.cpp>
+#include <../src/CFileIndex.cpp>
+#include <../src/CFileUpload.cpp>
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "BatchLogWriter.h"
+
+/// @brief Batch writer that keeps the sent batches as JSON text.
+class CTestBatchWriter : public CBatchLogWriter {
+    public:
+        bool Ready = true;
+        std::vector<String> Batches;
+    protected:
+        bool isReady() override { return(Ready); }
+        void sendBatch(JsonNode &oBatch) override { Batches.push_back(oBatch.getAsJsonText()); }
+};
+
+TEST(CBatchLogWriter,testPacksEntriesIntoOneBatch) {
+    CTestBatchWriter oWriter;
+    oWriter.setRateLimit(0);
+    oWriter.setFlushInterval(60000);
+    oWriter.receiveEvent(nullptr,MSG_LOG_ENTRY,"one",'I');
+    oWriter.receiveEvent(nullptr,MSG_LOG_ENTRY,"two \"quoted\"",'E');
+    oWriter.receiveEvent(nullptr,MSG_LOG_ENTRY,"filtered",'T');
+    oWriter.receiveEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    EXPECT_EQ(oWriter.Batches.size(),0U);
+    EXPECT_EQ(oWriter.getPending(),2U);
+
+    oWriter.setFlushInterval(0);
+    oWriter.receiveEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    ASSERT_EQ(oWriter.Batches.size(),1U);
+    JsonNode oBatch;
+    oBatch.parse(oWriter.Batches[0].c_str());
+    EXPECT_EQ(oBatch.getValueAsInt("dropped"),0);
+    JsonNode *pEntries = oBatch.getArray("entries");
+    ASSERT_NE(pEntries,nullptr);
+    ASSERT_EQ(pEntries->Elements.size(),2U);
+    EXPECT_NE(String(pEntries->Elements[0]->getValue()).find("[I] one"),std::string::npos);
+    EXPECT_NE(oWriter.Batches[0].find("[E] two \\\"quoted\\\""),std::string::npos);
+    EXPECT_EQ(oWriter.getSent(),2UL);
+}
+
+TEST(CBatchLogWriter,testFlushesFullBatch) {
+    CTestBatchWriter oWriter;
+    oWriter.setRateLimit(0);
+    oWriter.setFlushInterval(60000);
+    String strMessage(100,'x');
+    int nEntries = 0;
+    while(oWriter.Batches.empty()) {
+        oWriter.writeLogEntry("I",strMessage.c_str());
+        nEntries++;
+    }
+    EXPECT_EQ(oWriter.getPending(),1U);
+    EXPECT_EQ(oWriter.getSent(),(unsigned long) nEntries - 1);
+    EXPECT_LT((nEntries - 1) * strMessage.length(),(size_t) LOG_BATCH_BUFFER_SIZE);
+}
+
+TEST(CBatchLogWriter,testRateLimitAndNotReady) {
+    CTestBatchWriter oWriter;
+    oWriter.setRateLimit(5);
+    for(int n = 0; n < 8; n++) oWriter.writeLogEntry("W","flood");
+    EXPECT_EQ(oWriter.getPending(),5U);
+    EXPECT_EQ(oWriter.getDropped(),3UL);
+    oWriter.flush();
+    ASSERT_EQ(oWriter.Batches.size(),1U);
+    JsonNode oBatch;
+    oBatch.parse(oWriter.Batches[0].c_str());
+    EXPECT_EQ(oBatch.getValueAsInt("dropped"),3);
+
+    oWriter.Ready = false;
+    oWriter.setRateLimit(0);
+    oWriter.writeLogEntry("W","offline");
+    EXPECT_EQ(oWriter.getPending(),0U);
+    EXPECT_EQ(oWriter.getDropped(),4UL);
+}
+
+TEST(CBatchLogWriter,testCountsPendingEntriesLostOnFlush) {
+    CTestBatchWriter oWriter;
+    oWriter.writeLogEntry("I","one");
+    oWriter.writeLogEntry("I","two");
+    // The destination disconnects before the batch is sent
+    oWriter.Ready = false;
+    oWriter.flush();
+    EXPECT_EQ(oWriter.getPending(),0U);
+    EXPECT_EQ(oWriter.getDropped(),2UL);
+
+    oWriter.Ready = true;
+    oWriter.flush();
+    ASSERT_EQ(oWriter.Batches.size(),1U);
+    JsonNode oBatch;
+    oBatch.parse(oWriter.Batches[0].c_str());
+    EXPECT_EQ(oBatch.getValueAsInt("dropped"),2);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "BufferPool.h"
+
+static const BufferPoolClass tTestClasses[] = { { 16, 2 }, { 64, 1 } };
+
+TEST(CBufferPool,testUsesSmallestFreeClass) {
+    CBufferPool oPool(tTestClasses,2);
+    void *p1 = oPool.allocate(10);
+    void *p2 = oPool.allocate(16);
+    EXPECT_TRUE(oPool.isPoolBuffer(p1));
+    EXPECT_TRUE(oPool.isPoolBuffer(p2));
+    // Class 16 is used up, the next request goes to class 64
+    void *p3 = oPool.allocate(8);
+    EXPECT_TRUE(oPool.isPoolBuffer(p3));
+    EXPECT_EQ(oPool.getExhausted(),1UL);
+    EXPECT_EQ(oPool.getFree(),0U);
+    // Pool is used up - heap
+    void *p4 = oPool.allocate(8);
+    EXPECT_FALSE(oPool.isPoolBuffer(p4));
+    EXPECT_EQ(oPool.getHeap(),1UL);
+    memset(p3,'x',64);
+
+    oPool.release(p1);
+    oPool.release(p4);
+    EXPECT_EQ(oPool.allocate(12),p1);
+    oPool.release(p1);
+    oPool.release(p2);
+    oPool.release(p3);
+    EXPECT_EQ(oPool.getFree(),3U);
+    EXPECT_EQ(oPool.getHits(),4UL);
+}
+
+TEST(CBufferPool,testOversizedFromHeap) {
+    CBufferPool oPool(tTestClasses,2);
+    void *pBig = oPool.allocate(100);
+    ASSERT_NE(pBig,nullptr);
+    EXPECT_FALSE(oPool.isPoolBuffer(pBig));
+    EXPECT_EQ(oPool.getOversized(),1UL);
+    oPool.release(pBig);
+    oPool.release(nullptr);
+
+    JsonNode oStatus;
+    oPool.writeStatusTo(oStatus,STATUS_LEVEL_VERBOSE);
+    EXPECT_EQ(oStatus.getValueAsInt("oversized"),1);
+    EXPECT_EQ(oStatus.getValueAsInt("hitrate"),0);
+    ASSERT_TRUE(oStatus.isJsonObject("64"));
+    EXPECT_EQ(oStatus.getObject("64")->getValueAsInt("count"),1);
+}
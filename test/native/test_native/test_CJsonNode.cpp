@@ -558,6 +558,14 @@ TEST(CJsonNode,testParseEscapedQuotes) {
     EXPECT_STREQ(node.getValue("key"),"value\"quoted\"");
 }
 
+// Test: Parse control character and unicode escapes (as written by a browser)
+TEST(CJsonNode,testParseEscapedControlCharacters) {
+    CJsonNode node;
+    node.parse("{\"text\":\"{\\n  \\\"a\\\": 1\\t\\/\\u00e4\\u20ac\\n}\",\"next\":2}");
+    EXPECT_STREQ(node.getValue("text"),"{\n  \"a\": 1\t/\xc3\xa4\xe2\x82\xac\n}");
+    EXPECT_EQ(node.getValueAsInt("next"),2);
+}
+
 // Test: Multiple key-value pairs
 TEST(CJsonNode,testMultipleKeyValues) {
     CJsonNode node;
@@ -585,5 +593,148 @@ TEST(CJsonNode,testParseComplexJson) {
     EXPECT_TRUE(pSubElement->isNumberValue());
 }
 
+// Test: Deep copy keeps types and quoting
+TEST(CJsonNode,testCopyFrom) {
+    CJsonNode oSource;
+    oSource.parse("{\"a\":1,\"b\":\"text\",\"o\":{\"c\":true},\"l\":[1,2]}");
+    CJsonNode oCopy;
+    oCopy.setValue("old","gone");
+    oCopy.copyFrom(oSource);
+    EXPECT_STREQ(oCopy.getAsJsonText(),oSource.getAsJsonText());
+    EXPECT_FALSE(oCopy.exists("old"));
+    EXPECT_EQ(oCopy.getObject("o")->getParentNode(),&oCopy);
+}
+
+// Test: Merge objects recursive, replace values and arrays
+TEST(CJsonNode,testMerge) {
+    CJsonNode oTarget;
+    oTarget.parse("{\"a\":1,\"o\":{\"c\":true,\"d\":\"keep\"},\"l\":[1,2]}");
+    CJsonNode oPatch;
+    oPatch.parse("{\"a\":\"2\",\"o\":{\"c\":false,\"e\":5},\"l\":[3],\"n\":{\"x\":1}}");
+    oTarget.merge(oPatch);
+    EXPECT_STREQ(oTarget.getAsJsonText(),"{\"a\":\"2\",\"o\":{\"c\":false,\"d\":\"keep\",\"e\":5},\"l\":[3],\"n\":{\"x\":1}}");
+}
+
+// Test: Serialize into a buffer, same text as getAsJsonText()
+TEST(CJsonNode,testSerializeTo) {
+    CJsonNode oNode;
+    oNode.parse("{\"a\":1,\"s\":\"say \\\"hi\\\" c:\\\\x\",\"o\":{\"b\":true},\"l\":[1,\"x\",{}]}");
+    oNode.setValue("q","a\"b");
+    String strText = oNode.getAsJsonText();
+    size_t nLen = oNode.measureJson();
+    EXPECT_EQ(nLen,strText.length());
+    char szBuffer[128];
+    EXPECT_EQ(oNode.serializeTo(szBuffer,sizeof(szBuffer)),nLen);
+    EXPECT_STREQ(szBuffer,strText.c_str());
+    // Too small - cut, no terminator written beyond the buffer
+    memset(szBuffer,'#',sizeof(szBuffer));
+    EXPECT_EQ(oNode.serializeTo(szBuffer,5),nLen);
+    EXPECT_EQ(strncmp(szBuffer,strText.c_str(),5),0);
+    EXPECT_EQ(szBuffer[5],'#');
+}
+
+TEST(CJsonNode,testSerializerParts) {
+    CJsonNode oNode;
+    oNode.parse("{\"name\":\"a\\\"b\\\\c\",\"list\":[1,2,\"\\\"\"],\"obj\":{\"x\":true,\"e\":{},\"a\":[]}}");
+    String strText = oNode.getAsJsonText();
+    // Concatenated parts of any size are the complete text, escapes may be split
+    for(size_t nPartSize = 1; nPartSize <= strText.length() + 1; nPartSize++) {
+        CJsonSerializer oSerializer(&oNode);
+        String strParts;
+        char szBuffer[128];
+        size_t nLen = 0;
+        while((nLen = oSerializer.read(szBuffer,nPartSize)) > 0) {
+            EXPECT_LE(nLen,nPartSize);
+            strParts.append(szBuffer,nLen);
+        }
+        EXPECT_STREQ(strParts.c_str(),strText.c_str()) << "part size " << nPartSize;
+        EXPECT_EQ(oSerializer.read(szBuffer,nPartSize),0U);
+    }
+}
+
+
+TEST(CJsonNode,testCreateMergePatch) {
+    CJsonNode oOld, oNew, oPatch;
+    oOld.parse("{\"a\":1,\"b\":\"x\",\"o\":{\"c\":1,\"d\":2},\"l\":[1,2],\"gone\":true}");
+    oNew.parse("{\"a\":1,\"b\":\"y\",\"o\":{\"c\":1,\"d\":3},\"l\":[1,3],\"new\":{\"e\":0}}");
+    EXPECT_FALSE(oOld.isEqual(oNew));
+    EXPECT_TRUE(oPatch.createMergePatch(oOld,oNew));
+    EXPECT_STREQ(oPatch.getAsJsonText(),"{\"b\":\"y\",\"o\":{\"d\":3},\"l\":[1,3],\"new\":{\"e\":0},\"gone\":null}");
+    // Nothing changed - empty patch
+    CJsonNode oCopy;
+    oCopy.copyFrom(oNew);
+    EXPECT_TRUE(oCopy.isEqual(oNew));
+    EXPECT_FALSE(oPatch.createMergePatch(oNew,oCopy));
+    EXPECT_EQ(oPatch.Elements.size(),0U);
+    // Quoted and unquoted values differ
+    CJsonNode oQuoted, oPlain;
+    oQuoted.setValue("v","1");
+    oPlain.setValue("v",1);
+    EXPECT_FALSE(oQuoted.isEqual(oPlain));
+}
+
 #pragma endregion
 
+
+/// @brief CBOR encoding of a JSON text as hex string.
+static std::string toCborHex(const char *pszJson) {
+    CJsonNode oNode;
+    oNode.parse(pszJson);
+    std::vector<uint8_t> tData(oNode.measureCbor());
+    EXPECT_EQ(oNode.serializeCborTo(tData.data(),tData.size()),tData.size());
+    std::string strHex;
+    char szByte[3];
+    for(uint8_t byData : tData) { snprintf(szByte,sizeof(szByte),"%02x",byData); strHex += szByte; }
+    return(strHex);
+}
+
+/// @brief JSON text of a CBOR item given as hex string, "invalid" if it cannot be decoded.
+static std::string fromCborHex(const char *pszHex) {
+    std::vector<uint8_t> tData;
+    for(const char *psz = pszHex; psz[0] && psz[1]; psz += 2) tData.push_back((uint8_t) strtoul(std::string(psz,2).c_str(),nullptr,16));
+    CJsonNode oNode;
+    if(oNode.parseCbor(tData.data(),tData.size()) != tData.size()) return("invalid");
+    return(oNode.getAsJsonText());
+}
+
+TEST(CJsonNode,testCborEncoding) {
+    // Examples of RFC 8949, Appendix A
+    EXPECT_EQ(toCborHex("{\"a\":1,\"b\":[2,3]}"),"a26161016162820203");
+    EXPECT_EQ(toCborHex("[0,23,24,100,1000,1000000,-1,-1000]"),"880017181818641903e81a000f4240203903e7");
+    EXPECT_EQ(toCborHex("[true,false,null,\"a\",\"\"]"),"85f5f4f6616160");
+    // Floats: single precision if it is exact, double otherwise
+    EXPECT_EQ(toCborHex("[1.5,1.1]"),"82fa3fc00000fb3ff199999999999a");
+}
+
+TEST(CJsonNode,testCborDecoding) {
+    EXPECT_EQ(fromCborHex("a26161016162820203"),"{\"a\":1,\"b\":[2,3]}");
+    EXPECT_EQ(fromCborHex("83203903e71bffffffffffffffff"),"[-1,-1000,18446744073709551615]");
+    // Half, single and double floats, NaN becomes null
+    EXPECT_EQ(fromCborHex("83f93e00fa47c35000fb3ff199999999999a"),"[1.5,100000,1.1]");
+    EXPECT_EQ(fromCborHex("81f97e00"),"[null]");
+    // Indefinite length, tags, byte strings and simple values
+    EXPECT_EQ(fromCborHex("bf61610161629f0203ffff"),"{\"a\":1,\"b\":[2,3]}");
+    EXPECT_EQ(fromCborHex("82c11a514b67b04401020304"),"[1363896240,\"AQIDBA==\"]");
+    EXPECT_EQ(fromCborHex("84f5f4f6f7"),"[true,false,null,null]");
+    // Invalid data
+    EXPECT_EQ(fromCborHex("a261610161628202"),"invalid");
+    EXPECT_EQ(fromCborHex("1c"),"invalid");
+    EXPECT_EQ(fromCborHex("a1416101"),"invalid");
+    // Nesting deeper than JSON_CBOR_MAX_DEPTH
+    std::string strNested;
+    for(int nDepth = 0; nDepth < JSON_CBOR_MAX_DEPTH; nDepth++) strNested += "81";
+    EXPECT_EQ(fromCborHex((strNested + "00").c_str()).length(),(size_t) JSON_CBOR_MAX_DEPTH * 2 + 1);
+    EXPECT_EQ(fromCborHex((strNested + "8100").c_str()),"invalid");
+}
+
+TEST(CJsonNode,testCborRoundTripIsSmaller) {
+    CJsonNode oNode;
+    oNode.parse("{\"command\":\"update\",\"data\":\"status\",\"payload\":{\"wifi\":{\"rssi\":-67,\"connected\":true,"
+                "\"ip\":\"192.168.1.17\",\"uptime\":1234567},\"sensors\":[21.5,48.25,1013.2],\"name\":\"a \\\"quoted\\\" text\"}}");
+    std::vector<uint8_t> tData(oNode.measureCbor());
+    oNode.serializeCborTo(tData.data(),tData.size());
+    CJsonNode oDecoded;
+    ASSERT_EQ(oDecoded.parseCbor(tData.data(),tData.size()),tData.size());
+    EXPECT_STREQ(oDecoded.getAsJsonText(),oNode.getAsJsonText());
+    EXPECT_LT(tData.size(),oNode.measureJson());
+}
@@ -23,3 +23,58 @@ TEST_F(CVarTable,setSingleVarValue) {
 }
     */
 
+
+TEST_F(CVarTest, emptyVarHasNoValue) {
+    EXPECT_EQ(oVar.getValue(),nullptr);
+    EXPECT_EQ(oVar.getIntValue(),0);
+    EXPECT_FALSE(oVar.getBoolValue());
+}
+
+TEST_F(CVarTest, intValueIsConvertedOnDemand) {
+    oVar.setValue(-42);
+    EXPECT_FALSE(oVar.isTextValue());
+    EXPECT_EQ(oVar.getIntValue(),-42);
+    EXPECT_STREQ(oVar.getValue(),"-42");
+    EXPECT_TRUE(oVar.getBoolValue());
+    EXPECT_EQ(oVar.getUnsignedLongValue(),strtoul("-42",nullptr,10));
+}
+
+TEST_F(CVarTest, unsignedLongValueIsConvertedOnDemand) {
+    oVar.setValue(4000000000UL);
+    EXPECT_EQ(oVar.getUnsignedLongValue(),4000000000UL);
+    EXPECT_STREQ(oVar.getValue(),"4000000000");
+}
+
+TEST_F(CVarTest, boolValueIsConvertedOnDemand) {
+    oVar.setValue(true);
+    EXPECT_TRUE(oVar.getBoolValue());
+    EXPECT_EQ(oVar.getIntValue(),1);
+    EXPECT_STREQ(oVar.getValue(),"1");
+    oVar.setValue(false);
+    EXPECT_FALSE(oVar.getBoolValue());
+    EXPECT_STREQ(oVar.getValue(),"0");
+}
+
+TEST_F(CVarTest, textValueIsParsedAndCacheIsReset) {
+    oVar.setValue("123");
+    EXPECT_TRUE(oVar.isTextValue());
+    EXPECT_EQ(oVar.getIntValue(),123);
+    EXPECT_EQ(oVar.getUnsignedLongValue(),123UL);
+    oVar.setValue("off");
+    EXPECT_EQ(oVar.getIntValue(),0);
+    EXPECT_FALSE(oVar.getBoolValue());
+    oVar.setValue(7);
+    EXPECT_EQ(oVar.getIntValue(),7);
+    EXPECT_STREQ(oVar.getValue(),"7");
+}
+
+TEST_F(CVarTest, valueBufferIsReused) {
+    oVar.setValue(1);
+    const char *pszFirst = oVar.getValue();
+    oVar.setValue(123456789);
+    EXPECT_EQ(oVar.getValue(),pszFirst);
+    oVar.setValue("short");
+    EXPECT_EQ(oVar.getValue(),pszFirst);
+    oVar.setValue("a text value that does not fit into the current buffer");
+    EXPECT_STREQ(oVar.getValue(),"a text value that does not fit into the current buffer");
+}
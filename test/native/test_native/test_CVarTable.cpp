@@ -127,4 +127,38 @@ TEST_F(CVarTableTest, getValueWithStringReference) {
     String strName("strKey");
     const char* result = varTable.getValue(strName, "default");
     EXPECT_STREQ(result, "strValue");
-}
\ No newline at end of file
+}
+TEST_F(CVarTableTest, findInLargeTable) {
+    char szName[32];
+    for(int n = 0; n < 300; n++) {
+        snprintf(szName,sizeof(szName),"Module.Var%d",n);
+        varTable.set(szName,n);
+    }
+    EXPECT_EQ(varTable.getIntValue("module.var0",-1),0);
+    EXPECT_EQ(varTable.getIntValue("MODULE.VAR299",-1),299);
+    EXPECT_EQ(varTable.getIntValue("module.var300",-1),-1);
+    varTable.set("module.var150",-5);
+    EXPECT_EQ(varTable.getIntValue("Module.Var150",0),-5);
+}
+
+TEST_F(CVarTableTest, caseSensitiveTableKeepsVarsApart) {
+    varTableCaseSensitive.set("Key",1);
+    varTableCaseSensitive.set("key",2);
+    EXPECT_EQ(varTableCaseSensitive.getIntValue("Key",0),1);
+    EXPECT_EQ(varTableCaseSensitive.getIntValue("key",0),2);
+    EXPECT_EQ(varTableCaseSensitive.find("KEY"),nullptr);
+}
+
+TEST_F(CVarTableTest, indexFollowsRenamedVar) {
+    CVar *pVar = varTable.set("Renamed.Var",7);
+    ASSERT_NE(pVar,nullptr);
+    pVar->setVarName("Other.Name.That.Is.Longer");
+    EXPECT_EQ(varTable.find("other.name.that.is.longer"),pVar);
+    EXPECT_EQ(varTable.getIntValue("Other.Name.That.Is.Longer",0),7);
+    EXPECT_EQ(varTable.find("Renamed.Var"),nullptr);
+    // The old name is free for a new var
+    CVar *pNewVar = varTable.set("Renamed.Var",8);
+    EXPECT_NE(pNewVar,pVar);
+    EXPECT_EQ(varTable.getIntValue("Renamed.Var",0),8);
+    EXPECT_EQ(varTable.getIntValue("Other.Name.That.Is.Longer",0),7);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include "ConfigJournal.h"
+
+static const char *TEST_BASE_FILE    = "test_journal_config.json";
+static const char *TEST_JOURNAL_FILE = "test_journal_config.jnl";
+
+/// @brief Reads a test file into a string.
+static String readTestFile(const char *pszFileName) {
+    String strData;
+    FILE *pFile = fopen(pszFileName,"r");
+    if(pFile) {
+        char szBuffer[256];
+        size_t nRead;
+        while((nRead = fread(szBuffer,1,sizeof(szBuffer),pFile)) > 0) strData.append(szBuffer,nRead);
+        fclose(pFile);
+    }
+    return(strData);
+}
+
+static void writeTestFile(const char *pszFileName, const char *pszData) {
+    FILE *pFile = fopen(pszFileName,"w");
+    fputs(pszData,pFile);
+    fclose(pFile);
+}
+
+/// @brief Loads the config like CAppl on boot: base file, then the journal.
+static void loadTestConfig(CConfigJournal &oJournal, JsonNode &oDoc) {
+    oDoc.parse(readTestFile(TEST_BASE_FILE).c_str());
+    oJournal.replayFile(oDoc);
+    oJournal.remember(oDoc);
+}
+
+class CConfigJournalTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            remove(TEST_BASE_FILE);
+            remove(TEST_JOURNAL_FILE);
+            writeTestFile(TEST_BASE_FILE,"{\"devicename\":\"dev\",\"unknown\":1,\"wifi\":{\"ssid\":\"net\",\"dhcp\":true}}");
+        }
+        void TearDown() override {
+            remove(TEST_BASE_FILE);
+            remove(TEST_JOURNAL_FILE);
+        }
+};
+
+TEST_F(CConfigJournalTest,testAppendsChangedSettingsOnly) {
+    CConfigJournal oJournal(TEST_BASE_FILE,TEST_JOURNAL_FILE);
+    JsonNode oDoc;
+    loadTestConfig(oJournal,oDoc);
+
+    JsonNode oCurrent;
+    oCurrent.parse("{\"devicename\":\"dev\",\"wifi\":{\"ssid\":\"other\",\"dhcp\":true}}");
+    EXPECT_TRUE(oJournal.save(oCurrent));
+    EXPECT_EQ(oJournal.getRecordCount(),1U);
+    EXPECT_STREQ(readTestFile(TEST_JOURNAL_FILE).c_str(),"25\t{\"wifi\":{\"ssid\":\"other\"}}\n");
+
+    // Nothing changed - nothing written
+    EXPECT_TRUE(oJournal.save(oCurrent));
+    EXPECT_EQ(oJournal.getRecordCount(),1U);
+}
+
+TEST_F(CConfigJournalTest,testReplayRestoresSettings) {
+    {
+        CConfigJournal oJournal(TEST_BASE_FILE,TEST_JOURNAL_FILE);
+        JsonNode oDoc;
+        loadTestConfig(oJournal,oDoc);
+        JsonNode oCurrent;
+        oCurrent.parse("{\"devicename\":\"dev\",\"wifi\":{\"ssid\":\"a\",\"dhcp\":true}}");
+        oJournal.save(oCurrent);
+        oCurrent.parse("{\"devicename\":\"dev\",\"wifi\":{\"ssid\":\"a\",\"dhcp\":false},\"new\":{\"v\":\"x\"}}");
+        oJournal.save(oCurrent);
+        EXPECT_EQ(oJournal.getRecordCount(),2U);
+    }
+    CConfigJournal oJournal(TEST_BASE_FILE,TEST_JOURNAL_FILE);
+    JsonNode oDoc;
+    loadTestConfig(oJournal,oDoc);
+    EXPECT_EQ(oJournal.getRecordCount(),2U);
+    EXPECT_STREQ(oDoc.getAsJsonText(),"{\"devicename\":\"dev\",\"unknown\":1,\"wifi\":{\"ssid\":\"a\",\"dhcp\":false},\"new\":{\"v\":\"x\"}}");
+}
+
+TEST_F(CConfigJournalTest,testIgnoresIncompleteRecord) {
+    writeTestFile(TEST_JOURNAL_FILE,"13\t{\"unknown\":2}\n40\t{\"unknown\":3");
+    CConfigJournal oJournal(TEST_BASE_FILE,TEST_JOURNAL_FILE);
+    JsonNode oDoc;
+    loadTestConfig(oJournal,oDoc);
+    EXPECT_EQ(oJournal.getRecordCount(),1U);
+    EXPECT_STREQ(oDoc.getValue("unknown"),"2");
+
+    // The damaged journal is compacted into the base file at the next save
+    JsonNode oCurrent;
+    oCurrent.parse("{\"devicename\":\"new\"}");
+    EXPECT_TRUE(oJournal.save(oCurrent));
+    EXPECT_STREQ(readTestFile(TEST_JOURNAL_FILE).c_str(),"");
+    EXPECT_STREQ(readTestFile(TEST_BASE_FILE).c_str(),"{\"devicename\":\"new\",\"unknown\":2,\"wifi\":{\"ssid\":\"net\",\"dhcp\":true}}");
+}
+
+TEST_F(CConfigJournalTest,testCompactsWhenJournalIsFull) {
+    CConfigJournal oJournal(TEST_BASE_FILE,TEST_JOURNAL_FILE);
+    JsonNode oDoc;
+    loadTestConfig(oJournal,oDoc);
+    JsonNode oCurrent;
+    int nSaves = 0;
+    while(nSaves < 1000) {
+        oCurrent.setValue("counter",nSaves++);
+        oJournal.save(oCurrent);
+        if(oJournal.getRecordCount() == 0) break;
+        EXPECT_LE(oJournal.getJournalSize(),(size_t) CONFIG_JOURNAL_MAX_SIZE);
+    }
+    EXPECT_LT(nSaves,1000);
+    JsonNode oBase;
+    oBase.parse(readTestFile(TEST_BASE_FILE).c_str());
+    EXPECT_EQ(oBase.getValueAsInt("counter"),nSaves - 1);
+    EXPECT_STREQ(oBase.getValue("wifi.ssid"),"net");
+}
+
+TEST_F(CConfigJournalTest,testWritesBaseFileWithoutPersistedState) {
+    remove(TEST_BASE_FILE);
+    CConfigJournal oJournal(TEST_BASE_FILE,TEST_JOURNAL_FILE);
+    JsonNode oCurrent;
+    oCurrent.parse("{\"devicename\":\"dev\"}");
+    EXPECT_TRUE(oJournal.save(oCurrent));
+    EXPECT_STREQ(readTestFile(TEST_BASE_FILE).c_str(),"{\"devicename\":\"dev\"}");
+    EXPECT_EQ(oJournal.getRecordCount(),0U);
+
+    oJournal.clear();
+    oCurrent.setValue("devicename","x");
+    EXPECT_TRUE(oJournal.save(oCurrent));
+    EXPECT_STREQ(readTestFile(TEST_BASE_FILE).c_str(),"{\"devicename\":\"x\"}");
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include "FileIndex.h"
+#include "LSCUtils.h"
+#include <stdio.h>
+#include <utime.h>
+
+static const char *TEST_INDEX_FILE = "test_fileindex.txt";
+
+TEST(CFileIndexTest,testSortedFindAndRemove) {
+    CFileIndex oIndex;
+    char szPath[32];
+    for(int n = 0; n < 50; n++) {
+        snprintf(szPath,sizeof(szPath),"/file%d.js",n);
+        oIndex.set(szPath,n * 10);
+    }
+    EXPECT_EQ(oIndex.getCount(),50U);
+    for(int n = 0; n < 50; n++) {
+        snprintf(szPath,sizeof(szPath),"/file%d.js",n);
+        FileIndexEntry *pEntry = oIndex.find(szPath);
+        ASSERT_NE(pEntry,nullptr);
+        EXPECT_EQ(pEntry->Size,(uint32_t)(n * 10));
+    }
+    EXPECT_EQ(oIndex.find("/missing.js"),nullptr);
+
+    // Update keeps one entry and resets the content hash
+    oIndex.set("/file1.js",99,1234);
+    EXPECT_EQ(oIndex.getCount(),50U);
+    EXPECT_EQ(oIndex.find("/file1.js")->ContentHash,1234U);
+    oIndex.set("/file1.js",100);
+    EXPECT_EQ(oIndex.find("/file1.js")->ContentHash,0U);
+
+    oIndex.remove("/file1.js");
+    EXPECT_EQ(oIndex.find("/file1.js"),nullptr);
+    EXPECT_EQ(oIndex.getCount(),49U);
+}
+
+TEST(CFileIndexTest,testPathsWithSameHash) {
+    // Both paths have the same LSC::getHash()
+    const char *pszPath1 = "/f1079599.js";
+    const char *pszPath2 = "/f1262382.js";
+    ASSERT_EQ(LSC::getHash(pszPath1),LSC::getHash(pszPath2));
+    CFileIndex oIndex;
+    oIndex.set("/other.js",1);
+    oIndex.set(pszPath1,10,0x1111);
+    EXPECT_EQ(oIndex.find(pszPath2),nullptr);
+    oIndex.set(pszPath2,20,0x2222);
+    EXPECT_EQ(oIndex.getCount(),3U);
+    ASSERT_NE(oIndex.find(pszPath1),nullptr);
+    ASSERT_NE(oIndex.find(pszPath2),nullptr);
+    EXPECT_EQ(oIndex.find(pszPath1)->ContentHash,0x1111U);
+    EXPECT_EQ(oIndex.find(pszPath2)->ContentHash,0x2222U);
+
+    // Removing one path keeps the other
+    oIndex.remove(pszPath1);
+    EXPECT_EQ(oIndex.find(pszPath1),nullptr);
+    ASSERT_NE(oIndex.find(pszPath2),nullptr);
+    EXPECT_EQ(oIndex.find(pszPath2)->Size,20U);
+    oIndex.remove(pszPath1);
+    EXPECT_EQ(oIndex.getCount(),2U);
+}
+
+TEST(CFileIndexTest,testETagHashesFileOnce) {
+    const char *pszContent = "<html>etag test</html>";
+    FILE *pFile = fopen(TEST_INDEX_FILE,"w");
+    ASSERT_NE(pFile,nullptr);
+    fputs(pszContent,pFile);
+    fclose(pFile);
+
+    CFileIndex oIndex;
+    char szETag[FILE_INDEX_ETAG_SIZE];
+    EXPECT_FALSE(oIndex.getETag(TEST_INDEX_FILE,szETag));
+    EXPECT_FALSE(oIndex.hashNext());
+    // The file is not read by getETag(), it is hashed by the loop
+    oIndex.set(TEST_INDEX_FILE,0);
+    EXPECT_FALSE(oIndex.getETag(TEST_INDEX_FILE,szETag));
+    EXPECT_TRUE(oIndex.hashNext());
+    EXPECT_FALSE(oIndex.hashNext());
+    ASSERT_TRUE(oIndex.getETag(TEST_INDEX_FILE,szETag));
+    char szExpected[FILE_INDEX_ETAG_SIZE];
+    uint32_t ulHash = LSC::updateHash(LSC_HASH_START,pszContent,strlen(pszContent));
+    snprintf(szExpected,sizeof(szExpected),"\"%08x-%x\"",(unsigned int) ulHash,(unsigned int) strlen(pszContent));
+    EXPECT_STREQ(szETag,szExpected);
+    EXPECT_EQ(oIndex.find(TEST_INDEX_FILE)->Size,strlen(pszContent));
+
+    // A known hash is not computed again
+    oIndex.set(TEST_INDEX_FILE,strlen(pszContent),0x1234);
+    EXPECT_FALSE(oIndex.hashNext());
+    ASSERT_TRUE(oIndex.getETag(TEST_INDEX_FILE,szETag));
+    snprintf(szExpected,sizeof(szExpected),"\"00001234-%x\"",(unsigned int) strlen(pszContent));
+    EXPECT_STREQ(szETag,szExpected);
+    remove(TEST_INDEX_FILE);
+
+    // A file that cannot be read is removed by the loop
+    oIndex.set("missing_fileindex.txt",10);
+    EXPECT_TRUE(oIndex.hashNext());
+    EXPECT_EQ(oIndex.find("missing_fileindex.txt"),nullptr);
+}
+
+/// @brief Writes a test file and sets its modification time.
+static void writeIndexFile(const char *pszContent, time_t tModified) {
+    FILE *pFile = fopen(TEST_INDEX_FILE,"w");
+    ASSERT_NE(pFile,nullptr);
+    fputs(pszContent,pFile);
+    fclose(pFile);
+    struct utimbuf oTimes = { tModified, tModified };
+    utime(TEST_INDEX_FILE,&oTimes);
+}
+
+TEST(CFileIndexTest,testETagFollowsChangesByOthers) {
+    writeIndexFile("<html>version 1</html>",1000000);
+    CFileIndex oIndex;
+    oIndex.set(TEST_INDEX_FILE,0);
+    ASSERT_TRUE(oIndex.hashNext());
+    char szETag1[FILE_INDEX_ETAG_SIZE], szETag2[FILE_INDEX_ETAG_SIZE], szETag3[FILE_INDEX_ETAG_SIZE];
+    ASSERT_TRUE(oIndex.getETag(TEST_INDEX_FILE,szETag1));
+    uint32_t ulVersion = oIndex.getVersion(TEST_INDEX_FILE);
+
+    // Same size, other content and time - found by checkNext(), hashed again by hashNext()
+    writeIndexFile("<html>version 2</html>",1000010);
+    ASSERT_TRUE(oIndex.getETag(TEST_INDEX_FILE,szETag2));
+    EXPECT_STREQ(szETag1,szETag2);
+    oIndex.checkNext();
+    EXPECT_FALSE(oIndex.getETag(TEST_INDEX_FILE,szETag2));
+    EXPECT_NE(oIndex.getVersion(TEST_INDEX_FILE),ulVersion);
+    ASSERT_TRUE(oIndex.hashNext());
+    ASSERT_TRUE(oIndex.getETag(TEST_INDEX_FILE,szETag2));
+    EXPECT_STRNE(szETag1,szETag2);
+
+    // Other size, same time - found by the delivery (verify())
+    writeIndexFile("<html>version 10</html>",1000010);
+    EXPECT_TRUE(oIndex.verify(TEST_INDEX_FILE,strlen("<html>version 2</html>"),1000010));
+    EXPECT_FALSE(oIndex.verify(TEST_INDEX_FILE,strlen("<html>version 10</html>"),1000010));
+    EXPECT_FALSE(oIndex.getETag(TEST_INDEX_FILE,szETag3));
+    ASSERT_TRUE(oIndex.hashNext());
+    ASSERT_TRUE(oIndex.getETag(TEST_INDEX_FILE,szETag3));
+    EXPECT_STRNE(szETag2,szETag3);
+
+    // Unchanged file, the ETag is the same
+    oIndex.checkNext();
+    EXPECT_FALSE(oIndex.hashNext());
+    ASSERT_TRUE(oIndex.getETag(TEST_INDEX_FILE,szETag1));
+    EXPECT_STREQ(szETag1,szETag3);
+
+    // A removed file is removed from the index
+    remove(TEST_INDEX_FILE);
+    oIndex.checkNext();
+    EXPECT_FALSE(oIndex.getETag(TEST_INDEX_FILE,szETag1));
+    EXPECT_EQ(oIndex.find(TEST_INDEX_FILE),nullptr);
+}
+
+TEST(CFileIndexTest,testVersionChangesWithContent) {
+    CFileIndex oIndex;
+    EXPECT_EQ(oIndex.getVersion("/page.html"),0U);
+    oIndex.set("/page.html",10,0x1111);
+    oIndex.set("/other.html",10,0x2222);
+    uint32_t ulVersion = oIndex.getVersion("/page.html");
+    EXPECT_NE(ulVersion,0U);
+    EXPECT_NE(oIndex.getVersion("/other.html"),ulVersion);
+    // Lookups keep the version, an upload (set) changes it
+    EXPECT_EQ(oIndex.getVersion("/page.html"),ulVersion);
+    oIndex.set("/page.html",10,0x3333);
+    EXPECT_NE(oIndex.getVersion("/page.html"),ulVersion);
+}
+
+TEST(CFileIndexTest,testContentType) {
+    EXPECT_STREQ(CFileIndex::getContentType("/index.html"),"text/html");
+    EXPECT_STREQ(CFileIndex::getContentType("/index.html.gz"),"text/html");
+    EXPECT_STREQ(CFileIndex::getContentType("/APP.JS"),"application/javascript");
+    EXPECT_STREQ(CFileIndex::getContentType("/logo.svg"),"image/svg+xml");
+    EXPECT_STREQ(CFileIndex::getContentType("/data.gz"),"application/gzip");
+    EXPECT_STREQ(CFileIndex::getContentType("/dir.d/noext"),"application/octet-stream");
+    EXPECT_STREQ(CFileIndex::getContentType("/file.unknown"),"application/octet-stream");
+}
+
+TEST(CFileIndexTest,testMatchesETag) {
+    const char *pszETag = "\"0a1b2c3d-10\"";
+    EXPECT_TRUE(CFileIndex::matchesETag("\"0a1b2c3d-10\"",pszETag));
+    EXPECT_TRUE(CFileIndex::matchesETag("\"x\", W/\"0a1b2c3d-10\"",pszETag));
+    EXPECT_TRUE(CFileIndex::matchesETag("*",pszETag));
+    EXPECT_FALSE(CFileIndex::matchesETag("\"0a1b2c3d-11\"",pszETag));
+    EXPECT_FALSE(CFileIndex::matchesETag("\"0a1b2c3d\"",pszETag));
+    EXPECT_FALSE(CFileIndex::matchesETag("",pszETag));
+}
+
+TEST(CFileIndexTest,testParseRange) {
+    size_t nStart = 0, nEnd = 0;
+    EXPECT_EQ(CFileIndex::parseRange("bytes=0-99",1000,nStart,nEnd),FILE_RANGE_OK);
+    EXPECT_EQ(nStart,0U); EXPECT_EQ(nEnd,99U);
+    EXPECT_EQ(CFileIndex::parseRange("bytes=500-",1000,nStart,nEnd),FILE_RANGE_OK);
+    EXPECT_EQ(nStart,500U); EXPECT_EQ(nEnd,999U);
+    EXPECT_EQ(CFileIndex::parseRange("bytes=-100",1000,nStart,nEnd),FILE_RANGE_OK);
+    EXPECT_EQ(nStart,900U); EXPECT_EQ(nEnd,999U);
+    EXPECT_EQ(CFileIndex::parseRange("bytes=900-2000",1000,nStart,nEnd),FILE_RANGE_OK);
+    EXPECT_EQ(nEnd,999U);
+    EXPECT_EQ(CFileIndex::parseRange("bytes=1000-",1000,nStart,nEnd),FILE_RANGE_INVALID);
+    EXPECT_EQ(CFileIndex::parseRange("bytes=-0",1000,nStart,nEnd),FILE_RANGE_INVALID);
+    EXPECT_EQ(CFileIndex::parseRange("bytes=0-1,5-9",1000,nStart,nEnd),FILE_RANGE_NONE);
+    EXPECT_EQ(CFileIndex::parseRange("bytes=9-5",1000,nStart,nEnd),FILE_RANGE_NONE);
+    EXPECT_EQ(CFileIndex::parseRange("items=0-5",1000,nStart,nEnd),FILE_RANGE_NONE);
+    EXPECT_EQ(CFileIndex::parseRange(nullptr,1000,nStart,nEnd),FILE_RANGE_NONE);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "FileLogWriter.h"
+
+static const char *TEST_LOG_BASE = "test_filelog";
+
+/// @brief Reads the whole log with a small buffer.
+static String readLog(CFileLogWriter &oWriter, size_t nMaxBytes = 0) {
+    String strLog;
+    CFileLogReader oReader(&oWriter,nMaxBytes);
+    uint8_t tBuffer[37];
+    size_t nRead;
+    while((nRead = oReader.read(tBuffer,sizeof(tBuffer))) > 0) strLog.append((const char *) tBuffer,nRead);
+    return(strLog);
+}
+
+class CFileLogWriterTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            CFileLogWriter oWriter(TEST_LOG_BASE);
+            oWriter.clear();
+        }
+        void TearDown() override {
+            CFileLogWriter oWriter(TEST_LOG_BASE);
+            oWriter.clear();
+        }
+};
+
+TEST_F(CFileLogWriterTest,testWritesPageAlignedChunks) {
+    CFileLogWriter oWriter(TEST_LOG_BASE);
+    String strMessage(50,'m');
+    oWriter.writeLogEntry("I",strMessage.c_str());
+    EXPECT_EQ(oWriter.getWrites(),0UL);
+    EXPECT_GT(oWriter.getBuffered(),50U);
+
+    while(oWriter.getWrites() == 0) oWriter.writeLogEntry("I",strMessage.c_str());
+    EXPECT_EQ(oWriter.getFileSize(0) % FILE_LOG_PAGE_SIZE,0U);
+    EXPECT_GT(oWriter.getBuffered(),0U);
+
+    oWriter.flush();
+    EXPECT_EQ(oWriter.getBuffered(),0U);
+    String strLog = readLog(oWriter);
+    EXPECT_EQ(strLog.length(),oWriter.getBytes());
+    EXPECT_NE(strLog.find("[I] " + strMessage + "\n"),std::string::npos);
+}
+
+TEST_F(CFileLogWriterTest,testRotatesAndReadsTail) {
+    int nEntries = 0;
+    {
+        CFileLogWriter oWriter(TEST_LOG_BASE);
+        while(oWriter.getGeneration() < FILE_LOG_FILE_COUNT + 1) {
+            oWriter.writeLogEntry("W",("entry " + std::to_string(nEntries++)).c_str());
+        }
+        EXPECT_EQ(oWriter.getOldestGeneration(),2UL);
+        for(unsigned long ulGen = oWriter.getOldestGeneration(); ulGen < oWriter.getGeneration(); ulGen++) {
+            EXPECT_EQ(oWriter.getFileSize(ulGen),(size_t) FILE_LOG_FILE_SIZE);
+        }
+        EXPECT_EQ(oWriter.getFileSize(1),0U);
+    }
+    // A new writer continues with the current file
+    CFileLogWriter oWriter(TEST_LOG_BASE);
+    EXPECT_EQ(oWriter.getGeneration(),(unsigned long) FILE_LOG_FILE_COUNT + 1);
+    oWriter.writeLogEntry("E","last");
+    String strTail = readLog(oWriter,100);
+    EXPECT_EQ(strTail.length(),100U);
+    EXPECT_EQ(strTail.substr(strTail.length() - 5),"last\n");
+    EXPECT_NE(strTail.find("entry " + std::to_string(nEntries - 1) + "\n"),std::string::npos);
+
+    String strAll = readLog(oWriter);
+    EXPECT_GT(strAll.length(),(size_t) (FILE_LOG_FILE_COUNT - 1) * FILE_LOG_FILE_SIZE);
+    EXPECT_EQ(strAll.find("entry 0\n"),std::string::npos);
+    EXPECT_EQ(strAll.substr(strAll.length() - strTail.length()),strTail);
+}
+
+TEST_F(CFileLogWriterTest,testFlushesOnShutdown) {
+    CFileLogWriter oWriter(TEST_LOG_BASE);
+    oWriter.receiveEvent(nullptr,MSG_LOG_ENTRY,"boot",'I');
+    oWriter.receiveEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    EXPECT_EQ(oWriter.getWrites(),0UL);
+    oWriter.receiveEvent(nullptr,MSG_APPL_SHUTDOWN,nullptr,0);
+    EXPECT_EQ(oWriter.getWrites(),1UL);
+    EXPECT_NE(readLog(oWriter).find("[I] boot\n"),std::string::npos);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "FileUpload.h"
+#include "LSCUtils.h"
+#include <stdio.h>
+
+static const char *TEST_UPLOAD_FILE = "test_upload.txt";
+
+/// @brief Reads a whole file, empty if it does not exist.
+static String readFile(const char *pszFileName) {
+    String strContent;
+    FILE *pFile = fopen(pszFileName,"rb");
+    if(pFile) {
+        int nChar;
+        while((nChar = fgetc(pFile)) != EOF) strContent += (char) nChar;
+        fclose(pFile);
+    }
+    return(strContent);
+}
+
+static bool exists(const char *pszFileName) {
+    FILE *pFile = fopen(pszFileName,"rb");
+    if(pFile) fclose(pFile);
+    return(pFile != nullptr);
+}
+
+class CFileUploadTest : public ::testing::Test {
+    protected:
+        void TearDown() override {
+            remove(TEST_UPLOAD_FILE);
+        }
+};
+
+TEST_F(CFileUploadTest,testWritesPagesAndRenames) {
+    String strData;
+    for(int n = 0; n < 5000; n++) strData += (char) ('a' + n % 26);
+    CFileUpload oUpload;
+    ASSERT_TRUE(oUpload.begin(TEST_UPLOAD_FILE));
+    // Small TCP like chunks
+    for(size_t nPos = 0; nPos < strData.length(); nPos += 100) {
+        size_t nLen = std::min((size_t) 100,strData.length() - nPos);
+        EXPECT_TRUE(oUpload.write((const uint8_t *) strData.c_str() + nPos,nLen));
+    }
+    // Only full buffers have been written, the file is not replaced yet
+    EXPECT_EQ(oUpload.getWrites(),strData.length() / FILE_UPLOAD_BUFFER_SIZE);
+    EXPECT_FALSE(exists(TEST_UPLOAD_FILE));
+    String strTempPath = oUpload.getTempPath();
+    EXPECT_EQ(readFile(strTempPath.c_str()).length() % FILE_UPLOAD_PAGE_SIZE,0U);
+
+    ASSERT_TRUE(oUpload.finish());
+    EXPECT_EQ(readFile(TEST_UPLOAD_FILE),strData);
+    EXPECT_FALSE(exists(strTempPath.c_str()));
+    EXPECT_EQ(oUpload.getSize(),strData.length());
+    EXPECT_EQ(oUpload.getHash(),LSC::updateHash(LSC_HASH_START,strData.c_str(),strData.length()));
+}
+
+TEST_F(CFileUploadTest,testAbortKeepsOldFile) {
+    FILE *pFile = fopen(TEST_UPLOAD_FILE,"w");
+    ASSERT_NE(pFile,nullptr);
+    fputs("old",pFile);
+    fclose(pFile);
+    String strTempPath;
+    {
+        CFileUploads oUploads;
+        int nRequest = 0;
+        CFileUpload *pUpload = oUploads.begin(&nRequest,TEST_UPLOAD_FILE);
+        ASSERT_NE(pUpload,nullptr);
+        EXPECT_EQ(oUploads.get(&nRequest,TEST_UPLOAD_FILE),pUpload);
+        strTempPath = pUpload->getTempPath();
+        pUpload->write((const uint8_t *) "new",3);
+        // Released without finish() - like a disconnected request
+        EXPECT_FALSE(oUploads.release(&nRequest));
+        EXPECT_EQ(oUploads.get(&nRequest,TEST_UPLOAD_FILE),nullptr);
+    }
+    EXPECT_EQ(readFile(TEST_UPLOAD_FILE),"old");
+    EXPECT_FALSE(exists(strTempPath.c_str()));
+}
+
+TEST_F(CFileUploadTest,testUploadsPerOwner) {
+    CFileUploads oUploads;
+    int tRequests[FILE_UPLOAD_MAX + 1];
+    String tPaths[FILE_UPLOAD_MAX + 1];
+    for(int n = 0; n < FILE_UPLOAD_MAX; n++) {
+        tPaths[n] = "test_upload_" + std::to_string(n) + ".txt";
+        ASSERT_NE(oUploads.begin(&tRequests[n],tPaths[n].c_str()),nullptr);
+    }
+    EXPECT_EQ(oUploads.begin(&tRequests[FILE_UPLOAD_MAX],TEST_UPLOAD_FILE),nullptr);
+    EXPECT_EQ(oUploads.getActive(),(size_t) FILE_UPLOAD_MAX);
+    // Each request writes to its own file
+    for(int n = 0; n < FILE_UPLOAD_MAX; n++) {
+        oUploads.get(&tRequests[n],tPaths[n].c_str())->write((const uint8_t *) tPaths[n].c_str(),tPaths[n].length());
+    }
+    for(int n = 0; n < FILE_UPLOAD_MAX; n++) {
+        CFileUpload *pUpload = oUploads.get(&tRequests[n],tPaths[n].c_str());
+        EXPECT_TRUE(pUpload->finish());
+        oUploads.done(&tRequests[n],pUpload);
+        EXPECT_TRUE(oUploads.release(&tRequests[n]));
+        EXPECT_EQ(readFile(tPaths[n].c_str()),tPaths[n]);
+        remove(tPaths[n].c_str());
+    }
+    EXPECT_EQ(oUploads.getActive(),0U);
+    // The rejected request has failed
+    EXPECT_FALSE(oUploads.release(&tRequests[FILE_UPLOAD_MAX]));
+}
+
+TEST_F(CFileUploadTest,testConcurrentUploadsOfSamePath) {
+    CFileUploads oUploads;
+    int nRequest1 = 0, nRequest2 = 0;
+    CFileUpload *pUpload1 = oUploads.begin(&nRequest1,TEST_UPLOAD_FILE);
+    CFileUpload *pUpload2 = oUploads.begin(&nRequest2,TEST_UPLOAD_FILE);
+    ASSERT_NE(pUpload1,nullptr);
+    ASSERT_NE(pUpload2,nullptr);
+    EXPECT_STRNE(pUpload1->getTempPath(),pUpload2->getTempPath());
+    pUpload1->write((const uint8_t *) "first",5);
+    pUpload2->write((const uint8_t *) "second",6);
+    // The abort of one upload does not touch the data of the other
+    EXPECT_FALSE(oUploads.release(&nRequest1));
+    EXPECT_TRUE(pUpload2->finish());
+    EXPECT_EQ(readFile(TEST_UPLOAD_FILE),"second");
+    oUploads.done(&nRequest2,pUpload2);
+    EXPECT_TRUE(oUploads.release(&nRequest2));
+}
+
+TEST_F(CFileUploadTest,testSeveralFilesOfOneRequest) {
+    CFileUploads oUploads;
+    int nRequest = 0;
+    // More files than slots - each file frees its slot, when it is done
+    String tPaths[FILE_UPLOAD_MAX + 1];
+    for(int n = 0; n <= FILE_UPLOAD_MAX; n++) {
+        tPaths[n] = "test_upload_part" + std::to_string(n) + ".txt";
+        CFileUpload *pUpload = oUploads.begin(&nRequest,tPaths[n].c_str());
+        ASSERT_NE(pUpload,nullptr);
+        pUpload->write((const uint8_t *) tPaths[n].c_str(),tPaths[n].length());
+        // A running upload of the request is not aborted by the next file
+        if(n > 0) {
+            CFileUpload *pPrevious = oUploads.get(&nRequest,tPaths[n - 1].c_str());
+            ASSERT_NE(pPrevious,nullptr);
+            EXPECT_TRUE(pPrevious->finish());
+            oUploads.done(&nRequest,pPrevious);
+        }
+    }
+    CFileUpload *pLast = oUploads.get(&nRequest,tPaths[FILE_UPLOAD_MAX].c_str());
+    EXPECT_TRUE(pLast->finish());
+    oUploads.done(&nRequest,pLast);
+    EXPECT_TRUE(oUploads.release(&nRequest));
+    for(int n = 0; n <= FILE_UPLOAD_MAX; n++) {
+        EXPECT_EQ(readFile(tPaths[n].c_str()),tPaths[n]);
+        remove(tPaths[n].c_str());
+    }
+}
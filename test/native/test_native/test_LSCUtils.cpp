@@ -9,10 +9,41 @@ TEST(LSCUtils,testStringCompares) {
     EXPECT_NE(LSC::stricmp("This is Zulu","this is zulu2"),0);
 }
 
+TEST(LSCUtils,testListItems) {
+    EXPECT_TRUE(LSC::isInList(" wifi , MQTT","mqtt"));
+    EXPECT_FALSE(LSC::isInList("wifi,mqtt","wif"));
+    char szItem[5];
+    const char *pszNext = LSC::getListItem(" wifi , mqttclient,",szItem,sizeof(szItem));
+    EXPECT_STREQ(szItem,"wifi");
+    pszNext = LSC::getListItem(pszNext,szItem,sizeof(szItem));
+    EXPECT_STREQ(szItem,"mqtt");     // truncated
+    EXPECT_STREQ(pszNext,"");
+}
+
 TEST(LSCUtils,testSpecialCompares) {
     EXPECT_NE(LSC::stricmp("this is true","this no true"),0);
 }
 
+TEST(LSCUtils,testHashNoCaseIgnoresCase) {
+    EXPECT_EQ(LSC::getHashNoCase("WiFi"),LSC::getHashNoCase("wifi"));
+    EXPECT_NE(LSC::getHashNoCase("wifi"),LSC::getHashNoCase("wifi2"));
+    EXPECT_EQ(LSC::getHashNoCase(nullptr),0U);
+}
+
+TEST(LSCUtils,testHashIsCaseSensitive) {
+    EXPECT_NE(LSC::getHash("WiFi"),LSC::getHash("wifi"));
+    EXPECT_EQ(LSC::getHash("WIFI"),LSC::getHashNoCase("wifi"));
+    EXPECT_EQ(LSC::getHash(nullptr),0U);
+}
+
+TEST(LSCUtils,testUpdateHashInParts) {
+    const char *pszData = "Hello world";
+    EXPECT_EQ(LSC::updateHash(LSC_HASH_START,pszData,strlen(pszData)),LSC::getHash(pszData));
+    uint32_t ulHash = LSC::updateHash(LSC_HASH_START,pszData,5);
+    EXPECT_EQ(LSC::updateHash(ulHash,pszData + 5,strlen(pszData) - 5),LSC::getHash(pszData));
+    EXPECT_EQ(LSC::updateHash(LSC_HASH_START,pszData,0),(uint32_t) LSC_HASH_START);
+}
+
 TEST(LSCUtils,testIsPositiveNumber) {
     EXPECT_TRUE(LSC::isNumber("55"));
     EXPECT_TRUE(LSC::isNumber("5.54"));
@@ -0,0 +1,57 @@
+// Floor of this module: info is kept, verbose and trace are removed by the preprocessor
+#define LOG_MODULE_LEVEL_FLOOR  LOG_CLASS_NO_INFO
+#define TRACE
+#include <gtest/gtest.h>
+#include <vector>
+#include "ApplLogging.h"
+
+/// @brief Writer that keeps the written entries.
+class CFloorLogWriter : public CLogWriter {
+    public:
+        std::vector<String> Entries;
+        void writeLogEntry(const char *pszType, const char *pszMessage) override {
+            Entries.push_back(String(pszType) + ":" + pszMessage);
+        }
+};
+
+/// @brief Stand-in for the application, the ApplLog macros write to Appl.Log.
+struct CFloorTestAppl {
+    CEventHandler   MsgBus;
+    CEventLogger    Log;
+    CFloorLogWriter Writer;
+    CFloorTestAppl() : Log(&MsgBus) {
+        Writer.setLogLevel(9);
+        MsgBus.registerEventReceiver(&Writer,"floor");
+    }
+};
+
+static int nEvaluated = 0;
+static int countEvaluation() { return(++nEvaluated); }
+
+TEST(CLogFloor,testCallsAboveFloorAreRemoved) {
+    CFloorTestAppl Appl;
+    CFloorLogWriter &oWriter = Appl.Writer;
+    nEvaluated = 0;
+
+    ApplLogVerbose("verbose");
+    ApplLogVerboseWithParms("verbose %d",countEvaluation());
+    ApplLogTrace("trace");
+    ApplLogTraceWithParms("trace %d",countEvaluation());
+    EXPECT_EQ(nEvaluated,0);
+    EXPECT_EQ(oWriter.Entries.size(),0U);
+
+    ApplLogInfo("info");
+    ApplLogInfoWithParms("info %d",countEvaluation());
+    ApplLogWarnWithParms("warn %d",countEvaluation());
+    ApplLogErrorWithParms("error %d",countEvaluation());
+    EXPECT_EQ(nEvaluated,3);
+    ASSERT_EQ(oWriter.Entries.size(),4U);
+    EXPECT_STREQ(oWriter.Entries[0].c_str(),"I:info");
+    EXPECT_STREQ(oWriter.Entries[1].c_str(),"I:info 1");
+    EXPECT_STREQ(oWriter.Entries[2].c_str(),"W:warn 2");
+    EXPECT_STREQ(oWriter.Entries[3].c_str(),"E:error 3");
+
+    // The floor removes the calls, not the classes - the logger still writes them
+    Appl.Log.log("V","direct %d",1);
+    EXPECT_EQ(oWriter.Entries.size(),5U);
+}
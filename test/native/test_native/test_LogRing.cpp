@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <thread>
+#include "Logging.h"
+
+/// @brief Writer that keeps the written entries.
+class CRingTestWriter : public CLogWriter {
+    public:
+        std::vector<String> Entries;
+        CEventLogger *pLog = nullptr;      // Logs while writing, if set
+        void writeLogEntry(const char *pszType, const char *pszMessage) override {
+            Entries.push_back(String(pszType) + ":" + pszMessage);
+            if(pLog) pLog->log("I","written %d",(int) Entries.size());
+        }
+};
+
+TEST(CLogRing,testQueuesUntilDrained) {
+    CEventHandler oBus;
+    CLogRing oRing(&oBus);
+    CEventLogger oLog(&oBus,&oRing);
+    CRingTestWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    oBus.registerEventReceiver(&oRing,"ring");
+
+    oLog.log("I","value %d",1);
+    oLog.log("E","error %s","x");
+    oLog.log("T","filtered");
+    EXPECT_EQ(oWriter.Entries.size(),0U);
+    EXPECT_EQ(oRing.size(),2U);
+
+    oBus.sendEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    ASSERT_EQ(oWriter.Entries.size(),2U);
+    EXPECT_STREQ(oWriter.Entries[0].c_str(),"I:value 1");
+    EXPECT_STREQ(oWriter.Entries[1].c_str(),"E:error x");
+    EXPECT_EQ(oRing.size(),0U);
+    EXPECT_EQ(oRing.getWritten(),2UL);
+}
+
+TEST(CLogRing,testOverflowPolicies) {
+    CEventHandler oBus;
+    CRingTestWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    for(LogRingPolicy ePolicy : { LOG_RING_DROP_OLDEST, LOG_RING_DROP_NEW, LOG_RING_BLOCK }) {
+        oWriter.Entries.clear();
+        CLogRing oRing(&oBus);
+        oRing.setPolicy(ePolicy);
+        for(int n = 0; n < LOG_RING_SIZE + 2; n++) {
+            oRing.push('I',std::to_string(n).c_str());
+        }
+        oRing.flush();
+        if(ePolicy == LOG_RING_BLOCK) {
+            ASSERT_EQ(oWriter.Entries.size(),(size_t) LOG_RING_SIZE + 2);
+            EXPECT_EQ(oRing.getDropped(),0UL);
+            EXPECT_EQ(oRing.getBlocked(),2UL);
+            EXPECT_STREQ(oWriter.Entries[0].c_str(),"I:0");
+        } else {
+            ASSERT_EQ(oWriter.Entries.size(),(size_t) LOG_RING_SIZE);
+            EXPECT_EQ(oRing.getDropped(),2UL);
+            EXPECT_STREQ(oWriter.Entries[0].c_str(),ePolicy == LOG_RING_DROP_OLDEST ? "I:2" : "I:0");
+        }
+        EXPECT_EQ(oRing.getHighWater(),(size_t) LOG_RING_SIZE);
+    }
+}
+
+TEST(CLogRing,testTruncatesLongEntries) {
+    CEventHandler oBus;
+    CLogRing oRing(&oBus);
+    CEventLogger oLog(&oBus,&oRing);
+    CRingTestWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    String strLong(LOG_RING_TEXT_SIZE + 10,'x');
+    oLog.log("I","%s",strLong.c_str());
+    oRing.flush();
+    ASSERT_EQ(oWriter.Entries.size(),1U);
+    EXPECT_EQ(oWriter.Entries[0].length(),(size_t) LOG_RING_TEXT_SIZE - 1 + 2);
+    EXPECT_EQ(oRing.getTruncated(),1UL);
+}
+
+TEST(CLogRing,testWriterLogsAreQueuedForNextDrain) {
+    CEventHandler oBus;
+    CLogRing oRing(&oBus);
+    oRing.setPolicy(LOG_RING_BLOCK);
+    CEventLogger oLog(&oBus,&oRing);
+    oLog.Suppressor.setWindow(0);
+    CRingTestWriter oWriter;
+    oWriter.pLog = &oLog;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    oLog.log("I","first");
+    EXPECT_EQ(oRing.drain(),1U);
+    EXPECT_EQ(oWriter.Entries.size(),1U);
+    EXPECT_EQ(oRing.size(),1U);
+    EXPECT_EQ(oRing.drain(),1U);
+    EXPECT_STREQ(oWriter.Entries[1].c_str(),"I:written 1");
+
+    JsonNode oStatus;
+    oRing.writeStatusTo(oStatus);
+    EXPECT_EQ(oStatus.getValueAsInt("written"),3);
+    EXPECT_EQ(oStatus.getValueAsInt("policy"),(int) LOG_RING_BLOCK);
+}
+
+TEST(CLogRing,testSuppressionFromSeveralTasks) {
+    CEventHandler oBus;
+    CLogRing oRing(&oBus);
+    CEventLogger oLog(&oBus,&oRing);
+    oLog.Suppressor.setWindow(60000);
+    CRingTestWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    // The suppression table is checked inside the ring lock - no repeat is lost
+    std::vector<std::thread> tTasks;
+    for(int nTask = 0; nTask < 4; nTask++) {
+        tTasks.emplace_back([&oLog]() {
+            for(int n = 0; n < 500; n++) oLog.log("I","flood %d",n);
+        });
+    }
+    for(std::thread &oTask : tTasks) oTask.join();
+    EXPECT_EQ(oRing.size(),1U);
+    EXPECT_EQ(oLog.Suppressor.getSuppressed(),1999UL);
+}
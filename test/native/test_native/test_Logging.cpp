@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "Logging.h"
+
+/// @brief Writer that keeps the written entries.
+class CTestLogWriter : public CLogWriter {
+    public:
+        std::vector<String> Entries;
+        void writeLogEntry(const char *pszType, const char *pszMessage) override {
+            Entries.push_back(String(pszType) + ":" + pszMessage);
+        }
+};
+
+/// @brief Receiver that counts the log records on the message bus.
+class CLogRecordCounter : public IMsgEventReceiver {
+    public:
+        int Records   = 0;
+        int Formatted = 0;
+        int receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nClass) override {
+            if(nMsg == MSG_LOG_RECORD) {
+                Records++;
+                if(((CLogRecord *) pMessage)->isFormatted()) Formatted++;
+            }
+            return(EVENT_MSG_RESULT_OK);
+        }
+};
+
+TEST(CEventLogger,testLogClassNumbers) {
+    EXPECT_EQ(CEventLogger::getLogClassNumberFrom('I'),1);
+    EXPECT_EQ(CEventLogger::getLogClassNumberFrom('W'),6);
+    EXPECT_EQ(CEventLogger::getLogClassNumberFrom('X'),9);
+    EXPECT_EQ(CEventLogger::getLogClassNumberFrom('?'),0);
+}
+
+TEST(CEventLogger,testDropsClassesWithoutWriter) {
+    CEventHandler oBus;
+    CEventLogger oLog(&oBus);
+    CLogRecordCounter oCounter;
+    oBus.registerEventReceiver(&oCounter,"counter");
+    oLog.log("I","no writer %d",1);
+    EXPECT_EQ(oCounter.Records,0);
+
+    CTestLogWriter oWriter;
+    oWriter.setLogLevel(2);
+    EXPECT_TRUE(CEventLogger::isClassEnabled('I'));
+    EXPECT_TRUE(CEventLogger::isClassEnabled('E'));
+    EXPECT_FALSE(CEventLogger::isClassEnabled('T'));
+    oLog.log("T","filtered %d",1);
+    EXPECT_EQ(oCounter.Records,0);
+    oLog.log("W","always %d",1);
+    EXPECT_EQ(oCounter.Records,1);
+
+    oWriter.setLogLevel(9);
+    EXPECT_TRUE(CEventLogger::isClassEnabled('T'));
+}
+
+TEST(CEventLogger,testWritersFormatRecordOnce) {
+    CEventHandler oBus;
+    CEventLogger oLog(&oBus);
+    CTestLogWriter oWriter1;
+    CTestLogWriter oWriter2;
+    oWriter2.setLogLevel(0);
+    oBus.registerEventReceiver(&oWriter1,"writer1");
+    oBus.registerEventReceiver(&oWriter2,"writer2");
+    CLogRecordCounter oCounter;
+    oBus.registerEventReceiver(&oCounter,"counter");
+
+    oLog.log("I","value %d of %s",42,"test");
+    ASSERT_EQ(oWriter1.Entries.size(),1U);
+    EXPECT_STREQ(oWriter1.Entries[0].c_str(),"I:value 42 of test");
+    EXPECT_EQ(oWriter2.Entries.size(),0U);
+    EXPECT_EQ(oCounter.Formatted,1);
+
+    oLog.log("E","error %s","both");
+    ASSERT_EQ(oWriter2.Entries.size(),1U);
+    EXPECT_STREQ(oWriter1.Entries[1].c_str(),"E:error both");
+    EXPECT_STREQ(oWriter2.Entries[0].c_str(),"E:error both");
+}
+
+TEST(CEventLogger,testWriterStillAcceptsTextEntries) {
+    CEventHandler oBus;
+    CTestLogWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    oBus.sendEvent(nullptr,MSG_LOG_ENTRY,"direct",'I');
+    oBus.sendEvent(nullptr,MSG_LOG_ENTRY,"trace",'T');
+    ASSERT_EQ(oWriter.Entries.size(),1U);
+    EXPECT_STREQ(oWriter.Entries[0].c_str(),"I:direct");
+}
+
+/// @brief Writer that renders structured entries as JSON.
+class CJsonTestLogWriter : public CLogWriter {
+    public:
+        std::vector<String> Entries;
+        void writeLogRecord(const char *pszType, CLogRecord *pRecord) override {
+            char szJson[256];
+            if(pRecord->getFields()) pRecord->getFields()->renderJson(szJson,sizeof(szJson));
+            else                     snprintf(szJson,sizeof(szJson),"%s",pRecord->getText());
+            Entries.push_back(szJson);
+        }
+};
+
+TEST(CEventLogger,testStructuredEntries) {
+    CEventHandler oBus;
+    CEventLogger oLog(&oBus);
+    CTestLogWriter oTextWriter;
+    CJsonTestLogWriter oJsonWriter;
+    oBus.registerEventReceiver(&oTextWriter,"text");
+    oBus.registerEventReceiver(&oJsonWriter,"json");
+    String strHost("broker");
+    oLog.logKV("W","mqtt_disconnect","reason",3,"uptime",123456UL,"host",strHost,"retry",true,"load",0.5f,"note","a \"b\"\n");
+    ASSERT_EQ(oTextWriter.Entries.size(),1U);
+    EXPECT_STREQ(oTextWriter.Entries[0].c_str(),"W:mqtt_disconnect reason=3 uptime=123456 host=\"broker\" retry=true load=0.5 note=\"a \"b\"\n\"");
+    ASSERT_EQ(oJsonWriter.Entries.size(),1U);
+    EXPECT_STREQ(oJsonWriter.Entries[0].c_str(),"{\"event\":\"mqtt_disconnect\",\"reason\":3,\"uptime\":123456,\"host\":\"broker\",\"retry\":true,\"load\":0.5,\"note\":\"a \\\"b\\\"\\n\"}");
+
+    JsonNode oParsed;
+    oParsed.parse(oJsonWriter.Entries[0].c_str());
+    EXPECT_EQ(oParsed.getValueAsInt("reason"),3);
+    EXPECT_STREQ(oParsed.getValue("host"),"broker");
+
+    oLog.logKV("T","filtered","n",1);
+    EXPECT_EQ(oTextWriter.Entries.size(),1U);
+}
+
+TEST(CEventLogger,testSuppressionIsOffByDefault) {
+    CEventHandler oBus;
+    CEventLogger oLog(&oBus);
+    CTestLogWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    for(int n = 0; n < 3; n++) oLog.log("W","retry %d",n);
+    ASSERT_EQ(oWriter.Entries.size(),3U);
+    EXPECT_STREQ(oWriter.Entries[2].c_str(),"W:retry 2");
+    EXPECT_EQ(oLog.Suppressor.getSuppressed(),0UL);
+}
+
+TEST(CEventLogger,testSuppressesRepeats) {
+    CEventHandler oBus;
+    CEventLogger oLog(&oBus);
+    oLog.Suppressor.setWindow(50);
+    CTestLogWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    for(int n = 0; n < 5; n++) oLog.log("W","retry %d",n);
+    oLog.log("E","other");
+    ASSERT_EQ(oWriter.Entries.size(),2U);
+    EXPECT_STREQ(oWriter.Entries[0].c_str(),"W:retry 0");
+    EXPECT_EQ(oLog.Suppressor.getSuppressed(),4UL);
+
+    oLog.flushRepeats();
+    EXPECT_EQ(oWriter.Entries.size(),2U);
+    delay(60);
+    oLog.flushRepeats();
+    ASSERT_EQ(oWriter.Entries.size(),3U);
+    EXPECT_STREQ(oWriter.Entries[2].c_str(),"W:last message repeated 4 times");
+    oLog.log("W","retry %d",9);
+    EXPECT_STREQ(oWriter.Entries[3].c_str(),"W:retry 9");
+}
+
+TEST(CEventLogger,testSamplesPerClass) {
+    CEventHandler oBus;
+    CEventLogger oLog(&oBus);
+    oLog.Suppressor.setWindow(0);
+    oLog.Suppressor.setSampling('I',4);
+    CTestLogWriter oWriter;
+    oBus.registerEventReceiver(&oWriter,"writer");
+    for(int n = 0; n < 8; n++) {
+        oLog.log("I","sample %d",n);
+        oLog.log("E","error %d",n);
+    }
+    ASSERT_EQ(oWriter.Entries.size(),10U);
+    EXPECT_STREQ(oWriter.Entries[0].c_str(),"I:sample 0");
+    EXPECT_EQ(oLog.Suppressor.getSampledOut(),6UL);
+}
+
+TEST(CLogFields,testTruncatesAndLimitsFields) {
+    CLogFields oFields("event");
+    for(int n = 0; n < LOG_KV_MAX_FIELDS + 2; n++) oFields.set("n",n);
+    EXPECT_EQ(oFields.getCount(),(size_t) LOG_KV_MAX_FIELDS);
+    char szText[16];
+    size_t nLen = oFields.renderText(szText,sizeof(szText));
+    EXPECT_GT(nLen,sizeof(szText));
+    EXPECT_EQ(strlen(szText),sizeof(szText) - 1);
+    EXPECT_EQ(strncmp(szText,"event n=0 n=1 n",sizeof(szText) - 1),0);
+    char szFull[256];
+    oFields.renderText(szFull,sizeof(szFull));
+    EXPECT_NE(strstr(szFull,"(+2 fields)"),nullptr);
+}
+
+TEST(CLogFields,testSixtyFourBitValues) {
+    CLogFields oFields("counters");
+    oFields.add("ll",(long long) -5000000000LL,"i64",(int64_t) INT64_MIN,"u64",(uint64_t) UINT64_MAX,"ull",6000000000ULL);
+    ASSERT_EQ(oFields.getCount(),4U);
+    char szText[128];
+    oFields.renderText(szText,sizeof(szText));
+    EXPECT_STREQ(szText,"counters ll=-5000000000 i64=-9223372036854775808 u64=18446744073709551615 ull=6000000000");
+    oFields.renderJson(szText,sizeof(szText));
+    EXPECT_STREQ(szText,"{\"event\":\"counters\",\"ll\":-5000000000,\"i64\":-9223372036854775808,\"u64\":18446744073709551615,\"ull\":6000000000}");
+}
@@ -2,6 +2,8 @@
 #include <gtest/gtest.h>
 #include "MQTTController.h"
 #include "WebSocket.h"
+#include "Base64Data.h"
+#include <chrono>
 
 TEST(CWebSocketMessage,testConstructorAllocatesZeroTerminatedBuffer) {
     CWebSocketMessage oMessage(nullptr,nullptr,5,WS_TEXT);
@@ -33,6 +35,325 @@ TEST(CWebSocketMessage,testSetMessageDataIgnoresOverflowSegment) {
     EXPECT_STREQ(oMessage.pSerializedMessage,"Hello");
 }
 
+TEST(CWebSocketMessage,testMessagesComeFromPools) {
+    CBufferPool &oBuffers = CWebSocketMessage::getBufferPool();
+    CBufferPool &oObjects = CWebSocketMessage::getObjectPool();
+    size_t nFreeBuffers = oBuffers.getFree();
+    size_t nFreeObjects = oObjects.getFree();
+    CWebSocketMessage *pMessage = new CWebSocketMessage(nullptr,nullptr,300,WS_TEXT);
+    EXPECT_TRUE(oObjects.isPoolBuffer(pMessage));
+    EXPECT_TRUE(oBuffers.isPoolBuffer(pMessage->pSerializedMessage));
+    EXPECT_EQ(oBuffers.getFree(),nFreeBuffers - 1);
+    EXPECT_EQ(pMessage->pSerializedMessage[300],'\0');
+    delete(pMessage);
+    EXPECT_EQ(oBuffers.getFree(),nFreeBuffers);
+    EXPECT_EQ(oObjects.getFree(),nFreeObjects);
+
+    unsigned long ulOversized = oBuffers.getOversized();
+    CWebSocketMessage oHuge(nullptr,nullptr,20000,WS_BINARY);
+    EXPECT_FALSE(oBuffers.isPoolBuffer(oHuge.pSerializedMessage));
+    EXPECT_EQ(oBuffers.getOversized(),ulOversized + 1);
+}
+
+TEST(CWebSocketQuotas,testLimitsQueuedMessagesPerClient) {
+    CWebSocketQuotas oQuotas;
+    oQuotas.setLimits(2,100);
+    EXPECT_TRUE(oQuotas.reserve(1,40));
+    EXPECT_TRUE(oQuotas.reserve(1,40));
+    EXPECT_FALSE(oQuotas.reserve(1,10));        // message quota
+    EXPECT_TRUE(oQuotas.reserve(2,90));         // other client has its own quota
+    oQuotas.release(1,40);
+    EXPECT_FALSE(oQuotas.reserve(1,70));        // byte quota
+    EXPECT_TRUE(oQuotas.reserve(1,20));
+    EXPECT_FALSE(oQuotas.reserve(2,WS_MAX_MESSAGE_SIZE + 1));
+    ASSERT_NE(oQuotas.getClient(1),nullptr);
+    EXPECT_EQ(oQuotas.getClient(1)->Dropped,2UL);
+    EXPECT_EQ(oQuotas.getClient(1)->Bytes,60U);
+    EXPECT_EQ(oQuotas.getClient(2)->Oversized,1UL);
+
+    JsonNode oStatus;
+    oQuotas.writeStatusTo(oStatus);
+    EXPECT_EQ(oStatus.getObject("1")->getValueAsInt("queued"),2);
+    EXPECT_EQ(oStatus.getObject("2")->getValueAsInt("oversized"),1);
+}
+
+TEST(CWebSocketQuotas,testReusesSlotsOfDisconnectedClients) {
+    CWebSocketQuotas oQuotas;
+    for(uint32_t ulId = 1; ulId <= WS_QUOTA_CLIENTS; ulId++) EXPECT_TRUE(oQuotas.reserve(ulId,1));
+    EXPECT_FALSE(oQuotas.reserve(100,1));
+    EXPECT_EQ(oQuotas.getRejected(),1UL);
+    oQuotas.disconnect(1);
+    EXPECT_FALSE(oQuotas.reserve(100,1));       // Message of client 1 is still queued
+    oQuotas.release(1,1);
+    EXPECT_TRUE(oQuotas.reserve(100,1));
+    EXPECT_EQ(oQuotas.getClient(1),nullptr);
+}
+
+TEST(CWebSocketQuotas,testClientIdsOfConnectedClients) {
+    CWebSocketQuotas oQuotas;
+    EXPECT_TRUE(oQuotas.connect(7));
+    EXPECT_TRUE(oQuotas.connect(9));
+    EXPECT_TRUE(oQuotas.connect(7));            // Keeps its slot
+    EXPECT_TRUE(oQuotas.reserve(7,10));
+    uint32_t tIds[WS_QUOTA_CLIENTS];
+    ASSERT_EQ(oQuotas.getClientIds(tIds,WS_QUOTA_CLIENTS),2U);
+    EXPECT_EQ(tIds[0],7U);
+    EXPECT_EQ(tIds[1],9U);
+    EXPECT_EQ(oQuotas.getClientIds(tIds,1),1U);
+    oQuotas.disconnect(7);
+    ASSERT_EQ(oQuotas.getClientIds(tIds,WS_QUOTA_CLIENTS),1U);
+    EXPECT_EQ(tIds[0],9U);
+}
+
+TEST(CWebSocketAuthSessions,testSessionIsBoundToTokenIPAndLifetime) {
+    CWebSocketAuthSessions oSessions;
+    EXPECT_FALSE(oSessions.check(1,"token-1234567","10.0.0.1"));
+    oSessions.store(1,"token-1234567","10.0.0.1",millis(),1000);
+    EXPECT_TRUE(oSessions.check(1,"token-1234567","10.0.0.1"));
+    EXPECT_FALSE(oSessions.check(1,"token-1234568","10.0.0.1"));    // other token
+    EXPECT_FALSE(oSessions.check(1,"token-1234567","10.0.0.2"));    // other IP
+    EXPECT_FALSE(oSessions.check(2,"token-1234567","10.0.0.1"));    // other client
+    EXPECT_EQ(oSessions.getHits(),1UL);
+    EXPECT_EQ(oSessions.getMisses(),4UL);
+    EXPECT_TRUE(oSessions.isAuthenticated(1));
+    EXPECT_FALSE(oSessions.isAuthenticated(2));
+    // Expired token
+    oSessions.store(3,"token-1234567","10.0.0.1",millis() - 2000,1000);
+    EXPECT_FALSE(oSessions.check(3,"token-1234567","10.0.0.1"));
+    EXPECT_FALSE(oSessions.isAuthenticated(3));
+    // Disconnect
+    oSessions.invalidate(1);
+    EXPECT_FALSE(oSessions.check(1,"token-1234567","10.0.0.1"));
+    EXPECT_EQ(oSessions.getSessions(),1U);
+}
+
+TEST(CWebSocketAuthSessions,testClientIdsOfValidSessions) {
+    CWebSocketAuthSessions oSessions;
+    oSessions.store(3,"token-of-client-3","10.0.0.3",millis(),60000);
+    oSessions.store(4,"token-of-client-4","10.0.0.4",millis(),60000);
+    oSessions.store(5,"token-of-client-5","10.0.0.5",millis() - 2000,1000);   // expired
+    uint32_t tIds[WS_AUTH_SESSIONS];
+    ASSERT_EQ(oSessions.getClientIds(tIds,WS_AUTH_SESSIONS),2U);
+    EXPECT_EQ(tIds[0],3U);
+    EXPECT_EQ(tIds[1],4U);
+    oSessions.invalidate(3);
+    ASSERT_EQ(oSessions.getClientIds(tIds,WS_AUTH_SESSIONS),1U);
+    EXPECT_EQ(tIds[0],4U);
+}
+
+TEST(CWebSocketAuthSessions,testReplacesOldestSessionWhenFull) {
+    CWebSocketAuthSessions oSessions;
+    unsigned long ulNow = millis();
+    for(uint32_t ulId = 1; ulId <= WS_AUTH_SESSIONS; ulId++) {
+        oSessions.store(ulId,"token-1234567","10.0.0.1",ulNow - 100 + ulId,60000);
+    }
+    oSessions.store(100,"token-1234567","10.0.0.1",ulNow,60000);
+    EXPECT_EQ(oSessions.getSessions(),(size_t) WS_AUTH_SESSIONS);
+    EXPECT_FALSE(oSessions.check(1,"token-1234567","10.0.0.1"));
+    EXPECT_TRUE(oSessions.check(2,"token-1234567","10.0.0.1"));
+    EXPECT_TRUE(oSessions.check(100,"token-1234567","10.0.0.1"));
+}
+
+/**
+ * @brief Validates a token like CAccessToken does (base64, JSON, base64, JSON).
+ * The AES decryption needs the platform crypto library, so the native test
+ * validates the token without it.
+ */
+static bool decodeTestToken(const char *pszToken, const char *pszIPAddress, unsigned long &ulTimeStamp) {
+    char szBuffer[strlen(pszToken) * 2];
+    CBase64Data::base64DecodeData(pszToken,strlen(pszToken),szBuffer,sizeof(szBuffer));
+    CJsonNode oToken;
+    oToken.parse(szBuffer);
+    const char *pszData = oToken.getValue("Data","");
+    char szData[256] = {0};
+    CBase64Data::base64DecodeData(pszData,strlen(pszData),szData,sizeof(szData));
+    CJsonNode oData;
+    oData.parse(szData);
+    ulTimeStamp = strtoul(oData.getValue("TS","0"),0,10);
+    return(strcmp(oData.getValue("IP",""),pszIPAddress) == 0 && millis() - ulTimeStamp < 60000);
+}
+
+/// @brief Creates a token with the structure of CAccessToken: base64({"IV":...,"Data":base64({"TS":...,"IP":...,"T":...})})
+static String createTestToken(const char *pszIPAddress) {
+    char szData[128];
+    snprintf(szData,sizeof(szData),"{\"TS\":%lu,\"IP\":\"%s\",\"T\":\"0123456789012345\"}",millis(),pszIPAddress);
+    char szData64[256];
+    CBase64Data::base64EncodeData(szData,strlen(szData),szData64,sizeof(szData64),true);
+    char szToken[384];
+    snprintf(szToken,sizeof(szToken),"{\"IV\":\"AAECAwQFBgcICQoLDA0ODw==\",\"Data\":\"%s\"}",szData64);
+    char szToken64[640];
+    CBase64Data::base64EncodeData(szToken,strlen(szToken),szToken64,sizeof(szToken64),true);
+    return(String(szToken64));
+}
+
+TEST(CWebSocketAuthSessions,testAuthenticateValidatesOnce) {
+    String strToken = createTestToken("192.168.1.20");
+    CWebSocketAuthSessions oSessions;
+    int nValidations = 0;
+    auto fnValidate = [&nValidations](const char *pszToken, const char *pszIPAddress, unsigned long &ulTimeStamp) {
+        nValidations++;
+        return(decodeTestToken(pszToken,pszIPAddress,ulTimeStamp));
+    };
+    for(int n = 0; n < 100; n++) {
+        EXPECT_TRUE(oSessions.authenticate(1,strToken.c_str(),"192.168.1.20",60000,fnValidate));
+    }
+    EXPECT_EQ(nValidations,1);
+    EXPECT_EQ(oSessions.getHits(),99UL);
+    EXPECT_EQ(oSessions.getSessions(),1U);
+
+    // Another IP validates the token again, the failed validation removes the session
+    EXPECT_FALSE(oSessions.authenticate(1,strToken.c_str(),"192.168.1.21",60000,fnValidate));
+    EXPECT_EQ(nValidations,2);
+    EXPECT_EQ(oSessions.getSessions(),0U);
+
+    // Short tokens are rejected without a validation
+    EXPECT_FALSE(oSessions.authenticate(1,"short","192.168.1.20",60000,fnValidate));
+    EXPECT_EQ(nValidations,2);
+}
+
+/// @brief Measures nCommands calls of authenticate() in micro seconds, without a session cache each call validates the token.
+static long long measureAuthenticate(const char *pszToken, bool bCached, int nCommands) {
+    CWebSocketAuthSessions oSessions;
+    int nAuthenticated = 0;
+    auto tStart = std::chrono::steady_clock::now();
+    for(int n = 0; n < nCommands; n++) {
+        if(!bCached) oSessions.invalidate(1);
+        if(oSessions.authenticate(1,pszToken,"192.168.1.20",60000,decodeTestToken)) nAuthenticated++;
+    }
+    auto tDuration = std::chrono::steady_clock::now() - tStart;
+    EXPECT_EQ(nAuthenticated,nCommands);
+    return(std::chrono::duration_cast<std::chrono::microseconds>(tDuration).count());
+}
+
+TEST(CWebSocketAuthSessions,benchmarkAuthenticate) {
+    String strToken = createTestToken("192.168.1.20");
+    const int nCommands = 5000;
+    // The times are written to the test report (--gtest_output), they are not asserted
+    RecordProperty("validated_us",(int) measureAuthenticate(strToken.c_str(),false,nCommands));
+    RecordProperty("cached_us",   (int) measureAuthenticate(strToken.c_str(),true, nCommands));
+}
+
+/// @brief Command handler that remembers the last command.
+class CTestCommandHandler : public IWebSocketCommandHandler {
+    public:
+        int  LastCommandId = 0;
+        bool LastAuthenticated = false;
+        bool onWebSocketCommand(int nCommandId, JsonNode &oRequest, CWebSocketMessage *pMessage, bool bAuthenticated) override {
+            LastCommandId     = nCommandId;
+            LastAuthenticated = bAuthenticated;
+            return(true);
+        }
+};
+
+TEST(CWebSocketCommands,testFindsCommandsCaseInsensitive) {
+    CWebSocketCommands oCommands;
+    CTestCommandHandler oHandler;
+    oCommands.registerCommand("getstatus",&oHandler,1);
+    oCommands.registerCommand("setLight",&oHandler,2,true);
+    ASSERT_NE(oCommands.find("GetStatus"),nullptr);
+    EXPECT_EQ(oCommands.find("GetStatus")->CommandId,1);
+    EXPECT_EQ(oCommands.find("setlight")->pHandler,&oHandler);
+    EXPECT_EQ(oCommands.find("getstat"),nullptr);
+    EXPECT_TRUE(oCommands.find("setlight")->NeedsAuth);
+    EXPECT_FALSE(oCommands.find("getstatus")->NeedsAuth);
+    // Replace an existing command
+    oCommands.registerCommand("GETSTATUS",&oHandler,3);
+    EXPECT_EQ(oCommands.find("getstatus")->CommandId,3);
+}
+
+TEST(CWebSocketCommands,testAuthListMatchesWholeNames) {
+    CWebSocketCommands oCommands;
+    CTestCommandHandler oHandler;
+    oCommands.registerCommand("restart",&oHandler,1);
+    oCommands.registerCommand("reset",&oHandler,2);
+    EXPECT_TRUE(oCommands.find("restart")->NeedsAuth);
+    EXPECT_FALSE(oCommands.find("reset")->NeedsAuth);       // only a substring of "factoryreset"
+    EXPECT_TRUE(oCommands.needsAuth("FactoryReset"));
+    EXPECT_FALSE(oCommands.needsAuth("start"));
+    oCommands.setNeedsAuth(" reset , other");
+    EXPECT_FALSE(oCommands.find("restart")->NeedsAuth);
+    EXPECT_TRUE(oCommands.find("reset")->NeedsAuth);
+    EXPECT_TRUE(oCommands.needsAuth("other"));
+    EXPECT_FALSE(CWebSocketCommands::isInList("",""));
+}
+
+TEST(CWebSocketCommands,testAuthListKeepsRegisteredAuth) {
+    CWebSocketCommands oCommands;
+    CTestCommandHandler oHandler;
+    oCommands.registerCommand("getlog",&oHandler,1,true);
+    oCommands.registerCommand("getstatus",&oHandler,2);
+    oCommands.setNeedsAuth("getstatus");
+    EXPECT_TRUE(oCommands.find("getlog")->NeedsAuth);
+    EXPECT_TRUE(oCommands.needsAuth("getlog"));
+    EXPECT_TRUE(oCommands.find("getstatus")->NeedsAuth);
+    oCommands.setNeedsAuth("");
+    EXPECT_TRUE(oCommands.find("getlog")->NeedsAuth);
+    EXPECT_FALSE(oCommands.find("getstatus")->NeedsAuth);
+}
+
+TEST(CWebSocketCommands,testFindsNamesOfBinaryCommandIds) {
+    CWebSocketCommands oCommands;
+    CTestCommandHandler oHandler;
+    oCommands.registerCommand("getstatus",&oHandler,1);
+    EXPECT_STREQ(oCommands.getName(WebSocketBinaryHeader::getCommandId("GetStatus")),"getstatus");
+    EXPECT_EQ(oCommands.getName(WebSocketBinaryHeader::getCommandId("getconfig")),nullptr);
+    EXPECT_EQ(oCommands.getName(0),nullptr);
+}
+
+TEST(WebSocketBinaryHeader,testWriteAndRead) {
+    WebSocketBinaryHeader oHeader;
+    oHeader.Flags     = WS_BINARY_FLAG_RESPONSE;
+    oHeader.CommandId = WebSocketBinaryHeader::getCommandId("update");
+    oHeader.Sequence  = 0x1234;
+    uint8_t tBuffer[WS_BINARY_HEADER_SIZE];
+    oHeader.write(tBuffer);
+    EXPECT_EQ(tBuffer[0],WS_BINARY_MAGIC);
+    EXPECT_EQ(tBuffer[6],0x12);
+    EXPECT_EQ(tBuffer[7],0x34);
+
+    WebSocketBinaryHeader oRead;
+    ASSERT_TRUE(oRead.read(tBuffer,sizeof(tBuffer)));
+    EXPECT_EQ(oRead.Flags,WS_BINARY_FLAG_RESPONSE);
+    EXPECT_EQ(oRead.CommandId,oHeader.CommandId);
+    EXPECT_EQ(oRead.Sequence,0x1234);
+    // Too short, or no binary message (i.E. a stream fragment)
+    EXPECT_FALSE(oRead.read(tBuffer,WS_BINARY_HEADER_SIZE - 1));
+    tBuffer[0] = '@';
+    EXPECT_FALSE(oRead.read(tBuffer,sizeof(tBuffer)));
+}
+
+TEST(CWebSocketProtocols,testHandshakeSelectsBinaryClients) {
+    CWebSocketProtocols oProtocols;
+    EXPECT_TRUE(CWebSocketProtocols::isRequested("json, lsc.cbor"));
+    EXPECT_FALSE(CWebSocketProtocols::isRequested("lsc.cbor2"));
+    EXPECT_FALSE(CWebSocketProtocols::isRequested(nullptr));
+
+    uint32_t ulPeer = CWebSocketProtocols::getPeerKey("192.168.1.5",50000);
+    EXPECT_NE(ulPeer,CWebSocketProtocols::getPeerKey("192.168.1.5",50001));
+    oProtocols.offer(ulPeer);
+    EXPECT_FALSE(oProtocols.connect(1,CWebSocketProtocols::getPeerKey("192.168.1.6",50000)));
+    EXPECT_TRUE(oProtocols.connect(2,ulPeer));
+    EXPECT_TRUE(oProtocols.isBinary(2));
+    EXPECT_FALSE(oProtocols.isBinary(1));
+    // The offer is used once
+    EXPECT_FALSE(oProtocols.connect(3,ulPeer));
+    EXPECT_EQ(oProtocols.getBinaryClients(),1U);
+    oProtocols.disconnect(2);
+    EXPECT_FALSE(oProtocols.isBinary(2));
+    EXPECT_EQ(oProtocols.getBinaryClients(),0U);
+}
+
+TEST(CWebSocketProtocols,testRejectsClientsWhenFull) {
+    CWebSocketProtocols oProtocols;
+    for(uint32_t ulClient = 1; ulClient <= WS_BINARY_CLIENTS + 1; ulClient++) {
+        uint32_t ulPeer = CWebSocketProtocols::getPeerKey("10.0.0.1",(uint16_t) ulClient);
+        oProtocols.offer(ulPeer);
+        EXPECT_EQ(oProtocols.connect(ulClient,ulPeer),ulClient <= WS_BINARY_CLIENTS);
+    }
+    EXPECT_EQ(oProtocols.getBinaryClients(),(size_t) WS_BINARY_CLIENTS);
+    EXPECT_EQ(oProtocols.getRejected(),1UL);
+}
+
 TEST(MQTTMessage,testConstructorCopiesTopicAndMessage) {
     char szTopic[] = "device/state";
     char szMessage[] = "online";
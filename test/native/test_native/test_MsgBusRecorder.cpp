@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include "MsgRecorder.h"
+#include "JsonNode.h"
+#include "MQTTController.h"
+#include "WebSocket.h"
+#include "Logging.h"
+
+/// @brief Receiver that remembers the last payload as text.
+class CTestReceiver : public IMsgEventReceiver {
+    public:
+        int     Calls = 0;
+        int     LastMsg = 0;
+        int     LastClass = 0;
+        String  LastData;
+        int receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nClass) override {
+            Calls++;
+            LastMsg   = nMsg;
+            LastClass = nClass;
+            if(nMsg == MSG_LOG_ENTRY)                   LastData = (const char *) pMessage;
+            else if(nMsg == MSG_LOG_ENTRY_JSON)         LastData = ((JsonNode *) pMessage)->getValue("text","");
+            else if(nMsg == MSG_MQTT_MSG_RECEIVED)      LastData = String(((MQTTMessage *) pMessage)->Topic) + "=" + ((MQTTMessage *) pMessage)->Message;
+            else if(nMsg == MSG_WEBSOCKET_DATA_RECEIVED) LastData = ((CWebSocketMessage *) pMessage)->pSerializedMessage;
+            return(EVENT_MSG_RESULT_OK);
+        }
+};
+
+/// @brief Receiver that sends a nested event, which must not be recorded.
+class CNestingReceiver : public IMsgEventReceiver {
+    public:
+        CEventHandler *pBus = nullptr;
+        int receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nClass) override {
+            if(nMsg == MSG_APPL_LOOP) pBus->sendEvent(this,MSG_LOG_ENTRY,"nested",LOG_CLASS_INFO);
+            return(EVENT_MSG_RESULT_OK);
+        }
+};
+
+TEST(CMsgBusRecorder,testRecordsTopLevelEventsOnly) {
+    CEventHandler oBus;
+    CNestingReceiver oNesting;
+    oNesting.pBus = &oBus;
+    oBus.registerEventReceiver(&oNesting,"nesting");
+    CMsgBusRecorder oRecorder(&oBus);
+    oRecorder.start();
+    oBus.sendEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    oBus.sendEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    oRecorder.stop();
+    EXPECT_EQ(oRecorder.getRecordCount(),2UL);
+    EXPECT_EQ(strstr(oRecorder.getRecords(),"nested"),nullptr);
+}
+
+TEST(CMsgBusRecorder,testStopsRecording) {
+    CEventHandler oBus;
+    CMsgBusRecorder oRecorder(&oBus);
+    oRecorder.start();
+    oBus.sendEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    oRecorder.stop();
+    oBus.sendEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    EXPECT_EQ(oRecorder.getRecordCount(),1UL);
+    EXPECT_FALSE(oRecorder.isRecording());
+}
+
+TEST(CMsgBusRecorder,testCountsDroppedEventsWithoutFile) {
+    CEventHandler oBus;
+    CMsgBusRecorder oRecorder(&oBus,16);
+    oRecorder.start();
+    for(int n = 0; n < 10; n++) oBus.sendEvent(nullptr,MSG_APPL_LOOP,nullptr,0);
+    oRecorder.stop();
+    EXPECT_GT(oRecorder.getDroppedCount(),0UL);
+    EXPECT_EQ(oRecorder.getRecordCount() + oRecorder.getDroppedCount(),10UL);
+}
+
+TEST(CMsgBusReplayer,testReplaysTextWithEscapes) {
+    CEventHandler oBus;
+    CMsgBusRecorder oRecorder(&oBus);
+    oRecorder.start();
+    oBus.sendEvent(nullptr,MSG_LOG_ENTRY,"line1\nline2\ttab \\ end",LOG_CLASS_WARN);
+    oRecorder.stop();
+
+    CEventHandler oReplayBus;
+    CTestReceiver oReceiver;
+    oReplayBus.registerEventReceiver(&oReceiver,"test");
+    CMsgBusReplayer oReplayer(&oReplayBus);
+    EXPECT_EQ(oReplayer.load(oRecorder.getRecords()),1U);
+    EXPECT_EQ(oReplayer.replay(),1U);
+    EXPECT_EQ(oReceiver.LastMsg,MSG_LOG_ENTRY);
+    EXPECT_EQ(oReceiver.LastClass,LOG_CLASS_WARN);
+    EXPECT_STREQ(oReceiver.LastData.c_str(),"line1\nline2\ttab \\ end");
+}
+
+TEST(CMsgBusReplayer,testReplaysPayloads) {
+    CEventHandler oBus;
+    CMsgBusRecorder oRecorder(&oBus);
+    oRecorder.start();
+    JsonNode oNode;
+    oNode.setValue("text","hello");
+    oBus.sendEvent(nullptr,MSG_LOG_ENTRY_JSON,&oNode,0);
+    MQTTMessage oMQTTMessage("device/cmd/power","on");
+    oBus.sendEvent(nullptr,MSG_MQTT_MSG_RECEIVED,&oMQTTMessage,0);
+    uint8_t szData[] = "{\"command\":\"status\"}";
+    CWebSocketMessage oWSMessage(nullptr,nullptr,sizeof(szData) - 1,WS_TEXT);
+    oWSMessage.setMessageData(szData,0,sizeof(szData) - 1);
+    oBus.sendEvent(nullptr,MSG_WEBSOCKET_DATA_RECEIVED,&oWSMessage,1);
+    oRecorder.stop();
+
+    CEventHandler oReplayBus;
+    CTestReceiver oReceiver;
+    oReplayBus.registerEventReceiver(&oReceiver,"test");
+    CMsgBusReplayer oReplayer(&oReplayBus);
+    oReplayer.load(oRecorder.getRecords());
+    ASSERT_EQ(oReplayer.getEventCount(),3U);
+    oReplayer.replay();
+    EXPECT_EQ(oReceiver.Calls,3);
+    EXPECT_STREQ(oReceiver.LastData.c_str(),"{\"command\":\"status\"}");
+    EXPECT_EQ(oReceiver.LastClass,1);
+
+    oReplayer.clear();
+    oReplayer.load("0\t5310\t0\t-\tM\tdevice/cmd/power\ton\n");
+    oReplayer.replay();
+    EXPECT_STREQ(oReceiver.LastData.c_str(),"device/cmd/power=on");
+
+    oReplayer.clear();
+    oReplayer.load("0\t202\t0\t-\tJ\t{\"text\":\"hello\"}\n");
+    oReplayer.replay();
+    EXPECT_STREQ(oReceiver.LastData.c_str(),"hello");
+}
+
+TEST(CMsgBusReplayer,testResolvesSenderByName) {
+    CEventHandler oBus;
+    CTestReceiver oSender;
+    CTestReceiver oReceiver;
+    oBus.registerEventReceiver(&oSender,"sender");
+    oBus.registerEventReceiver(&oReceiver,"receiver");
+    CMsgBusReplayer oReplayer(&oBus);
+    oReplayer.load("0\t110\t0\tsender\tN\n");
+    oReplayer.replay();
+    EXPECT_EQ(oSender.Calls,0);
+    EXPECT_EQ(oReceiver.Calls,1);
+}
+
+TEST(CMsgBusReplayer,testIgnoresInvalidLines) {
+    CEventHandler oBus;
+    CMsgBusReplayer oReplayer(&oBus);
+    EXPECT_EQ(oReplayer.load("garbage\n\n12\t110\n0\t110\t0\t-\tN\n"),1U);
+}
+
+TEST(CMsgBusReplayer,testReplayWithSpeedKeepsTiming) {
+    CEventHandler oBus;
+    CMsgBusReplayer oReplayer(&oBus);
+    oReplayer.load("0\t110\t0\t-\tN\n40\t110\t0\t-\tN\n");
+    oReplayer.replay(2.0);
+    EXPECT_GE(oReplayer.getReplayMicros(),19000UL);
+}
+
+TEST(CEventHandler,testProfilingCountsReceiverCalls) {
+    CEventHandler oBus;
+    CTestReceiver oReceiver;
+    oBus.registerEventReceiver(&oReceiver,"test");
+    EXPECT_EQ(oBus.getProfile("test"),nullptr);
+    CMsgBusReplayer oReplayer(&oBus);
+    oReplayer.load("0\t110\t0\t-\tN\n1\t110\t0\t-\tN\n2\t110\t0\t-\tN\n");
+    oReplayer.replay(0,true);
+    const MsgReceiverProfile *pProfile = oBus.getProfile("test");
+    ASSERT_NE(pProfile,nullptr);
+    EXPECT_EQ(pProfile->Calls,3UL);
+    EXPECT_GE(pProfile->TotalMicros,pProfile->MaxMicros);
+    EXPECT_EQ(oBus.getProfile("unknown"),nullptr);
+}
+
+TEST(CMsgBusRecorder,testRecordsLogRecordsAsText) {
+    CEventHandler oBus;
+    CEventLogger oLog(&oBus);
+    CLogWriter oWriter;
+    CMsgBusRecorder oRecorder(&oBus);
+    oRecorder.start();
+    oLog.log("W","value %d",7);
+    oRecorder.stop();
+
+    CEventHandler oReplayBus;
+    CTestReceiver oReceiver;
+    oReplayBus.registerEventReceiver(&oReceiver,"test");
+    CMsgBusReplayer oReplayer(&oReplayBus);
+    EXPECT_EQ(oReplayer.load(oRecorder.getRecords()),1U);
+    oReplayer.replay();
+    EXPECT_EQ(oReceiver.LastMsg,MSG_LOG_ENTRY);
+    EXPECT_STREQ(oReceiver.LastData.c_str(),"value 7");
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <atomic>
+#include "MsgQueue.h"
+#include "EventHandler.h"
+#include "Msgs.h"
+
+TEST(CSPSCQueue,testPushPopKeepsOrder) {
+    CSPSCQueue<int,4> oQueue;
+    EXPECT_TRUE(oQueue.empty());
+    EXPECT_TRUE(oQueue.push(1));
+    EXPECT_TRUE(oQueue.push(2));
+    EXPECT_EQ(oQueue.size(),2U);
+    int nValue = 0;
+    EXPECT_TRUE(oQueue.pop(nValue));
+    EXPECT_EQ(nValue,1);
+    EXPECT_TRUE(oQueue.pop(nValue));
+    EXPECT_EQ(nValue,2);
+    EXPECT_FALSE(oQueue.pop(nValue));
+}
+
+TEST(CSPSCQueue,testRejectsWhenFull) {
+    CSPSCQueue<int,3> oQueue;
+    EXPECT_TRUE(oQueue.push(1));
+    EXPECT_TRUE(oQueue.push(2));
+    EXPECT_TRUE(oQueue.push(3));
+    EXPECT_FALSE(oQueue.push(4));
+    EXPECT_EQ(oQueue.size(),3U);
+    EXPECT_EQ(oQueue.getDropped(),1UL);
+    int nValue = 0;
+    oQueue.pop(nValue);
+    EXPECT_TRUE(oQueue.push(5));
+}
+
+TEST(CSPSCQueue,testStressOneProducerOneConsumer) {
+    const int nCount = 200000;
+    CSPSCQueue<int,16> oQueue;
+    std::thread oProducer([&]() {
+        for(int n = 0; n < nCount; n++) {
+            while(!oQueue.push(n)) std::this_thread::yield();
+        }
+    });
+    int nExpected = 0;
+    int nValue;
+    while(nExpected < nCount) {
+        if(oQueue.pop(nValue)) {
+            ASSERT_EQ(nValue,nExpected);
+            nExpected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    oProducer.join();
+    EXPECT_TRUE(oQueue.empty());
+}
+
+/// @brief Checks the order of the posted events per producer.
+class CPostedEventCounter : public IMsgEventReceiver {
+    public:
+        static const int PRODUCERS = 4;
+        int  Received[PRODUCERS] = { 0 };
+        bool InOrder = true;
+        int receiveEvent(const void * pSender, int nMsg, const void * pMessage, int nClass) override {
+            int nProducer = nMsg - MSG_USER_BASE;
+            if(nProducer < 0 || nProducer >= PRODUCERS) return(EVENT_MSG_RESULT_OK);
+            if(nClass != Received[nProducer]) InOrder = false;
+            Received[nProducer]++;
+            return(EVENT_MSG_RESULT_OK);
+        }
+};
+
+TEST(CEventHandler,testStressPostedEventsFromProducerThreads) {
+    const int nCount = 20000;
+    CEventHandler oBus;
+    CPostedEventCounter oCounter;
+    oBus.registerEventReceiver(&oCounter,"counter");
+    CMsgPostQueue tQueues[CPostedEventCounter::PRODUCERS];
+    for(auto &oQueue : tQueues) oBus.registerPostQueue(&oQueue);
+
+    std::atomic<int> nRunning { CPostedEventCounter::PRODUCERS };
+    std::vector<std::thread> tProducers;
+    for(int nProducer = 0; nProducer < CPostedEventCounter::PRODUCERS; nProducer++) {
+        tProducers.emplace_back([&,nProducer]() {
+            for(int n = 0; n < nCount; n++) {
+                while(!tQueues[nProducer].post(nullptr,MSG_USER_BASE + nProducer,nullptr,n)) std::this_thread::yield();
+            }
+            nRunning--;
+        });
+    }
+    int nSent = 0;
+    while(nRunning > 0 || nSent < nCount * CPostedEventCounter::PRODUCERS) {
+        nSent += oBus.dispatchPostedEvents();
+    }
+    for(auto &oThread : tProducers) oThread.join();
+
+    EXPECT_EQ(nSent,nCount * CPostedEventCounter::PRODUCERS);
+    EXPECT_TRUE(oCounter.InOrder);
+    for(int nProducer = 0; nProducer < CPostedEventCounter::PRODUCERS; nProducer++) {
+        EXPECT_EQ(oCounter.Received[nProducer],nCount);
+    }
+}
+
+static int g_nReleased = 0;
+static void releaseTestMessage(const void *pMessage) { g_nReleased++; free((void *) pMessage); }
+
+TEST(CEventHandler,testPostedEventReleasesMessage) {
+    CEventHandler oBus;
+    CMsgPostQueue oQueue;
+    oBus.registerPostQueue(&oQueue);
+    oBus.registerPostQueue(&oQueue);
+    g_nReleased = 0;
+    EXPECT_TRUE(oQueue.post(nullptr,MSG_LOG_ENTRY,strdup("posted"),0,releaseTestMessage));
+    EXPECT_EQ(oBus.dispatchPostedEvents(),1);
+    EXPECT_EQ(g_nReleased,1);
+    EXPECT_EQ(oBus.dispatchPostedEvents(),0);
+}
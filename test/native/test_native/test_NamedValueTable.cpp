@@ -1,6 +1,7 @@
 
 #include <gtest/gtest.h>
 #include "NamedValueTable.h"
+#include <chrono>
 
 TEST(CNamedValueEntry,testStoresKeyAndValue) {
     CNamedValueEntry<int> oEntry("key",42);
@@ -85,3 +86,178 @@ TEST(CUniqueNameMultiValueTable,testUpdatesExistingKeyWithoutAddingEntry) {
     EXPECT_EQ(oTable.size(),1);
     EXPECT_EQ(oTable.get("key"),9);
 }
+
+#pragma region Hash index
+
+TEST(CNamedValueTable,testHashIndexFindsKeysCaseInsensitive) {
+    CNamedValueTable<int> oTable(false,-1);
+    oTable.enableHashIndex();
+    EXPECT_TRUE(oTable.hasHashIndex());
+    oTable.set("WiFi",1);
+    oTable.set("mqtt",2);
+    EXPECT_EQ(oTable.get("wifi"),1);
+    EXPECT_EQ(oTable.get("MQTT"),2);
+    EXPECT_EQ(oTable.get("unknown"),-1);
+    EXPECT_FALSE(oTable.hasKeyEntry(nullptr));
+}
+
+TEST(CNamedValueTable,testHashIndexRespectsCaseSensitivity) {
+    CNamedValueTable<int> oTable(true,-1);
+    oTable.enableHashIndex();
+    oTable.set("WiFi",1);
+    EXPECT_EQ(oTable.get("WiFi"),1);
+    EXPECT_EQ(oTable.get("wifi"),-1);
+}
+
+TEST(CNamedValueTable,testHashIndexKeepsOrderOfDuplicateKeys) {
+    CNamedValueTable<int> oTable;
+    oTable.set("key",1);
+    oTable.set("other",5);
+    oTable.set("key",2);
+    oTable.enableHashIndex();
+    oTable.set("key",3);
+    CNamedValueEntry<int> *pEntry = oTable.findFirstByKey("key");
+    ASSERT_NE(pEntry,nullptr);
+    EXPECT_EQ(pEntry->value,1);
+    pEntry = oTable.findNextByKey("key",pEntry);
+    ASSERT_NE(pEntry,nullptr);
+    EXPECT_EQ(pEntry->value,2);
+    pEntry = oTable.findNextByKey("key",pEntry);
+    ASSERT_NE(pEntry,nullptr);
+    EXPECT_EQ(pEntry->value,3);
+    EXPECT_EQ(oTable.findNextByKey("key",pEntry),nullptr);
+}
+
+TEST(CNamedValueTable,testHashIndexGrowsWithEntries) {
+    CNamedValueTable<int> oTable(true,-1);
+    oTable.enableHashIndex();
+    char szKey[16];
+    for(int n = 0; n < 500; n++) {
+        snprintf(szKey,sizeof(szKey),"key%d",n);
+        oTable.set(szKey,n);
+    }
+    for(int n = 0; n < 500; n++) {
+        snprintf(szKey,sizeof(szKey),"key%d",n);
+        ASSERT_EQ(oTable.get(szKey),n);
+    }
+    std::vector<const char *> tKeys = oTable.getKeys();
+    EXPECT_STREQ(tKeys[0],"key0");
+    EXPECT_STREQ(tKeys[499],"key499");
+    oTable.enableHashIndex(false);
+    EXPECT_FALSE(oTable.hasHashIndex());
+    EXPECT_EQ(oTable.get("key250"),250);
+}
+
+TEST(CMultiNameUniqueValueTable,testHashIndexAllowsMultipleNames) {
+    CMultiNameUniqueValueTable<int> oTable;
+    oTable.enableHashIndex();
+    EXPECT_NE(oTable.set("first",5),nullptr);
+    EXPECT_NE(oTable.set("first",6),nullptr);
+    EXPECT_EQ(oTable.set("second",5),nullptr);
+    EXPECT_EQ(oTable.size(),2);
+    EXPECT_EQ(oTable.findNextByKey("first",oTable.findFirstByKey("first"))->value,6);
+}
+
+TEST(CUniqueNameMultiValueTable,testHashIndexUpdatesExistingKey) {
+    CUniqueNameMultiValueTable<int> oTable(false);
+    oTable.enableHashIndex();
+    CNamedValueEntry<int> *pOriginal = oTable.set("Key",5);
+    EXPECT_EQ(oTable.set("KEY",9),pOriginal);
+    EXPECT_EQ(oTable.size(),1);
+    EXPECT_EQ(oTable.get("key"),9);
+}
+
+TEST(CNamedValueTable,testSetKeyRenamesIndexedEntry) {
+    CNamedValueTable<int> oTable(false,-1);
+    oTable.enableHashIndex();
+    oTable.set("short",1);
+    CNamedValueEntry<int> *pEntry = oTable.set("renamed",2);
+    EXPECT_TRUE(oTable.setKey(pEntry,"a.much.longer.key.name"));
+    EXPECT_EQ(oTable.get("renamed"),-1);
+    EXPECT_EQ(oTable.get("A.Much.Longer.Key.Name"),2);
+    EXPECT_EQ(oTable.get("short"),1);
+    EXPECT_STREQ(oTable.getKeys()[1],"a.much.longer.key.name");
+    CNamedValueEntry<int> oForeign("foreign",3);
+    EXPECT_FALSE(oTable.setKey(&oForeign,"other"));
+}
+
+/// @brief Measures nLookups key lookups (hit) in a table with nEntries entries.
+static long long measureKeyLookups(int nEntries, bool bHashIndex, int nLookups) {
+    CNamedValueTable<int> oTable(false,-1);
+    if(bHashIndex) oTable.enableHashIndex();
+    char szKey[24];
+    for(int n = 0; n < nEntries; n++) {
+        snprintf(szKey,sizeof(szKey),"module.value%d",n);
+        oTable.set(szKey,n);
+    }
+    long long llSum = 0;
+    auto tStart = std::chrono::steady_clock::now();
+    for(int n = 0; n < nLookups; n++) {
+        snprintf(szKey,sizeof(szKey),"MODULE.VALUE%d",n % nEntries);
+        llSum += oTable.get(szKey);
+    }
+    auto tDuration = std::chrono::steady_clock::now() - tStart;
+    EXPECT_GE(llSum,0);
+    return(std::chrono::duration_cast<std::chrono::microseconds>(tDuration).count());
+}
+
+TEST(CNamedValueTable,benchmarkHashIndexLookups) {
+    const int nLookups = 20000;
+    // The times are written to the test report (--gtest_output), they are not asserted
+    for(int nEntries : { 10, 100, 1000 }) {
+        String strEntries = std::to_string(nEntries);
+        RecordProperty("linear_us_" + strEntries,(int) measureKeyLookups(nEntries,false,nLookups));
+        RecordProperty("hashed_us_" + strEntries,(int) measureKeyLookups(nEntries,true, nLookups));
+    }
+}
+
+#pragma endregion
+
+#pragma region Key storage
+
+TEST(CNamedValueEntry,testStoresShortKeyInline) {
+    CNamedValueEntry<int> oEntry("123456789012345",1);
+    const char *pszKey = oEntry.getKey();
+    EXPECT_STREQ(pszKey,"123456789012345");
+    EXPECT_TRUE(pszKey >= (const char *) &oEntry && pszKey < (const char *) (&oEntry + 1));
+}
+
+TEST(CNamedValueEntry,testCopiesLongKey) {
+    char szKey[] = "a.very.long.key.name";
+    CNamedValueEntry<int> oEntry(szKey,1);
+    szKey[0] = 'X';
+    EXPECT_STREQ(oEntry.getKey(),"a.very.long.key.name");
+    EXPECT_NE(oEntry.getKey(),szKey);
+}
+
+TEST(CNamedValueEntry,testReferencesStaticKey) {
+    static const char *pszKey = "a.static.key.longer.than.inline";
+    CNamedValueEntry<int> oEntry(pszKey,1,true);
+    EXPECT_EQ(oEntry.getKey(),pszKey);
+    EXPECT_TRUE(oEntry.doesKeyMatch("A.STATIC.KEY.LONGER.THAN.INLINE",false));
+}
+
+TEST(CNamedValueTable,testEntriesStayValidAcrossChunks) {
+    CNamedValueTable<int> oTable;
+    CNamedValueEntry<int> *pFirst = oTable.set("first",0);
+    char szKey[32];
+    for(int n = 1; n < NAMED_VALUE_TABLE_CHUNK_SIZE * 3 + 1; n++) {
+        snprintf(szKey,sizeof(szKey),"key.number.%d.long",n);
+        oTable.set(szKey,n);
+    }
+    EXPECT_EQ(oTable.findFirstByKey("first"),pFirst);
+    EXPECT_STREQ(pFirst->getKey(),"first");
+    EXPECT_EQ(oTable.get("key.number.24.long"),24);
+    EXPECT_EQ((int) oTable.getKeys().size(),NAMED_VALUE_TABLE_CHUNK_SIZE * 3 + 1);
+}
+
+TEST(CNamedValueTable,testSetWithStaticKeyDoesNotCopy) {
+    static const char *pszKey = "static.key.of.a.component";
+    CNamedValueTable<int> oTable;
+    CNamedValueEntry<int> *pEntry = oTable.set(pszKey,7,true);
+    ASSERT_NE(pEntry,nullptr);
+    EXPECT_EQ(pEntry->getKey(),pszKey);
+    EXPECT_EQ(oTable.get("static.key.of.a.component"),7);
+}
+
+#pragma endregion
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "StatusSubscriptions.h"
+
+/// @brief Status section with a counter, counts how often it was written.
+class CTestSection : public IStatusHandler {
+    public:
+        int Value  = 0;
+        int Writes = 0;
+        void writeStatusTo(JsonNode &oStatusNode, int nLevel) override {
+            Writes++;
+            oStatusNode.setValue("value",Value);
+            if(nLevel >= STATUS_LEVEL_VERBOSE) oStatusNode.setValue("verbose",true);
+        }
+};
+
+/// @brief Collects the sent messages as text per client.
+class CTestSubscriptions : public CStatusSubscriptions {
+    public:
+        std::vector<std::pair<uint32_t,String>> Sent;
+        uint32_t GoneClient = 0;
+        CTestSubscriptions(CStatusHandler *pStatus) : CStatusSubscriptions(pStatus) {}
+    protected:
+        bool sendStatus(uint32_t ulClientId, JsonNode &oMessage) override {
+            if(ulClientId == GoneClient) return(false);
+            Sent.push_back({ ulClientId, oMessage.getAsJsonText() });
+            return(true);
+        }
+        bool isConnected(uint32_t ulClientId) override { return(ulClientId != GoneClient); }
+};
+
+TEST(CStatusSubscriptions,testSnapshotThenPatches) {
+    CStatusHandler oStatus;
+    CTestSection oWiFi, oMqtt;
+    oStatus.addStatusHandler("wifi",&oWiFi);
+    oStatus.addStatusHandler("mqtt",&oMqtt);
+    CTestSubscriptions oSubs(&oStatus);
+
+    ASSERT_TRUE(oSubs.subscribe(1,"wifi",STATUS_LEVEL_INFO,STATUS_SUBSCRIPTION_MIN_INTERVAL));
+    oSubs.process();
+    ASSERT_EQ(oSubs.Sent.size(),1U);
+    EXPECT_STREQ(oSubs.Sent[0].second.c_str(),"{\"command\":\"update\",\"data\":\"status\",\"payload\":{\"wifi\":{\"value\":0}}}");
+    EXPECT_EQ(oMqtt.Writes,0);
+
+    // Not dirty - nothing is sent, the other section does not count
+    oSubs.markDirty("mqtt");
+    delay(STATUS_SUBSCRIPTION_MIN_INTERVAL + 10);
+    oSubs.process();
+    EXPECT_EQ(oSubs.Sent.size(),1U);
+
+    // Dirty - only the changed field
+    oWiFi.Value = 5;
+    oSubs.markDirty("wifi");
+    oSubs.process();
+    ASSERT_EQ(oSubs.Sent.size(),2U);
+    EXPECT_STREQ(oSubs.Sent[1].second.c_str(),"{\"command\":\"update\",\"data\":\"statuspatch\",\"payload\":{\"wifi\":{\"value\":5}}}");
+
+    // Dirty within the min. interval - waits
+    oWiFi.Value = 6;
+    oSubs.markDirty("wifi");
+    oSubs.process();
+    EXPECT_EQ(oSubs.Sent.size(),2U);
+    delay(STATUS_SUBSCRIPTION_MIN_INTERVAL + 10);
+    oSubs.process();
+    EXPECT_EQ(oSubs.Sent.size(),3U);
+    EXPECT_EQ(oSubs.getSnapshots(),1UL);
+    EXPECT_EQ(oSubs.getPatches(),2UL);
+}
+
+TEST(CStatusSubscriptions,testSameSubscriptionSharesOneWrite) {
+    CStatusHandler oStatus;
+    CTestSection oWiFi;
+    oStatus.addStatusHandler("wifi",&oWiFi);
+    CTestSubscriptions oSubs(&oStatus);
+
+    oSubs.subscribe(1,"wifi");
+    oSubs.subscribe(2,"WiFi");
+    oSubs.subscribe(3,"wifi",STATUS_LEVEL_VERBOSE);
+    EXPECT_EQ(oSubs.getSubscribers(),3U);
+    EXPECT_EQ(oSubs.getGroups(),2U);
+    oSubs.process();
+    EXPECT_EQ(oSubs.Sent.size(),3U);
+    EXPECT_EQ(oWiFi.Writes,2);
+    EXPECT_EQ(oSubs.getWrites(),2UL);
+
+    // A resync gets the status of the last push (no write), the others nothing
+    oWiFi.Value = 1;
+    oSubs.resync(2);
+    oSubs.Sent.clear();
+    oSubs.process();
+    ASSERT_EQ(oSubs.Sent.size(),1U);
+    EXPECT_EQ(oWiFi.Writes,2);
+    EXPECT_EQ(oSubs.Sent[0].first,2U);
+    EXPECT_STREQ(oSubs.Sent[0].second.c_str(),"{\"command\":\"update\",\"data\":\"status\",\"payload\":{\"wifi\":{\"value\":0}}}");
+}
+
+TEST(CStatusSubscriptions,testJoinBetweenPushesWaitsForInterval) {
+    CStatusHandler oStatus;
+    CTestSection oWiFi;
+    oStatus.addStatusHandler("wifi",&oWiFi);
+    CTestSubscriptions oSubs(&oStatus);
+
+    oSubs.subscribe(1,"wifi",STATUS_LEVEL_INFO,STATUS_SUBSCRIPTION_MIN_INTERVAL);
+    oSubs.process();
+    ASSERT_EQ(oSubs.Sent.size(),1U);
+
+    // Dirty within the interval, a client joins - only the new client gets a message
+    oWiFi.Value = 5;
+    oSubs.markDirty("wifi");
+    oSubs.subscribe(2,"wifi",STATUS_LEVEL_INFO,STATUS_SUBSCRIPTION_MIN_INTERVAL);
+    oSubs.process();
+    ASSERT_EQ(oSubs.Sent.size(),2U);
+    EXPECT_EQ(oSubs.Sent[1].first,2U);
+    EXPECT_STREQ(oSubs.Sent[1].second.c_str(),"{\"command\":\"update\",\"data\":\"status\",\"payload\":{\"wifi\":{\"value\":0}}}");
+    EXPECT_EQ(oWiFi.Writes,1);
+
+    // Both get the patch, when the interval elapsed
+    delay(STATUS_SUBSCRIPTION_MIN_INTERVAL + 10);
+    oSubs.process();
+    ASSERT_EQ(oSubs.Sent.size(),4U);
+    EXPECT_EQ(oSubs.Sent[2].first,1U);
+    EXPECT_EQ(oSubs.Sent[3].first,2U);
+    EXPECT_STREQ(oSubs.Sent[3].second.c_str(),"{\"command\":\"update\",\"data\":\"statuspatch\",\"payload\":{\"wifi\":{\"value\":5}}}");
+}
+
+TEST(CStatusSubscriptions,testGoneClientsAreRemoved) {
+    CStatusHandler oStatus;
+    CTestSection oWiFi;
+    oStatus.addStatusHandler("wifi",&oWiFi);
+    CTestSubscriptions oSubs(&oStatus);
+
+    oSubs.subscribe(1,"wifi");
+    oSubs.subscribe(2,"wifi");
+    oSubs.GoneClient = 2;
+    oSubs.process();
+    EXPECT_EQ(oSubs.getSubscribers(),1U);
+
+    oSubs.subscribe(3,"wifi");
+    oSubs.GoneClient = 3;
+    oSubs.purge();
+    EXPECT_EQ(oSubs.getSubscribers(),1U);
+    oSubs.unsubscribe(1);
+    EXPECT_EQ(oSubs.getSubscribers(),0U);
+    EXPECT_EQ(oSubs.getGroups(),0U);
+    EXPECT_FALSE(oSubs.resync(1));
+}
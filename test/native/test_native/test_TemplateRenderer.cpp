@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include "TemplateRenderer.h"
+
+/// @brief Test templates are written with '$', replaced by the configured placeholder sign.
+static String tpl(const char *pszText) {
+    String strResult(pszText);
+    for(char &c : strResult) if(c == '$') c = TEMPLATE_PLACEHOLDER;
+    return(strResult);
+}
+
+/// @brief Renders a template from memory, using a small output buffer.
+static String renderTemplate(CTemplateRenderer &oRenderer, const char *pszName, const char *pszTemplate, size_t nBufferSize = 7) {
+    String strResult;
+    std::shared_ptr<CTemplateRenderState> pState = oRenderer.begin(pszName,std::unique_ptr<ITemplateSource>(new CMemoryTemplateSource(pszTemplate)));
+    if(!pState) return(strResult);
+    uint8_t tBuffer[64];
+    size_t nLen;
+    while((nLen = pState->fill(tBuffer,nBufferSize)) > 0) {
+        strResult += String((const char *) tBuffer,nLen);
+    }
+    EXPECT_TRUE(pState->isDone());
+    return(strResult);
+}
+
+TEST(CCompiledTemplate,testSplitsStaticAndPlaceholders) {
+    String strTemplate = tpl("<p>$WiFi.SSID$</p>$name$");
+    CMemoryTemplateSource oSource(strTemplate.c_str());
+    CCompiledTemplate oTemplate;
+    ASSERT_TRUE(oTemplate.compile(oSource));
+    const std::vector<TemplateSegment> &tSegments = oTemplate.getSegments();
+    ASSERT_EQ(tSegments.size(),4U);
+    EXPECT_EQ(tSegments[0].NameIdx,-1);
+    EXPECT_EQ(tSegments[0].Length,3U);
+    EXPECT_STREQ(oTemplate.getName(tSegments[1].NameIdx),"WiFi.SSID");
+    EXPECT_EQ(tSegments[2].Offset,14U);
+    EXPECT_STREQ(oTemplate.getName(tSegments[3].NameIdx),"name");
+    EXPECT_EQ(oTemplate.getPlaceholderCount(),2U);
+}
+
+TEST(CCompiledTemplate,testKeepsInvalidPlaceholdersAsText) {
+    CTemplateRenderer oRenderer;
+    EXPECT_STREQ(renderTemplate(oRenderer,"a",tpl("costs 5$ or $$ 6 $ $x y$").c_str()).c_str(),tpl("costs 5$ or $ 6 $ $x y$").c_str());
+    String strLongName = tpl("$") + String(TEMPLATE_PARAM_NAME_LENGTH + 1,'a') + tpl("$");
+    EXPECT_STREQ(renderTemplate(oRenderer,"b",strLongName.c_str()).c_str(),strLongName.c_str());
+}
+
+TEST(CCompiledTemplate,testScansAcrossBlockBoundaries) {
+    String strTemplate(TEMPLATE_SCAN_BLOCK_SIZE - 3,'x');
+    strTemplate += tpl("$value$");
+    CTemplateRenderer oRenderer;
+    oRenderer.setResolver([](const char *pszName, String &strValue) {
+        strValue = "42";
+        return(true);
+    });
+    String strExpected(TEMPLATE_SCAN_BLOCK_SIZE - 3,'x');
+    strExpected += "42";
+    EXPECT_STREQ(renderTemplate(oRenderer,"t",strTemplate.c_str()).c_str(),strExpected.c_str());
+}
+
+TEST(CTemplateRenderer,testResolvesFromVarTable) {
+    CVarTable oVars;
+    oVars.set("WiFi.SSID","MyNet");
+    oVars.set("WiFi.Passwd","secret")->setCriticalVar(true);
+    CTemplateRenderer oRenderer(&oVars);
+    oRenderer.setResolver([](const char *pszName, String &strValue) {
+        if(strcmp(pszName,"Version") != 0) return(false);
+        strValue = "1.0";
+        return(true);
+    });
+    for(size_t nBufferSize : { 1, 3, 64 }) {
+        EXPECT_STREQ(renderTemplate(oRenderer,"page",tpl("SSID=$WiFi.SSID$;PW=$WiFi.Passwd$;V=$Version$;U=$Unknown$").c_str(),nBufferSize).c_str(),
+                     "SSID=MyNet;PW=;V=1.0;U=");
+    }
+}
+
+TEST(CTemplateRenderer,testCachesCompiledTemplates) {
+    CTemplateRenderer oRenderer;
+    String strFirst = tpl("a$b$c");
+    CMemoryTemplateSource oSource(strFirst.c_str());
+    std::shared_ptr<CCompiledTemplate> pFirst = oRenderer.getTemplate("page",oSource);
+    EXPECT_EQ(oRenderer.getTemplate("page",oSource),pFirst);
+
+    String strChanged = tpl("a$b$cd");
+    CMemoryTemplateSource oChanged(strChanged.c_str());
+    EXPECT_NE(oRenderer.getTemplate("page",oChanged),pFirst);
+
+    std::shared_ptr<CCompiledTemplate> pSecond = oRenderer.getTemplate("page",oChanged);
+    oRenderer.invalidate("page");
+    EXPECT_NE(oRenderer.getTemplate("page",oChanged),pSecond);
+}
+
+TEST(CTemplateRenderer,testEmptyTemplate) {
+    CTemplateRenderer oRenderer;
+    EXPECT_STREQ(renderTemplate(oRenderer,"empty","").c_str(),"");
+}
+
+TEST(CTemplateRenderer,testRecompilesSameSizeEdit) {
+    CTemplateRenderer oRenderer;
+    String strFirst = tpl("ab$c$");
+    CMemoryTemplateSource oSource(strFirst.c_str());
+    std::shared_ptr<CCompiledTemplate> pFirst = oRenderer.getTemplate("page",oSource);
+    EXPECT_EQ(pFirst->getPlaceholderCount(),1U);
+
+    // Same size and version - the source is not read again
+    String strChanged = tpl("$a$bc");
+    CMemoryTemplateSource oSameVersion(strChanged.c_str());
+    EXPECT_EQ(oRenderer.getTemplate("page",oSameVersion),pFirst);
+
+    // Same size, the placeholder moved - the writer changed the version
+    CMemoryTemplateSource oChanged(strChanged.c_str(),2);
+    std::shared_ptr<CCompiledTemplate> pChanged = oRenderer.getTemplate("page",oChanged);
+    EXPECT_NE(pChanged,pFirst);
+    EXPECT_STREQ(pChanged->getName(0),"a");
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "WebSocketStream.h"
+#include <memory>
+#include <stdio.h>
+
+/// @brief Collects the sent fragments, the send queue holds QueueSize fragments.
+class CTestStreams : public CWebSocketStreams {
+    public:
+        std::vector<std::pair<uint32_t,std::string>> Sent;
+        size_t   QueueSize  = 1000;
+        size_t   Queued     = 0;
+        uint32_t GoneClient = 0;
+    protected:
+        bool canSend(uint32_t ulClientId) override { return(Queued < QueueSize); }
+        bool isConnected(uint32_t ulClientId) override { return(ulClientId != GoneClient); }
+        bool sendFragment(uint32_t ulClientId, const uint8_t *pData, size_t nLen) override {
+            Queued++;
+            Sent.push_back({ ulClientId, std::string((const char *) pData,nLen) });
+            return(true);
+        }
+};
+
+/// @brief Final flag of a fragment header "@<id>,<seq>,<final>...".
+static bool isFinal(const std::string &strFragment) {
+    size_t nFlag = strFragment.find(',',strFragment.find(',') + 1) + 1;
+    return(strFragment[nFlag] == '1');
+}
+
+/// @brief Reassembles the fragments of a stream like the runtime.js, returns "" if incomplete.
+static std::string reassemble(std::vector<std::pair<uint32_t,std::string>> &tSent, std::string *pHeader = nullptr) {
+    std::string strResult;
+    for(auto &oFragment : tSent) {
+        size_t nHeaderEnd = oFragment.second.find('\n');
+        std::string strHeader = oFragment.second.substr(0,nHeaderEnd);
+        if(pHeader && pHeader->empty()) *pHeader = strHeader;
+        strResult += oFragment.second.substr(nHeaderEnd + 1);
+        if(isFinal(strHeader)) return(strResult);
+    }
+    return("");
+}
+
+TEST(CWebSocketStreams,testJsonStreamIsComplete) {
+    CTestStreams oStreams;
+    JsonNode *pDoc = new JsonNode();
+    JsonNode *pPayload = pDoc->createPayloadStructure("backup","config");
+    for(int nIdx = 0; nIdx < 200; nIdx++) pPayload->setValue(("key" + std::to_string(nIdx)).c_str(),"a value with \"quotes\"");
+    String strExpected = pDoc->getAsJsonText();
+    ASSERT_GT(strExpected.length(),(size_t) WS_STREAM_FRAGMENT_SIZE * 4);
+
+    EXPECT_NE(oStreams.startJson(7,pDoc),0U);
+    EXPECT_EQ(oStreams.getActive(),1U);
+    while(oStreams.getActive() > 0) oStreams.process();
+    std::string strHeader;
+    EXPECT_EQ(reassemble(oStreams.Sent,&strHeader),strExpected);
+    EXPECT_EQ(strHeader.substr(strHeader.find(',')),",0,0,,");
+    EXPECT_TRUE(isFinal(oStreams.Sent.back().second));
+    EXPECT_EQ(oStreams.Sent.back().second.find('\n'),oStreams.Sent.back().second.length() - 1);
+    EXPECT_EQ(oStreams.getBytes(),strExpected.length());
+    for(auto &oFragment : oStreams.Sent) {
+        EXPECT_EQ(oFragment.first,7U);
+        EXPECT_LE(oFragment.second.length(),(size_t) WS_STREAM_HEADER_SIZE + WS_STREAM_FRAGMENT_SIZE);
+    }
+}
+
+TEST(CWebSocketStreams,testFlowControl) {
+    CTestStreams oStreams;
+    oStreams.QueueSize = 2;
+    std::string strData(WS_STREAM_FRAGMENT_SIZE * 3 + 10,'x');
+    oStreams.start(1,[strData](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t {
+        size_t nLen = std::min(nMaxLen,strData.length() - nIndex);
+        memcpy(pBuffer,strData.c_str() + nIndex,nLen);
+        return(nLen);
+    },"log","file");
+    // Queue full - waits, nothing produced
+    oStreams.process();
+    EXPECT_EQ(oStreams.Sent.size(),2U);
+    oStreams.process();
+    EXPECT_EQ(oStreams.Sent.size(),2U);
+    EXPECT_GE(oStreams.getWaits(),2UL);
+    // Queue drained - the stream continues
+    while(oStreams.getActive() > 0) {
+        oStreams.Queued = 0;
+        oStreams.process();
+    }
+    std::string strHeader;
+    EXPECT_EQ(reassemble(oStreams.Sent,&strHeader),strData);
+    EXPECT_EQ(strHeader.substr(strHeader.find(',')),",0,0,log,file");
+}
+
+TEST(CWebSocketStreams,testAbortAndSlots) {
+    CTestStreams oStreams;
+    oStreams.QueueSize = 0;
+    auto fnEndless = [](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t { memset(pBuffer,'y',nMaxLen); return(nMaxLen); };
+    for(int nIdx = 0; nIdx < WS_STREAM_MAX; nIdx++) EXPECT_NE(oStreams.start(nIdx + 1,fnEndless),0U);
+    EXPECT_EQ(oStreams.start(9,fnEndless),0U);
+    EXPECT_EQ(oStreams.getRejected(),1UL);
+    // The document of a rejected JSON stream is deleted
+    EXPECT_EQ(oStreams.startJson(9,new JsonNode()),0U);
+
+    oStreams.GoneClient = 1;
+    oStreams.process();
+    EXPECT_EQ(oStreams.getActive(),(size_t) WS_STREAM_MAX - 1);
+    oStreams.abort(2);
+    EXPECT_EQ(oStreams.getActive(),0U);
+    EXPECT_EQ(oStreams.getAborted(),2UL);
+    EXPECT_TRUE(oStreams.Sent.empty());
+}
+
+TEST(CWebSocketStreams,testFileStreamWithPrefixAndSuffix) {
+    const char *pszFile = "test_streamfile.json";
+    std::string strContent = "{\"wifi\":{\"ssid\":\"test\"},\"list\":[";
+    for(int nIdx = 0; nIdx < 500; nIdx++) strContent += std::to_string(nIdx) + ",";
+    strContent += "0]}";
+    FILE *pFile = fopen(pszFile,"wb");
+    ASSERT_NE(pFile,nullptr);
+    fwrite(strContent.c_str(),1,strContent.length(),pFile);
+    fclose(pFile);
+
+    CTestStreams oStreams;
+    std::shared_ptr<CWebSocketFileReader> pReader = std::make_shared<CWebSocketFileReader>(pszFile,"{\"payload\":","}");
+    EXPECT_EQ(pReader->getFileSize(),strContent.length());
+    EXPECT_NE(oStreams.start(3,[pReader](uint8_t *pBuffer, size_t nMaxLen, size_t nIndex) -> size_t {
+        return(pReader->read(pBuffer,nMaxLen));
+    }),0U);
+    while(oStreams.getActive() > 0) oStreams.process();
+    EXPECT_EQ(reassemble(oStreams.Sent),"{\"payload\":" + strContent + "}");
+    EXPECT_GT(oStreams.Sent.size(),2U);
+    remove(pszFile);
+
+    CWebSocketFileReader oMissing("missing_streamfile.json","[","]");
+    EXPECT_EQ(oMissing.getFileSize(),0U);
+}